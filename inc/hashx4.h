@@ -20,6 +20,7 @@
  */
 
 #include <stddef.h>
+#include <stdint.h>
 #include "hashx4_config.h"
 
 #define HX4_ERR_SUCCESS (0)
@@ -27,30 +28,297 @@
 #define HX4_ERR_BUFFER_TOO_SMALL (-2)
 #define HX4_ERR_OVERLAP (-3)
 #define HX4_ERR_COOKIE_TOO_SMALL (-4)
+#define HX4_ERR_NOT_FOUND (-5)
+#define HX4_ERR_SEARCH_FAILED (-6)
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
-int hx4_djbx33a_32_ref     (const void *in, size_t in_sz, const void *cookie, size_t cookie_sz, void *out, size_t out_sz);
-int hx4_djbx33a_32_copt    (const void *in, size_t in_sz, const void *cookie, size_t cookie_sz, void *out, size_t out_sz);
-int hx4_x4djbx33a_128_ref  (const void *in, size_t in_sz, const void *cookie, size_t cookie_sz, void *out, size_t out_sz);
-int hx4_x4djbx33a_128_copt (const void *in, size_t in_sz, const void *cookie, size_t cookie_sz, void *out, size_t out_sz);
+/* a fragment of the input of the _v functions, the same layout as struct iovec on POSIX */
+typedef struct {
+  const void *iov_base;
+  size_t iov_len;
+} hx4_iovec;
+
+HX4_API int hx4_djbx33a_32_ref     (const void *in, size_t in_sz, const void *cookie, size_t cookie_sz, void *out, size_t out_sz);
+HX4_API int hx4_djbx33a_32_copt    (const void *in, size_t in_sz, const void *cookie, size_t cookie_sz, void *out, size_t out_sz);
+HX4_API int hx4_x4djbx33a_128_ref  (const void *in, size_t in_sz, const void *cookie, size_t cookie_sz, void *out, size_t out_sz);
+HX4_API int hx4_x4djbx33a_128_copt (const void *in, size_t in_sz, const void *cookie, size_t cookie_sz, void *out, size_t out_sz);
+
+#if HX4_HAS_MMX
+HX4_API int hx4_x4djbx33a_128_mmx  (const void *in, size_t in_sz, const void *cookie, size_t cookie_sz, void *out, size_t out_sz);
+#endif
+
+#if HX4_HAS_SSE2
+HX4_API int hx4_x4djbx33a_128_sse2 (const void *in, size_t in_sz, const void *cookie, size_t cookie_sz, void *out, size_t out_sz);
+HX4_API int hx4_x4djbx33a_128_sse2rle(const void *in, size_t in_sz, const void *cookie, size_t cookie_sz, void *out, size_t out_sz);
+#endif
+
+#if HX4_HAS_SSSE3
+HX4_API int hx4_x4djbx33a_128_ssse3(const void *in, size_t in_sz, const void *cookie, size_t cookie_sz, void *out, size_t out_sz);
+#endif
+
+HX4_API int hx4_kdjbx33a_32_ref      (const void *in, size_t in_sz, const void *cookie, size_t cookie_sz, void *out, size_t out_sz);
+HX4_API int hx4_kdjbx33a_32_copt     (const void *in, size_t in_sz, const void *cookie, size_t cookie_sz, void *out, size_t out_sz);
+HX4_API int hx4_x4kdjbx33a_128_ref   (const void *in, size_t in_sz, const void *cookie, size_t cookie_sz, void *out, size_t out_sz);
+HX4_API int hx4_x4kdjbx33a_128_copt  (const void *in, size_t in_sz, const void *cookie, size_t cookie_sz, void *out, size_t out_sz);
+
+#if HX4_HAS_SSE2
+HX4_API int hx4_x4kdjbx33a_128_sse2  (const void *in, size_t in_sz, const void *cookie, size_t cookie_sz, void *out, size_t out_sz);
+#endif
+
+#if HX4_HAS_SSSE3
+HX4_API int hx4_x4kdjbx33a_128_ssse3 (const void *in, size_t in_sz, const void *cookie, size_t cookie_sz, void *out, size_t out_sz);
+#endif
+
+HX4_API int hx4_siphash24_64_ref   (const void *in, size_t in_sz, const void *cookie, size_t cookie_sz, void *out, size_t out_sz);
+HX4_API int hx4_siphash24_64_copt  (const void *in, size_t in_sz, const void *cookie, size_t cookie_sz, void *out, size_t out_sz);
+
+HX4_API int hx4_siphash13_64_ref   (const void *in, size_t in_sz, const void *cookie, size_t cookie_sz, void *out, size_t out_sz);
+HX4_API int hx4_siphash13_64_copt  (const void *in, size_t in_sz, const void *cookie, size_t cookie_sz, void *out, size_t out_sz);
+HX4_API int hx4_x4siphash13_256_ref(const void *in, size_t in_sz, const void *cookie, size_t cookie_sz, void *out, size_t out_sz);
+
+#if HX4_HAS_SSE2
+HX4_API int hx4_x4siphash13_256_sse2(const void *in, size_t in_sz, const void *cookie, size_t cookie_sz, void *out, size_t out_sz);
+#endif
+
+HX4_API int hx4_halfsiphash13_32_ref    (const void *in, size_t in_sz, const void *cookie, size_t cookie_sz, void *out, size_t out_sz);
+HX4_API int hx4_halfsiphash13_32_copt   (const void *in, size_t in_sz, const void *cookie, size_t cookie_sz, void *out, size_t out_sz);
+HX4_API int hx4_x4halfsiphash13_128_ref (const void *in, size_t in_sz, const void *cookie, size_t cookie_sz, void *out, size_t out_sz);
+
+#if HX4_HAS_SSE2
+HX4_API int hx4_x4halfsiphash13_128_sse2(const void *in, size_t in_sz, const void *cookie, size_t cookie_sz, void *out, size_t out_sz);
+#endif
+
+/*
+ * CRC-32C, with a zero cookie crc32c_32 is the standard CRC-32C (iSCSI, SSE4.2),
+ * x4crc32c_128 runs a CRC-32C over every fourth 8 byte word of the input
+ */
+HX4_API int hx4_crc32c_32_ref          (const void *in, size_t in_sz, const void *cookie, size_t cookie_sz, void *out, size_t out_sz);
+HX4_API int hx4_x4crc32c_128_ref       (const void *in, size_t in_sz, const void *cookie, size_t cookie_sz, void *out, size_t out_sz);
+
+#if HX4_HAS_SSE42
+HX4_API int hx4_crc32c_32_sse42        (const void *in, size_t in_sz, const void *cookie, size_t cookie_sz, void *out, size_t out_sz);
+HX4_API int hx4_x4crc32c_128_sse42     (const void *in, size_t in_sz, const void *cookie, size_t cookie_sz, void *out, size_t out_sz);
+#endif
+
+#if HX4_HAS_SSE42 && HX4_HAS_PCLMUL
+HX4_API int hx4_crc32c_32_pclmul       (const void *in, size_t in_sz, const void *cookie, size_t cookie_sz, void *out, size_t out_sz);
+#endif
+
+/*
+ * x4aes_128, 4 lanes of one AES round per 16 byte block, the cookie gives the round keys
+ */
+HX4_API int hx4_x4aes_128_ref          (const void *in, size_t in_sz, const void *cookie, size_t cookie_sz, void *out, size_t out_sz);
+
+#if HX4_HAS_AESNI
+HX4_API int hx4_x4aes_128_aesni        (const void *in, size_t in_sz, const void *cookie, size_t cookie_sz, void *out, size_t out_sz);
+#endif
+
+/*
+ * POLYVAL (RFC 8452) keyed with the first 16 bytes of the cookie, a universal hash
+ * and not a MAC by itself, the output has to be encrypted under a per message nonce
+ */
+HX4_API int hx4_polyval_128_ref        (const void *in, size_t in_sz, const void *cookie, size_t cookie_sz, void *out, size_t out_sz);
+
+#if HX4_HAS_PCLMUL
+HX4_API int hx4_polyval_128_pclmul     (const void *in, size_t in_sz, const void *cookie, size_t cookie_sz, void *out, size_t out_sz);
+#endif
+
+/*
+ * x4mulfold_128, 4 lanes over interleaved 4 byte words with a 32x32->64bit multiply-fold per word
+ */
+HX4_API int hx4_x4mulfold_128_ref      (const void *in, size_t in_sz, const void *cookie, size_t cookie_sz, void *out, size_t out_sz);
+HX4_API int hx4_x4mulfold_128_copt     (const void *in, size_t in_sz, const void *cookie, size_t cookie_sz, void *out, size_t out_sz);
+
+#if HX4_HAS_SSE2
+HX4_API int hx4_x4mulfold_128_sse2     (const void *in, size_t in_sz, const void *cookie, size_t cookie_sz, void *out, size_t out_sz);
+#endif
+
+#if HX4_HAS_AVX2
+HX4_API int hx4_x4mulfold_128_avx2     (const void *in, size_t in_sz, const void *cookie, size_t cookie_sz, void *out, size_t out_sz);
+#endif
+
+/*
+ * scatter-gather variants, they hash the concatenation of the iov_cnt fragments
+ * without copying them together, the result equals the one of the function
+ * without _v on the concatenated input
+ */
+
+HX4_API int hx4_djbx33a_32_ref_v          (const hx4_iovec *iov, size_t iov_cnt, const void *cookie, size_t cookie_sz, void *out, size_t out_sz);
+HX4_API int hx4_djbx33a_32_copt_v         (const hx4_iovec *iov, size_t iov_cnt, const void *cookie, size_t cookie_sz, void *out, size_t out_sz);
+HX4_API int hx4_x4djbx33a_128_ref_v       (const hx4_iovec *iov, size_t iov_cnt, const void *cookie, size_t cookie_sz, void *out, size_t out_sz);
+HX4_API int hx4_x4djbx33a_128_copt_v      (const hx4_iovec *iov, size_t iov_cnt, const void *cookie, size_t cookie_sz, void *out, size_t out_sz);
+
+#if HX4_HAS_MMX
+HX4_API int hx4_x4djbx33a_128_mmx_v       (const hx4_iovec *iov, size_t iov_cnt, const void *cookie, size_t cookie_sz, void *out, size_t out_sz);
+#endif
+
+#if HX4_HAS_SSE2
+HX4_API int hx4_x4djbx33a_128_sse2_v      (const hx4_iovec *iov, size_t iov_cnt, const void *cookie, size_t cookie_sz, void *out, size_t out_sz);
+HX4_API int hx4_x4djbx33a_128_sse2rle_v   (const hx4_iovec *iov, size_t iov_cnt, const void *cookie, size_t cookie_sz, void *out, size_t out_sz);
+#endif
+
+#if HX4_HAS_SSSE3
+HX4_API int hx4_x4djbx33a_128_ssse3_v     (const hx4_iovec *iov, size_t iov_cnt, const void *cookie, size_t cookie_sz, void *out, size_t out_sz);
+#endif
+
+HX4_API int hx4_kdjbx33a_32_ref_v         (const hx4_iovec *iov, size_t iov_cnt, const void *cookie, size_t cookie_sz, void *out, size_t out_sz);
+HX4_API int hx4_kdjbx33a_32_copt_v        (const hx4_iovec *iov, size_t iov_cnt, const void *cookie, size_t cookie_sz, void *out, size_t out_sz);
+HX4_API int hx4_x4kdjbx33a_128_ref_v      (const hx4_iovec *iov, size_t iov_cnt, const void *cookie, size_t cookie_sz, void *out, size_t out_sz);
+HX4_API int hx4_x4kdjbx33a_128_copt_v     (const hx4_iovec *iov, size_t iov_cnt, const void *cookie, size_t cookie_sz, void *out, size_t out_sz);
+
+#if HX4_HAS_SSE2
+HX4_API int hx4_x4kdjbx33a_128_sse2_v     (const hx4_iovec *iov, size_t iov_cnt, const void *cookie, size_t cookie_sz, void *out, size_t out_sz);
+#endif
+
+#if HX4_HAS_SSSE3
+HX4_API int hx4_x4kdjbx33a_128_ssse3_v    (const hx4_iovec *iov, size_t iov_cnt, const void *cookie, size_t cookie_sz, void *out, size_t out_sz);
+#endif
+
+HX4_API int hx4_siphash24_64_ref_v        (const hx4_iovec *iov, size_t iov_cnt, const void *cookie, size_t cookie_sz, void *out, size_t out_sz);
+HX4_API int hx4_siphash24_64_copt_v       (const hx4_iovec *iov, size_t iov_cnt, const void *cookie, size_t cookie_sz, void *out, size_t out_sz);
+HX4_API int hx4_siphash13_64_ref_v        (const hx4_iovec *iov, size_t iov_cnt, const void *cookie, size_t cookie_sz, void *out, size_t out_sz);
+HX4_API int hx4_siphash13_64_copt_v       (const hx4_iovec *iov, size_t iov_cnt, const void *cookie, size_t cookie_sz, void *out, size_t out_sz);
+HX4_API int hx4_x4siphash13_256_ref_v     (const hx4_iovec *iov, size_t iov_cnt, const void *cookie, size_t cookie_sz, void *out, size_t out_sz);
+
+#if HX4_HAS_SSE2
+HX4_API int hx4_x4siphash13_256_sse2_v    (const hx4_iovec *iov, size_t iov_cnt, const void *cookie, size_t cookie_sz, void *out, size_t out_sz);
+#endif
+
+HX4_API int hx4_halfsiphash13_32_ref_v    (const hx4_iovec *iov, size_t iov_cnt, const void *cookie, size_t cookie_sz, void *out, size_t out_sz);
+HX4_API int hx4_halfsiphash13_32_copt_v   (const hx4_iovec *iov, size_t iov_cnt, const void *cookie, size_t cookie_sz, void *out, size_t out_sz);
+HX4_API int hx4_x4halfsiphash13_128_ref_v (const hx4_iovec *iov, size_t iov_cnt, const void *cookie, size_t cookie_sz, void *out, size_t out_sz);
+
+#if HX4_HAS_SSE2
+HX4_API int hx4_x4halfsiphash13_128_sse2_v(const hx4_iovec *iov, size_t iov_cnt, const void *cookie, size_t cookie_sz, void *out, size_t out_sz);
+#endif
+
+/*
+ * C string variants, they hash str up to but not including the terminating NUL,
+ * the result equals the one of the function without _cstr on (str,
+ * strlen(str)), the length is stored to *str_len unless str_len is NULL. The
+ * SSE2/SSSE3 x4djbx33a and x4kdjbx33a variants find the terminator while they
+ * hash and may read past it, but never past the aligned 16 byte block that
+ * holds it, the others call strlen first.
+ */
+
+HX4_API int hx4_djbx33a_32_ref_cstr          (const char *str, size_t *str_len, const void *cookie, size_t cookie_sz, void *out, size_t out_sz);
+HX4_API int hx4_djbx33a_32_copt_cstr         (const char *str, size_t *str_len, const void *cookie, size_t cookie_sz, void *out, size_t out_sz);
+HX4_API int hx4_x4djbx33a_128_ref_cstr       (const char *str, size_t *str_len, const void *cookie, size_t cookie_sz, void *out, size_t out_sz);
+HX4_API int hx4_x4djbx33a_128_copt_cstr      (const char *str, size_t *str_len, const void *cookie, size_t cookie_sz, void *out, size_t out_sz);
 
 #if HX4_HAS_MMX
-int hx4_x4djbx33a_128_mmx  (const void *in, size_t in_sz, const void *cookie, size_t cookie_sz, void *out, size_t out_sz);
+HX4_API int hx4_x4djbx33a_128_mmx_cstr       (const char *str, size_t *str_len, const void *cookie, size_t cookie_sz, void *out, size_t out_sz);
 #endif
 
 #if HX4_HAS_SSE2
-int hx4_x4djbx33a_128_sse2 (const void *in, size_t in_sz, const void *cookie, size_t cookie_sz, void *out, size_t out_sz);
+HX4_API int hx4_x4djbx33a_128_sse2_cstr      (const char *str, size_t *str_len, const void *cookie, size_t cookie_sz, void *out, size_t out_sz);
+HX4_API int hx4_x4djbx33a_128_sse2rle_cstr   (const char *str, size_t *str_len, const void *cookie, size_t cookie_sz, void *out, size_t out_sz);
 #endif
 
 #if HX4_HAS_SSSE3
-int hx4_x4djbx33a_128_ssse3(const void *in, size_t in_sz, const void *cookie, size_t cookie_sz, void *out, size_t out_sz);
+HX4_API int hx4_x4djbx33a_128_ssse3_cstr     (const char *str, size_t *str_len, const void *cookie, size_t cookie_sz, void *out, size_t out_sz);
+#endif
+
+HX4_API int hx4_kdjbx33a_32_ref_cstr         (const char *str, size_t *str_len, const void *cookie, size_t cookie_sz, void *out, size_t out_sz);
+HX4_API int hx4_kdjbx33a_32_copt_cstr        (const char *str, size_t *str_len, const void *cookie, size_t cookie_sz, void *out, size_t out_sz);
+HX4_API int hx4_x4kdjbx33a_128_ref_cstr      (const char *str, size_t *str_len, const void *cookie, size_t cookie_sz, void *out, size_t out_sz);
+HX4_API int hx4_x4kdjbx33a_128_copt_cstr     (const char *str, size_t *str_len, const void *cookie, size_t cookie_sz, void *out, size_t out_sz);
+
+#if HX4_HAS_SSE2
+HX4_API int hx4_x4kdjbx33a_128_sse2_cstr     (const char *str, size_t *str_len, const void *cookie, size_t cookie_sz, void *out, size_t out_sz);
 #endif
 
-int hx4_siphash24_64_ref   (const void *in, size_t in_sz, const void *cookie, size_t cookie_sz, void *out, size_t out_sz);
-int hx4_siphash24_64_copt  (const void *in, size_t in_sz, const void *cookie, size_t cookie_sz, void *out, size_t out_sz);
+#if HX4_HAS_SSSE3
+HX4_API int hx4_x4kdjbx33a_128_ssse3_cstr    (const char *str, size_t *str_len, const void *cookie, size_t cookie_sz, void *out, size_t out_sz);
+#endif
+
+HX4_API int hx4_siphash24_64_ref_cstr        (const char *str, size_t *str_len, const void *cookie, size_t cookie_sz, void *out, size_t out_sz);
+HX4_API int hx4_siphash24_64_copt_cstr       (const char *str, size_t *str_len, const void *cookie, size_t cookie_sz, void *out, size_t out_sz);
+HX4_API int hx4_siphash13_64_ref_cstr        (const char *str, size_t *str_len, const void *cookie, size_t cookie_sz, void *out, size_t out_sz);
+HX4_API int hx4_siphash13_64_copt_cstr       (const char *str, size_t *str_len, const void *cookie, size_t cookie_sz, void *out, size_t out_sz);
+HX4_API int hx4_x4siphash13_256_ref_cstr     (const char *str, size_t *str_len, const void *cookie, size_t cookie_sz, void *out, size_t out_sz);
+
+#if HX4_HAS_SSE2
+HX4_API int hx4_x4siphash13_256_sse2_cstr    (const char *str, size_t *str_len, const void *cookie, size_t cookie_sz, void *out, size_t out_sz);
+#endif
+
+HX4_API int hx4_halfsiphash13_32_ref_cstr    (const char *str, size_t *str_len, const void *cookie, size_t cookie_sz, void *out, size_t out_sz);
+HX4_API int hx4_halfsiphash13_32_copt_cstr   (const char *str, size_t *str_len, const void *cookie, size_t cookie_sz, void *out, size_t out_sz);
+HX4_API int hx4_x4halfsiphash13_128_ref_cstr (const char *str, size_t *str_len, const void *cookie, size_t cookie_sz, void *out, size_t out_sz);
+
+#if HX4_HAS_SSE2
+HX4_API int hx4_x4halfsiphash13_128_sse2_cstr(const char *str, size_t *str_len, const void *cookie, size_t cookie_sz, void *out, size_t out_sz);
+#endif
+
+/*
+ * copy-and-hash variants, they copy in_sz bytes from in to dst and hash them in
+ * the same pass, the hash equals the one of the function without _copy
+ * dst must not overlap in, cookie or out
+ */
+
+/* copies of at least this size use non-temporal stores that do not pull dst into the cache */
+#ifndef HX4_COPY_STREAM_MIN_SIZE
+# define HX4_COPY_STREAM_MIN_SIZE (1024*1024)
+#endif
+
+#if HX4_HAS_SSE2
+HX4_API int hx4_x4djbx33a_128_sse2_copy     (void *dst, const void *in, size_t in_sz, const void *cookie, size_t cookie_sz, void *out, size_t out_sz);
+HX4_API int hx4_x4siphash13_256_sse2_copy   (void *dst, const void *in, size_t in_sz, const void *cookie, size_t cookie_sz, void *out, size_t out_sz);
+HX4_API int hx4_x4halfsiphash13_128_sse2_copy(void *dst, const void *in, size_t in_sz, const void *cookie, size_t cookie_sz, void *out, size_t out_sz);
+#endif
+
+#if HX4_HAS_SSSE3
+HX4_API int hx4_x4djbx33a_128_ssse3_copy    (void *dst, const void *in, size_t in_sz, const void *cookie, size_t cookie_sz, void *out, size_t out_sz);
+#endif
+
+/*
+ * case-insensitive variants for ASCII keys like HTTP header names, hostnames
+ * or SQL identifiers, A-Z are folded to a-z while the input is hashed, the
+ * result equals the one of the function without _ci on the lowercased input,
+ * all other bytes are hashed unchanged
+ */
+
+HX4_API int hx4_djbx33a_32_ref_ci     (const void *in, size_t in_sz, const void *cookie, size_t cookie_sz, void *out, size_t out_sz);
+HX4_API int hx4_djbx33a_32_copt_ci    (const void *in, size_t in_sz, const void *cookie, size_t cookie_sz, void *out, size_t out_sz);
+HX4_API int hx4_x4djbx33a_128_ref_ci  (const void *in, size_t in_sz, const void *cookie, size_t cookie_sz, void *out, size_t out_sz);
+HX4_API int hx4_x4djbx33a_128_copt_ci (const void *in, size_t in_sz, const void *cookie, size_t cookie_sz, void *out, size_t out_sz);
+
+#if HX4_HAS_SSE2
+HX4_API int hx4_x4djbx33a_128_sse2_ci (const void *in, size_t in_sz, const void *cookie, size_t cookie_sz, void *out, size_t out_sz);
+#endif
+
+#if HX4_HAS_SSSE3
+HX4_API int hx4_x4djbx33a_128_ssse3_ci(const void *in, size_t in_sz, const void *cookie, size_t cookie_sz, void *out, size_t out_sz);
+#endif
+
+HX4_API int hx4_siphash24_64_ref_ci   (const void *in, size_t in_sz, const void *cookie, size_t cookie_sz, void *out, size_t out_sz);
+HX4_API int hx4_siphash24_64_copt_ci  (const void *in, size_t in_sz, const void *cookie, size_t cookie_sz, void *out, size_t out_sz);
+HX4_API int hx4_siphash13_64_ref_ci   (const void *in, size_t in_sz, const void *cookie, size_t cookie_sz, void *out, size_t out_sz);
+HX4_API int hx4_siphash13_64_copt_ci  (const void *in, size_t in_sz, const void *cookie, size_t cookie_sz, void *out, size_t out_sz);
+
+/* bulk hashing of integer columns, every element is hashed as an independent key */
+HX4_API int hx4_hash_u32_array       (const uint32_t *keys, size_t n, const void *cookie, size_t cookie_sz, uint32_t *out);
+HX4_API int hx4_hash_u64_array       (const uint64_t *keys, size_t n, const void *cookie, size_t cookie_sz, uint64_t *out);
+HX4_API int hx4_hash_u128_array      (const void *keys, size_t n, const void *cookie, size_t cookie_sz, uint64_t *out);
+
+HX4_API int hx4_hash_u32_array_ref   (const uint32_t *keys, size_t n, const void *cookie, size_t cookie_sz, uint32_t *out);
+HX4_API int hx4_hash_u64_array_ref   (const uint64_t *keys, size_t n, const void *cookie, size_t cookie_sz, uint64_t *out);
+HX4_API int hx4_hash_u128_array_ref  (const void *keys, size_t n, const void *cookie, size_t cookie_sz, uint64_t *out);
+
+#if HX4_HAS_SSE2
+HX4_API int hx4_hash_u32_array_sse2  (const uint32_t *keys, size_t n, const void *cookie, size_t cookie_sz, uint32_t *out);
+HX4_API int hx4_hash_u64_array_sse2  (const uint64_t *keys, size_t n, const void *cookie, size_t cookie_sz, uint64_t *out);
+HX4_API int hx4_hash_u128_array_sse2 (const void *keys, size_t n, const void *cookie, size_t cookie_sz, uint64_t *out);
+#endif
+
+#if HX4_HAS_AVX2
+HX4_API int hx4_hash_u32_array_avx2  (const uint32_t *keys, size_t n, const void *cookie, size_t cookie_sz, uint32_t *out);
+HX4_API int hx4_hash_u64_array_avx2  (const uint64_t *keys, size_t n, const void *cookie, size_t cookie_sz, uint64_t *out);
+HX4_API int hx4_hash_u128_array_avx2 (const void *keys, size_t n, const void *cookie, size_t cookie_sz, uint64_t *out);
+#endif
 
 
 #ifdef __cplusplus
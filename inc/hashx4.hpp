@@ -0,0 +1,412 @@
+#ifndef HASHX4_HPP
+#define HASHX4_HPP
+/* 
+ * Copyright 2015 Kai Dietrich <mail@cleeus.de>
+ *
+ * This file is part of hashx4.
+ *
+ * Hashx4 is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Hashx4 is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with hashx4.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/*
+ * C++17 interface.
+ *
+ *   hx4::djbx33a_32(s, cookie), hx4::x4djbx33a_128(s, cookie)
+ *     constexpr versions of djbx33a and x4djbx33a, so the hash of a string
+ *     literal is known at compile time, for switch on string and for static
+ *     tables. djbx33a_32 returns the 4 output bytes as a little endian
+ *     uint32_t, x4djbx33a_128 the 16 output bytes.
+ *
+ *   hx4::algo::<name>
+ *     one tag per algorithm, naming the fastest kernel the build enables:
+ *     x4djbx33a_128 is the ssse3 kernel with -mssse3 and the copt kernel
+ *     without SSE2. The choice is made by the preprocessor, there is no
+ *     runtime dispatch (see hashx4_dispatch.h for that).
+ *
+ *   hx4::hash<Algo>(in, in_sz, cookie), hx4::hash<Algo>(s, cookie)
+ *     the digest of Algo as a std::array of Algo::output_size bytes
+ *
+ *   hx4::hasher<Algo>
+ *     a hash functor for std::unordered_map and std::unordered_set, for
+ *     std::string and std::string_view keys. It returns hx4::fold() of the
+ *     digest and keeps the cookie. A default constructed hasher has a zero
+ *     cookie.
+ *
+ *   hx4::fold(digest)
+ *     the digest as std::size_t, every 64bit word of it is mixed in. The
+ *     first 8 bytes alone only hold 2 of the 4 lanes of an x4 function, so
+ *     keys that differ only in the other lanes would all collide.
+ *
+ *   hx4::job<Algo>
+ *     hashes an input in time slices (see hashx4_job.h): step() hashes at
+ *     most max_bytes bytes or for about max_time and returns true while
+ *     input is left, result() is the digest once it returns false. Only the
+ *     algorithms with a stream state (the djb and siphash families) have a
+ *     job.
+ *
+ *   hx4::hash_sliced<Algo>(in, in_sz, cookie, max_bytes, max_time) (C++20)
+ *     the same as a coroutine. Every resume() of the returned task hashes
+ *     one slice and returns true once result() is there, so an event loop
+ *     can resume it once per iteration.
+ *
+ * When hashx4.hpp is included before hashx4.h, the hash functions come from
+ * hashx4_inline.h, so the kernel is compiled into the caller. The output
+ * buffer and cookie sizes are constants then and the parameter checks fold
+ * away, the C functions keep them. After hashx4.h (also through
+ * hashx4_stats.h or another module header) the library kernels are called
+ * instead. The two kinds of translation units use different inline
+ * namespaces, so they can be linked together. hx4::job always calls into the
+ * library.
+ */
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string_view>
+
+#if defined(__cpp_impl_coroutine) && __cplusplus >= 202002L
+# include <coroutine>
+# include <exception>
+# define HX4_HAS_COROUTINES 1
+#endif
+
+#ifndef HASHX4_H
+# include "hashx4_inline.h"
+# define HX4_HPP_KERNELS inline_kernels
+#else
+# define HX4_HPP_KERNELS library_kernels
+#endif
+#include "hashx4_job.h"
+
+namespace hx4 {
+
+/* the 16 byte cookie of all hashx4 functions */
+struct cookie {
+  std::uint8_t bytes[16];
+
+  /* the little endian 32bit word i of the cookie */
+  constexpr std::uint32_t word(std::size_t i) const {
+    return  (std::uint32_t)bytes[4*i]
+         | ((std::uint32_t)bytes[4*i+1] << 8)
+         | ((std::uint32_t)bytes[4*i+2] << 16)
+         | ((std::uint32_t)bytes[4*i+3] << 24);
+  }
+};
+
+template<std::size_t N>
+using digest = std::array<std::uint8_t, N>;
+
+constexpr std::uint32_t djbx33a_32(std::string_view s, const cookie &c = cookie{}) {
+  std::uint32_t state = 5381;
+  for(std::size_t i=0; i<s.size(); i++) {
+    state = state * 33 + (std::uint8_t)s[i];
+  }
+  return state ^ c.word(0);
+}
+
+constexpr digest<16> x4djbx33a_128(std::string_view s, const cookie &c = cookie{}) {
+  std::uint32_t state[4] = { 5381, 5381, 5381, 5381 };
+  digest<16> out{};
+  for(std::size_t i=0; i<s.size(); i++) {
+    state[i % 4] = state[i % 4] * 33 + (std::uint8_t)s[i];
+  }
+  for(std::size_t i=0; i<16; i++) {
+    out[i] = (std::uint8_t)(state[i / 4] >> (8 * (i % 4))) ^ c.bytes[i];
+  }
+  return out;
+}
+
+namespace literals {
+
+/* "GET"_djbx33a is hx4::djbx33a_32("GET") with a zero cookie */
+constexpr std::uint32_t operator""_djbx33a(const char *s, std::size_t n) {
+  return djbx33a_32(std::string_view(s, n));
+}
+
+} // namespace literals
+
+typedef int (*kernel_t)(const void *in, std::size_t in_sz, const void *cookie, std::size_t cookie_sz, void *out, std::size_t out_sz);
+
+// the tags and everything that calls their kernel, see the top of the file
+inline namespace HX4_HPP_KERNELS {
+
+namespace algo {
+
+#define HX4_ALGO_TAG(tag_name, output_bits, kernel_function) \
+struct tag_name { \
+  static constexpr std::size_t output_size = (output_bits)/8; \
+  static constexpr kernel_t kernel = kernel_function; \
+  static constexpr const char *kernel_name = #kernel_function; \
+};
+
+HX4_ALGO_TAG(djbx33a_32, 32, hx4_djbx33a_32_copt)
+
+#if HX4_HAS_SSSE3
+HX4_ALGO_TAG(x4djbx33a_128, 128, hx4_x4djbx33a_128_ssse3)
+#elif HX4_HAS_SSE2
+HX4_ALGO_TAG(x4djbx33a_128, 128, hx4_x4djbx33a_128_sse2)
+#else
+HX4_ALGO_TAG(x4djbx33a_128, 128, hx4_x4djbx33a_128_copt)
+#endif
+
+HX4_ALGO_TAG(kdjbx33a_32, 32, hx4_kdjbx33a_32_copt)
+
+#if HX4_HAS_SSSE3
+HX4_ALGO_TAG(x4kdjbx33a_128, 128, hx4_x4kdjbx33a_128_ssse3)
+#elif HX4_HAS_SSE2
+HX4_ALGO_TAG(x4kdjbx33a_128, 128, hx4_x4kdjbx33a_128_sse2)
+#else
+HX4_ALGO_TAG(x4kdjbx33a_128, 128, hx4_x4kdjbx33a_128_copt)
+#endif
+
+HX4_ALGO_TAG(siphash24_64, 64, hx4_siphash24_64_copt)
+HX4_ALGO_TAG(siphash13_64, 64, hx4_siphash13_64_copt)
+
+#if HX4_HAS_SSE2
+HX4_ALGO_TAG(x4siphash13_256, 256, hx4_x4siphash13_256_sse2)
+#else
+HX4_ALGO_TAG(x4siphash13_256, 256, hx4_x4siphash13_256_ref)
+#endif
+
+HX4_ALGO_TAG(halfsiphash13_32, 32, hx4_halfsiphash13_32_copt)
+
+#if HX4_HAS_SSE2
+HX4_ALGO_TAG(x4halfsiphash13_128, 128, hx4_x4halfsiphash13_128_sse2)
+#else
+HX4_ALGO_TAG(x4halfsiphash13_128, 128, hx4_x4halfsiphash13_128_ref)
+#endif
+
+#if HX4_HAS_SSE42 && HX4_HAS_PCLMUL
+HX4_ALGO_TAG(crc32c_32, 32, hx4_crc32c_32_pclmul)
+#elif HX4_HAS_SSE42
+HX4_ALGO_TAG(crc32c_32, 32, hx4_crc32c_32_sse42)
+#else
+HX4_ALGO_TAG(crc32c_32, 32, hx4_crc32c_32_ref)
+#endif
+
+#if HX4_HAS_SSE42
+HX4_ALGO_TAG(x4crc32c_128, 128, hx4_x4crc32c_128_sse42)
+#else
+HX4_ALGO_TAG(x4crc32c_128, 128, hx4_x4crc32c_128_ref)
+#endif
+
+#if HX4_HAS_AESNI
+HX4_ALGO_TAG(x4aes_128, 128, hx4_x4aes_128_aesni)
+#else
+HX4_ALGO_TAG(x4aes_128, 128, hx4_x4aes_128_ref)
+#endif
+
+#if HX4_HAS_PCLMUL
+HX4_ALGO_TAG(polyval_128, 128, hx4_polyval_128_pclmul)
+#else
+HX4_ALGO_TAG(polyval_128, 128, hx4_polyval_128_ref)
+#endif
+
+#if HX4_HAS_AVX2
+HX4_ALGO_TAG(x4mulfold_128, 128, hx4_x4mulfold_128_avx2)
+#elif HX4_HAS_SSE2
+HX4_ALGO_TAG(x4mulfold_128, 128, hx4_x4mulfold_128_sse2)
+#else
+HX4_ALGO_TAG(x4mulfold_128, 128, hx4_x4mulfold_128_copt)
+#endif
+
+#undef HX4_ALGO_TAG
+
+} // namespace algo
+
+template<class Algo>
+inline digest<Algo::output_size> hash(const void *in, std::size_t in_sz, const cookie &c) {
+  digest<Algo::output_size> out;
+  // an empty std::string_view may have a NULL data(), the kernels reject that
+  Algo::kernel(in ? in : c.bytes, in_sz, c.bytes, sizeof(c.bytes), out.data(), out.size());
+  return out;
+}
+
+template<class Algo>
+inline digest<Algo::output_size> hash(std::string_view s, const cookie &c) {
+  return hash<Algo>(s.data(), s.size(), c);
+}
+
+template<std::size_t N>
+inline std::size_t fold(const digest<N> &d) {
+  std::uint64_t value = 0;
+  std::uint64_t word;
+  std::size_t i;
+
+  for(i=0; i<N; i+=8) {
+    word = 0;
+    std::memcpy(&word, d.data() + i, N - i < 8 ? N - i : 8);
+    value = (value ^ word) * 0x9e3779b97f4a7c15ULL;
+  }
+  // the high bits of the product depend on all bits of the words
+  return (std::size_t)(value ^ (value >> 32));
+}
+
+template<class Algo>
+class hasher {
+public:
+  /* string_view lookups in a std::string keyed container (C++20) */
+  typedef void is_transparent;
+
+  hasher() : cookie_() {}
+  explicit hasher(const cookie &c) : cookie_(c) {}
+
+  std::size_t operator()(std::string_view s) const {
+    return (*this)(s.data(), s.size());
+  }
+
+  std::size_t operator()(const void *in, std::size_t in_sz) const {
+    return fold(hash<Algo>(in, in_sz, cookie_));
+  }
+
+  const cookie &get_cookie() const {
+    return cookie_;
+  }
+
+private:
+  cookie cookie_;
+};
+
+} // inline namespace HX4_HPP_KERNELS
+
+/* the HX4_ALG_ constant of an algorithm for hx4_job */
+template<class Algo>
+struct job_algorithm;
+
+#define HX4_JOB_ALGORITHM(tag_name, algorithm) \
+template<> \
+struct job_algorithm<algo::tag_name> { \
+  static constexpr int value = (algorithm); \
+};
+
+HX4_JOB_ALGORITHM(djbx33a_32, HX4_ALG_DJBX33A_32)
+HX4_JOB_ALGORITHM(x4djbx33a_128, HX4_ALG_X4DJBX33A_128)
+HX4_JOB_ALGORITHM(kdjbx33a_32, HX4_ALG_KDJBX33A_32)
+HX4_JOB_ALGORITHM(x4kdjbx33a_128, HX4_ALG_X4KDJBX33A_128)
+HX4_JOB_ALGORITHM(siphash24_64, HX4_ALG_SIPHASH24_64)
+HX4_JOB_ALGORITHM(siphash13_64, HX4_ALG_SIPHASH13_64)
+HX4_JOB_ALGORITHM(x4siphash13_256, HX4_ALG_X4SIPHASH13_256)
+HX4_JOB_ALGORITHM(halfsiphash13_32, HX4_ALG_HALFSIPHASH13_32)
+HX4_JOB_ALGORITHM(x4halfsiphash13_128, HX4_ALG_X4HALFSIPHASH13_128)
+
+#undef HX4_JOB_ALGORITHM
+
+template<class Algo>
+class job {
+public:
+  /* the input is not copied, it has to outlive the job, throws
+   * std::invalid_argument for a NULL input with a size */
+  job(const void *in, std::size_t in_sz, const cookie &c) {
+    // an empty input may have a NULL pointer like in hx4::hash, nothing is read from it
+    if(hx4_job_init(&job_, job_algorithm<Algo>::value, in || in_sz ? in : c.bytes, in_sz, c.bytes, sizeof(c.bytes)) != HX4_ERR_SUCCESS) {
+      throw std::invalid_argument("hx4_job_init failed");
+    }
+  }
+  job(std::string_view s, const cookie &c) : job(s.data(), s.size(), c) {}
+
+  /* 0 is no limit, returns true while input is left */
+  bool step(std::size_t max_bytes, std::chrono::microseconds max_time = std::chrono::microseconds(0)) {
+    const std::int64_t us = max_time.count();
+    return hx4_job_step(&job_, max_bytes, us <= 0 ? 0 : us > UINT32_MAX ? UINT32_MAX : (std::uint32_t)us) == HX4_JOB_PENDING;
+  }
+
+  bool done() const {
+    return job_.pos == job_.in_sz;
+  }
+
+  std::size_t bytes_hashed() const {
+    return job_.pos;
+  }
+
+  /* the digest of the whole input, only valid once done() */
+  digest<Algo::output_size> result() const {
+    digest<Algo::output_size> out{};
+    hx4_job copy = job_;
+    hx4_job_final(&copy, out.data(), out.size());
+    return out;
+  }
+
+private:
+  hx4_job job_;
+};
+
+#if HX4_HAS_COROUTINES
+/* the coroutine of hash_sliced, it only runs when resumed */
+template<class Digest>
+class sliced_task {
+public:
+  struct promise_type {
+    Digest value{};
+
+    sliced_task get_return_object() {
+      return sliced_task(std::coroutine_handle<promise_type>::from_promise(*this));
+    }
+    std::suspend_always initial_suspend() noexcept { return {}; }
+    std::suspend_always final_suspend() noexcept { return {}; }
+    void return_value(const Digest &d) { value = d; }
+    void unhandled_exception() { std::terminate(); }
+  };
+
+  sliced_task(sliced_task &&other) noexcept : handle_(other.handle_) {
+    other.handle_ = nullptr;
+  }
+  sliced_task(const sliced_task &) = delete;
+  sliced_task &operator=(const sliced_task &) = delete;
+  ~sliced_task() {
+    if(handle_) {
+      handle_.destroy();
+    }
+  }
+
+  /* hashes the next slice, returns true once the digest is there */
+  bool resume() {
+    if(!handle_.done()) {
+      handle_.resume();
+    }
+    return handle_.done();
+  }
+
+  bool done() const {
+    return handle_.done();
+  }
+
+  const Digest &result() const {
+    return handle_.promise().value;
+  }
+
+private:
+  explicit sliced_task(std::coroutine_handle<promise_type> handle) : handle_(handle) {}
+
+  std::coroutine_handle<promise_type> handle_;
+};
+
+template<class Algo>
+sliced_task<digest<Algo::output_size> > hash_sliced(const void *in, std::size_t in_sz, cookie c, std::size_t max_bytes, std::chrono::microseconds max_time) {
+  job<Algo> j(in, in_sz, c);
+  while(j.step(max_bytes, max_time)) {
+    co_await std::suspend_always();
+  }
+  co_return j.result();
+}
+#endif
+
+} // namespace hx4
+
+#undef HX4_HPP_KERNELS
+
+#endif
@@ -0,0 +1,79 @@
+#ifndef HASHX4_BLOOM_H
+#define HASHX4_BLOOM_H
+/* 
+ * Copyright 2015 Kai Dietrich <mail@cleeus.de>
+ *
+ * This file is part of hashx4.
+ *
+ * Hashx4 is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Hashx4 is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with hashx4.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Cache line blocked Bloom filter on top of x4djbx33a.
+ *
+ * A key is hashed once with x4djbx33a_128 (the fastest variant the build
+ * has). The four lanes only see every fourth byte of the key each, so they
+ * are not four independent hashes. A short multiply/xorshift mix over all
+ * 128 output bits gives the block index and the probe bits instead of
+ * rehashing the key for every probe.
+ *
+ * The filter is an array of 64 byte blocks of eight 64bit words. A key
+ * sets one bit in every word of its block (k = 8), so an insert or a query
+ * touches one cache line and the probe is a single mask compare over the
+ * line, done with SSE2 or AVX2 registers.
+ *
+ * The batch functions hash a group of keys first and prefetch their blocks,
+ * then probe them, so the cache misses of the group overlap.
+ *
+ * The caller provides the memory, HX4_BLOOM_MEMORY_SIZE(num_blocks) bytes.
+ * About 10 bits per key (num_blocks = n * 10 / 512) give a false positive
+ * rate of about 1%.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include "hashx4_config.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define HX4_BLOOM_BLOCK_SIZE 64
+
+/* bytes of memory for a filter with num_blocks blocks, including the alignment slack */
+#define HX4_BLOOM_MEMORY_SIZE(num_blocks) ( (size_t)(num_blocks) * HX4_BLOOM_BLOCK_SIZE + HX4_BLOOM_BLOCK_SIZE - 1 )
+
+typedef struct {
+  uint64_t *blocks;
+  size_t num_blocks;
+  uint8_t cookie[128/8];
+} hx4_bloom;
+
+/* clears memory and sets up the filter, num_blocks is what fits into memory_sz */
+int hx4_bloom_init(hx4_bloom *bloom, void *memory, size_t memory_sz, const void *cookie, size_t cookie_sz);
+
+int hx4_bloom_insert(hx4_bloom *bloom, const void *key, size_t key_sz);
+
+/* returns 1 if the key may be in the set, 0 if it is not, or an error code */
+int hx4_bloom_query(const hx4_bloom *bloom, const void *key, size_t key_sz);
+
+/* keys[i] points to key_sizes[i] bytes, results[i] receives 1 or 0 like hx4_bloom_query */
+int hx4_bloom_insert_batch(hx4_bloom *bloom, const void *const *keys, const size_t *key_sizes, size_t n);
+int hx4_bloom_query_batch(const hx4_bloom *bloom, const void *const *keys, const size_t *key_sizes, size_t n, uint8_t *results);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -12,6 +12,36 @@
 # define HX4_HAS_SSE2 1
 # define HX4_HAS_SSSE3 1
 
+/* MSVC has no SSE4 switch, /arch:AVX implies it */
+# ifdef __AVX__
+#   define HX4_HAS_SSE41 1
+# else
+#   define HX4_HAS_SSE41 0
+# endif
+
+# ifdef __AVX__
+#   define HX4_HAS_SSE42 1
+# else
+#   define HX4_HAS_SSE42 0
+# endif
+
+# ifdef __AVX2__
+#   define HX4_HAS_AVX2 1
+# else
+#   define HX4_HAS_AVX2 0
+# endif
+
+/* MSVC has no switch for AES-NI and PCLMULQDQ, define them to 1 on the command line */
+# ifndef HX4_HAS_AESNI
+#   define HX4_HAS_AESNI 0
+# endif
+
+# ifndef HX4_HAS_PCLMUL
+#   define HX4_HAS_PCLMUL 0
+# endif
+
+# define HX4_INLINE static __inline
+
 #elif defined(__GNUC__)
 
 # ifdef __MMX__
@@ -32,8 +62,58 @@
 #   define HX4_HAS_SSSE3 0
 # endif
 
+# ifdef __SSE4_1__
+#   define HX4_HAS_SSE41 1
+# else
+#   define HX4_HAS_SSE41 0
+# endif
+
+# ifdef __SSE4_2__
+#   define HX4_HAS_SSE42 1
+# else
+#   define HX4_HAS_SSE42 0
+# endif
+
+# ifdef __AVX2__
+#   define HX4_HAS_AVX2 1
+# else
+#   define HX4_HAS_AVX2 0
+# endif
+
+# ifdef __AES__
+#   define HX4_HAS_AESNI 1
+# else
+#   define HX4_HAS_AESNI 0
+# endif
+
+# ifdef __PCLMUL__
+#   define HX4_HAS_PCLMUL 1
+# else
+#   define HX4_HAS_PCLMUL 0
+# endif
+
+# define HX4_INLINE static __inline__
+
 #else
 # error platform auto config not implemented for this compiler
 #endif
 
+/*
+ * Call, size and latency counters in the hash functions, see hashx4_stats.h.
+ * Off by default, the instrumentation is then compiled out.
+ */
+#ifndef HX4_STATS
+# define HX4_STATS 0
+#endif
+
+/*
+ * Linkage of the hash functions. hashx4_inline.h sets HX4_HEADER_ONLY and
+ * compiles the sources into the including file with static inline linkage.
+ */
+#if defined(HX4_HEADER_ONLY) && HX4_HEADER_ONLY
+# define HX4_API HX4_INLINE
+#else
+# define HX4_API
+#endif
+
 #endif
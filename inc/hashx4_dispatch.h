@@ -0,0 +1,123 @@
+#ifndef HASHX4_DISPATCH_H
+#define HASHX4_DISPATCH_H
+/* 
+ * Copyright 2015 Kai Dietrich <mail@cleeus.de>
+ *
+ * This file is part of hashx4.
+ *
+ * Hashx4 is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Hashx4 is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with hashx4.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+
+/*
+ * Runtime kernel selection by measurement.
+ *
+ * Which kernel of an algorithm is the fastest depends on the CPU and on the
+ * input size (SSSE3 beats SSE2 on some CPUs and loses on others, the SIMD
+ * kernels lose to copt on short keys). hx4_dispatch_calibrate times every
+ * kernel the build contains on one input size of each size class and keeps
+ * the fastest one in a table. All kernels of an algorithm give the same
+ * output, so the choice never changes a hash.
+ *
+ * The table can be saved to a text file together with the CPU brand string.
+ * hx4_dispatch_load only accepts a file of the same CPU whose kernels are
+ * all in this build, so later processes skip the calibration, and a profile
+ * that was copied to another machine is calibrated anew.
+ *
+ * hx4_dispatch_default calibrates a table on first use, with the profile
+ * file in the environment variable HX4_DISPATCH_PROFILE if that is set. The
+ * first call is not thread safe, make it before starting threads.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include "hashx4_config.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef int (*hx4_hash_function)(const void *in, size_t in_sz, const void *cookie, size_t cookie_sz, void *out, size_t out_sz);
+
+/* the algorithms with more than one kernel that gives the same output */
+enum {
+  HX4_ALG_DJBX33A_32,
+  HX4_ALG_X4DJBX33A_128,
+  HX4_ALG_KDJBX33A_32,
+  HX4_ALG_X4KDJBX33A_128,
+  HX4_ALG_SIPHASH24_64,
+  HX4_ALG_SIPHASH13_64,
+  HX4_ALG_X4SIPHASH13_256,
+  HX4_ALG_HALFSIPHASH13_32,
+  HX4_ALG_X4HALFSIPHASH13_128,
+  HX4_ALG_CRC32C_32,
+  HX4_ALG_X4CRC32C_128,
+  HX4_ALG_X4AES_128,
+  HX4_ALG_POLYVAL_128,
+  HX4_ALG_X4MULFOLD_128,
+  HX4_ALG_COUNT
+};
+
+/* input sizes up to 16, 64, 256 and 4096 bytes and above */
+#define HX4_DISPATCH_SIZE_CLASSES 5
+
+#define HX4_DISPATCH_CPU_SIZE 64
+
+/* scratch memory of hx4_dispatch_calibrate */
+#define HX4_DISPATCH_CALIBRATE_MEMORY_SIZE (64*1024)
+
+typedef struct {
+  /* brand string of the CPU the table was calibrated on */
+  char cpu[HX4_DISPATCH_CPU_SIZE];
+  /* kernel index per algorithm and size class, 0 is always the ref kernel */
+  uint8_t kernel[HX4_ALG_COUNT][HX4_DISPATCH_SIZE_CLASSES];
+} hx4_dispatch_table;
+
+/* fills the table with the widest kernel of the build for every size, without measuring */
+void hx4_dispatch_init(hx4_dispatch_table *table);
+
+/* measures all kernels, takes about a second */
+int hx4_dispatch_calibrate(hx4_dispatch_table *table, void *memory, size_t memory_sz);
+
+/*
+ * Returns HX4_ERR_NOT_FOUND if the file does not exist, was made on another
+ * CPU or names a kernel this build does not have, HX4_ERR_PARAM_INVALID if
+ * it is malformed. The table is only written on success.
+ */
+int hx4_dispatch_load(hx4_dispatch_table *table, const char *path);
+int hx4_dispatch_save(const hx4_dispatch_table *table, const char *path);
+
+/* loads the profile at path, or calibrates and saves it there, path may be NULL */
+int hx4_dispatch_load_or_calibrate(hx4_dispatch_table *table, const char *path, void *memory, size_t memory_sz);
+
+/* the table calibrated on first use, see above */
+const hx4_dispatch_table *hx4_dispatch_default(void);
+
+int hx4_dispatch_size_class(size_t in_sz);
+size_t hx4_dispatch_num_kernels(int algorithm);
+const char *hx4_dispatch_algorithm_name(int algorithm);
+const char *hx4_dispatch_kernel_name(int algorithm, size_t kernel);
+
+/* the kernel the table selects for in_sz bytes, NULL for an invalid algorithm */
+hx4_hash_function hx4_dispatch_function(const hx4_dispatch_table *table, int algorithm, size_t in_sz);
+
+/* hashes with the kernel the table selects, same parameters and errors as the kernels */
+int hx4_dispatch_hash(const hx4_dispatch_table *table, int algorithm, const void *in, size_t in_sz, const void *cookie, size_t cookie_sz, void *out, size_t out_sz);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
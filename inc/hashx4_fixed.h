@@ -0,0 +1,219 @@
+#ifndef HASHX4_FIXED_H
+#define HASHX4_FIXED_H
+/* 
+ * Copyright 2015 Kai Dietrich <mail@cleeus.de>
+ *
+ * This file is part of hashx4.
+ *
+ * Hashx4 is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Hashx4 is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with hashx4.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Fixed length keys (uint32_t, uint64_t, 12 byte tuples, UUIDs).
+ *
+ * The functions here are fully unrolled for one input length and inline,
+ * so there is no loop setup, no alignment seek and no parameter checks.
+ * The caller guarantees that in points to len bytes, cookie to 16 bytes
+ * and out to the output size of the algorithm.
+ * The output is the same as that of the generic functions with the same
+ * algorithm name.
+ *
+ *   void hx4_djbx33a_32_len{4,8,12,16}   (const void *in, const void *cookie, void *out);
+ *   void hx4_x4djbx33a_128_len{4,8,12,16}(const void *in, const void *cookie, void *out);
+ *   void hx4_siphash24_64_len{4,8,12,16} (const void *in, const void *cookie, void *out);
+ *   void hx4_siphash13_64_len{4,8,12,16} (const void *in, const void *cookie, void *out);
+ */
+
+#include <stdint.h>
+#include <string.h>
+#include "hashx4_config.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define HX4_FIXED_U8TO32_LE(p) \
+  (((uint32_t)((p)[0])      ) | \
+   ((uint32_t)((p)[1]) <<  8) | \
+   ((uint32_t)((p)[2]) << 16) | \
+   ((uint32_t)((p)[3]) << 24))
+
+#define HX4_FIXED_U8TO64_LE(p) \
+  ((uint64_t)HX4_FIXED_U8TO32_LE(p) | ((uint64_t)HX4_FIXED_U8TO32_LE((p) + 4) << 32))
+
+/* djbx33a */
+
+#define HX4_FIXED_DJBX33A_4BYTES(offset) \
+  state = state * 33 + p[(offset)+0]; \
+  state = state * 33 + p[(offset)+1]; \
+  state = state * 33 + p[(offset)+2]; \
+  state = state * 33 + p[(offset)+3];
+
+#define HX4_FIXED_DJBX33A_BODY_4  HX4_FIXED_DJBX33A_4BYTES(0)
+#define HX4_FIXED_DJBX33A_BODY_8  HX4_FIXED_DJBX33A_BODY_4  HX4_FIXED_DJBX33A_4BYTES(4)
+#define HX4_FIXED_DJBX33A_BODY_12 HX4_FIXED_DJBX33A_BODY_8  HX4_FIXED_DJBX33A_4BYTES(8)
+#define HX4_FIXED_DJBX33A_BODY_16 HX4_FIXED_DJBX33A_BODY_12 HX4_FIXED_DJBX33A_4BYTES(12)
+
+#define HX4_FIXED_DJBX33A_IMPL(len) \
+HX4_INLINE void hx4_djbx33a_32_len##len(const void *in, const void *cookie, void *out) { \
+  const uint8_t *p = (const uint8_t*)in; \
+  uint32_t state = 5381; \
+  uint32_t cookie_word; \
+  HX4_FIXED_DJBX33A_BODY_##len \
+  memcpy(&cookie_word, cookie, sizeof(cookie_word)); \
+  state ^= cookie_word; \
+  memcpy(out, &state, sizeof(state)); \
+}
+
+HX4_FIXED_DJBX33A_IMPL(4)
+HX4_FIXED_DJBX33A_IMPL(8)
+HX4_FIXED_DJBX33A_IMPL(12)
+HX4_FIXED_DJBX33A_IMPL(16)
+
+/* x4djbx33a, byte i goes to lane i%4 */
+
+#define HX4_FIXED_X4DJBX33A_4BYTES(offset) \
+  state[0] = state[0] * 33 + p[(offset)+0]; \
+  state[1] = state[1] * 33 + p[(offset)+1]; \
+  state[2] = state[2] * 33 + p[(offset)+2]; \
+  state[3] = state[3] * 33 + p[(offset)+3];
+
+#define HX4_FIXED_X4DJBX33A_BODY_4  HX4_FIXED_X4DJBX33A_4BYTES(0)
+#define HX4_FIXED_X4DJBX33A_BODY_8  HX4_FIXED_X4DJBX33A_BODY_4  HX4_FIXED_X4DJBX33A_4BYTES(4)
+#define HX4_FIXED_X4DJBX33A_BODY_12 HX4_FIXED_X4DJBX33A_BODY_8  HX4_FIXED_X4DJBX33A_4BYTES(8)
+#define HX4_FIXED_X4DJBX33A_BODY_16 HX4_FIXED_X4DJBX33A_BODY_12 HX4_FIXED_X4DJBX33A_4BYTES(12)
+
+#define HX4_FIXED_X4DJBX33A_IMPL(len) \
+HX4_INLINE void hx4_x4djbx33a_128_len##len(const void *in, const void *cookie, void *out) { \
+  const uint8_t *p = (const uint8_t*)in; \
+  uint32_t state[4] = { 5381, 5381, 5381, 5381 }; \
+  uint32_t cookie_words[4]; \
+  HX4_FIXED_X4DJBX33A_BODY_##len \
+  memcpy(cookie_words, cookie, sizeof(cookie_words)); \
+  state[0] ^= cookie_words[0]; \
+  state[1] ^= cookie_words[1]; \
+  state[2] ^= cookie_words[2]; \
+  state[3] ^= cookie_words[3]; \
+  memcpy(out, state, sizeof(state)); \
+}
+
+HX4_FIXED_X4DJBX33A_IMPL(4)
+HX4_FIXED_X4DJBX33A_IMPL(8)
+HX4_FIXED_X4DJBX33A_IMPL(12)
+HX4_FIXED_X4DJBX33A_IMPL(16)
+
+/* siphash */
+
+#define HX4_FIXED_ROTL(x,b) (uint64_t)( ((x) << (b)) | ( (x) >> (64 - (b))) )
+
+#define HX4_FIXED_SIPROUND \
+    v0 += v1; v1=HX4_FIXED_ROTL(v1,13); v1 ^= v0; v0=HX4_FIXED_ROTL(v0,32); \
+    v2 += v3; v3=HX4_FIXED_ROTL(v3,16); v3 ^= v2; \
+    v0 += v3; v3=HX4_FIXED_ROTL(v3,21); v3 ^= v0; \
+    v2 += v1; v1=HX4_FIXED_ROTL(v1,17); v1 ^= v2; v2=HX4_FIXED_ROTL(v2,32);
+
+#define HX4_FIXED_SIPROUNDS_1 HX4_FIXED_SIPROUND
+#define HX4_FIXED_SIPROUNDS_2 HX4_FIXED_SIPROUNDS_1 HX4_FIXED_SIPROUND
+#define HX4_FIXED_SIPROUNDS_3 HX4_FIXED_SIPROUNDS_2 HX4_FIXED_SIPROUND
+#define HX4_FIXED_SIPROUNDS_4 HX4_FIXED_SIPROUNDS_3 HX4_FIXED_SIPROUND
+
+#define HX4_FIXED_SIP_COMPRESS(offset, c_rounds) \
+  m = HX4_FIXED_U8TO64_LE(p + (offset)); \
+  v3 ^= m; \
+  HX4_FIXED_SIPROUNDS_##c_rounds \
+  v0 ^= m;
+
+#define HX4_FIXED_SIPHASH_BODY_4(c_rounds) \
+  b = ((uint64_t)4 << 56) | HX4_FIXED_U8TO32_LE(p);
+#define HX4_FIXED_SIPHASH_BODY_8(c_rounds) \
+  HX4_FIXED_SIP_COMPRESS(0, c_rounds) \
+  b = ((uint64_t)8 << 56);
+#define HX4_FIXED_SIPHASH_BODY_12(c_rounds) \
+  HX4_FIXED_SIP_COMPRESS(0, c_rounds) \
+  b = ((uint64_t)12 << 56) | HX4_FIXED_U8TO32_LE(p + 8);
+#define HX4_FIXED_SIPHASH_BODY_16(c_rounds) \
+  HX4_FIXED_SIP_COMPRESS(0, c_rounds) \
+  HX4_FIXED_SIP_COMPRESS(8, c_rounds) \
+  b = ((uint64_t)16 << 56);
+
+#define HX4_FIXED_SIPHASH_IMPL(c_rounds, d_rounds, len) \
+HX4_INLINE void hx4_siphash##c_rounds##d_rounds##_64_len##len(const void *in, const void *cookie, void *out) { \
+  const uint8_t *p = (const uint8_t*)in; \
+  const uint64_t k0 = HX4_FIXED_U8TO64_LE((const uint8_t*)cookie); \
+  const uint64_t k1 = HX4_FIXED_U8TO64_LE((const uint8_t*)cookie + 8); \
+  uint64_t v0 = 0x736f6d6570736575ULL ^ k0; \
+  uint64_t v1 = 0x646f72616e646f6dULL ^ k1; \
+  uint64_t v2 = 0x6c7967656e657261ULL ^ k0; \
+  uint64_t v3 = 0x7465646279746573ULL ^ k1; \
+  uint64_t m; \
+  uint64_t b; \
+  int i; \
+  HX4_FIXED_SIPHASH_BODY_##len(c_rounds) \
+  (void)m; \
+  v3 ^= b; \
+  HX4_FIXED_SIPROUNDS_##c_rounds \
+  v0 ^= b; \
+  v2 ^= 0xff; \
+  HX4_FIXED_SIPROUNDS_##d_rounds \
+  b = v0 ^ v1 ^ v2 ^ v3; \
+  for(i=0; i<8; i++) { \
+    ((uint8_t*)out)[i] = (uint8_t)(b >> (8*i)); \
+  } \
+}
+
+HX4_FIXED_SIPHASH_IMPL(2, 4, 4)
+HX4_FIXED_SIPHASH_IMPL(2, 4, 8)
+HX4_FIXED_SIPHASH_IMPL(2, 4, 12)
+HX4_FIXED_SIPHASH_IMPL(2, 4, 16)
+
+HX4_FIXED_SIPHASH_IMPL(1, 3, 4)
+HX4_FIXED_SIPHASH_IMPL(1, 3, 8)
+HX4_FIXED_SIPHASH_IMPL(1, 3, 12)
+HX4_FIXED_SIPHASH_IMPL(1, 3, 16)
+
+#undef HX4_FIXED_SIPHASH_IMPL
+#undef HX4_FIXED_SIPHASH_BODY_16
+#undef HX4_FIXED_SIPHASH_BODY_12
+#undef HX4_FIXED_SIPHASH_BODY_8
+#undef HX4_FIXED_SIPHASH_BODY_4
+#undef HX4_FIXED_SIP_COMPRESS
+#undef HX4_FIXED_SIPROUNDS_4
+#undef HX4_FIXED_SIPROUNDS_3
+#undef HX4_FIXED_SIPROUNDS_2
+#undef HX4_FIXED_SIPROUNDS_1
+#undef HX4_FIXED_SIPROUND
+#undef HX4_FIXED_ROTL
+
+#undef HX4_FIXED_X4DJBX33A_IMPL
+#undef HX4_FIXED_X4DJBX33A_BODY_16
+#undef HX4_FIXED_X4DJBX33A_BODY_12
+#undef HX4_FIXED_X4DJBX33A_BODY_8
+#undef HX4_FIXED_X4DJBX33A_BODY_4
+#undef HX4_FIXED_X4DJBX33A_4BYTES
+
+#undef HX4_FIXED_DJBX33A_IMPL
+#undef HX4_FIXED_DJBX33A_BODY_16
+#undef HX4_FIXED_DJBX33A_BODY_12
+#undef HX4_FIXED_DJBX33A_BODY_8
+#undef HX4_FIXED_DJBX33A_BODY_4
+#undef HX4_FIXED_DJBX33A_4BYTES
+
+#undef HX4_FIXED_U8TO64_LE
+#undef HX4_FIXED_U8TO32_LE
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,61 @@
+#ifndef HASHX4_INLINE_H
+#define HASHX4_INLINE_H
+/* 
+ * Copyright 2015 Kai Dietrich <mail@cleeus.de>
+ *
+ * This file is part of hashx4.
+ *
+ * Hashx4 is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Hashx4 is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with hashx4.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Header-only build mode.
+ *
+ * Including this header instead of hashx4.h compiles the hash functions into
+ * the including translation unit with static inline linkage. The compiler can
+ * then inline a kernel into the call site, constant-fold the parameter checks
+ * and unroll the loops for a known input size, which pays off for short keys.
+ * No linking against the hashx4 library is needed.
+ *
+ * The feature macros from hashx4_config.h apply as usual. The src/ directory
+ * has to be shipped next to inc/. The sources compile as C and as C++.
+ */
+
+#ifdef HASHX4_H
+# error "hashx4_inline.h must be included instead of hashx4.h, not after it"
+#endif
+
+// the HX4_STATS counters live in the library, the inline functions are not counted
+#undef HX4_STATS
+#define HX4_STATS 0
+
+#define HX4_HEADER_ONLY 1
+#include "hashx4.h"
+
+#include "../src/hx4_util.c"
+#include "../src/hx4_djbx33a.c"
+#include "../src/hx4_kdjbx33a.c"
+#include "../src/siphash24.c"
+#include "../src/hx4_siphash24.c"
+#include "../src/siphash13.c"
+#include "../src/hx4_siphash13.c"
+#include "../src/halfsiphash.c"
+#include "../src/hx4_halfsiphash13.c"
+#include "../src/hx4_crc32c.c"
+#include "../src/hx4_x4aes.c"
+#include "../src/hx4_polyval.c"
+#include "../src/hx4_mulfold.c"
+#include "../src/hx4_bulk.c"
+
+#endif
@@ -0,0 +1,116 @@
+#ifndef HASHX4_INTERN_H
+#define HASHX4_INTERN_H
+/* 
+ * Copyright 2015 Kai Dietrich <mail@cleeus.de>
+ *
+ * This file is part of hashx4.
+ *
+ * Hashx4 is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Hashx4 is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with hashx4.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+
+/*
+ * String interning with cached hashes.
+ *
+ * Every string is hashed once with keyed SipHash-1-3 when it is interned and
+ * copied into an arena behind an 8 byte header with the low 32 bits of the
+ * hash and the length. The handle of a string is its arena offset / 8 + 1,
+ * a 32bit number that is never 0. Equal strings get the same handle, so two
+ * interned strings are equal if their handles are, and the hash of a handle
+ * is one read of the header. Maps keyed by handles do not rehash the string.
+ *
+ * The table is open addressing with linear probing over 64bit slots of hash
+ * and handle, at most 3/4 full. The caller provides the memory,
+ * HX4_INTERN_MEMORY_SIZE(num_slots, arena_sz) bytes, and nothing ever moves,
+ * so a full table or arena fails with HX4_ERR_BUFFER_TOO_SMALL.
+ *
+ * One thread at a time may intern (the caller serializes the writers). Any
+ * number of threads may call the find functions and the handle accessors at
+ * the same time, also while a string is being interned: the writer fills the
+ * arena entry before it publishes the slot with a release store, and readers
+ * load the slots with acquire semantics.
+ *
+ * The batch functions hash a group of strings first and prefetch their
+ * slots, then probe them, so the cache misses of the group overlap.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include "hashx4_config.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* bytes of memory for a table of num_slots slots (a power of two) and an arena of arena_sz bytes */
+#define HX4_INTERN_MEMORY_SIZE(num_slots, arena_sz) ( (size_t)(num_slots) * 8 + (size_t)(arena_sz) + 7 )
+
+/* the most strings a table of num_slots slots takes */
+#define HX4_INTERN_MAX_STRINGS(num_slots) ( (size_t)(num_slots) / 4 * 3 )
+
+/* arena bytes of one string: header, the bytes and a terminating 0, rounded up to 8 */
+#define HX4_INTERN_ENTRY_SIZE(str_len) ( ((size_t)(str_len) + 8 + 1 + 7) & ~(size_t)7 )
+
+typedef struct {
+  uint64_t *slots;
+  size_t num_slots;
+  uint8_t *arena;
+  size_t arena_sz;
+  /* only used by the writer */
+  size_t arena_used;
+  size_t count;
+  uint8_t cookie[128/8];
+} hx4_intern;
+
+/*
+ * num_slots must be a power of two of at least 4 and at most 2^32. The first
+ * num_slots * 8 bytes of memory (after alignment) are the table, the rest is
+ * the arena. Handles address at most 32GiB of arena.
+ */
+int hx4_intern_init(hx4_intern *in, void *memory, size_t memory_sz, size_t num_slots, const void *cookie, size_t cookie_sz);
+
+/* interns the string and writes its handle, strings may contain 0 bytes but str is never NULL */
+int hx4_intern_add(hx4_intern *in, const void *str, size_t str_len, uint32_t *handle);
+
+/* writes the handle of an interned string, returns HX4_ERR_NOT_FOUND if it is not interned */
+int hx4_intern_find(const hx4_intern *in, const void *str, size_t str_len, uint32_t *handle);
+
+/*
+ * strs[i] points to str_lens[i] bytes. The batch intern stops at the first
+ * string that does not fit, the strings before it are interned. The batch
+ * find writes handle 0 for strings that are not interned.
+ */
+int hx4_intern_add_batch(hx4_intern *in, const void *const *strs, const size_t *str_lens, size_t n, uint32_t *handles);
+int hx4_intern_find_batch(const hx4_intern *in, const void *const *strs, const size_t *str_lens, size_t n, uint32_t *handles);
+
+/* the cached hash of an interned string, the low 32 bits of hx4_siphash13_64 with the table cookie */
+HX4_INLINE uint32_t hx4_intern_hash(const hx4_intern *in, uint32_t handle) {
+  return *(const uint32_t*)(in->arena + ((size_t)handle - 1) * 8);
+}
+
+HX4_INLINE size_t hx4_intern_len(const hx4_intern *in, uint32_t handle) {
+  return *(const uint32_t*)(in->arena + ((size_t)handle - 1) * 8 + 4);
+}
+
+/* the interned bytes, followed by a 0 byte */
+HX4_INLINE const char *hx4_intern_data(const hx4_intern *in, uint32_t handle) {
+  return (const char*)(in->arena + ((size_t)handle - 1) * 8 + 8);
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
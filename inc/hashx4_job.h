@@ -0,0 +1,87 @@
+#ifndef HASHX4_JOB_H
+#define HASHX4_JOB_H
+/* 
+ * Copyright 2015 Kai Dietrich <mail@cleeus.de>
+ *
+ * This file is part of hashx4.
+ *
+ * Hashx4 is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Hashx4 is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with hashx4.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+
+/*
+ * Resumable hashing of large inputs in time slices.
+ *
+ * Hashing a gigabyte in one call blocks a single threaded event loop for a
+ * good part of a second. A job hashes the input in slices instead: every
+ * hx4_job_step hashes at most max_bytes bytes or for about max_us
+ * microseconds and returns, the stream state (the SIMD lanes, the position
+ * and the partial words) stays in the job until the next step. The digest
+ * is the same as that of the one shot function.
+ *
+ * The time limit is checked after every HX4_JOB_CHUNK_SIZE bytes, so a
+ * step overshoots by at most one chunk (a few microseconds) and always
+ * makes progress. A limit of 0 means no limit.
+ *
+ * Jobs run the algorithms that have a stream state (the djb and siphash
+ * families, HX4_ALG_DJBX33A_32 to HX4_ALG_X4HALFSIPHASH13_128 of
+ * hashx4_dispatch.h), with the widest kernel of the build. The job may be
+ * copied or moved between steps, the input must stay where it is.
+ *
+ * hashx4.hpp wraps a job as hx4::job and, with C++20, as a coroutine.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include "hashx4_config.h"
+#include "hashx4_dispatch.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* hx4_job_step returns this while input is left */
+#define HX4_JOB_PENDING 1
+
+/* bytes hashed between two looks at the clock */
+#define HX4_JOB_CHUNK_SIZE (16*1024)
+
+/* room for the largest stream state */
+#define HX4_JOB_STREAM_SIZE 256
+
+typedef struct {
+  /* the stream state lives 16 byte aligned somewhere in here */
+  uint8_t stream[HX4_JOB_STREAM_SIZE + 15];
+  size_t stream_offset;
+  int algorithm;
+  const uint8_t *in;
+  size_t in_sz;
+  /* bytes hashed so far */
+  size_t pos;
+} hx4_job;
+
+int hx4_job_init(hx4_job *job, int algorithm, const void *in, size_t in_sz, const void *cookie, size_t cookie_sz);
+
+/* returns HX4_JOB_PENDING, HX4_ERR_SUCCESS once all input is hashed, or an error code */
+int hx4_job_step(hx4_job *job, size_t max_bytes, uint32_t max_us);
+
+/* writes the digest once, HX4_ERR_PARAM_INVALID while input is left */
+int hx4_job_final(hx4_job *job, void *out, size_t out_sz);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
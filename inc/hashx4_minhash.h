@@ -0,0 +1,83 @@
+#ifndef HASHX4_MINHASH_H
+#define HASHX4_MINHASH_H
+/* 
+ * Copyright 2015 Kai Dietrich <mail@cleeus.de>
+ *
+ * This file is part of hashx4.
+ *
+ * Hashx4 is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Hashx4 is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with hashx4.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * MinHash signatures over the byte shingles of a document.
+ *
+ * Every shingle_sz byte window of the document (1 to 8 bytes, so a shingle
+ * is a zero padded uint64_t) is hashed once with the bulk SipHash-1-3 kernel
+ * (hx4_hash_u64_array). The two 32bit halves h1 and h2 of that hash give the
+ * value of the shingle under permutation j as h1 + j*h2 mod 2^32, and
+ * signature[j] is the minimum of that over all shingles. A document shorter
+ * than one shingle is a single shingle, an empty document has a signature
+ * of all 0xffffffff.
+ *
+ * The SIMD variants keep the minima of 16 permutations in registers while
+ * they stream over a block of shingles, so a document is read once.
+ * The fraction of equal signature entries estimates the Jaccard similarity
+ * of the shingle sets of two documents.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include "hashx4_config.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define HX4_MINHASH_MAX_SHINGLE_SIZE 8
+/* num_hashes is a multiple of HX4_MINHASH_HASH_STEP up to HX4_MINHASH_MAX_HASHES */
+#define HX4_MINHASH_HASH_STEP 16
+#define HX4_MINHASH_MAX_HASHES 256
+
+typedef struct {
+  size_t shingle_sz;
+  size_t num_hashes;
+  uint8_t cookie[128/8];
+} hx4_minhash;
+
+int hx4_minhash_init(hx4_minhash *minhash, size_t shingle_sz, size_t num_hashes, const void *cookie, size_t cookie_sz);
+
+/* signature receives minhash->num_hashes values */
+int hx4_minhash_signature     (const hx4_minhash *minhash, const void *doc, size_t doc_sz, uint32_t *signature);
+int hx4_minhash_signature_ref (const hx4_minhash *minhash, const void *doc, size_t doc_sz, uint32_t *signature);
+
+#if HX4_HAS_SSE2
+int hx4_minhash_signature_sse2(const hx4_minhash *minhash, const void *doc, size_t doc_sz, uint32_t *signature);
+#endif
+
+#if HX4_HAS_SSE41
+int hx4_minhash_signature_sse41(const hx4_minhash *minhash, const void *doc, size_t doc_sz, uint32_t *signature);
+#endif
+
+#if HX4_HAS_AVX2
+int hx4_minhash_signature_avx2(const hx4_minhash *minhash, const void *doc, size_t doc_sz, uint32_t *signature);
+#endif
+
+/* the fraction of equal entries of two signatures */
+int hx4_minhash_similarity(const uint32_t *a, const uint32_t *b, size_t num_hashes, double *similarity);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,81 @@
+#ifndef HASHX4_PARTITION_H
+#define HASHX4_PARTITION_H
+/* 
+ * Copyright 2015 Kai Dietrich <mail@cleeus.de>
+ *
+ * This file is part of hashx4.
+ *
+ * Hashx4 is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Hashx4 is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with hashx4.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Hash partitioning of (key, payload) columns, the first step of a radix hash join.
+ *
+ * A partition run has three phases:
+ *   1. hx4_partition_histogram hashes the keys (hx4_hash_u64_array), keeps the
+ *      partition id of every row in a pids scratch array and counts the rows
+ *      per partition.
+ *   2. hx4_partition_prefix_sum turns the histograms into write cursors.
+ *   3. hx4_partition_scatter writes the tuples to their partitions. It collects
+ *      the tuples of each partition in a cache line sized software write
+ *      combining buffer and writes full lines with non-temporal stores, so the
+ *      output does not evict the working set and is not read before it is written.
+ *
+ * For a parallel run every thread does phase 1 on its own chunk of rows with its
+ * own histogram, one thread does phase 2 over all histograms once they are done,
+ * then every thread does phase 3 on its chunk with its own cursors and buffers.
+ * The caller owns the threads and the barriers between the phases.
+ * hx4_partition_u64 does all three phases for a single thread.
+ *
+ * The partition id is the top bits of the 64bit hash, so 2^bits partitions
+ * with 0 <= bits <= HX4_PARTITION_MAX_BITS.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include "hashx4_config.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define HX4_PARTITION_MAX_BITS 16
+
+/* size in bytes of the write combining scratch that hx4_partition_scatter needs */
+#define HX4_PARTITION_SWWC_SIZE(bits) ( ((size_t)1 << (bits)) * (64 + sizeof(size_t)) + 64 )
+
+typedef struct {
+  uint64_t key;
+  uint64_t payload;
+} hx4_tuple;
+
+/* pids: n entries, histogram: 2^bits entries, overwritten */
+int hx4_partition_histogram(const uint64_t *keys, size_t n, const void *cookie, size_t cookie_sz, int bits, uint16_t *pids, size_t *histogram);
+
+/* histograms: num_histograms consecutive arrays of 2^bits counts, replaced by the first
+ * output index of every partition and histogram. partition_offsets may be NULL, otherwise
+ * it receives the 2^bits+1 partition boundaries. */
+int hx4_partition_prefix_sum(size_t *histograms, size_t num_histograms, int bits, size_t *partition_offsets);
+
+/* cursors: the 2^bits entries that hx4_partition_prefix_sum made for this chunk, advanced */
+int hx4_partition_scatter(const uint64_t *keys, const uint64_t *payloads, const uint16_t *pids, size_t n, int bits, size_t *cursors, void *swwc, size_t swwc_sz, hx4_tuple *out);
+
+/* all three phases, partition_offsets: 2^bits+1 entries */
+int hx4_partition_u64(const uint64_t *keys, const uint64_t *payloads, size_t n, const void *cookie, size_t cookie_sz, int bits, uint16_t *pids, void *swwc, size_t swwc_sz, hx4_tuple *out, size_t *partition_offsets);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
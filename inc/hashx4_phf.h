@@ -0,0 +1,85 @@
+#ifndef HASHX4_PHF_H
+#define HASHX4_PHF_H
+/* 
+ * Copyright 2015 Kai Dietrich <mail@cleeus.de>
+ *
+ * This file is part of hashx4.
+ *
+ * Hashx4 is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Hashx4 is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with hashx4.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/*
+ * Minimal perfect hashing of static key sets (CHD, hash and displace).
+ *
+ * A key is hashed once with x4djbx33a_128 and mixed over all lanes like in
+ * the Bloom filter. The cookie only goes into the final mix, so keys with
+ * equal x4djbx33a states (the lanes are plain sums, e.g. "A...b" and "B...A"
+ * four bytes apart) fail the build for every cookie. The mix gives a bucket
+ * (about 4 keys per bucket) and a 64bit value. Each bucket has a
+ * displacement d, and the slot of a key is the mix of its value and d
+ * reduced to 0 .. num_keys-1. The builder places the largest buckets first
+ * and searches the smallest d that moves all keys of a bucket to free slots.
+ * If a bucket needs more than HX4_PHF_MAX_DISPLACEMENT tries it gives up
+ * with HX4_ERR_SEARCH_FAILED, and the caller tries the next cookie.
+ *
+ * The keys are stored in slot order, so a lookup is one hash, one read of the
+ * displacement table and one memcmp against the key in the slot.
+ *
+ * util/hx4phf.c builds tables at build time and writes them out as C.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include "hashx4_config.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define HX4_PHF_NUM_BUCKETS(num_keys) ( ((size_t)(num_keys) + 3) / 4 )
+#define HX4_PHF_MAX_DISPLACEMENT 0x1000000
+
+/* scratch memory of hx4_phf_build */
+#define HX4_PHF_BUILD_MEMORY_SIZE(num_keys) \
+  ( (size_t)(num_keys) * (8 + 4 + 4 + 1) + (HX4_PHF_NUM_BUCKETS(num_keys) + 1) * 4 + 8 )
+
+typedef struct {
+  uint8_t cookie[128/8];
+  uint32_t num_keys;
+  uint32_t num_buckets;
+  /* num_buckets displacements */
+  const uint32_t *displacements;
+  /* the key in slot i is key_data[key_offsets[i]] .. key_data[key_offsets[i+1]-1] */
+  const uint32_t *key_offsets;
+  const char *key_data;
+} hx4_phf;
+
+/*
+ * keys[i] points to key_sizes[i] bytes. Fills HX4_PHF_NUM_BUCKETS(n)
+ * displacements and the slot of every key, slots is a permutation of 0 .. n-1.
+ * Returns HX4_ERR_PARAM_INVALID for duplicate keys and HX4_ERR_SEARCH_FAILED
+ * if there is no table for this cookie.
+ */
+int hx4_phf_build(const void *const *keys, const size_t *key_sizes, size_t n, const void *cookie, size_t cookie_sz,
+                  uint32_t *displacements, uint32_t *slots, void *memory, size_t memory_sz);
+
+/* returns the slot of the key, HX4_ERR_NOT_FOUND if it is not in the set, or an error code */
+int hx4_phf_lookup(const hx4_phf *phf, const void *key, size_t key_sz);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
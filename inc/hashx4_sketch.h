@@ -0,0 +1,106 @@
+#ifndef HASHX4_SKETCH_H
+#define HASHX4_SKETCH_H
+/* 
+ * Copyright 2015 Kai Dietrich <mail@cleeus.de>
+ *
+ * This file is part of hashx4.
+ *
+ * Hashx4 is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Hashx4 is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with hashx4.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * HyperLogLog (distinct counts) and Count-Min (frequencies) sketches.
+ *
+ * Both sketches eat 64bit keyed hashes: SipHash-1-3 of the key bytes with
+ * the cookie of the sketch. A uint64_t key hashes the same as its 8 little
+ * endian bytes, so the _u64_batch functions (which hash with the SIMD bulk
+ * kernel, hx4_hash_u64_array) and the byte key functions can be mixed on one
+ * sketch. The _hashes functions take hashes that were made elsewhere with
+ * the same function.
+ *
+ * HyperLogLog starts with a sparse list of (register, rank) entries at the
+ * HyperLogLog++ sparse precision 25 and estimates with linear counting over
+ * those 2^25 registers, which is nearly exact for small sets where the dense
+ * registers are off by 1.04/sqrt(2^precision). Once the list holds more than
+ * 3/32 * 2^precision distinct entries they are folded down to 2^precision
+ * dense byte registers. Two sketches with the same precision and cookie merge
+ * into the union of their sets.
+ *
+ * Count-Min has depth rows of width uint32_t counters, width a power of two.
+ * Row i uses the index h1 + i*h2 of the two halves of the hash. Queries never
+ * underestimate and overestimate by at most e*N/width with probability
+ * 1 - e^-depth. Two sketches with the same shape and cookie merge by adding.
+ *
+ * All memory comes from the caller.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include "hashx4_config.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define HX4_HLL_MIN_PRECISION 4
+#define HX4_HLL_MAX_PRECISION 18
+
+/* 2^precision registers and the sparse list of 2^precision / 8 uint32_t
+ * entries behind them, plus alignment slack */
+#define HX4_HLL_MEMORY_SIZE(precision) ( ((size_t)3 << (precision)) / 2 + 15 )
+
+typedef struct {
+  uint8_t *registers;
+  uint32_t *sparse;
+  size_t sparse_count;
+  size_t sparse_capacity;
+  int precision;
+  int dense;
+  uint8_t cookie[128/8];
+} hx4_hll;
+
+int hx4_hll_init(hx4_hll *hll, int precision, void *memory, size_t memory_sz, const void *cookie, size_t cookie_sz);
+int hx4_hll_add(hx4_hll *hll, const void *key, size_t key_sz);
+int hx4_hll_add_batch(hx4_hll *hll, const void *const *keys, const size_t *key_sizes, size_t n);
+int hx4_hll_add_u64_batch(hx4_hll *hll, const uint64_t *keys, size_t n);
+int hx4_hll_add_hashes(hx4_hll *hll, const uint64_t *hashes, size_t n);
+int hx4_hll_merge(hx4_hll *dst, const hx4_hll *src);
+/* may compact the sparse list, hence not const */
+int hx4_hll_estimate(hx4_hll *hll, double *estimate);
+
+#define HX4_CMS_MAX_DEPTH 8
+
+#define HX4_CMS_MEMORY_SIZE(width, depth) ( (size_t)(width) * (size_t)(depth) * sizeof(uint32_t) )
+
+typedef struct {
+  uint32_t *counters;
+  size_t width;
+  int depth;
+  uint8_t cookie[128/8];
+} hx4_cms;
+
+int hx4_cms_init(hx4_cms *cms, size_t width, int depth, void *memory, size_t memory_sz, const void *cookie, size_t cookie_sz);
+int hx4_cms_add(hx4_cms *cms, const void *key, size_t key_sz, uint32_t count);
+int hx4_cms_add_batch(hx4_cms *cms, const void *const *keys, const size_t *key_sizes, size_t n);
+int hx4_cms_add_u64_batch(hx4_cms *cms, const uint64_t *keys, size_t n);
+int hx4_cms_add_hashes(hx4_cms *cms, const uint64_t *hashes, size_t n);
+int hx4_cms_query(const hx4_cms *cms, const void *key, size_t key_sz, uint32_t *count);
+int hx4_cms_query_u64_batch(const hx4_cms *cms, const uint64_t *keys, size_t n, uint32_t *counts);
+int hx4_cms_merge(hx4_cms *dst, const hx4_cms *src);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,160 @@
+#ifndef HASHX4_STATS_H
+#define HASHX4_STATS_H
+/* 
+ * Copyright 2015 Kai Dietrich <mail@cleeus.de>
+ *
+ * This file is part of hashx4.
+ *
+ * Hashx4 is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Hashx4 is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with hashx4.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/*
+ * Counters of the hash functions, for finding out in production which
+ * kernels run, at which input sizes and how long they take.
+ *
+ * The library counts only when it is built with HX4_STATS=1 (cmake
+ * -DHX4_STATS=ON). Otherwise the instrumentation is compiled out of the hash
+ * functions and hx4_stats_snapshot returns HX4_ERR_NOT_FOUND.
+ *
+ * Every call of a public hash function adds to the counters of its kernel:
+ * the _v, _ci, _cstr and _copy variants count for the kernel they are
+ * built on, and the ref bulk functions also count the halfsiphash13 and
+ * siphash13 calls they make per key. Every HX4_STATS_SAMPLE_INTERVAL-th call
+ * of a kernel in a thread is timed with the time stamp counter.
+ *
+ * Each thread writes to its own cache line aligned slot of counters, so the
+ * threads do not contend. The first HX4_STATS_MAX_THREADS threads get a
+ * slot, all later ones share the last slot and may lose counts.
+ * hx4_stats_snapshot sums up the slots of all threads, the counts of
+ * threads that hash at the same time may be a call behind.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include "hashx4.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define HX4_STATS_KERNELS(X) \
+  X(hx4_djbx33a_32_ref) \
+  X(hx4_djbx33a_32_copt) \
+  X(hx4_x4djbx33a_128_ref) \
+  X(hx4_x4djbx33a_128_copt) \
+  X(hx4_x4djbx33a_128_mmx) \
+  X(hx4_x4djbx33a_128_sse2) \
+  X(hx4_x4djbx33a_128_sse2rle) \
+  X(hx4_x4djbx33a_128_ssse3) \
+  X(hx4_kdjbx33a_32_ref) \
+  X(hx4_kdjbx33a_32_copt) \
+  X(hx4_x4kdjbx33a_128_ref) \
+  X(hx4_x4kdjbx33a_128_copt) \
+  X(hx4_x4kdjbx33a_128_sse2) \
+  X(hx4_x4kdjbx33a_128_ssse3) \
+  X(hx4_siphash24_64_ref) \
+  X(hx4_siphash24_64_copt) \
+  X(hx4_siphash13_64_ref) \
+  X(hx4_siphash13_64_copt) \
+  X(hx4_x4siphash13_256_ref) \
+  X(hx4_x4siphash13_256_sse2) \
+  X(hx4_halfsiphash13_32_ref) \
+  X(hx4_halfsiphash13_32_copt) \
+  X(hx4_x4halfsiphash13_128_ref) \
+  X(hx4_x4halfsiphash13_128_sse2) \
+  X(hx4_crc32c_32_ref) \
+  X(hx4_x4crc32c_128_ref) \
+  X(hx4_crc32c_32_sse42) \
+  X(hx4_x4crc32c_128_sse42) \
+  X(hx4_crc32c_32_pclmul) \
+  X(hx4_x4aes_128_ref) \
+  X(hx4_x4aes_128_aesni) \
+  X(hx4_polyval_128_ref) \
+  X(hx4_polyval_128_pclmul) \
+  X(hx4_x4mulfold_128_ref) \
+  X(hx4_x4mulfold_128_copt) \
+  X(hx4_x4mulfold_128_sse2) \
+  X(hx4_x4mulfold_128_avx2) \
+  X(hx4_hash_u32_array_ref) \
+  X(hx4_hash_u32_array_sse2) \
+  X(hx4_hash_u32_array_avx2) \
+  X(hx4_hash_u64_array_ref) \
+  X(hx4_hash_u64_array_sse2) \
+  X(hx4_hash_u64_array_avx2) \
+  X(hx4_hash_u128_array_ref) \
+  X(hx4_hash_u128_array_sse2) \
+  X(hx4_hash_u128_array_avx2)
+
+/* HX4_STATS_hx4_djbx33a_32_ref and so on, the index of a kernel in hx4_stats */
+#define HX4_STATS_KERNEL_ENUM(name) HX4_STATS_##name,
+enum {
+  HX4_STATS_KERNELS(HX4_STATS_KERNEL_ENUM)
+  HX4_STATS_KERNEL_COUNT
+};
+#undef HX4_STATS_KERNEL_ENUM
+
+/* bucket 0 counts empty inputs, bucket b inputs of 2^(b-1) to 2^b-1 bytes,
+ * the last bucket everything from 2^(HX4_STATS_HISTOGRAM_SIZE-2) bytes up */
+#define HX4_STATS_HISTOGRAM_SIZE 34
+
+#ifndef HX4_STATS_MAX_THREADS
+# define HX4_STATS_MAX_THREADS 64
+#endif
+
+/* a power of two */
+#ifndef HX4_STATS_SAMPLE_INTERVAL
+# define HX4_STATS_SAMPLE_INTERVAL 64
+#endif
+
+typedef struct {
+  uint64_t calls;
+  uint64_t bytes;
+  uint64_t size_histogram[HX4_STATS_HISTOGRAM_SIZE];
+  /* the timed calls, the sum and the maximum of their time stamp counter cycles */
+  uint64_t latency_samples;
+  uint64_t latency_cycles;
+  uint64_t latency_max_cycles;
+} hx4_stats_counters;
+
+typedef struct {
+  hx4_stats_counters kernel[HX4_STATS_KERNEL_COUNT];
+  /* the threads that have hashed since the start of the process */
+  size_t threads;
+} hx4_stats;
+
+/* the sum of the counters of all threads */
+int hx4_stats_snapshot(hx4_stats *snapshot);
+
+/* zeroes the counters of all threads, call it while no thread hashes */
+void hx4_stats_reset(void);
+
+/* the function name of a kernel, NULL for an invalid index */
+const char *hx4_stats_kernel_name(int kernel);
+
+/* the input size bucket of the histograms */
+int hx4_stats_size_bucket(uint64_t in_sz);
+
+#if HX4_STATS
+/* called by the instrumented hash functions */
+uint64_t hx4_stats_begin(int kernel);
+void hx4_stats_end(int kernel, uint64_t in_sz, uint64_t start);
+uint64_t hx4_stats_iov_size(const hx4_iovec *iov, size_t iov_cnt);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,119 @@
+/*
+   HalfSipHash reference C implementation
+
+   Written in 2016 by
+   Jean-Philippe Aumasson <jeanphilippe.aumasson@gmail.com>
+
+   To the extent possible under law, the author(s) have dedicated all copyright
+   and related and neighboring rights to this software to the public domain
+   worldwide. This software is distributed without any warranty.
+
+   You should have received a copy of the CC0 Public Domain Dedication along with
+   this software. If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.
+*/
+#include <stdint.h>
+#include <string.h>
+
+#include "hashx4.h"
+#include "hx4_util.h"
+
+/* HalfSipHash-1-3, 32bit output, as used by the Linux kernel for hash tables */
+#define cROUNDS 1
+#define dROUNDS 3
+
+// the siphash sources share these in the header-only build
+#ifndef HX4_SIPHASH_TYPEDEFS
+#define HX4_SIPHASH_TYPEDEFS
+typedef uint64_t u64;
+typedef uint32_t u32;
+typedef uint8_t u8;
+#endif
+
+#define ROTL(x,b) (u32)( ((x) << (b)) | ( (x) >> (32 - (b))) )
+
+#define U32TO8_LE(p, v)         \
+    (p)[0] = (u8)((v)      ); (p)[1] = (u8)((v) >>  8); \
+    (p)[2] = (u8)((v) >> 16); (p)[3] = (u8)((v) >> 24);
+
+#define U8TO32_LE(p) \
+  (((u32)((p)[0])      ) | \
+   ((u32)((p)[1]) <<  8) | \
+   ((u32)((p)[2]) << 16) | \
+   ((u32)((p)[3]) << 24))
+
+#define SIPROUND            \
+  do {              \
+    v0 += v1; v1=ROTL(v1, 5); v1 ^= v0; v0=ROTL(v0,16); \
+    v2 += v3; v3=ROTL(v3, 8); v3 ^= v2;     \
+    v0 += v3; v3=ROTL(v3, 7); v3 ^= v0;     \
+    v2 += v1; v1=ROTL(v1,13); v1 ^= v2; v2=ROTL(v2,16); \
+  } while(0)
+
+static int halfsiphash( unsigned char *out, const unsigned char *in, size_t inlen, const unsigned char *k )
+{
+  u32 v0 = 0;
+  u32 v1 = 0;
+  u32 v2 = 0x6c796765;
+  u32 v3 = 0x74656462;
+  u32 b;
+  u32 k0 = U8TO32_LE( k );
+  u32 k1 = U8TO32_LE( k + 4 );
+  u32 m;
+  int i;
+  const u8 *end = in + inlen - ( inlen % sizeof( u32 ) );
+  const int left = inlen & 3;
+  b = ( ( u32 )inlen ) << 24;
+  v3 ^= k1;
+  v2 ^= k0;
+  v1 ^= k1;
+  v0 ^= k0;
+
+  for ( ; in != end; in += 4 )
+  {
+    m = U8TO32_LE( in );
+    v3 ^= m;
+    for( i = 0; i < cROUNDS; ++i ) SIPROUND;
+    v0 ^= m;
+  }
+
+  switch( left )
+  {
+  case 3: b |= ( ( u32 )in[ 2] )  << 16;
+  case 2: b |= ( ( u32 )in[ 1] )  <<  8;
+  case 1: b |= ( ( u32 )in[ 0] ); break;
+  case 0: break;
+  }
+
+  v3 ^= b;
+  for( i = 0; i < cROUNDS; ++i ) SIPROUND;
+  v0 ^= b;
+
+  v2 ^= 0xff;
+  for( i = 0; i < dROUNDS; ++i ) SIPROUND;
+  b = v1 ^ v3;
+  U32TO8_LE( out, b );
+
+  return 0;
+}
+
+HX4_API int hx4_halfsiphash13_32_ref(const void *in, size_t in_sz, const void *cookie, size_t cookie_sz, void *out, size_t out_sz) {
+  int rc;
+  HX4_STATS_BEGIN(hx4_halfsiphash13_32_ref)
+
+  rc = hx4_check_params(32/8, in, in_sz, cookie, cookie_sz, out, out_sz);
+  if(rc != HX4_ERR_SUCCESS) {
+    return rc;
+  }
+
+  halfsiphash((unsigned char*)out, (const unsigned char*)in, in_sz, (const unsigned char*)cookie);
+
+  HX4_STATS_END(hx4_halfsiphash13_32_ref, in_sz)
+  return HX4_ERR_SUCCESS;
+}
+
+#undef ROTL
+#undef SIPROUND
+#undef U32TO8_LE
+#undef U8TO32_LE
+#undef cROUNDS
+#undef dROUNDS
@@ -0,0 +1,280 @@
+/* 
+ * Copyright 2015 Kai Dietrich <mail@cleeus.de>
+ *
+ * This file is part of hashx4.
+ *
+ * Hashx4 is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Hashx4 is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with hashx4.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "hashx4_config.h"
+
+#if HX4_HAS_SSE2
+# include <emmintrin.h>
+#endif
+
+#if HX4_HAS_AVX2
+# include <immintrin.h>
+#endif
+
+#include "hashx4.h"
+#include "hashx4_bloom.h"
+#include "hx4_util.h"
+
+// keys hashed and prefetched ahead of the probes in the batch functions
+#define HX4_BLOOM_BATCH 16
+
+#define U8TO32_LE(p)                                                           \
+  (((uint32_t)((p)[0])) | ((uint32_t)((p)[1]) << 8) |                          \
+   ((uint32_t)((p)[2]) << 16) | ((uint32_t)((p)[3]) << 24))
+
+#define U8TO64_LE(p) \
+  (((uint64_t)U8TO32_LE(p)) | ((uint64_t)U8TO32_LE((p) + 4) << 32))
+
+// where a key goes: the block and eight 6 bit positions, one per word
+typedef struct {
+  const uint64_t *block;
+  uint64_t bits;
+} hx4_bloom_probe;
+
+static uint64_t hx4_bloom_fmix64(uint64_t k) {
+  k ^= k >> 33;
+  k *= 0xff51afd7ed558ccdULL;
+  k ^= k >> 33;
+  k *= 0xc4ceb9fe1a85ec53ULL;
+  k ^= k >> 33;
+  return k;
+}
+
+static int hx4_bloom_hash(const hx4_bloom *bloom, const void *key, size_t key_sz, hx4_bloom_probe *probe) {
+  uint8_t x4[128/8];
+  uint64_t a, b;
+  uint64_t m0, m1;
+  int rc;
+
+#if HX4_HAS_SSSE3
+  rc = hx4_x4djbx33a_128_ssse3(key, key_sz, bloom->cookie, sizeof(bloom->cookie), x4, sizeof(x4));
+#elif HX4_HAS_SSE2
+  rc = hx4_x4djbx33a_128_sse2(key, key_sz, bloom->cookie, sizeof(bloom->cookie), x4, sizeof(x4));
+#else
+  rc = hx4_x4djbx33a_128_copt(key, key_sz, bloom->cookie, sizeof(bloom->cookie), x4, sizeof(x4));
+#endif
+  if(rc != HX4_ERR_SUCCESS) {
+    return rc;
+  }
+
+  //every lane only saw every fourth byte, mix them all into both words
+  a = U8TO64_LE(x4);
+  b = U8TO64_LE(x4 + 8);
+  m0 = hx4_bloom_fmix64(a ^ (b * 0x9e3779b97f4a7c15ULL));
+  m1 = hx4_bloom_fmix64(b ^ m0);
+
+  //multiply and shift instead of a modulo, num_blocks is at most 2^32
+  probe->block = bloom->blocks + 8 * (size_t)(((m0 >> 32) * (uint64_t)bloom->num_blocks) >> 32);
+  probe->bits = m1;
+  return HX4_ERR_SUCCESS;
+}
+
+#if HX4_HAS_AVX2
+// the two halves of the line mask, word j gets bit (bits >> 6j) & 63
+#define HX4_AVX2_BLOOM_MASKS(bits, ymask_lo, ymask_hi) \
+  { \
+    __m256i ybits = _mm256_set1_epi64x((long long)(bits)); \
+    __m256i y63 = _mm256_set1_epi64x(63); \
+    __m256i yone = _mm256_set1_epi64x(1); \
+    ymask_lo = _mm256_sllv_epi64(yone, _mm256_and_si256(_mm256_srlv_epi64(ybits, _mm256_setr_epi64x(0, 6, 12, 18)), y63)); \
+    ymask_hi = _mm256_sllv_epi64(yone, _mm256_and_si256(_mm256_srlv_epi64(ybits, _mm256_setr_epi64x(24, 30, 36, 42)), y63)); \
+  }
+#else
+static void hx4_bloom_mask(uint64_t bits, uint64_t *mask) {
+  int j;
+  for(j=0; j<8; j++) {
+    mask[j] = ( ( uint64_t )1 ) << ((bits >> (6*j)) & 63);
+  }
+}
+#endif
+
+static void hx4_bloom_set(const hx4_bloom_probe *probe) {
+  uint64_t *block = (uint64_t*)probe->block;
+#if HX4_HAS_AVX2
+  __m256i ymask_lo, ymask_hi;
+  HX4_AVX2_BLOOM_MASKS(probe->bits, ymask_lo, ymask_hi)
+  _mm256_store_si256((__m256i*)block, _mm256_or_si256(_mm256_load_si256((const __m256i*)block), ymask_lo));
+  _mm256_store_si256((__m256i*)block + 1, _mm256_or_si256(_mm256_load_si256((const __m256i*)block + 1), ymask_hi));
+#else
+  uint64_t mask[8];
+  int j;
+  hx4_bloom_mask(probe->bits, mask);
+  for(j=0; j<8; j++) {
+    block[j] |= mask[j];
+  }
+#endif
+}
+
+static int hx4_bloom_test(const hx4_bloom_probe *probe) {
+  const uint64_t *block = probe->block;
+#if HX4_HAS_AVX2
+  __m256i ymask_lo, ymask_hi;
+  __m256i ymissing;
+  HX4_AVX2_BLOOM_MASKS(probe->bits, ymask_lo, ymask_hi)
+  ymissing = _mm256_or_si256(
+    _mm256_andnot_si256(_mm256_load_si256((const __m256i*)block), ymask_lo),
+    _mm256_andnot_si256(_mm256_load_si256((const __m256i*)block + 1), ymask_hi));
+  return _mm256_testz_si256(ymissing, ymissing);
+#elif HX4_HAS_SSE2
+  HX4_ALIGNED(uint64_t mask[8], 16);
+  __m128i xmissing;
+  hx4_bloom_mask(probe->bits, mask);
+  xmissing = _mm_or_si128(
+    _mm_or_si128(
+      _mm_andnot_si128(_mm_load_si128((const __m128i*)block), _mm_load_si128((const __m128i*)mask)),
+      _mm_andnot_si128(_mm_load_si128((const __m128i*)block + 1), _mm_load_si128((const __m128i*)mask + 1))),
+    _mm_or_si128(
+      _mm_andnot_si128(_mm_load_si128((const __m128i*)block + 2), _mm_load_si128((const __m128i*)mask + 2)),
+      _mm_andnot_si128(_mm_load_si128((const __m128i*)block + 3), _mm_load_si128((const __m128i*)mask + 3))));
+  return _mm_movemask_epi8(_mm_cmpeq_epi8(xmissing, _mm_setzero_si128())) == 0xffff;
+#else
+  uint64_t mask[8];
+  uint64_t missing = 0;
+  int j;
+  hx4_bloom_mask(probe->bits, mask);
+  for(j=0; j<8; j++) {
+    missing |= mask[j] & ~block[j];
+  }
+  return missing == 0;
+#endif
+}
+
+static void hx4_bloom_prefetch(const hx4_bloom_probe *probe) {
+#if HX4_HAS_SSE2
+  _mm_prefetch((const char*)probe->block, _MM_HINT_T0);
+#else
+  (void)probe;
+#endif
+}
+
+int hx4_bloom_init(hx4_bloom *bloom, void *memory, size_t memory_sz, const void *cookie, size_t cookie_sz) {
+  size_t align;
+
+  if(!bloom || !memory || !cookie) {
+    return HX4_ERR_PARAM_INVALID;
+  }
+  if(cookie_sz < 128/8) {
+    return HX4_ERR_COOKIE_TOO_SMALL;
+  }
+  align = hx4_bytes_to_aligned(memory, HX4_BLOOM_BLOCK_SIZE);
+  if(memory_sz < align + HX4_BLOOM_BLOCK_SIZE) {
+    return HX4_ERR_BUFFER_TOO_SMALL;
+  }
+
+  bloom->blocks = (uint64_t*)((uint8_t*)memory + align);
+  bloom->num_blocks = (memory_sz - align) / HX4_BLOOM_BLOCK_SIZE;
+  if((uint64_t)bloom->num_blocks > ( ( uint64_t )1 ) << 32) {
+    bloom->num_blocks = (size_t)(( ( uint64_t )1 ) << 32);
+  }
+  memcpy(bloom->cookie, cookie, sizeof(bloom->cookie));
+  memset(bloom->blocks, 0, bloom->num_blocks * HX4_BLOOM_BLOCK_SIZE);
+
+  return HX4_ERR_SUCCESS;
+}
+
+int hx4_bloom_insert(hx4_bloom *bloom, const void *key, size_t key_sz) {
+  hx4_bloom_probe probe;
+  int rc;
+
+  if(!bloom || !bloom->blocks) {
+    return HX4_ERR_PARAM_INVALID;
+  }
+  rc = hx4_bloom_hash(bloom, key, key_sz, &probe);
+  if(rc != HX4_ERR_SUCCESS) {
+    return rc;
+  }
+  hx4_bloom_set(&probe);
+  return HX4_ERR_SUCCESS;
+}
+
+int hx4_bloom_query(const hx4_bloom *bloom, const void *key, size_t key_sz) {
+  hx4_bloom_probe probe;
+  int rc;
+
+  if(!bloom || !bloom->blocks) {
+    return HX4_ERR_PARAM_INVALID;
+  }
+  rc = hx4_bloom_hash(bloom, key, key_sz, &probe);
+  if(rc != HX4_ERR_SUCCESS) {
+    return rc;
+  }
+  return hx4_bloom_test(&probe);
+}
+
+int hx4_bloom_insert_batch(hx4_bloom *bloom, const void *const *keys, const size_t *key_sizes, size_t n) {
+  hx4_bloom_probe probes[HX4_BLOOM_BATCH];
+  size_t group;
+  size_t i;
+  size_t j;
+  int rc;
+
+  if(!bloom || !bloom->blocks || !keys || !key_sizes) {
+    return HX4_ERR_PARAM_INVALID;
+  }
+
+  for(i=0; i<n; i+=group) {
+    group = n - i < HX4_BLOOM_BATCH ? n - i : HX4_BLOOM_BATCH;
+    for(j=0; j<group; j++) {
+      rc = hx4_bloom_hash(bloom, keys[i+j], key_sizes[i+j], &probes[j]);
+      if(rc != HX4_ERR_SUCCESS) {
+        return rc;
+      }
+      hx4_bloom_prefetch(&probes[j]);
+    }
+    for(j=0; j<group; j++) {
+      hx4_bloom_set(&probes[j]);
+    }
+  }
+
+  return HX4_ERR_SUCCESS;
+}
+
+int hx4_bloom_query_batch(const hx4_bloom *bloom, const void *const *keys, const size_t *key_sizes, size_t n, uint8_t *results) {
+  hx4_bloom_probe probes[HX4_BLOOM_BATCH];
+  size_t group;
+  size_t i;
+  size_t j;
+  int rc;
+
+  if(!bloom || !bloom->blocks || !keys || !key_sizes || !results) {
+    return HX4_ERR_PARAM_INVALID;
+  }
+
+  for(i=0; i<n; i+=group) {
+    group = n - i < HX4_BLOOM_BATCH ? n - i : HX4_BLOOM_BATCH;
+    for(j=0; j<group; j++) {
+      rc = hx4_bloom_hash(bloom, keys[i+j], key_sizes[i+j], &probes[j]);
+      if(rc != HX4_ERR_SUCCESS) {
+        return rc;
+      }
+      hx4_bloom_prefetch(&probes[j]);
+    }
+    for(j=0; j<group; j++) {
+      results[i+j] = (uint8_t)hx4_bloom_test(&probes[j]);
+    }
+  }
+
+  return HX4_ERR_SUCCESS;
+}
+
+#undef HX4_AVX2_BLOOM_MASKS
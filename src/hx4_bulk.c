@@ -0,0 +1,711 @@
+/* 
+ * Copyright 2015 Kai Dietrich <mail@cleeus.de>
+ *
+ * This file is part of hashx4.
+ *
+ * Hashx4 is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Hashx4 is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with hashx4.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "hashx4_config.h"
+
+#if HX4_HAS_SSE2
+# include <emmintrin.h>
+#endif
+
+#if HX4_HAS_AVX2
+# include <immintrin.h>
+#endif
+
+#include "hashx4.h"
+#include "hx4_util.h"
+
+// The bulk functions hash every element of an integer column as an
+// independent key. The 32-bit keys are hashed with HalfSipHash-1-3, the
+// 64 and 128-bit keys with SipHash-1-3. All of them only see fixed size
+// keys, so the message schedule is the same for every element and
+// whole registers full of keys can be pushed through the rounds at once.
+// The result for element i is exactly what the scalar function returns
+// for the little endian bytes of keys[i].
+
+// how far ahead of the current key the input is prefetched, in bytes
+#define HX4_BULK_PREFETCH_DISTANCE 512
+
+#define ROTL64(x,b) (uint64_t)( ((x) << (b)) | ( (x) >> (64 - (b))) )
+#define ROTL32(x,b) (uint32_t)( ((x) << (b)) | ( (x) >> (32 - (b))) )
+
+#define U32TO8_LE(p, v)         \
+    (p)[0] = (uint8_t)((v)      ); (p)[1] = (uint8_t)((v) >>  8); \
+    (p)[2] = (uint8_t)((v) >> 16); (p)[3] = (uint8_t)((v) >> 24);
+
+#define U64TO8_LE(p, v)         \
+  U32TO8_LE((p),     (uint32_t)((v)      ));   \
+  U32TO8_LE((p) + 4, (uint32_t)((v) >> 32));
+
+#define U8TO32_LE(p)                                                           \
+  (((uint32_t)((p)[0])) | ((uint32_t)((p)[1]) << 8) |                          \
+   ((uint32_t)((p)[2]) << 16) | ((uint32_t)((p)[3]) << 24))
+
+#define U8TO64_LE(p) \
+  (((uint64_t)U8TO32_LE(p)) | ((uint64_t)U8TO32_LE((p) + 4) << 32))
+
+#define SIPROUND            \
+  do {              \
+    v0 += v1; v1=ROTL64(v1,13); v1 ^= v0; v0=ROTL64(v0,32); \
+    v2 += v3; v3=ROTL64(v3,16); v3 ^= v2;     \
+    v0 += v3; v3=ROTL64(v3,21); v3 ^= v0;     \
+    v2 += v1; v1=ROTL64(v1,17); v1 ^= v2; v2=ROTL64(v2,32); \
+  } while(0)
+
+#define HALFSIPROUND            \
+  do {              \
+    v0 += v1; v1=ROTL32(v1, 5); v1 ^= v0; v0=ROTL32(v0,16); \
+    v2 += v3; v3=ROTL32(v3, 8); v3 ^= v2;     \
+    v0 += v3; v3=ROTL32(v3, 7); v3 ^= v0;     \
+    v2 += v1; v1=ROTL32(v1,13); v1 ^= v2; v2=ROTL32(v2,16); \
+  } while(0)
+
+//SipHash-1-3 of a message made of words full 64-bit words
+static uint64_t hx4_bulk_siphash13(uint64_t k0, uint64_t k1, const uint8_t *m, int words) {
+  uint64_t v0 = 0x736f6d6570736575ULL ^ k0;
+  uint64_t v1 = 0x646f72616e646f6dULL ^ k1;
+  uint64_t v2 = 0x6c7967656e657261ULL ^ k0;
+  uint64_t v3 = 0x7465646279746573ULL ^ k1;
+  uint64_t b = ( ( uint64_t )words*8 ) << 56;
+  uint64_t w;
+  int i;
+
+  for(i=0; i<words; i++) {
+    w = U8TO64_LE( m + 8*i );
+    v3 ^= w;
+    SIPROUND;
+    v0 ^= w;
+  }
+
+  v3 ^= b;
+  SIPROUND;
+  v0 ^= b;
+
+  v2 ^= 0xff;
+  SIPROUND;
+  SIPROUND;
+  SIPROUND;
+
+  return v0 ^ v1 ^ v2 ^ v3;
+}
+
+//HalfSipHash-1-3 of a single 32-bit word
+static uint32_t hx4_bulk_halfsiphash13(uint32_t k0, uint32_t k1, uint32_t m) {
+  uint32_t v0 = 0 ^ k0;
+  uint32_t v1 = 0 ^ k1;
+  uint32_t v2 = 0x6c796765 ^ k0;
+  uint32_t v3 = 0x74656462 ^ k1;
+  uint32_t b = ( ( uint32_t )4 ) << 24;
+
+  v3 ^= m;
+  HALFSIPROUND;
+  v0 ^= m;
+
+  v3 ^= b;
+  HALFSIPROUND;
+  v0 ^= b;
+
+  v2 ^= 0xff;
+  HALFSIPROUND;
+  HALFSIPROUND;
+  HALFSIPROUND;
+
+  return v1 ^ v3;
+}
+
+//n*key_sz must not wrap around, the overlap checks would see a short array then
+static int hx4_bulk_check_params(const void *keys, size_t n, size_t key_sz, const void *cookie, size_t cookie_sz, void *out, size_t hash_sz) {
+  if(n > SIZE_MAX / key_sz) {
+    return HX4_ERR_PARAM_INVALID;
+  }
+  return hx4_check_params(0, keys, n*key_sz, cookie, cookie_sz, out, n*hash_sz);
+}
+
+//the reference variants are plain per element loops over the scalar reference functions
+HX4_API int hx4_hash_u32_array_ref(const uint32_t *keys, size_t n, const void *cookie, size_t cookie_sz, uint32_t *out) {
+  uint8_t key_bytes[4];
+  uint8_t hash_bytes[4];
+  size_t i;
+  int rc;
+  HX4_STATS_BEGIN(hx4_hash_u32_array_ref)
+
+  rc = hx4_bulk_check_params(keys, n, 4, cookie, cookie_sz, out, 4);
+  if(rc != HX4_ERR_SUCCESS) {
+    return rc;
+  }
+
+  for(i=0; i<n; i++) {
+    U32TO8_LE(key_bytes, keys[i]);
+    rc = hx4_halfsiphash13_32_ref(key_bytes, sizeof(key_bytes), cookie, cookie_sz, hash_bytes, sizeof(hash_bytes));
+    if(rc != HX4_ERR_SUCCESS) {
+      return rc;
+    }
+    out[i] = U8TO32_LE(hash_bytes);
+  }
+
+  HX4_STATS_END(hx4_hash_u32_array_ref, (uint64_t)n*4)
+  return HX4_ERR_SUCCESS;
+}
+
+HX4_API int hx4_hash_u64_array_ref(const uint64_t *keys, size_t n, const void *cookie, size_t cookie_sz, uint64_t *out) {
+  uint8_t key_bytes[8];
+  uint8_t hash_bytes[8];
+  size_t i;
+  int rc;
+  HX4_STATS_BEGIN(hx4_hash_u64_array_ref)
+
+  rc = hx4_bulk_check_params(keys, n, 8, cookie, cookie_sz, out, 8);
+  if(rc != HX4_ERR_SUCCESS) {
+    return rc;
+  }
+
+  for(i=0; i<n; i++) {
+    U64TO8_LE(key_bytes, keys[i]);
+    rc = hx4_siphash13_64_ref(key_bytes, sizeof(key_bytes), cookie, cookie_sz, hash_bytes, sizeof(hash_bytes));
+    if(rc != HX4_ERR_SUCCESS) {
+      return rc;
+    }
+    out[i] = U8TO64_LE(hash_bytes);
+  }
+
+  HX4_STATS_END(hx4_hash_u64_array_ref, (uint64_t)n*8)
+  return HX4_ERR_SUCCESS;
+}
+
+HX4_API int hx4_hash_u128_array_ref(const void *keys, size_t n, const void *cookie, size_t cookie_sz, uint64_t *out) {
+  const uint8_t *p = (const uint8_t*)keys;
+  uint8_t hash_bytes[8];
+  size_t i;
+  int rc;
+  HX4_STATS_BEGIN(hx4_hash_u128_array_ref)
+
+  rc = hx4_bulk_check_params(keys, n, 16, cookie, cookie_sz, out, 8);
+  if(rc != HX4_ERR_SUCCESS) {
+    return rc;
+  }
+
+  for(i=0; i<n; i++) {
+    rc = hx4_siphash13_64_ref(p + 16*i, 16, cookie, cookie_sz, hash_bytes, sizeof(hash_bytes));
+    if(rc != HX4_ERR_SUCCESS) {
+      return rc;
+    }
+    out[i] = U8TO64_LE(hash_bytes);
+  }
+
+  HX4_STATS_END(hx4_hash_u128_array_ref, (uint64_t)n*16)
+  return HX4_ERR_SUCCESS;
+}
+
+#if HX4_HAS_SSE2
+#define HX4_SSE2_ROTL64(x, b) _mm_or_si128(_mm_slli_epi64((x), (b)), _mm_srli_epi64((x), 64-(b)))
+#define HX4_SSE2_ROTL64_16(x) _mm_shufflehi_epi16(_mm_shufflelo_epi16((x), _MM_SHUFFLE(2,1,0,3)), _MM_SHUFFLE(2,1,0,3))
+#define HX4_SSE2_ROTL64_32(x) _mm_shuffle_epi32((x), _MM_SHUFFLE(2,3,0,1))
+
+#define HX4_SSE2_SIPROUND(v0, v1, v2, v3) \
+    v0 = _mm_add_epi64(v0, v1); v1 = HX4_SSE2_ROTL64(v1, 13); v1 = _mm_xor_si128(v1, v0); v0 = HX4_SSE2_ROTL64_32(v0); \
+    v2 = _mm_add_epi64(v2, v3); v3 = HX4_SSE2_ROTL64_16(v3);  v3 = _mm_xor_si128(v3, v2); \
+    v0 = _mm_add_epi64(v0, v3); v3 = HX4_SSE2_ROTL64(v3, 21); v3 = _mm_xor_si128(v3, v0); \
+    v2 = _mm_add_epi64(v2, v1); v1 = HX4_SSE2_ROTL64(v1, 17); v1 = _mm_xor_si128(v1, v2); v2 = HX4_SSE2_ROTL64_32(v2);
+
+#define HX4_SSE2_ROTL32(x, b) _mm_or_si128(_mm_slli_epi32((x), (b)), _mm_srli_epi32((x), 32-(b)))
+#define HX4_SSE2_ROTL32_16(x) _mm_shufflehi_epi16(_mm_shufflelo_epi16((x), _MM_SHUFFLE(2,3,0,1)), _MM_SHUFFLE(2,3,0,1))
+
+#define HX4_SSE2_HALFSIPROUND(v0, v1, v2, v3) \
+    v0 = _mm_add_epi32(v0, v1); v1 = HX4_SSE2_ROTL32(v1,  5); v1 = _mm_xor_si128(v1, v0); v0 = HX4_SSE2_ROTL32_16(v0); \
+    v2 = _mm_add_epi32(v2, v3); v3 = HX4_SSE2_ROTL32(v3,  8); v3 = _mm_xor_si128(v3, v2); \
+    v0 = _mm_add_epi32(v0, v3); v3 = HX4_SSE2_ROTL32(v3,  7); v3 = _mm_xor_si128(v3, v0); \
+    v2 = _mm_add_epi32(v2, v1); v1 = HX4_SSE2_ROTL32(v1, 13); v1 = _mm_xor_si128(v1, v2); v2 = HX4_SSE2_ROTL32_16(v2);
+
+//the initial state, broadcast to all lanes of the a and b registers
+#define HX4_SSE2_BULK_INIT() \
+    v0a = v0b = xinit[0]; v1a = v1b = xinit[1]; v2a = v2b = xinit[2]; v3a = v3b = xinit[3];
+
+//one message word for the a and the b registers
+#define HX4_SSE2_BULK_SIPCOMPRESS(ma, mb) \
+    v3a = _mm_xor_si128(v3a, (ma)); v3b = _mm_xor_si128(v3b, (mb)); \
+    HX4_SSE2_SIPROUND(v0a, v1a, v2a, v3a) \
+    HX4_SSE2_SIPROUND(v0b, v1b, v2b, v3b) \
+    v0a = _mm_xor_si128(v0a, (ma)); v0b = _mm_xor_si128(v0b, (mb));
+
+#define HX4_SSE2_BULK_SIPFINAL() \
+    v2a = _mm_xor_si128(v2a, xfinal); v2b = _mm_xor_si128(v2b, xfinal); \
+    HX4_SSE2_SIPROUND(v0a, v1a, v2a, v3a) \
+    HX4_SSE2_SIPROUND(v0b, v1b, v2b, v3b) \
+    HX4_SSE2_SIPROUND(v0a, v1a, v2a, v3a) \
+    HX4_SSE2_SIPROUND(v0b, v1b, v2b, v3b) \
+    HX4_SSE2_SIPROUND(v0a, v1a, v2a, v3a) \
+    HX4_SSE2_SIPROUND(v0b, v1b, v2b, v3b) \
+    v0a = _mm_xor_si128(_mm_xor_si128(v0a, v1a), _mm_xor_si128(v2a, v3a)); \
+    v0b = _mm_xor_si128(_mm_xor_si128(v0b, v1b), _mm_xor_si128(v2b, v3b));
+
+static void hx4_sse2_bulk_sipinit(__m128i *xinit, const void *cookie) {
+  HX4_ALIGNED(uint64_t v[2], 16);
+  uint64_t k0 = U8TO64_LE( (const uint8_t*)cookie );
+  uint64_t k1 = U8TO64_LE( (const uint8_t*)cookie + 8 );
+
+  v[0] = v[1] = 0x736f6d6570736575ULL ^ k0; xinit[0] = _mm_load_si128((const __m128i*)v);
+  v[0] = v[1] = 0x646f72616e646f6dULL ^ k1; xinit[1] = _mm_load_si128((const __m128i*)v);
+  v[0] = v[1] = 0x6c7967656e657261ULL ^ k0; xinit[2] = _mm_load_si128((const __m128i*)v);
+  v[0] = v[1] = 0x7465646279746573ULL ^ k1; xinit[3] = _mm_load_si128((const __m128i*)v);
+}
+
+static __m128i hx4_sse2_bulk_sipconst(uint64_t c) {
+  HX4_ALIGNED(uint64_t v[2], 16);
+  v[0] = v[1] = c;
+  return _mm_load_si128((const __m128i*)v);
+}
+
+HX4_API int hx4_hash_u32_array_sse2(const uint32_t *keys, size_t n, const void *cookie, size_t cookie_sz, uint32_t *out) {
+  uint32_t k0, k1;
+  size_t i;
+  int rc;
+  __m128i xinit[4];
+  __m128i v0a, v1a, v2a, v3a;
+  __m128i v0b, v1b, v2b, v3b;
+  __m128i ma, mb;
+  __m128i xb, xfinal;
+  HX4_STATS_BEGIN(hx4_hash_u32_array_sse2)
+
+  rc = hx4_bulk_check_params(keys, n, 4, cookie, cookie_sz, out, 4);
+  if(rc != HX4_ERR_SUCCESS) {
+    return rc;
+  }
+
+  k0 = U8TO32_LE( (const uint8_t*)cookie );
+  k1 = U8TO32_LE( (const uint8_t*)cookie + 4 );
+  xinit[0] = _mm_set1_epi32((int)(0 ^ k0));
+  xinit[1] = _mm_set1_epi32((int)(0 ^ k1));
+  xinit[2] = _mm_set1_epi32((int)(0x6c796765 ^ k0));
+  xinit[3] = _mm_set1_epi32((int)(0x74656462 ^ k1));
+  xb = _mm_set1_epi32(4 << 24);
+  xfinal = _mm_set1_epi32(0xff);
+
+  //eight keys per iteration, two independent register sets hide the latency of the rounds
+  for(i=0; i+8 <= n; i+=8) {
+    _mm_prefetch((const char*)(keys + i) + HX4_BULK_PREFETCH_DISTANCE, _MM_HINT_T0);
+    ma = _mm_loadu_si128((const __m128i*)(keys + i));
+    mb = _mm_loadu_si128((const __m128i*)(keys + i + 4));
+
+    HX4_SSE2_BULK_INIT()
+    v3a = _mm_xor_si128(v3a, ma); v3b = _mm_xor_si128(v3b, mb);
+    HX4_SSE2_HALFSIPROUND(v0a, v1a, v2a, v3a)
+    HX4_SSE2_HALFSIPROUND(v0b, v1b, v2b, v3b)
+    v0a = _mm_xor_si128(v0a, ma); v0b = _mm_xor_si128(v0b, mb);
+
+    v3a = _mm_xor_si128(v3a, xb); v3b = _mm_xor_si128(v3b, xb);
+    HX4_SSE2_HALFSIPROUND(v0a, v1a, v2a, v3a)
+    HX4_SSE2_HALFSIPROUND(v0b, v1b, v2b, v3b)
+    v0a = _mm_xor_si128(v0a, xb); v0b = _mm_xor_si128(v0b, xb);
+
+    v2a = _mm_xor_si128(v2a, xfinal); v2b = _mm_xor_si128(v2b, xfinal);
+    HX4_SSE2_HALFSIPROUND(v0a, v1a, v2a, v3a)
+    HX4_SSE2_HALFSIPROUND(v0b, v1b, v2b, v3b)
+    HX4_SSE2_HALFSIPROUND(v0a, v1a, v2a, v3a)
+    HX4_SSE2_HALFSIPROUND(v0b, v1b, v2b, v3b)
+    HX4_SSE2_HALFSIPROUND(v0a, v1a, v2a, v3a)
+    HX4_SSE2_HALFSIPROUND(v0b, v1b, v2b, v3b)
+
+    _mm_storeu_si128((__m128i*)(out + i), _mm_xor_si128(v1a, v3a));
+    _mm_storeu_si128((__m128i*)(out + i + 4), _mm_xor_si128(v1b, v3b));
+  }
+
+  for( ; i<n; i++) {
+    out[i] = hx4_bulk_halfsiphash13(k0, k1, keys[i]);
+  }
+
+  HX4_STATS_END(hx4_hash_u32_array_sse2, (uint64_t)n*4)
+  return HX4_ERR_SUCCESS;
+}
+
+HX4_API int hx4_hash_u64_array_sse2(const uint64_t *keys, size_t n, const void *cookie, size_t cookie_sz, uint64_t *out) {
+  uint8_t key_bytes[8];
+  uint64_t k0, k1;
+  size_t i;
+  int rc;
+  __m128i xinit[4];
+  __m128i v0a, v1a, v2a, v3a;
+  __m128i v0b, v1b, v2b, v3b;
+  __m128i ma, mb;
+  __m128i xb, xfinal;
+  HX4_STATS_BEGIN(hx4_hash_u64_array_sse2)
+
+  rc = hx4_bulk_check_params(keys, n, 8, cookie, cookie_sz, out, 8);
+  if(rc != HX4_ERR_SUCCESS) {
+    return rc;
+  }
+
+  hx4_sse2_bulk_sipinit(xinit, cookie);
+  xb = hx4_sse2_bulk_sipconst(( ( uint64_t )8 ) << 56);
+  xfinal = hx4_sse2_bulk_sipconst(0xff);
+
+  //four keys per iteration, two in each register set
+  for(i=0; i+4 <= n; i+=4) {
+    _mm_prefetch((const char*)(keys + i) + HX4_BULK_PREFETCH_DISTANCE, _MM_HINT_T0);
+    ma = _mm_loadu_si128((const __m128i*)(keys + i));
+    mb = _mm_loadu_si128((const __m128i*)(keys + i + 2));
+
+    HX4_SSE2_BULK_INIT()
+    HX4_SSE2_BULK_SIPCOMPRESS(ma, mb)
+    HX4_SSE2_BULK_SIPCOMPRESS(xb, xb)
+    HX4_SSE2_BULK_SIPFINAL()
+
+    _mm_storeu_si128((__m128i*)(out + i), v0a);
+    _mm_storeu_si128((__m128i*)(out + i + 2), v0b);
+  }
+
+  k0 = U8TO64_LE( (const uint8_t*)cookie );
+  k1 = U8TO64_LE( (const uint8_t*)cookie + 8 );
+  for( ; i<n; i++) {
+    U64TO8_LE(key_bytes, keys[i]);
+    out[i] = hx4_bulk_siphash13(k0, k1, key_bytes, 1);
+  }
+
+  HX4_STATS_END(hx4_hash_u64_array_sse2, (uint64_t)n*8)
+  return HX4_ERR_SUCCESS;
+}
+
+HX4_API int hx4_hash_u128_array_sse2(const void *keys, size_t n, const void *cookie, size_t cookie_sz, uint64_t *out) {
+  const uint8_t *p = (const uint8_t*)keys;
+  uint64_t k0, k1;
+  size_t i;
+  int rc;
+  __m128i xinit[4];
+  __m128i v0a, v1a, v2a, v3a;
+  __m128i v0b, v1b, v2b, v3b;
+  __m128i x0, x1, x2, x3;
+  __m128i xb, xfinal;
+  HX4_STATS_BEGIN(hx4_hash_u128_array_sse2)
+
+  rc = hx4_bulk_check_params(keys, n, 16, cookie, cookie_sz, out, 8);
+  if(rc != HX4_ERR_SUCCESS) {
+    return rc;
+  }
+
+  hx4_sse2_bulk_sipinit(xinit, cookie);
+  xb = hx4_sse2_bulk_sipconst(( ( uint64_t )16 ) << 56);
+  xfinal = hx4_sse2_bulk_sipconst(0xff);
+
+  //four keys per iteration, the low and high words of two keys are
+  //gathered into one register each
+  for(i=0; i+4 <= n; i+=4) {
+    _mm_prefetch((const char*)(p + 16*i) + HX4_BULK_PREFETCH_DISTANCE, _MM_HINT_T0);
+    x0 = _mm_loadu_si128((const __m128i*)(p + 16*i));
+    x1 = _mm_loadu_si128((const __m128i*)(p + 16*i + 16));
+    x2 = _mm_loadu_si128((const __m128i*)(p + 16*i + 32));
+    x3 = _mm_loadu_si128((const __m128i*)(p + 16*i + 48));
+
+    HX4_SSE2_BULK_INIT()
+    HX4_SSE2_BULK_SIPCOMPRESS(_mm_unpacklo_epi64(x0, x1), _mm_unpacklo_epi64(x2, x3))
+    HX4_SSE2_BULK_SIPCOMPRESS(_mm_unpackhi_epi64(x0, x1), _mm_unpackhi_epi64(x2, x3))
+    HX4_SSE2_BULK_SIPCOMPRESS(xb, xb)
+    HX4_SSE2_BULK_SIPFINAL()
+
+    _mm_storeu_si128((__m128i*)(out + i), v0a);
+    _mm_storeu_si128((__m128i*)(out + i + 2), v0b);
+  }
+
+  k0 = U8TO64_LE( (const uint8_t*)cookie );
+  k1 = U8TO64_LE( (const uint8_t*)cookie + 8 );
+  for( ; i<n; i++) {
+    out[i] = hx4_bulk_siphash13(k0, k1, p + 16*i, 2);
+  }
+
+  HX4_STATS_END(hx4_hash_u128_array_sse2, (uint64_t)n*16)
+  return HX4_ERR_SUCCESS;
+}
+
+#undef HX4_SSE2_BULK_SIPFINAL
+#undef HX4_SSE2_BULK_SIPCOMPRESS
+#undef HX4_SSE2_BULK_INIT
+#undef HX4_SSE2_HALFSIPROUND
+#undef HX4_SSE2_ROTL32_16
+#undef HX4_SSE2_ROTL32
+#undef HX4_SSE2_SIPROUND
+#undef HX4_SSE2_ROTL64_32
+#undef HX4_SSE2_ROTL64_16
+#undef HX4_SSE2_ROTL64
+#endif //HX4_HAS_SSE2
+
+#if HX4_HAS_AVX2
+#define HX4_AVX2_ROTL64(x, b) _mm256_or_si256(_mm256_slli_epi64((x), (b)), _mm256_srli_epi64((x), 64-(b)))
+#define HX4_AVX2_ROTL64_16(x) _mm256_shufflehi_epi16(_mm256_shufflelo_epi16((x), _MM_SHUFFLE(2,1,0,3)), _MM_SHUFFLE(2,1,0,3))
+#define HX4_AVX2_ROTL64_32(x) _mm256_shuffle_epi32((x), _MM_SHUFFLE(2,3,0,1))
+
+#define HX4_AVX2_SIPROUND(v0, v1, v2, v3) \
+    v0 = _mm256_add_epi64(v0, v1); v1 = HX4_AVX2_ROTL64(v1, 13); v1 = _mm256_xor_si256(v1, v0); v0 = HX4_AVX2_ROTL64_32(v0); \
+    v2 = _mm256_add_epi64(v2, v3); v3 = HX4_AVX2_ROTL64_16(v3);  v3 = _mm256_xor_si256(v3, v2); \
+    v0 = _mm256_add_epi64(v0, v3); v3 = HX4_AVX2_ROTL64(v3, 21); v3 = _mm256_xor_si256(v3, v0); \
+    v2 = _mm256_add_epi64(v2, v1); v1 = HX4_AVX2_ROTL64(v1, 17); v1 = _mm256_xor_si256(v1, v2); v2 = HX4_AVX2_ROTL64_32(v2);
+
+#define HX4_AVX2_ROTL32(x, b) _mm256_or_si256(_mm256_slli_epi32((x), (b)), _mm256_srli_epi32((x), 32-(b)))
+#define HX4_AVX2_ROTL32_16(x) _mm256_shufflehi_epi16(_mm256_shufflelo_epi16((x), _MM_SHUFFLE(2,3,0,1)), _MM_SHUFFLE(2,3,0,1))
+
+#define HX4_AVX2_HALFSIPROUND(v0, v1, v2, v3) \
+    v0 = _mm256_add_epi32(v0, v1); v1 = HX4_AVX2_ROTL32(v1,  5); v1 = _mm256_xor_si256(v1, v0); v0 = HX4_AVX2_ROTL32_16(v0); \
+    v2 = _mm256_add_epi32(v2, v3); v3 = HX4_AVX2_ROTL32(v3,  8); v3 = _mm256_xor_si256(v3, v2); \
+    v0 = _mm256_add_epi32(v0, v3); v3 = HX4_AVX2_ROTL32(v3,  7); v3 = _mm256_xor_si256(v3, v0); \
+    v2 = _mm256_add_epi32(v2, v1); v1 = HX4_AVX2_ROTL32(v1, 13); v1 = _mm256_xor_si256(v1, v2); v2 = HX4_AVX2_ROTL32_16(v2);
+
+#define HX4_AVX2_BULK_INIT() \
+    v0a = v0b = yinit[0]; v1a = v1b = yinit[1]; v2a = v2b = yinit[2]; v3a = v3b = yinit[3];
+
+#define HX4_AVX2_BULK_SIPCOMPRESS(ma, mb) \
+    v3a = _mm256_xor_si256(v3a, (ma)); v3b = _mm256_xor_si256(v3b, (mb)); \
+    HX4_AVX2_SIPROUND(v0a, v1a, v2a, v3a) \
+    HX4_AVX2_SIPROUND(v0b, v1b, v2b, v3b) \
+    v0a = _mm256_xor_si256(v0a, (ma)); v0b = _mm256_xor_si256(v0b, (mb));
+
+#define HX4_AVX2_BULK_SIPFINAL() \
+    v2a = _mm256_xor_si256(v2a, yfinal); v2b = _mm256_xor_si256(v2b, yfinal); \
+    HX4_AVX2_SIPROUND(v0a, v1a, v2a, v3a) \
+    HX4_AVX2_SIPROUND(v0b, v1b, v2b, v3b) \
+    HX4_AVX2_SIPROUND(v0a, v1a, v2a, v3a) \
+    HX4_AVX2_SIPROUND(v0b, v1b, v2b, v3b) \
+    HX4_AVX2_SIPROUND(v0a, v1a, v2a, v3a) \
+    HX4_AVX2_SIPROUND(v0b, v1b, v2b, v3b) \
+    v0a = _mm256_xor_si256(_mm256_xor_si256(v0a, v1a), _mm256_xor_si256(v2a, v3a)); \
+    v0b = _mm256_xor_si256(_mm256_xor_si256(v0b, v1b), _mm256_xor_si256(v2b, v3b));
+
+static void hx4_avx2_bulk_sipinit(__m256i *yinit, const void *cookie) {
+  uint64_t k0 = U8TO64_LE( (const uint8_t*)cookie );
+  uint64_t k1 = U8TO64_LE( (const uint8_t*)cookie + 8 );
+
+  yinit[0] = _mm256_set1_epi64x((long long)(0x736f6d6570736575ULL ^ k0));
+  yinit[1] = _mm256_set1_epi64x((long long)(0x646f72616e646f6dULL ^ k1));
+  yinit[2] = _mm256_set1_epi64x((long long)(0x6c7967656e657261ULL ^ k0));
+  yinit[3] = _mm256_set1_epi64x((long long)(0x7465646279746573ULL ^ k1));
+}
+
+HX4_API int hx4_hash_u32_array_avx2(const uint32_t *keys, size_t n, const void *cookie, size_t cookie_sz, uint32_t *out) {
+  uint32_t k0, k1;
+  size_t i;
+  int rc;
+  __m256i yinit[4];
+  __m256i v0a, v1a, v2a, v3a;
+  __m256i v0b, v1b, v2b, v3b;
+  __m256i ma, mb;
+  __m256i yb, yfinal;
+  HX4_STATS_BEGIN(hx4_hash_u32_array_avx2)
+
+  rc = hx4_bulk_check_params(keys, n, 4, cookie, cookie_sz, out, 4);
+  if(rc != HX4_ERR_SUCCESS) {
+    return rc;
+  }
+
+  k0 = U8TO32_LE( (const uint8_t*)cookie );
+  k1 = U8TO32_LE( (const uint8_t*)cookie + 4 );
+  yinit[0] = _mm256_set1_epi32((int)(0 ^ k0));
+  yinit[1] = _mm256_set1_epi32((int)(0 ^ k1));
+  yinit[2] = _mm256_set1_epi32((int)(0x6c796765 ^ k0));
+  yinit[3] = _mm256_set1_epi32((int)(0x74656462 ^ k1));
+  yb = _mm256_set1_epi32(4 << 24);
+  yfinal = _mm256_set1_epi32(0xff);
+
+  //sixteen keys per iteration, eight in each register set
+  for(i=0; i+16 <= n; i+=16) {
+    _mm_prefetch((const char*)(keys + i) + HX4_BULK_PREFETCH_DISTANCE, _MM_HINT_T0);
+    ma = _mm256_loadu_si256((const __m256i*)(keys + i));
+    mb = _mm256_loadu_si256((const __m256i*)(keys + i + 8));
+
+    HX4_AVX2_BULK_INIT()
+    v3a = _mm256_xor_si256(v3a, ma); v3b = _mm256_xor_si256(v3b, mb);
+    HX4_AVX2_HALFSIPROUND(v0a, v1a, v2a, v3a)
+    HX4_AVX2_HALFSIPROUND(v0b, v1b, v2b, v3b)
+    v0a = _mm256_xor_si256(v0a, ma); v0b = _mm256_xor_si256(v0b, mb);
+
+    v3a = _mm256_xor_si256(v3a, yb); v3b = _mm256_xor_si256(v3b, yb);
+    HX4_AVX2_HALFSIPROUND(v0a, v1a, v2a, v3a)
+    HX4_AVX2_HALFSIPROUND(v0b, v1b, v2b, v3b)
+    v0a = _mm256_xor_si256(v0a, yb); v0b = _mm256_xor_si256(v0b, yb);
+
+    v2a = _mm256_xor_si256(v2a, yfinal); v2b = _mm256_xor_si256(v2b, yfinal);
+    HX4_AVX2_HALFSIPROUND(v0a, v1a, v2a, v3a)
+    HX4_AVX2_HALFSIPROUND(v0b, v1b, v2b, v3b)
+    HX4_AVX2_HALFSIPROUND(v0a, v1a, v2a, v3a)
+    HX4_AVX2_HALFSIPROUND(v0b, v1b, v2b, v3b)
+    HX4_AVX2_HALFSIPROUND(v0a, v1a, v2a, v3a)
+    HX4_AVX2_HALFSIPROUND(v0b, v1b, v2b, v3b)
+
+    _mm256_storeu_si256((__m256i*)(out + i), _mm256_xor_si256(v1a, v3a));
+    _mm256_storeu_si256((__m256i*)(out + i + 8), _mm256_xor_si256(v1b, v3b));
+  }
+
+  for( ; i<n; i++) {
+    out[i] = hx4_bulk_halfsiphash13(k0, k1, keys[i]);
+  }
+
+  HX4_STATS_END(hx4_hash_u32_array_avx2, (uint64_t)n*4)
+  return HX4_ERR_SUCCESS;
+}
+
+HX4_API int hx4_hash_u64_array_avx2(const uint64_t *keys, size_t n, const void *cookie, size_t cookie_sz, uint64_t *out) {
+  uint8_t key_bytes[8];
+  uint64_t k0, k1;
+  size_t i;
+  int rc;
+  __m256i yinit[4];
+  __m256i v0a, v1a, v2a, v3a;
+  __m256i v0b, v1b, v2b, v3b;
+  __m256i ma, mb;
+  __m256i yb, yfinal;
+  HX4_STATS_BEGIN(hx4_hash_u64_array_avx2)
+
+  rc = hx4_bulk_check_params(keys, n, 8, cookie, cookie_sz, out, 8);
+  if(rc != HX4_ERR_SUCCESS) {
+    return rc;
+  }
+
+  hx4_avx2_bulk_sipinit(yinit, cookie);
+  yb = _mm256_set1_epi64x((long long)(( ( uint64_t )8 ) << 56));
+  yfinal = _mm256_set1_epi64x(0xff);
+
+  //eight keys per iteration, four in each register set
+  for(i=0; i+8 <= n; i+=8) {
+    _mm_prefetch((const char*)(keys + i) + HX4_BULK_PREFETCH_DISTANCE, _MM_HINT_T0);
+    ma = _mm256_loadu_si256((const __m256i*)(keys + i));
+    mb = _mm256_loadu_si256((const __m256i*)(keys + i + 4));
+
+    HX4_AVX2_BULK_INIT()
+    HX4_AVX2_BULK_SIPCOMPRESS(ma, mb)
+    HX4_AVX2_BULK_SIPCOMPRESS(yb, yb)
+    HX4_AVX2_BULK_SIPFINAL()
+
+    _mm256_storeu_si256((__m256i*)(out + i), v0a);
+    _mm256_storeu_si256((__m256i*)(out + i + 4), v0b);
+  }
+
+  k0 = U8TO64_LE( (const uint8_t*)cookie );
+  k1 = U8TO64_LE( (const uint8_t*)cookie + 8 );
+  for( ; i<n; i++) {
+    U64TO8_LE(key_bytes, keys[i]);
+    out[i] = hx4_bulk_siphash13(k0, k1, key_bytes, 1);
+  }
+
+  HX4_STATS_END(hx4_hash_u64_array_avx2, (uint64_t)n*8)
+  return HX4_ERR_SUCCESS;
+}
+
+HX4_API int hx4_hash_u128_array_avx2(const void *keys, size_t n, const void *cookie, size_t cookie_sz, uint64_t *out) {
+  const uint8_t *p = (const uint8_t*)keys;
+  uint64_t k0, k1;
+  size_t i;
+  int rc;
+  __m256i yinit[4];
+  __m256i v0a, v1a, v2a, v3a;
+  __m256i v0b, v1b, v2b, v3b;
+  __m256i y0, y1, y2, y3;
+  __m256i yb, yfinal;
+  HX4_STATS_BEGIN(hx4_hash_u128_array_avx2)
+
+  rc = hx4_bulk_check_params(keys, n, 16, cookie, cookie_sz, out, 8);
+  if(rc != HX4_ERR_SUCCESS) {
+    return rc;
+  }
+
+  hx4_avx2_bulk_sipinit(yinit, cookie);
+  yb = _mm256_set1_epi64x((long long)(( ( uint64_t )16 ) << 56));
+  yfinal = _mm256_set1_epi64x(0xff);
+
+  //eight keys per iteration. The unpacks work within 128-bit halves, so
+  //a register holds the keys in the order 0 2 1 3 and the result has
+  //to be permuted back before it is stored.
+  for(i=0; i+8 <= n; i+=8) {
+    _mm_prefetch((const char*)(p + 16*i) + HX4_BULK_PREFETCH_DISTANCE, _MM_HINT_T0);
+    _mm_prefetch((const char*)(p + 16*i) + HX4_BULK_PREFETCH_DISTANCE + 64, _MM_HINT_T0);
+    y0 = _mm256_loadu_si256((const __m256i*)(p + 16*i));
+    y1 = _mm256_loadu_si256((const __m256i*)(p + 16*i + 32));
+    y2 = _mm256_loadu_si256((const __m256i*)(p + 16*i + 64));
+    y3 = _mm256_loadu_si256((const __m256i*)(p + 16*i + 96));
+
+    HX4_AVX2_BULK_INIT()
+    HX4_AVX2_BULK_SIPCOMPRESS(_mm256_unpacklo_epi64(y0, y1), _mm256_unpacklo_epi64(y2, y3))
+    HX4_AVX2_BULK_SIPCOMPRESS(_mm256_unpackhi_epi64(y0, y1), _mm256_unpackhi_epi64(y2, y3))
+    HX4_AVX2_BULK_SIPCOMPRESS(yb, yb)
+    HX4_AVX2_BULK_SIPFINAL()
+
+    _mm256_storeu_si256((__m256i*)(out + i), _mm256_permute4x64_epi64(v0a, _MM_SHUFFLE(3,1,2,0)));
+    _mm256_storeu_si256((__m256i*)(out + i + 4), _mm256_permute4x64_epi64(v0b, _MM_SHUFFLE(3,1,2,0)));
+  }
+
+  k0 = U8TO64_LE( (const uint8_t*)cookie );
+  k1 = U8TO64_LE( (const uint8_t*)cookie + 8 );
+  for( ; i<n; i++) {
+    out[i] = hx4_bulk_siphash13(k0, k1, p + 16*i, 2);
+  }
+
+  HX4_STATS_END(hx4_hash_u128_array_avx2, (uint64_t)n*16)
+  return HX4_ERR_SUCCESS;
+}
+
+#undef HX4_AVX2_BULK_SIPFINAL
+#undef HX4_AVX2_BULK_SIPCOMPRESS
+#undef HX4_AVX2_BULK_INIT
+#undef HX4_AVX2_HALFSIPROUND
+#undef HX4_AVX2_ROTL32_16
+#undef HX4_AVX2_ROTL32
+#undef HX4_AVX2_SIPROUND
+#undef HX4_AVX2_ROTL64_32
+#undef HX4_AVX2_ROTL64_16
+#undef HX4_AVX2_ROTL64
+#endif //HX4_HAS_AVX2
+
+//the unsuffixed functions use the widest variant the build enables
+HX4_API int hx4_hash_u32_array(const uint32_t *keys, size_t n, const void *cookie, size_t cookie_sz, uint32_t *out) {
+#if HX4_HAS_AVX2
+  return hx4_hash_u32_array_avx2(keys, n, cookie, cookie_sz, out);
+#elif HX4_HAS_SSE2
+  return hx4_hash_u32_array_sse2(keys, n, cookie, cookie_sz, out);
+#else
+  return hx4_hash_u32_array_ref(keys, n, cookie, cookie_sz, out);
+#endif
+}
+
+HX4_API int hx4_hash_u64_array(const uint64_t *keys, size_t n, const void *cookie, size_t cookie_sz, uint64_t *out) {
+#if HX4_HAS_AVX2
+  return hx4_hash_u64_array_avx2(keys, n, cookie, cookie_sz, out);
+#elif HX4_HAS_SSE2
+  return hx4_hash_u64_array_sse2(keys, n, cookie, cookie_sz, out);
+#else
+  return hx4_hash_u64_array_ref(keys, n, cookie, cookie_sz, out);
+#endif
+}
+
+HX4_API int hx4_hash_u128_array(const void *keys, size_t n, const void *cookie, size_t cookie_sz, uint64_t *out) {
+#if HX4_HAS_AVX2
+  return hx4_hash_u128_array_avx2(keys, n, cookie, cookie_sz, out);
+#elif HX4_HAS_SSE2
+  return hx4_hash_u128_array_sse2(keys, n, cookie, cookie_sz, out);
+#else
+  return hx4_hash_u128_array_ref(keys, n, cookie, cookie_sz, out);
+#endif
+}
+
+#undef HALFSIPROUND
+#undef HX4_BULK_PREFETCH_DISTANCE
+#undef ROTL32
+#undef ROTL64
+#undef SIPROUND
+#undef U32TO8_LE
+#undef U64TO8_LE
+#undef U8TO32_LE
+#undef U8TO64_LE
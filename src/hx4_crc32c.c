@@ -0,0 +1,310 @@
+/* 
+ * Copyright 2015 Kai Dietrich <mail@cleeus.de>
+ *
+ * This file is part of hashx4.
+ *
+ * Hashx4 is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Hashx4 is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with hashx4.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "hashx4_config.h"
+
+#if HX4_HAS_SSE42
+# include <nmmintrin.h>
+#endif
+
+#if HX4_HAS_PCLMUL
+# include <wmmintrin.h>
+#endif
+
+#include "hashx4.h"
+#include "hx4_util.h"
+
+// CRC-32C (Castagnoli) as in iSCSI, ext4 and SSE4.2, reflected polynomial
+// 0x1EDC6F41. The cookie is xored into the initial value ~0 of every
+// register, so a zero cookie gives the standard CRC-32C.
+//
+// crc32c_32 is the plain CRC of the input. The crc32 instruction has a
+// latency of 3 cycles and a throughput of 1 per cycle, a single register
+// only uses a third of it. The pclmul variant splits the input into three
+// blocks, runs three registers over them at the same time and shifts the
+// partial CRCs into one with a carry-less multiplication.
+//
+// x4crc32c_128 runs 4 registers over the 8 byte words of the input in turn,
+// word i goes to lane i % 4, like the x4 variants of the other hashes. The
+// result are the 4 lane CRCs, there is nothing to combine.
+
+#define HX4_CRC32C_POLY 0x82f63b78UL
+
+#define U32TO8_LE(p, v)         \
+    (p)[0] = (uint8_t)((v)      ); (p)[1] = (uint8_t)((v) >>  8); \
+    (p)[2] = (uint8_t)((v) >> 16); (p)[3] = (uint8_t)((v) >> 24);
+
+#define U8TO32_LE(p) \
+  (((uint32_t)((p)[0])      ) | \
+   ((uint32_t)((p)[1]) <<  8) | \
+   ((uint32_t)((p)[2]) << 16) | \
+   ((uint32_t)((p)[3]) << 24))
+
+//lane of the input byte at position i in the x4 variants
+#define HX4_CRC32C_LANE(i) (((i) >> 3) & 0x03)
+
+static uint32_t hx4_crc32c_init(const void *cookie, int lane) {
+  return 0xffffffffUL ^ U8TO32_LE((const uint8_t*)cookie + 4*lane);
+}
+
+//bitwise, the straightforward way
+static uint32_t hx4_crc32c_byte_ref(uint32_t crc, uint8_t b) {
+  int i;
+
+  crc ^= b;
+  for(i=0; i<8; i++) {
+    crc = (crc >> 1) ^ (HX4_CRC32C_POLY & (0UL - (crc & 1)));
+  }
+  return crc;
+}
+
+HX4_API int hx4_crc32c_32_ref(const void *in, size_t in_sz, const void *cookie, size_t cookie_sz, void *out, size_t out_sz) {
+  const uint8_t *p = (const uint8_t*)in;
+  uint32_t crc;
+  size_t i;
+  int rc;
+  HX4_STATS_BEGIN(hx4_crc32c_32_ref)
+
+  rc = hx4_check_params(32/8, in, in_sz, cookie, cookie_sz, out, out_sz);
+  if(rc != HX4_ERR_SUCCESS) {
+    return rc;
+  }
+
+  crc = hx4_crc32c_init(cookie, 0);
+  for(i=0; i<in_sz; i++) {
+    crc = hx4_crc32c_byte_ref(crc, p[i]);
+  }
+  crc = ~crc;
+
+  U32TO8_LE((uint8_t*)out, crc);
+  HX4_STATS_END(hx4_crc32c_32_ref, in_sz)
+  return HX4_ERR_SUCCESS;
+}
+
+HX4_API int hx4_x4crc32c_128_ref(const void *in, size_t in_sz, const void *cookie, size_t cookie_sz, void *out, size_t out_sz) {
+  const uint8_t *p = (const uint8_t*)in;
+  uint32_t crc[4];
+  size_t i;
+  int lane;
+  int rc;
+  HX4_STATS_BEGIN(hx4_x4crc32c_128_ref)
+
+  rc = hx4_check_params(128/8, in, in_sz, cookie, cookie_sz, out, out_sz);
+  if(rc != HX4_ERR_SUCCESS) {
+    return rc;
+  }
+
+  for(lane=0; lane<4; lane++) {
+    crc[lane] = hx4_crc32c_init(cookie, lane);
+  }
+  for(i=0; i<in_sz; i++) {
+    lane = HX4_CRC32C_LANE(i);
+    crc[lane] = hx4_crc32c_byte_ref(crc[lane], p[i]);
+  }
+  for(lane=0; lane<4; lane++) {
+    crc[lane] = ~crc[lane];
+    U32TO8_LE((uint8_t*)out + 4*lane, crc[lane]);
+  }
+  HX4_STATS_END(hx4_x4crc32c_128_ref, in_sz)
+  return HX4_ERR_SUCCESS;
+}
+
+#if HX4_HAS_SSE42
+
+//crc32 of an 8 byte word, 32bit x86 has no 64bit crc32 instruction
+#if defined(__x86_64__) || defined(_M_X64)
+# define HX4_CRC32C_U64(crc, w) ((uint32_t)_mm_crc32_u64((crc), (w)))
+#else
+# define HX4_CRC32C_U64(crc, w) _mm_crc32_u32(_mm_crc32_u32((crc), (uint32_t)(w)), (uint32_t)((w) >> 32))
+#endif
+
+HX4_INLINE uint64_t hx4_crc32c_load64(const uint8_t *p) {
+  uint64_t w;
+  memcpy(&w, p, sizeof(w));
+  return w;
+}
+
+//a single register over p, the tail of all sse42 variants
+HX4_INLINE uint32_t hx4_crc32c_sse42(uint32_t crc, const uint8_t *p, size_t sz) {
+  const uint8_t * const p_end = p + sz;
+
+  for( ; p_end - p >= 8; p += 8) {
+    crc = HX4_CRC32C_U64(crc, hx4_crc32c_load64(p));
+  }
+  for( ; p < p_end; p++) {
+    crc = _mm_crc32_u8(crc, *p);
+  }
+  return crc;
+}
+
+HX4_API int hx4_crc32c_32_sse42(const void *in, size_t in_sz, const void *cookie, size_t cookie_sz, void *out, size_t out_sz) {
+  uint32_t crc;
+  int rc;
+  HX4_STATS_BEGIN(hx4_crc32c_32_sse42)
+
+  rc = hx4_check_params(32/8, in, in_sz, cookie, cookie_sz, out, out_sz);
+  if(rc != HX4_ERR_SUCCESS) {
+    return rc;
+  }
+
+  crc = ~hx4_crc32c_sse42(hx4_crc32c_init(cookie, 0), (const uint8_t*)in, in_sz);
+
+  memcpy(out, &crc, sizeof(crc));
+  HX4_STATS_END(hx4_crc32c_32_sse42, in_sz)
+  return HX4_ERR_SUCCESS;
+}
+
+HX4_API int hx4_x4crc32c_128_sse42(const void *in, size_t in_sz, const void *cookie, size_t cookie_sz, void *out, size_t out_sz) {
+  const uint8_t *p = (const uint8_t*)in;
+  const uint8_t * const p_end = p + in_sz;
+  uint32_t crc[4];
+  uint32_t crc0;
+  uint32_t crc1;
+  uint32_t crc2;
+  uint32_t crc3;
+  size_t i;
+  int lane;
+  int rc;
+  HX4_STATS_BEGIN(hx4_x4crc32c_128_sse42)
+
+  rc = hx4_check_params(128/8, in, in_sz, cookie, cookie_sz, out, out_sz);
+  if(rc != HX4_ERR_SUCCESS) {
+    return rc;
+  }
+
+  crc0 = hx4_crc32c_init(cookie, 0);
+  crc1 = hx4_crc32c_init(cookie, 1);
+  crc2 = hx4_crc32c_init(cookie, 2);
+  crc3 = hx4_crc32c_init(cookie, 3);
+
+  //main processing loop, 4 independent dependency chains
+  for( ; p_end - p >= 32; p += 32) {
+    crc0 = HX4_CRC32C_U64(crc0, hx4_crc32c_load64(p));
+    crc1 = HX4_CRC32C_U64(crc1, hx4_crc32c_load64(p + 8));
+    crc2 = HX4_CRC32C_U64(crc2, hx4_crc32c_load64(p + 16));
+    crc3 = HX4_CRC32C_U64(crc3, hx4_crc32c_load64(p + 24));
+  }
+
+  crc[0] = crc0;
+  crc[1] = crc1;
+  crc[2] = crc2;
+  crc[3] = crc3;
+
+  //process any input that is left, the lanes go on with the byte position
+  for(i=0; p < p_end; i++, p++) {
+    lane = HX4_CRC32C_LANE(i);
+    crc[lane] = _mm_crc32_u8(crc[lane], *p);
+  }
+
+  for(lane=0; lane<4; lane++) {
+    crc[lane] = ~crc[lane];
+  }
+  memcpy(out, crc, sizeof(crc));
+  HX4_STATS_END(hx4_x4crc32c_128_sse42, in_sz)
+  return HX4_ERR_SUCCESS;
+}
+
+#if HX4_HAS_PCLMUL
+
+// Shifting a CRC over n zero bytes multiplies it with x^(8n) mod P. With
+// k = x^(8n-33) mod P the carry-less product crc * k has 64 bits, and the
+// crc32 instruction reduces it while multiplying with the missing x^33.
+// The constants are x^(16L-33) and x^(8L-33) mod P, bit reflected, for the
+// block lengths L below.
+#define HX4_CRC32C_BLOCK_LONG 1024
+#define HX4_CRC32C_BLOCK_LONG_K2 0xa51b6135UL
+#define HX4_CRC32C_BLOCK_LONG_K1 0x170076faUL
+#define HX4_CRC32C_BLOCK_SHORT 128
+#define HX4_CRC32C_BLOCK_SHORT_K2 0xb9e02b86UL
+#define HX4_CRC32C_BLOCK_SHORT_K1 0x0d3b6092UL
+
+HX4_INLINE uint32_t hx4_crc32c_shift_pclmul(uint32_t crc, uint32_t k) {
+  const __m128i product = _mm_clmulepi64_si128(_mm_cvtsi32_si128((int)crc), _mm_cvtsi32_si128((int)k), 0x00);
+  const uint32_t lo = (uint32_t)_mm_cvtsi128_si32(product);
+  const uint32_t hi = (uint32_t)_mm_cvtsi128_si32(_mm_srli_si128(product, 4));
+  return _mm_crc32_u32(_mm_crc32_u32(0, lo), hi);
+}
+
+//three registers over three consecutive blocks of block bytes each, for as long as the input lasts
+HX4_INLINE uint32_t hx4_crc32c_3way(uint32_t crc, const uint8_t **pp, size_t *sz, size_t block, uint32_t k2, uint32_t k1) {
+  const uint8_t *p = *pp;
+  uint32_t crc0;
+  uint32_t crc1;
+  uint32_t crc2;
+  size_t i;
+
+  while(*sz >= 3*block) {
+    crc0 = crc;
+    crc1 = 0;
+    crc2 = 0;
+    for(i=0; i<block; i+=8) {
+      crc0 = HX4_CRC32C_U64(crc0, hx4_crc32c_load64(p + i));
+      crc1 = HX4_CRC32C_U64(crc1, hx4_crc32c_load64(p + block + i));
+      crc2 = HX4_CRC32C_U64(crc2, hx4_crc32c_load64(p + 2*block + i));
+    }
+    crc = hx4_crc32c_shift_pclmul(crc0, k2) ^ hx4_crc32c_shift_pclmul(crc1, k1) ^ crc2;
+    p += 3*block;
+    *sz -= 3*block;
+  }
+
+  *pp = p;
+  return crc;
+}
+
+HX4_API int hx4_crc32c_32_pclmul(const void *in, size_t in_sz, const void *cookie, size_t cookie_sz, void *out, size_t out_sz) {
+  const uint8_t *p = (const uint8_t*)in;
+  uint32_t crc;
+  int rc;
+  HX4_STATS_BEGIN(hx4_crc32c_32_pclmul)
+
+  rc = hx4_check_params(32/8, in, in_sz, cookie, cookie_sz, out, out_sz);
+  if(rc != HX4_ERR_SUCCESS) {
+    return rc;
+  }
+
+  crc = hx4_crc32c_init(cookie, 0);
+  crc = hx4_crc32c_3way(crc, &p, &in_sz, HX4_CRC32C_BLOCK_LONG, HX4_CRC32C_BLOCK_LONG_K2, HX4_CRC32C_BLOCK_LONG_K1);
+  crc = hx4_crc32c_3way(crc, &p, &in_sz, HX4_CRC32C_BLOCK_SHORT, HX4_CRC32C_BLOCK_SHORT_K2, HX4_CRC32C_BLOCK_SHORT_K1);
+  crc = ~hx4_crc32c_sse42(crc, p, in_sz);
+
+  memcpy(out, &crc, sizeof(crc));
+  HX4_STATS_END(hx4_crc32c_32_pclmul, in_sz)
+  return HX4_ERR_SUCCESS;
+}
+
+#undef HX4_CRC32C_BLOCK_LONG
+#undef HX4_CRC32C_BLOCK_LONG_K2
+#undef HX4_CRC32C_BLOCK_LONG_K1
+#undef HX4_CRC32C_BLOCK_SHORT
+#undef HX4_CRC32C_BLOCK_SHORT_K2
+#undef HX4_CRC32C_BLOCK_SHORT_K1
+#endif //HX4_HAS_PCLMUL
+
+#undef HX4_CRC32C_U64
+#endif //HX4_HAS_SSE42
+
+#undef HX4_CRC32C_LANE
+#undef U8TO32_LE
+#undef U32TO8_LE
+#undef HX4_CRC32C_POLY
@@ -0,0 +1,561 @@
+/* 
+ * Copyright 2015 Kai Dietrich <mail@cleeus.de>
+ *
+ * This file is part of hashx4.
+ *
+ * Hashx4 is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Hashx4 is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with hashx4.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef __GNUC__
+# include <time.h>
+# if defined(__x86_64__) || defined(__i386__)
+#  include <cpuid.h>
+# endif
+#elif _MSC_VER
+# include <windows.h>
+# include <intrin.h>
+#endif
+
+#include "hashx4_config.h"
+#include "hashx4.h"
+#include "hashx4_dispatch.h"
+#include "hx4_util.h"
+
+// The kernels of every algorithm, ref first and the widest last. The
+// profile file names them, so a profile stays valid when the kernels of
+// other instruction sets are added or removed from the build.
+
+typedef struct {
+  const char *name;
+  hx4_hash_function function;
+} hx4_dispatch_kernel;
+
+typedef struct {
+  const char *name;
+  size_t out_sz;
+  const hx4_dispatch_kernel *kernels;
+  size_t num_kernels;
+} hx4_dispatch_algorithm;
+
+static const hx4_dispatch_kernel hx4_dispatch_djbx33a_32[] = {
+  { "ref", hx4_djbx33a_32_ref },
+  { "copt", hx4_djbx33a_32_copt },
+};
+
+static const hx4_dispatch_kernel hx4_dispatch_x4djbx33a_128[] = {
+  { "ref", hx4_x4djbx33a_128_ref },
+  { "copt", hx4_x4djbx33a_128_copt },
+#if HX4_HAS_MMX
+  { "mmx", hx4_x4djbx33a_128_mmx },
+#endif
+#if HX4_HAS_SSE2
+  { "sse2rle", hx4_x4djbx33a_128_sse2rle },
+  { "sse2", hx4_x4djbx33a_128_sse2 },
+#endif
+#if HX4_HAS_SSSE3
+  { "ssse3", hx4_x4djbx33a_128_ssse3 },
+#endif
+};
+
+static const hx4_dispatch_kernel hx4_dispatch_kdjbx33a_32[] = {
+  { "ref", hx4_kdjbx33a_32_ref },
+  { "copt", hx4_kdjbx33a_32_copt },
+};
+
+static const hx4_dispatch_kernel hx4_dispatch_x4kdjbx33a_128[] = {
+  { "ref", hx4_x4kdjbx33a_128_ref },
+  { "copt", hx4_x4kdjbx33a_128_copt },
+#if HX4_HAS_SSE2
+  { "sse2", hx4_x4kdjbx33a_128_sse2 },
+#endif
+#if HX4_HAS_SSSE3
+  { "ssse3", hx4_x4kdjbx33a_128_ssse3 },
+#endif
+};
+
+static const hx4_dispatch_kernel hx4_dispatch_siphash24_64[] = {
+  { "ref", hx4_siphash24_64_ref },
+  { "copt", hx4_siphash24_64_copt },
+};
+
+static const hx4_dispatch_kernel hx4_dispatch_siphash13_64[] = {
+  { "ref", hx4_siphash13_64_ref },
+  { "copt", hx4_siphash13_64_copt },
+};
+
+static const hx4_dispatch_kernel hx4_dispatch_x4siphash13_256[] = {
+  { "ref", hx4_x4siphash13_256_ref },
+#if HX4_HAS_SSE2
+  { "sse2", hx4_x4siphash13_256_sse2 },
+#endif
+};
+
+static const hx4_dispatch_kernel hx4_dispatch_halfsiphash13_32[] = {
+  { "ref", hx4_halfsiphash13_32_ref },
+  { "copt", hx4_halfsiphash13_32_copt },
+};
+
+static const hx4_dispatch_kernel hx4_dispatch_x4halfsiphash13_128[] = {
+  { "ref", hx4_x4halfsiphash13_128_ref },
+#if HX4_HAS_SSE2
+  { "sse2", hx4_x4halfsiphash13_128_sse2 },
+#endif
+};
+
+static const hx4_dispatch_kernel hx4_dispatch_crc32c_32[] = {
+  { "ref", hx4_crc32c_32_ref },
+#if HX4_HAS_SSE42
+  { "sse42", hx4_crc32c_32_sse42 },
+#endif
+#if HX4_HAS_SSE42 && HX4_HAS_PCLMUL
+  { "pclmul", hx4_crc32c_32_pclmul },
+#endif
+};
+
+static const hx4_dispatch_kernel hx4_dispatch_x4crc32c_128[] = {
+  { "ref", hx4_x4crc32c_128_ref },
+#if HX4_HAS_SSE42
+  { "sse42", hx4_x4crc32c_128_sse42 },
+#endif
+};
+
+static const hx4_dispatch_kernel hx4_dispatch_x4aes_128[] = {
+  { "ref", hx4_x4aes_128_ref },
+#if HX4_HAS_AESNI
+  { "aesni", hx4_x4aes_128_aesni },
+#endif
+};
+
+static const hx4_dispatch_kernel hx4_dispatch_polyval_128[] = {
+  { "ref", hx4_polyval_128_ref },
+#if HX4_HAS_PCLMUL
+  { "pclmul", hx4_polyval_128_pclmul },
+#endif
+};
+
+static const hx4_dispatch_kernel hx4_dispatch_x4mulfold_128[] = {
+  { "ref", hx4_x4mulfold_128_ref },
+  { "copt", hx4_x4mulfold_128_copt },
+#if HX4_HAS_SSE2
+  { "sse2", hx4_x4mulfold_128_sse2 },
+#endif
+#if HX4_HAS_AVX2
+  { "avx2", hx4_x4mulfold_128_avx2 },
+#endif
+};
+
+#define HX4_DISPATCH_ALGORITHM(name, out_bits) \
+  { #name, (out_bits)/8, hx4_dispatch_##name, sizeof(hx4_dispatch_##name)/sizeof(hx4_dispatch_##name[0]) }
+
+//in the order of the HX4_ALG_ constants
+static const hx4_dispatch_algorithm hx4_dispatch_algorithms[HX4_ALG_COUNT] = {
+  HX4_DISPATCH_ALGORITHM(djbx33a_32, 32),
+  HX4_DISPATCH_ALGORITHM(x4djbx33a_128, 128),
+  HX4_DISPATCH_ALGORITHM(kdjbx33a_32, 32),
+  HX4_DISPATCH_ALGORITHM(x4kdjbx33a_128, 128),
+  HX4_DISPATCH_ALGORITHM(siphash24_64, 64),
+  HX4_DISPATCH_ALGORITHM(siphash13_64, 64),
+  HX4_DISPATCH_ALGORITHM(x4siphash13_256, 256),
+  HX4_DISPATCH_ALGORITHM(halfsiphash13_32, 32),
+  HX4_DISPATCH_ALGORITHM(x4halfsiphash13_128, 128),
+  HX4_DISPATCH_ALGORITHM(crc32c_32, 32),
+  HX4_DISPATCH_ALGORITHM(x4crc32c_128, 128),
+  HX4_DISPATCH_ALGORITHM(x4aes_128, 128),
+  HX4_DISPATCH_ALGORITHM(polyval_128, 128),
+  HX4_DISPATCH_ALGORITHM(x4mulfold_128, 128),
+};
+
+#undef HX4_DISPATCH_ALGORITHM
+
+//the input size that is measured for every size class
+static const size_t hx4_dispatch_class_sizes[HX4_DISPATCH_SIZE_CLASSES] = { 16, 64, 256, 4096, 64*1024 };
+
+//bytes hashed per measurement and the number of measurements, the best one counts
+#define HX4_DISPATCH_MEASURE_BYTES (256*1024)
+#define HX4_DISPATCH_MEASURE_RUNS 3
+
+#define HX4_DISPATCH_FILE_MAGIC "hx4dispatch 1"
+
+int hx4_dispatch_size_class(size_t in_sz) {
+  if(in_sz <= 16) {
+    return 0;
+  } else if(in_sz <= 64) {
+    return 1;
+  } else if(in_sz <= 256) {
+    return 2;
+  } else if(in_sz <= 4096) {
+    return 3;
+  }
+  return 4;
+}
+
+size_t hx4_dispatch_num_kernels(int algorithm) {
+  if(algorithm < 0 || algorithm >= HX4_ALG_COUNT) {
+    return 0;
+  }
+  return hx4_dispatch_algorithms[algorithm].num_kernels;
+}
+
+const char *hx4_dispatch_algorithm_name(int algorithm) {
+  if(algorithm < 0 || algorithm >= HX4_ALG_COUNT) {
+    return NULL;
+  }
+  return hx4_dispatch_algorithms[algorithm].name;
+}
+
+const char *hx4_dispatch_kernel_name(int algorithm, size_t kernel) {
+  if(kernel >= hx4_dispatch_num_kernels(algorithm)) {
+    return NULL;
+  }
+  return hx4_dispatch_algorithms[algorithm].kernels[kernel].name;
+}
+
+//the brand string with the leading blanks removed, "unknown" if there is no cpuid
+static void hx4_dispatch_cpu(char *cpu, size_t cpu_sz) {
+  char brand[3*16 + 1];
+  const char *p = brand;
+  uint32_t regs[12];
+  size_t i;
+  int have_brand = 0;
+
+  memset(brand, 0, sizeof(brand));
+  memset(regs, 0, sizeof(regs));
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+  if(__get_cpuid_max(0x80000000, NULL) >= 0x80000004) {
+    __get_cpuid(0x80000002, &regs[0], &regs[1], &regs[2], &regs[3]);
+    __get_cpuid(0x80000003, &regs[4], &regs[5], &regs[6], &regs[7]);
+    __get_cpuid(0x80000004, &regs[8], &regs[9], &regs[10], &regs[11]);
+    have_brand = 1;
+  }
+#elif _MSC_VER
+  {
+    int info[4];
+    __cpuid(info, 0x80000000);
+    if((uint32_t)info[0] >= 0x80000004) {
+      __cpuid((int*)&regs[0], 0x80000002);
+      __cpuid((int*)&regs[4], 0x80000003);
+      __cpuid((int*)&regs[8], 0x80000004);
+      have_brand = 1;
+    }
+  }
+#endif
+
+  if(have_brand) {
+    memcpy(brand, regs, sizeof(regs));
+    while(*p == ' ') {
+      p++;
+    }
+  }
+  if(*p == '\0') {
+    p = "unknown";
+  }
+
+  memset(cpu, 0, cpu_sz);
+  for(i=0; i+1<cpu_sz && p[i] != '\0'; i++) {
+    cpu[i] = p[i];
+  }
+}
+
+//monotonic time in seconds
+static double hx4_dispatch_now(void) {
+#ifdef __GNUC__
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec + (double)ts.tv_nsec / 1000000000.0;
+#elif _MSC_VER
+  LARGE_INTEGER count;
+  LARGE_INTEGER frequency;
+  QueryPerformanceCounter(&count);
+  QueryPerformanceFrequency(&frequency);
+  return (double)count.QuadPart / (double)frequency.QuadPart;
+#endif
+}
+
+void hx4_dispatch_init(hx4_dispatch_table *table) {
+  int algorithm;
+  int size_class;
+
+  memset(table, 0, sizeof(*table));
+  hx4_dispatch_cpu(table->cpu, sizeof(table->cpu));
+  for(algorithm=0; algorithm<HX4_ALG_COUNT; algorithm++) {
+    for(size_class=0; size_class<HX4_DISPATCH_SIZE_CLASSES; size_class++) {
+      table->kernel[algorithm][size_class] = (uint8_t)(hx4_dispatch_algorithms[algorithm].num_kernels - 1);
+    }
+  }
+}
+
+int hx4_dispatch_calibrate(hx4_dispatch_table *table, void *memory, size_t memory_sz) {
+  const uint8_t cookie[128/8] = {
+    0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f
+  };
+  uint8_t * const in = memory;
+  uint8_t out[256/8];
+  double best[HX4_DISPATCH_SIZE_CLASSES][16];
+  double start;
+  double duration;
+  uint64_t x = 0x2545f4914f6cdd1dULL;
+  const hx4_dispatch_algorithm *a;
+  size_t in_sz;
+  size_t repeats;
+  size_t kernel;
+  size_t i;
+  int algorithm;
+  int size_class;
+  int run;
+
+  if(table == NULL || memory == NULL) {
+    return HX4_ERR_PARAM_INVALID;
+  }
+  if(memory_sz < HX4_DISPATCH_CALIBRATE_MEMORY_SIZE) {
+    return HX4_ERR_BUFFER_TOO_SMALL;
+  }
+
+  for(i=0; i<HX4_DISPATCH_CALIBRATE_MEMORY_SIZE; i++) {
+    x = x * 6364136223846793005ULL + 1442695040888963407ULL;
+    in[i] = (uint8_t)(x >> 56);
+  }
+
+  hx4_dispatch_init(table);
+
+  for(algorithm=0; algorithm<HX4_ALG_COUNT; algorithm++) {
+    a = &hx4_dispatch_algorithms[algorithm];
+
+    //the kernels take turns in every run, so a change of the clock
+    //frequency does not favor the ones that were measured first
+    for(size_class=0; size_class<HX4_DISPATCH_SIZE_CLASSES; size_class++) {
+      in_sz = hx4_dispatch_class_sizes[size_class];
+      repeats = HX4_DISPATCH_MEASURE_BYTES / in_sz;
+      for(kernel=0; kernel<a->num_kernels; kernel++) {
+        best[size_class][kernel] = -1;
+      }
+      for(run=0; run<HX4_DISPATCH_MEASURE_RUNS; run++) {
+        for(kernel=0; kernel<a->num_kernels; kernel++) {
+          start = hx4_dispatch_now();
+          for(i=0; i<repeats; i++) {
+            a->kernels[kernel].function(in, in_sz, cookie, sizeof(cookie), out, a->out_sz);
+          }
+          duration = hx4_dispatch_now() - start;
+          if(best[size_class][kernel] < 0 || duration < best[size_class][kernel]) {
+            best[size_class][kernel] = duration;
+          }
+        }
+      }
+      for(kernel=1; kernel<a->num_kernels; kernel++) {
+        if(best[size_class][kernel] < best[size_class][table->kernel[algorithm][size_class]]) {
+          table->kernel[algorithm][size_class] = (uint8_t)kernel;
+        }
+      }
+    }
+  }
+
+  return HX4_ERR_SUCCESS;
+}
+
+int hx4_dispatch_save(const hx4_dispatch_table *table, const char *path) {
+  FILE *f;
+  int algorithm;
+  int size_class;
+  int rc = HX4_ERR_SUCCESS;
+
+  if(table == NULL || path == NULL) {
+    return HX4_ERR_PARAM_INVALID;
+  }
+
+  f = fopen(path, "w");
+  if(f == NULL) {
+    return HX4_ERR_NOT_FOUND;
+  }
+
+  fprintf(f, "%s\n", HX4_DISPATCH_FILE_MAGIC);
+  fprintf(f, "cpu %s\n", table->cpu);
+  for(algorithm=0; algorithm<HX4_ALG_COUNT; algorithm++) {
+    fprintf(f, "%s", hx4_dispatch_algorithms[algorithm].name);
+    for(size_class=0; size_class<HX4_DISPATCH_SIZE_CLASSES; size_class++) {
+      fprintf(f, " %s", hx4_dispatch_kernel_name(algorithm, table->kernel[algorithm][size_class]));
+    }
+    fprintf(f, "\n");
+  }
+
+  if(ferror(f)) {
+    rc = HX4_ERR_PARAM_INVALID;
+  }
+  if(fclose(f) != 0) {
+    rc = HX4_ERR_PARAM_INVALID;
+  }
+  return rc;
+}
+
+//the index of the kernel name in the algorithm, -1 if this build does not have it
+static int hx4_dispatch_find_kernel(const hx4_dispatch_algorithm *a, const char *name) {
+  size_t kernel;
+
+  for(kernel=0; kernel<a->num_kernels; kernel++) {
+    if(strcmp(a->kernels[kernel].name, name) == 0) {
+      return (int)kernel;
+    }
+  }
+  return -1;
+}
+
+int hx4_dispatch_load(hx4_dispatch_table *table, const char *path) {
+  hx4_dispatch_table loaded;
+  char line[256];
+  char names[1 + HX4_DISPATCH_SIZE_CLASSES][32];
+  uint8_t seen[HX4_ALG_COUNT];
+  const hx4_dispatch_algorithm *a;
+  FILE *f;
+  size_t len;
+  int algorithm;
+  int size_class;
+  int kernel;
+  int rc = HX4_ERR_SUCCESS;
+
+  if(table == NULL || path == NULL) {
+    return HX4_ERR_PARAM_INVALID;
+  }
+
+  f = fopen(path, "r");
+  if(f == NULL) {
+    return HX4_ERR_NOT_FOUND;
+  }
+
+  memset(&loaded, 0, sizeof(loaded));
+  memset(seen, 0, sizeof(seen));
+
+  //magic and cpu line
+  if(fgets(line, sizeof(line), f) == NULL || strncmp(line, HX4_DISPATCH_FILE_MAGIC "\n", sizeof(line)) != 0) {
+    rc = HX4_ERR_PARAM_INVALID;
+  } else if(fgets(line, sizeof(line), f) == NULL || strncmp(line, "cpu ", 4) != 0) {
+    rc = HX4_ERR_PARAM_INVALID;
+  } else {
+    len = strlen(line);
+    if(len > 0 && line[len-1] == '\n') {
+      line[len-1] = '\0';
+    }
+    hx4_dispatch_cpu(loaded.cpu, sizeof(loaded.cpu));
+    if(strcmp(line + 4, loaded.cpu) != 0) {
+      rc = HX4_ERR_NOT_FOUND;
+    }
+  }
+
+  //one line per algorithm
+  while(rc == HX4_ERR_SUCCESS && fgets(line, sizeof(line), f) != NULL) {
+    if(sscanf(line, "%31s %31s %31s %31s %31s %31s", names[0], names[1], names[2], names[3], names[4], names[5]) != 1 + HX4_DISPATCH_SIZE_CLASSES) {
+      rc = HX4_ERR_PARAM_INVALID;
+      break;
+    }
+    for(algorithm=0; algorithm<HX4_ALG_COUNT; algorithm++) {
+      if(strcmp(hx4_dispatch_algorithms[algorithm].name, names[0]) == 0) {
+        break;
+      }
+    }
+    if(algorithm == HX4_ALG_COUNT) {
+      rc = HX4_ERR_NOT_FOUND;
+      break;
+    }
+    a = &hx4_dispatch_algorithms[algorithm];
+    for(size_class=0; size_class<HX4_DISPATCH_SIZE_CLASSES; size_class++) {
+      kernel = hx4_dispatch_find_kernel(a, names[1 + size_class]);
+      if(kernel < 0) {
+        rc = HX4_ERR_NOT_FOUND;
+        break;
+      }
+      loaded.kernel[algorithm][size_class] = (uint8_t)kernel;
+    }
+    seen[algorithm] = 1;
+  }
+  fclose(f);
+
+  //a profile of an older build may lack algorithms
+  for(algorithm=0; rc == HX4_ERR_SUCCESS && algorithm<HX4_ALG_COUNT; algorithm++) {
+    if(!seen[algorithm]) {
+      rc = HX4_ERR_NOT_FOUND;
+    }
+  }
+
+  if(rc == HX4_ERR_SUCCESS) {
+    memcpy(table, &loaded, sizeof(loaded));
+  }
+  return rc;
+}
+
+int hx4_dispatch_load_or_calibrate(hx4_dispatch_table *table, const char *path, void *memory, size_t memory_sz) {
+  int rc;
+
+  if(path != NULL && hx4_dispatch_load(table, path) == HX4_ERR_SUCCESS) {
+    return HX4_ERR_SUCCESS;
+  }
+
+  rc = hx4_dispatch_calibrate(table, memory, memory_sz);
+  if(rc != HX4_ERR_SUCCESS) {
+    return rc;
+  }
+
+  //a profile that can't be written only costs the next process a calibration
+  if(path != NULL) {
+    hx4_dispatch_save(table, path);
+  }
+  return HX4_ERR_SUCCESS;
+}
+
+const hx4_dispatch_table *hx4_dispatch_default(void) {
+  static hx4_dispatch_table table;
+  static uint8_t memory[HX4_DISPATCH_CALIBRATE_MEMORY_SIZE];
+  static int ready = 0;
+
+  if(!ready) {
+    if(hx4_dispatch_load_or_calibrate(&table, getenv("HX4_DISPATCH_PROFILE"), memory, sizeof(memory)) != HX4_ERR_SUCCESS) {
+      hx4_dispatch_init(&table);
+    }
+    ready = 1;
+  }
+  return &table;
+}
+
+hx4_hash_function hx4_dispatch_function(const hx4_dispatch_table *table, int algorithm, size_t in_sz) {
+  const hx4_dispatch_algorithm *a;
+  size_t kernel;
+
+  if(table == NULL || algorithm < 0 || algorithm >= HX4_ALG_COUNT) {
+    return NULL;
+  }
+  a = &hx4_dispatch_algorithms[algorithm];
+  kernel = table->kernel[algorithm][hx4_dispatch_size_class(in_sz)];
+  if(kernel >= a->num_kernels) {
+    return NULL;
+  }
+  return a->kernels[kernel].function;
+}
+
+int hx4_dispatch_hash(const hx4_dispatch_table *table, int algorithm, const void *in, size_t in_sz, const void *cookie, size_t cookie_sz, void *out, size_t out_sz) {
+  const hx4_hash_function function = hx4_dispatch_function(table, algorithm, in_sz);
+
+  if(function == NULL) {
+    return HX4_ERR_PARAM_INVALID;
+  }
+  return function(in, in_sz, cookie, cookie_sz, out, out_sz);
+}
+
+#undef HX4_DISPATCH_FILE_MAGIC
+#undef HX4_DISPATCH_MEASURE_RUNS
+#undef HX4_DISPATCH_MEASURE_BYTES
@@ -37,44 +37,81 @@
 
 #include "hashx4.h"
 #include "hx4_util.h"
+#include "hx4_stream.h"
 
+HX4_API void hx4_djbx33a_32_init(hx4_djb_stream *stream, const void *cookie) {
+  memset(stream, 0, sizeof(*stream));
+  stream->state[0] = 5381;
+  memcpy(stream->cookie, cookie, sizeof(stream->cookie));
+}
 
-int hx4_djbx33a_32_ref(const void *buffer, size_t buffer_size, const void *cookie, size_t cookie_sz, void *out_hash, size_t out_hash_size) {
-  const uint8_t *p;
-  const uint8_t * const buffer_end = (uint8_t*)buffer + buffer_size;
-  uint32_t state = 5381;
-  int rc;
+HX4_API void hx4_djbx33a_32_final(hx4_djb_stream *stream, void *out) {
+  uint32_t state = stream->state[0];
+  hx4_xor_cookie_32(&state, stream->cookie);
+  memcpy(out, &state, sizeof(state));
+}
 
-  rc = hx4_check_params(sizeof(state), buffer, buffer_size, cookie, cookie_sz, out_hash, out_hash_size);
-  if(rc != HX4_ERR_SUCCESS) {
-    return rc;
+HX4_API void hx4_x4djbx33a_128_init(hx4_djb_stream *stream, const void *cookie) {
+  int i;
+  memset(stream, 0, sizeof(*stream));
+  for(i=0; i<4; i++) {
+    stream->state[i] = 5381;
   }
+  memcpy(stream->cookie, cookie, sizeof(stream->cookie));
+}
+
+HX4_API void hx4_x4djbx33a_128_final(hx4_djb_stream *stream, void *out) {
+  uint32_t state[4];
+  memcpy(state, stream->state, sizeof(state));
+  hx4_xor_cookie_128(state, stream->cookie);
+  memcpy(out, state, sizeof(state));
+}
+
+
+HX4_API void hx4_djbx33a_32_ref_update(hx4_djb_stream *stream, const void *buffer, size_t buffer_size) {
+  const uint8_t *p;
+  const uint8_t * const buffer_end = (uint8_t*)buffer + buffer_size;
+  uint32_t state = stream->state[0];
   
-  p = buffer;
+  p = (const uint8_t*)buffer;
   while(p<buffer_end) {
     state = state * 33  + *p;
     p++;
   }
 
-  hx4_xor_cookie_32(&state, cookie);
-  memcpy(out_hash, &state, sizeof(state));
-  return HX4_ERR_SUCCESS;
+  stream->state[0] = state;
+  stream->pos += buffer_size;
 }
 
-int hx4_djbx33a_32_copt(const void *buffer, size_t buffer_size, const void *cookie, size_t cookie_sz, void *out_hash, size_t out_hash_size) {
+HX4_STREAM_ONESHOT_IMPL(hx4_djbx33a_32_ref, hx4_djb_stream, 32/8, hx4_djbx33a_32_init, hx4_djbx33a_32_final)
+HX4_STREAM_V_IMPL(hx4_djbx33a_32_ref, hx4_djb_stream, 32/8, hx4_djbx33a_32_init, hx4_djbx33a_32_final)
+HX4_STREAM_CSTR_STRLEN_IMPL(hx4_djbx33a_32_ref)
+
+HX4_API void hx4_djbx33a_32_ref_ci_update(hx4_djb_stream *stream, const void *buffer, size_t buffer_size) {
+  const uint8_t *p;
+  const uint8_t * const buffer_end = (uint8_t*)buffer + buffer_size;
+  uint32_t state = stream->state[0];
+  
+  p = (const uint8_t*)buffer;
+  while(p<buffer_end) {
+    state = state * 33  + hx4_ascii_tolower(*p);
+    p++;
+  }
+
+  stream->state[0] = state;
+  stream->pos += buffer_size;
+}
+
+HX4_STREAM_CI_IMPL(hx4_djbx33a_32_ref, hx4_djb_stream, 32/8, hx4_djbx33a_32_init, hx4_djbx33a_32_final)
+
+HX4_API void hx4_djbx33a_32_copt_update(hx4_djb_stream *stream, const void *buffer, size_t buffer_size) {
   const uint8_t *p;
   const uint8_t * const buffer_end = (uint8_t*)buffer + buffer_size;
   const int num_bytes_to_seek = hx4_bytes_to_aligned(buffer, 16);
-  uint32_t state = 5381;
-  int rc;
+  uint32_t state = stream->state[0];
   int i;
 
-  rc = hx4_check_params(sizeof(state), buffer, buffer_size, cookie, cookie_sz, out_hash, out_hash_size);
-  if(rc != HX4_ERR_SUCCESS) {
-    return rc;
-  }
-
-  p = buffer;
+  p = (const uint8_t*)buffer;
 
   //hash input until p is aligned to alignment_target
   for(i=0; p<buffer_end && i<num_bytes_to_seek; i++) {
@@ -129,54 +166,140 @@ int hx4_djbx33a_32_copt(const void *buffer, size_t buffer_size, const void *cook
     p++;
   }
 
- 
-  hx4_xor_cookie_32(&state, cookie);
-  memcpy(out_hash, &state, sizeof(state));
-  return HX4_ERR_SUCCESS;
+
+  stream->state[0] = state;
+  stream->pos += buffer_size;
 }
 
+HX4_STREAM_ONESHOT_IMPL(hx4_djbx33a_32_copt, hx4_djb_stream, 32/8, hx4_djbx33a_32_init, hx4_djbx33a_32_final)
+HX4_STREAM_V_IMPL(hx4_djbx33a_32_copt, hx4_djb_stream, 32/8, hx4_djbx33a_32_init, hx4_djbx33a_32_final)
+HX4_STREAM_CSTR_STRLEN_IMPL(hx4_djbx33a_32_copt)
 
-int hx4_x4djbx33a_128_ref(const void *buffer, size_t buffer_size, const void *cookie, size_t cookie_sz, void *out_hash, size_t out_hash_size) {
+HX4_API void hx4_djbx33a_32_copt_ci_update(hx4_djb_stream *stream, const void *buffer, size_t buffer_size) {
   const uint8_t *p;
   const uint8_t * const buffer_end = (uint8_t*)buffer + buffer_size;
-  uint32_t state[] = { 5381, 5381, 5381, 5381 };
-  int state_i=0;
-  int rc;
+  const int num_bytes_to_seek = hx4_bytes_to_aligned(buffer, 16);
+  uint32_t state = stream->state[0];
+  int i;
+
+  p = (const uint8_t*)buffer;
 
-  rc = hx4_check_params(sizeof(state), buffer, buffer_size, cookie, cookie_sz, out_hash, out_hash_size);
-  if(rc != HX4_ERR_SUCCESS) {
-    return rc;
+  //hash input until p is aligned to alignment_target
+  for(i=0; p<buffer_end && i<num_bytes_to_seek; i++) {
+    state  = (state << 5) + state  + hx4_ascii_tolower(*p);
+    p++;
   }
+
+  HX4_ASSUME_ALIGNED(p, 16)
+
+  //main processing loop
+  while(p+15<buffer_end) {
+    HX4_ASSUME_ALIGNED(p, 16)
+
+#if 1
+#define HX4_DJBX33A_ROUND(round) \
+    /* state = state * 33 + hx4_ascii_tolower(p[round]); */ \
+    state = (state << 5) + state + hx4_ascii_tolower(p[round]);
+
+    HX4_DJBX33A_ROUND(0)
+    HX4_DJBX33A_ROUND(1)
+    HX4_DJBX33A_ROUND(2)
+    HX4_DJBX33A_ROUND(3)
+    HX4_DJBX33A_ROUND(4)
+    HX4_DJBX33A_ROUND(5)
+    HX4_DJBX33A_ROUND(6)
+    HX4_DJBX33A_ROUND(7)
+    HX4_DJBX33A_ROUND(8)
+    HX4_DJBX33A_ROUND(9)
+    HX4_DJBX33A_ROUND(10)
+    HX4_DJBX33A_ROUND(11)
+    HX4_DJBX33A_ROUND(12)
+    HX4_DJBX33A_ROUND(13)
+    HX4_DJBX33A_ROUND(14)
+    HX4_DJBX33A_ROUND(15)
+#endif
+
+#if 0
+    for(i=0; i<16; i++) {
+      //state = state*33 + p[i];
+      state = (state << 5) + state + p[i];
+    }
+#endif
+
+    p+=16;
+  }
+#undef HX4_DJBX33A_ROUND
+
+  //hash remainder
+  while(p<buffer_end) {
+    //state = state * 33  + hx4_ascii_tolower(*p);
+    state = (state << 5) + state + hx4_ascii_tolower(*p);
+    p++;
+  }
+
+
+  stream->state[0] = state;
+  stream->pos += buffer_size;
+}
+
+HX4_STREAM_CI_IMPL(hx4_djbx33a_32_copt, hx4_djb_stream, 32/8, hx4_djbx33a_32_init, hx4_djbx33a_32_final)
+
+
+HX4_API void hx4_x4djbx33a_128_ref_update(hx4_djb_stream *stream, const void *buffer, size_t buffer_size) {
+  const uint8_t *p;
+  const uint8_t * const buffer_end = (uint8_t*)buffer + buffer_size;
+  uint32_t state[4];
+  int state_i = (int)(stream->pos & 0x03);
+
+  memcpy(state, stream->state, sizeof(state));
   
-  p = buffer;
+  p = (const uint8_t*)buffer;
   while(p<buffer_end) {
     state[state_i] = state[state_i] * 33  + *p;
     p++;
     state_i = (state_i+1) % 4;
   }
 
-  hx4_xor_cookie_128(state, cookie);
-  memcpy(out_hash, state, sizeof(state));
+  memcpy(stream->state, state, sizeof(state));
+  stream->pos += buffer_size;
+}
 
-  return HX4_ERR_SUCCESS;
+HX4_STREAM_ONESHOT_IMPL(hx4_x4djbx33a_128_ref, hx4_djb_stream, 128/8, hx4_x4djbx33a_128_init, hx4_x4djbx33a_128_final)
+HX4_STREAM_V_IMPL(hx4_x4djbx33a_128_ref, hx4_djb_stream, 128/8, hx4_x4djbx33a_128_init, hx4_x4djbx33a_128_final)
+HX4_STREAM_CSTR_STRLEN_IMPL(hx4_x4djbx33a_128_ref)
+
+HX4_API void hx4_x4djbx33a_128_ref_ci_update(hx4_djb_stream *stream, const void *buffer, size_t buffer_size) {
+  const uint8_t *p;
+  const uint8_t * const buffer_end = (uint8_t*)buffer + buffer_size;
+  uint32_t state[4];
+  int state_i = (int)(stream->pos & 0x03);
+
+  memcpy(state, stream->state, sizeof(state));
+  
+  p = (const uint8_t*)buffer;
+  while(p<buffer_end) {
+    state[state_i] = state[state_i] * 33  + hx4_ascii_tolower(*p);
+    p++;
+    state_i = (state_i+1) % 4;
+  }
+
+  memcpy(stream->state, state, sizeof(state));
+  stream->pos += buffer_size;
 }
 
-int hx4_x4djbx33a_128_copt(const void *buffer, size_t buffer_size, const void *cookie, size_t cookie_sz, void *out_hash, size_t out_hash_size) {
+HX4_STREAM_CI_IMPL(hx4_x4djbx33a_128_ref, hx4_djb_stream, 128/8, hx4_x4djbx33a_128_init, hx4_x4djbx33a_128_final)
+
+HX4_API void hx4_x4djbx33a_128_copt_update(hx4_djb_stream *stream, const void *buffer, size_t buffer_size) {
   const uint8_t *p;
   const uint8_t * const buffer_end = (uint8_t*)buffer + buffer_size;
   const int num_bytes_to_seek = hx4_bytes_to_aligned(buffer, 16);
-  uint32_t state[] = { 5381, 5381, 5381, 5381 };
-  uint32_t state_tmp;
-  int state_i=0;
-  int rc;
+  uint32_t state[4];
+  int state_i = (int)(stream->pos & 0x03);
   int i;
 
-  rc = hx4_check_params(sizeof(state), buffer, buffer_size, cookie, cookie_sz, out_hash, out_hash_size);
-  if(rc != HX4_ERR_SUCCESS) {
-    return rc;
-  }
+  memcpy(state, stream->state, sizeof(state));
 
-  p = buffer;
+  p = (const uint8_t*)buffer;
 
   //hash input until p is aligned to alignment_target
   for(i=0; p<buffer_end && i<num_bytes_to_seek; i++) {
@@ -190,13 +313,7 @@ int hx4_x4djbx33a_128_copt(const void *buffer, size_t buffer_size, const void *c
 
   //rotate states to match position on the input stream
   //so that the main loop can be simple
-  for(i=0; i<state_i; i++) {
-    state_tmp = state[0];
-    state[0] = state[1];
-    state[1] = state[2];
-    state[2] = state[3];
-    state[3] = state_tmp;
-  }
+  hx4_x4djb_rotate_lanes(state, state_i);
 
   //main processing loop
   while(p+15<buffer_end) {
@@ -228,13 +345,7 @@ int hx4_x4djbx33a_128_copt(const void *buffer, size_t buffer_size, const void *c
 #undef HX4_DJB2X4_COPT_ROUND
 
   //rotate back the states
-  for(i=0; i<state_i; i++) {
-    state_tmp = state[3];
-    state[3] = state[2];
-    state[2] = state[1];
-    state[1] = state[0];
-    state[0] = state_tmp;
-  }
+  hx4_x4djb_unrotate_lanes(state, state_i);
 
   //process remainder
   while(p<buffer_end) {
@@ -244,21 +355,93 @@ int hx4_x4djbx33a_128_copt(const void *buffer, size_t buffer_size, const void *c
     state_i = (state_i+1) & 0x03;
   }
 
-  hx4_xor_cookie_128(state, cookie);
-  memcpy(out_hash, state, sizeof(state));
+  memcpy(stream->state, state, sizeof(state));
+  stream->pos += buffer_size;
+}
+
+HX4_STREAM_ONESHOT_IMPL(hx4_x4djbx33a_128_copt, hx4_djb_stream, 128/8, hx4_x4djbx33a_128_init, hx4_x4djbx33a_128_final)
+HX4_STREAM_V_IMPL(hx4_x4djbx33a_128_copt, hx4_djb_stream, 128/8, hx4_x4djbx33a_128_init, hx4_x4djbx33a_128_final)
+HX4_STREAM_CSTR_STRLEN_IMPL(hx4_x4djbx33a_128_copt)
+
+HX4_API void hx4_x4djbx33a_128_copt_ci_update(hx4_djb_stream *stream, const void *buffer, size_t buffer_size) {
+  const uint8_t *p;
+  const uint8_t * const buffer_end = (uint8_t*)buffer + buffer_size;
+  const int num_bytes_to_seek = hx4_bytes_to_aligned(buffer, 16);
+  uint32_t state[4];
+  int state_i = (int)(stream->pos & 0x03);
+  int i;
+
+  memcpy(state, stream->state, sizeof(state));
+
+  p = (const uint8_t*)buffer;
+
+  //hash input until p is aligned to alignment_target
+  for(i=0; p<buffer_end && i<num_bytes_to_seek; i++) {
+    //state[state_i] = state[state_i] * 33  + hx4_ascii_tolower(*p);
+    state[state_i] = (state[state_i] << 5) + state[state_i]  + hx4_ascii_tolower(*p);
+    p++;
+    state_i = (state_i+1) & 0x03;
+  }
+
+  HX4_ASSUME_ALIGNED(p, 16)
+
+  //rotate states to match position on the input stream
+  //so that the main loop can be simple
+  hx4_x4djb_rotate_lanes(state, state_i);
+
+  //main processing loop
+  while(p+15<buffer_end) {
+    HX4_ASSUME_ALIGNED(p, 16)
+
+#define HX4_DJB2X4_COPT_ROUND(state_i, round) \
+    state[state_i] = (state[state_i] << 5) + state[state_i] + hx4_ascii_tolower(p[round]);
+
+    HX4_DJB2X4_COPT_ROUND(0,0)
+    HX4_DJB2X4_COPT_ROUND(1,1)
+    HX4_DJB2X4_COPT_ROUND(2,2)
+    HX4_DJB2X4_COPT_ROUND(3,3)
+    HX4_DJB2X4_COPT_ROUND(0,4)
+    HX4_DJB2X4_COPT_ROUND(1,5)
+    HX4_DJB2X4_COPT_ROUND(2,6)
+    HX4_DJB2X4_COPT_ROUND(3,7)
+    HX4_DJB2X4_COPT_ROUND(0,8)
+    HX4_DJB2X4_COPT_ROUND(1,9)
+    HX4_DJB2X4_COPT_ROUND(2,10)
+    HX4_DJB2X4_COPT_ROUND(3,11)
+    HX4_DJB2X4_COPT_ROUND(0,12)
+    HX4_DJB2X4_COPT_ROUND(1,13)
+    HX4_DJB2X4_COPT_ROUND(2,14)
+    HX4_DJB2X4_COPT_ROUND(3,15)
+
+    p+=16;
+  }
+  
+#undef HX4_DJB2X4_COPT_ROUND
+
+  //rotate back the states
+  hx4_x4djb_unrotate_lanes(state, state_i);
+
+  //process remainder
+  while(p<buffer_end) {
+    //state[state_i] = state[state_i] * 33  + hx4_ascii_tolower(*p);
+    state[state_i] = (state[state_i] << 5) + state[state_i]  + hx4_ascii_tolower(*p);
+    p++;
+    state_i = (state_i+1) & 0x03;
+  }
 
-  return HX4_ERR_SUCCESS;
+  memcpy(stream->state, state, sizeof(state));
+  stream->pos += buffer_size;
 }
 
+HX4_STREAM_CI_IMPL(hx4_x4djbx33a_128_copt, hx4_djb_stream, 128/8, hx4_x4djbx33a_128_init, hx4_x4djbx33a_128_final)
+
 #if HX4_HAS_MMX
-int hx4_x4djbx33a_128_mmx(const void *buffer, size_t buffer_size, const void *cookie, size_t cookie_sz, void *out_hash, size_t out_hash_size) {
+HX4_API void hx4_x4djbx33a_128_mmx_update(hx4_djb_stream *stream, const void *buffer, size_t buffer_size) {
   const uint8_t *p;
   const uint8_t * const buffer_end = (uint8_t*)buffer + buffer_size;
   const int num_bytes_to_seek = hx4_bytes_to_aligned(buffer, 8);
-  HX4_ALIGNED(uint32_t state[], 8) = { 5381, 5381, 5381, 5381 };
-  uint32_t state_tmp;
-  int state_i=0;
-  int rc;
+  HX4_ALIGNED(uint32_t state[4], 8);
+  int state_i = (int)(stream->pos & 0x03);
   int i;
   __m64 xstate0;
   __m64 xstate1;
@@ -267,12 +450,9 @@ int hx4_x4djbx33a_128_mmx(const void *buffer, size_t buffer_size, const void *co
   __m64 xp1;
   __m64 xdword;
  
-  rc = hx4_check_params(sizeof(state), buffer, buffer_size, cookie, cookie_sz, out_hash, out_hash_size);
-  if(rc != HX4_ERR_SUCCESS) {
-    return rc;
-  }
+  memcpy(state, stream->state, sizeof(state));
 
-  p = buffer;
+  p = (const uint8_t*)buffer;
 
   //hash input until p is aligned to alignment_target
   for(i=0; p<buffer_end && i<num_bytes_to_seek; i++) {
@@ -286,13 +466,7 @@ int hx4_x4djbx33a_128_mmx(const void *buffer, size_t buffer_size, const void *co
 
   //rotate states to match position on the input stream
   //so that the main loop can be simple
-  for(i=0; i<state_i; i++) {
-    state_tmp = state[0];
-    state[0] = state[1];
-    state[1] = state[2];
-    state[2] = state[3];
-    state[3] = state_tmp;
-  }
+  hx4_x4djb_rotate_lanes(state, state_i);
 
   //load state into registers
   xstate0 = ((__m64*)state)[0];
@@ -346,13 +520,7 @@ int hx4_x4djbx33a_128_mmx(const void *buffer, size_t buffer_size, const void *co
   _mm_empty();
 
   //rotate back the states
-  for(i=0; i<state_i; i++) {
-    state_tmp = state[3];
-    state[3] = state[2];
-    state[2] = state[1];
-    state[1] = state[0];
-    state[0] = state_tmp;
-  }
+  hx4_x4djb_unrotate_lanes(state, state_i);
 
   //process remainder
   while(p<buffer_end) {
@@ -362,34 +530,29 @@ int hx4_x4djbx33a_128_mmx(const void *buffer, size_t buffer_size, const void *co
     state_i = (state_i+1) & 0x03;
   }
 
-  hx4_xor_cookie_128(state, cookie);
-  memcpy(out_hash, state, sizeof(state));
-
-  return HX4_ERR_SUCCESS;
+  memcpy(stream->state, state, sizeof(state));
+  stream->pos += buffer_size;
 }
+
+HX4_STREAM_ONESHOT_IMPL(hx4_x4djbx33a_128_mmx, hx4_djb_stream, 128/8, hx4_x4djbx33a_128_init, hx4_x4djbx33a_128_final)
+HX4_STREAM_V_IMPL(hx4_x4djbx33a_128_mmx, hx4_djb_stream, 128/8, hx4_x4djbx33a_128_init, hx4_x4djbx33a_128_final)
+HX4_STREAM_CSTR_STRLEN_IMPL(hx4_x4djbx33a_128_mmx)
 #endif //HX4_HAS_MMX
 
 #if HX4_HAS_SSE2
-int hx4_x4djbx33a_128_sse2(const void *buffer, size_t buffer_size, const void *cookie, size_t cookie_sz, void *out_hash, size_t out_hash_size) {
+HX4_API void hx4_x4djbx33a_128_sse2_update(hx4_djb_stream *stream, const void *buffer, size_t buffer_size) {
   const uint8_t *p;
   const uint8_t * const buffer_end = (uint8_t*)buffer + buffer_size;
   const int num_bytes_to_seek = hx4_bytes_to_aligned(buffer, 16);
-  HX4_ALIGNED(uint32_t state[], 16) = { 5381, 5381, 5381, 5381 };
-  uint32_t state_tmp;  
-  int state_i = 0;
-  int rc;
+  HX4_ALIGNED(uint32_t state[4], 16);
+  int state_i = (int)(stream->pos & 0x03);
   int i;
   __m128i xstate;
   __m128i xpin;
-  __m128i xp;
-  __m128i xqword;
 
-  rc = hx4_check_params(sizeof(state), buffer, buffer_size, cookie, cookie_sz, out_hash, out_hash_size);
-  if(rc != HX4_ERR_SUCCESS) {
-    return rc;
-  }
+  memcpy(state, stream->state, sizeof(state));
 
-  p = buffer;
+  p = (const uint8_t*)buffer;
 
   //hash input until p is aligned to alignment_target
   for(i=0; p<buffer_end && i<num_bytes_to_seek; i++) {
@@ -403,13 +566,7 @@ int hx4_x4djbx33a_128_sse2(const void *buffer, size_t buffer_size, const void *c
 
   //rotate states to match position on the input stream
   //so that the main loop can be simple
-  for(i=0; i<state_i; i++) {
-    state_tmp = state[0];
-    state[0] = state[1];
-    state[1] = state[2];
-    state[2] = state[3];
-    state[3] = state_tmp;
-  }
+  hx4_x4djb_rotate_lanes(state, state_i);
   
   //transfer state into register
   xstate = _mm_load_si128((__m128i*)state);
@@ -418,38 +575,78 @@ int hx4_x4djbx33a_128_sse2(const void *buffer, size_t buffer_size, const void *c
   while(p+15<buffer_end) {
     HX4_ASSUME_ALIGNED(p, 16)
 
-#define HX4_SSE2_X4DJBX33A(xstate, xp) \
-    xp = _mm_add_epi32(xp, xstate); \
-    xstate = _mm_slli_epi32(xstate, 5 ); \
-    xstate = _mm_add_epi32(xstate, xp);
+    //load 16 bytes aligned
+    xpin = _mm_load_si128((__m128i*)p);
+    
+    xstate = hx4_x4djbx33a_sse2_round(xstate, xpin);
+        
+    p+=16;
+  }
+
+  //store back state from register into memory
+  _mm_store_si128((__m128i*)state, xstate);
+  
+  //rotate back the states
+  hx4_x4djb_unrotate_lanes(state, state_i);
+
+  //process any input that is left
+  while(p<buffer_end) {
+    //state[state_i] = state[state_i] * 33  + *p;
+    state[state_i] = (state[state_i] << 5) + state[state_i]  + *p;
+    p++;
+    state_i = (state_i+1) & 0x03;
+  }
+
+  memcpy(stream->state, state, sizeof(state));
+  stream->pos += buffer_size;
+}
+
+HX4_STREAM_ONESHOT_IMPL(hx4_x4djbx33a_128_sse2, hx4_djb_stream, 128/8, hx4_x4djbx33a_128_init, hx4_x4djbx33a_128_final)
+HX4_STREAM_V_IMPL(hx4_x4djbx33a_128_sse2, hx4_djb_stream, 128/8, hx4_x4djbx33a_128_init, hx4_x4djbx33a_128_final)
+
+/* NUL terminated input: the aligned loads of the main loop are checked for
+ * the terminator before they are hashed, aligned loads never cross a page */
+HX4_API size_t hx4_x4djbx33a_128_sse2_cstr_update(hx4_djb_stream *stream, const char *str) {
+  const uint8_t *p;
+  const int num_bytes_to_seek = hx4_bytes_to_aligned(str, 16);
+  HX4_ALIGNED(uint32_t state[4], 16);
+  int state_i = (int)(stream->pos & 0x03);
+  int i;
+  size_t len;
+  __m128i xstate;
+  __m128i xpin;
+
+  memcpy(state, stream->state, sizeof(state));
+
+  p = (const uint8_t*)str;
+
+  //hash input until p is aligned to alignment_target
+  for(i=0; *p && i<num_bytes_to_seek; i++) {
+    //state[state_i] = state[state_i] * 33  + *p;
+    state[state_i] = (state[state_i] << 5) + state[state_i]  + *p;
+    p++;
+    state_i = (state_i+1) & 0x03;
+  }
+
+  //rotate states to match position on the input stream
+  //so that the main loop can be simple
+  hx4_x4djb_rotate_lanes(state, state_i);
+  
+  //transfer state into register
+  xstate = _mm_load_si128((__m128i*)state);
+  
+ //main processing loop, p is aligned unless the seek hit the terminator,
+  //the block holding the terminator is left to the scalar loop below
+  while(*p) {
+    HX4_ASSUME_ALIGNED(p, 16)
 
     //load 16 bytes aligned
     xpin = _mm_load_si128((__m128i*)p);
+    if(_mm_movemask_epi8(_mm_cmpeq_epi8(xpin, _mm_setzero_si128())) != 0) {
+      break;
+    }
     
-    //qword0, lower 8byte
-    xqword = _mm_setzero_si128();
-    xqword = _mm_unpacklo_epi8(xpin, xqword);   
-    //dword0
-    xp = _mm_setzero_si128();
-    xp = _mm_unpacklo_epi8(xqword, xp);
-    HX4_SSE2_X4DJBX33A(xstate, xp);
-    //dword1
-    xp = _mm_setzero_si128();
-    xp = _mm_unpackhi_epi8(xqword, xp);
-    HX4_SSE2_X4DJBX33A(xstate, xp);
-
-    //qword1, upper 8byte
-    xqword = _mm_setzero_si128();
-    xqword = _mm_unpackhi_epi8(xpin, xqword);
-    //dword2
-    xp = _mm_setzero_si128();
-    xp = _mm_unpacklo_epi8(xqword, xp);
-    HX4_SSE2_X4DJBX33A(xstate, xp);
-    //dword3
-    xp = _mm_setzero_si128();
-    xp = _mm_unpackhi_epi8(xqword, xp);
-    HX4_SSE2_X4DJBX33A(xstate, xp);
-#undef HX4_SSE2_X4DJBX33A
+    xstate = hx4_x4djbx33a_sse2_round(xstate, xpin);
         
     p+=16;
   }
@@ -458,51 +655,306 @@ int hx4_x4djbx33a_128_sse2(const void *buffer, size_t buffer_size, const void *c
   _mm_store_si128((__m128i*)state, xstate);
   
   //rotate back the states
-  for(i=0; i<state_i; i++) {
-    state_tmp = state[3];
-    state[3] = state[2];
-    state[2] = state[1];
-    state[1] = state[0];
-    state[0] = state_tmp;
+  hx4_x4djb_unrotate_lanes(state, state_i);
+
+  //process any input that is left
+  while(*p) {
+    //state[state_i] = state[state_i] * 33  + *p;
+    state[state_i] = (state[state_i] << 5) + state[state_i]  + *p;
+    p++;
+    state_i = (state_i+1) & 0x03;
   }
 
+  memcpy(stream->state, state, sizeof(state));
+  len = (size_t)(p - (const uint8_t*)str);
+  stream->pos += len;
+  return len;
+}
+
+HX4_STREAM_CSTR_IMPL(hx4_x4djbx33a_128_sse2, hx4_djb_stream, 128/8, hx4_x4djbx33a_128_init, hx4_x4djbx33a_128_final)
+
+/* case-insensitive: A-Z are folded right after the aligned load, before the
+ * bytes are unpacked into the lanes */
+HX4_API void hx4_x4djbx33a_128_sse2_ci_update(hx4_djb_stream *stream, const void *buffer, size_t buffer_size) {
+  const uint8_t *p;
+  const uint8_t * const buffer_end = (uint8_t*)buffer + buffer_size;
+  const int num_bytes_to_seek = hx4_bytes_to_aligned(buffer, 16);
+  HX4_ALIGNED(uint32_t state[4], 16);
+  int state_i = (int)(stream->pos & 0x03);
+  int i;
+  __m128i xstate;
+  __m128i xpin;
+
+  memcpy(state, stream->state, sizeof(state));
+
+  p = (const uint8_t*)buffer;
+
+  //hash input until p is aligned to alignment_target
+  for(i=0; p<buffer_end && i<num_bytes_to_seek; i++) {
+    //state[state_i] = state[state_i] * 33  + hx4_ascii_tolower(*p);
+    state[state_i] = (state[state_i] << 5) + state[state_i]  + hx4_ascii_tolower(*p);
+    p++;
+    state_i = (state_i+1) & 0x03;
+  }
+
+  HX4_ASSUME_ALIGNED(p, 16)
+
+  //rotate states to match position on the input stream
+  //so that the main loop can be simple
+  hx4_x4djb_rotate_lanes(state, state_i);
+  
+  //transfer state into register
+  xstate = _mm_load_si128((__m128i*)state);
+  
+ //main processing loop
+  while(p+15<buffer_end) {
+    HX4_ASSUME_ALIGNED(p, 16)
+
+    //load 16 bytes aligned
+    xpin = _mm_load_si128((__m128i*)p);
+    xpin = hx4_ascii_tolower_sse2(xpin);
+    
+    xstate = hx4_x4djbx33a_sse2_round(xstate, xpin);
+        
+    p+=16;
+  }
+
+  //store back state from register into memory
+  _mm_store_si128((__m128i*)state, xstate);
+  
+  //rotate back the states
+  hx4_x4djb_unrotate_lanes(state, state_i);
+
   //process any input that is left
   while(p<buffer_end) {
+    //state[state_i] = state[state_i] * 33  + hx4_ascii_tolower(*p);
+    state[state_i] = (state[state_i] << 5) + state[state_i]  + hx4_ascii_tolower(*p);
+    p++;
+    state_i = (state_i+1) & 0x03;
+  }
+
+  memcpy(stream->state, state, sizeof(state));
+  stream->pos += buffer_size;
+}
+
+HX4_STREAM_CI_IMPL(hx4_x4djbx33a_128_sse2, hx4_djb_stream, 128/8, hx4_x4djbx33a_128_init, hx4_x4djbx33a_128_final)
+
+/* Copy-and-hash: the main loop seeks to the alignment of dst instead of the
+ * input, loads unaligned and stores every loaded register to dst before it
+ * is unpacked into the lanes. Copies of HX4_COPY_STREAM_MIN_SIZE and more go
+ * around the cache with non-temporal stores. */
+HX4_API void hx4_x4djbx33a_128_sse2_copy_update(hx4_djb_stream *stream, void *dst, const void *buffer, size_t buffer_size) {
+  const uint8_t *p;
+  const uint8_t * const buffer_end = (uint8_t*)buffer + buffer_size;
+  const int num_bytes_to_seek = hx4_bytes_to_aligned(dst, 16);
+  const int stream_stores = buffer_size >= HX4_COPY_STREAM_MIN_SIZE;
+  uint8_t *q;
+  HX4_ALIGNED(uint32_t state[4], 16);
+  int state_i = (int)(stream->pos & 0x03);
+  int i;
+  __m128i xstate;
+  __m128i xpin;
+
+  memcpy(state, stream->state, sizeof(state));
+
+  p = (const uint8_t*)buffer;
+  q = (uint8_t*)dst;
+
+  //copy and hash input until q is aligned
+  for(i=0; p<buffer_end && i<num_bytes_to_seek; i++) {
+    state[state_i] = (state[state_i] << 5) + state[state_i]  + *p;
+    *q++ = *p++;
+    state_i = (state_i+1) & 0x03;
+  }
+
+  HX4_ASSUME_ALIGNED(q, 16)
+
+  //rotate states to match position on the input stream
+  hx4_x4djb_rotate_lanes(state, state_i);
+
+  xstate = _mm_load_si128((__m128i*)state);
+
+  //main processing loop
+  while(p+15<buffer_end) {
+    HX4_ASSUME_ALIGNED(q, 16)
+
+    xpin = _mm_loadu_si128((const __m128i*)p);
+    if(stream_stores) {
+      _mm_stream_si128((__m128i*)q, xpin);
+    } else {
+      _mm_store_si128((__m128i*)q, xpin);
+    }
+
+    xstate = hx4_x4djbx33a_sse2_round(xstate, xpin);
+
+    p+=16;
+    q+=16;
+  }
+
+  //the non-temporal stores are weakly ordered
+  if(stream_stores) {
+    _mm_sfence();
+  }
+
+  _mm_store_si128((__m128i*)state, xstate);
+
+  //rotate back the states
+  hx4_x4djb_unrotate_lanes(state, state_i);
+
+  //copy and hash any input that is left
+  while(p<buffer_end) {
+    state[state_i] = (state[state_i] << 5) + state[state_i]  + *p;
+    *q++ = *p++;
+    state_i = (state_i+1) & 0x03;
+  }
+
+  memcpy(stream->state, state, sizeof(state));
+  stream->pos += buffer_size;
+}
+
+HX4_STREAM_COPY_IMPL(hx4_x4djbx33a_128_sse2, hx4_djb_stream, 128/8, hx4_x4djbx33a_128_init, hx4_x4djbx33a_128_final)
+
+/* number of consecutive uniform bytes from which on the run is skipped
+ * in closed form instead of being hashed block by block */
+#define HX4_X4DJBX33A_RUN_MIN_SIZE 128
+
+/* Computes the multiplier 33^k and the increment (33^k-1)/32 of k djbx33a
+ * rounds over a constant input byte c, so that the state after the run is
+ * state*mul + c*add (mod 2^32).
+ * 33^k-1 is always divisible by 32. Doing the square and multiply in 64bit
+ * keeps 5 bits above the 32bit result, so the exact division can be done
+ * with a shift. */
+static void hx4_djbx33a_run_coefficients(uint64_t k, uint32_t *mul, uint32_t *add) {
+  uint64_t base = 33;
+  uint64_t pow = 1;
+
+  while(k) {
+    if(k & 1) {
+      pow *= base;
+    }
+    base *= base;
+    k >>= 1;
+  }
+
+  *mul = (uint32_t)pow;
+  *add = (uint32_t)((pow - 1) >> 5);
+}
+
+/* SSE2 has no 32bit low multiply, build it from two _mm_mul_epu32 */
+#define HX4_SSE2_MULLO_EPI32(a, b) \
+  _mm_unpacklo_epi32( \
+    _mm_shuffle_epi32(_mm_mul_epu32((a), (b)), _MM_SHUFFLE(0,0,2,0)), \
+    _mm_shuffle_epi32(_mm_mul_epu32(_mm_srli_si128((a), 4), _mm_srli_si128((b), 4)), _MM_SHUFFLE(0,0,2,0)))
+
+HX4_API void hx4_x4djbx33a_128_sse2rle_update(hx4_djb_stream *stream, const void *buffer, size_t buffer_size) {
+  const uint8_t *p;
+  const uint8_t *q;
+  const uint8_t *short_run_end;
+  const uint8_t * const buffer_end = (uint8_t*)buffer + buffer_size;
+  const int num_bytes_to_seek = hx4_bytes_to_aligned(buffer, 16);
+  HX4_ALIGNED(uint32_t state[4], 16);
+  uint32_t run_mul;
+  uint32_t run_add;
+  int state_i = (int)(stream->pos & 0x03);
+  int i;
+  __m128i xstate;
+  __m128i xpin;
+  __m128i xrun;
+
+  memcpy(state, stream->state, sizeof(state));
+
+  p = (const uint8_t*)buffer;
+
+  //hash input until p is aligned to alignment_target
+  for(i=0; p<buffer_end && i<num_bytes_to_seek; i++) {
     //state[state_i] = state[state_i] * 33  + *p;
     state[state_i] = (state[state_i] << 5) + state[state_i]  + *p;
     p++;
     state_i = (state_i+1) & 0x03;
   }
 
-  hx4_xor_cookie_128(state, cookie);
-  memcpy(out_hash, state, sizeof(state));
+  HX4_ASSUME_ALIGNED(p, 16)
+
+  //rotate states to match position on the input stream
+  //so that the main loop can be simple
+  hx4_x4djb_rotate_lanes(state, state_i);
+
+  //transfer state into register
+  xstate = _mm_load_si128((__m128i*)state);
+
+  short_run_end = p;
+
+  //main processing loop
+  while(p+15<buffer_end) {
+    HX4_ASSUME_ALIGNED(p, 16)
+
+    //load 16 bytes aligned
+    xpin = _mm_load_si128((__m128i*)p);
+
+    //check if the block consists of one repeated byte, unless it is the rest of a run that was too short
+    xrun = _mm_set1_epi8((char)p[0]);
+    if(p >= short_run_end && _mm_movemask_epi8(_mm_cmpeq_epi8(xpin, xrun)) == 0xffff) {
+      //find the end of the run
+      q = p+16;
+      while(q+15<buffer_end && _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_load_si128((__m128i*)q), xrun)) == 0xffff) {
+        q+=16;
+      }
+
+      //every lane sees (q-p)/4 times the same byte, jump over it
+      if(q-p >= HX4_X4DJBX33A_RUN_MIN_SIZE) {
+        hx4_djbx33a_run_coefficients((uint64_t)(q-p)/4, &run_mul, &run_add);
+        xstate = HX4_SSE2_MULLO_EPI32(xstate, _mm_set1_epi32((int)run_mul));
+        xstate = _mm_add_epi32(xstate, _mm_set1_epi32((int)(run_add * p[0])));
+        p = q;
+        continue;
+      }
+
+      //the blocks up to q would only find shorter runs
+      short_run_end = q;
+    }
+
+    xstate = hx4_x4djbx33a_sse2_round(xstate, xpin);
 
-  return HX4_ERR_SUCCESS;
+    p+=16;
+  }
+
+  //store back state from register into memory
+  _mm_store_si128((__m128i*)state, xstate);
+
+  //rotate back the states
+  hx4_x4djb_unrotate_lanes(state, state_i);
+
+  //process any input that is left
+  while(p<buffer_end) {
+    //state[state_i] = state[state_i] * 33  + *p;
+    state[state_i] = (state[state_i] << 5) + state[state_i]  + *p;
+    p++;
+    state_i = (state_i+1) & 0x03;
+  }
+
+  memcpy(stream->state, state, sizeof(state));
+  stream->pos += buffer_size;
 }
+
+HX4_STREAM_ONESHOT_IMPL(hx4_x4djbx33a_128_sse2rle, hx4_djb_stream, 128/8, hx4_x4djbx33a_128_init, hx4_x4djbx33a_128_final)
+HX4_STREAM_V_IMPL(hx4_x4djbx33a_128_sse2rle, hx4_djb_stream, 128/8, hx4_x4djbx33a_128_init, hx4_x4djbx33a_128_final)
+HX4_STREAM_CSTR_STRLEN_IMPL(hx4_x4djbx33a_128_sse2rle)
 #endif //HX4_HAS_SSE2
 
 #if HX4_HAS_SSSE3
-int hx4_x4djbx33a_128_ssse3(const void *buffer, size_t buffer_size, const void *cookie, size_t cookie_sz, void *out_hash, size_t out_hash_size) {
+HX4_API void hx4_x4djbx33a_128_ssse3_update(hx4_djb_stream *stream, const void *buffer, size_t buffer_size) {
   const uint8_t *p;
   const uint8_t * const buffer_end = (uint8_t*)buffer + buffer_size;
   const int num_bytes_to_seek = hx4_bytes_to_aligned(buffer, 16);
-  HX4_ALIGNED(uint32_t state[], 16) = { 5381, 5381, 5381, 5381 };
-  uint32_t state_tmp;
+  HX4_ALIGNED(uint32_t state[4], 16);
   __m128i xstate;
-  __m128i xp;
   __m128i xpin;
-  __m128i xbmask;
-  __m128i xshuffle;
-  int state_i = 0;
-  int rc;
+  int state_i = (int)(stream->pos & 0x03);
   int i;
 
-  rc = hx4_check_params(sizeof(state), buffer, buffer_size, cookie, cookie_sz, out_hash, out_hash_size);
-  if (rc != HX4_ERR_SUCCESS) {
-    return rc;
-  }
+  memcpy(state, stream->state, sizeof(state));
 
-  p = buffer;
+  p = (const uint8_t*)buffer;
 
   //hash input until p is aligned to alignment_target
   for (i = 0; p<buffer_end && i<num_bytes_to_seek; i++) {
@@ -516,25 +968,10 @@ int hx4_x4djbx33a_128_ssse3(const void *buffer, size_t buffer_size, const void *
 
   //rotate states to match position on the input stream
   //so that the main loop can be simple
-  for (i = 0; i<state_i; i++) {
-    state_tmp = state[0];
-    state[0] = state[1];
-    state[1] = state[2];
-    state[2] = state[3];
-    state[3] = state_tmp;
-  }
+  hx4_x4djb_rotate_lanes(state, state_i);
 
   //transfer state into register
   xstate = _mm_load_si128((__m128i*)state);
-  //load AND mask
-  xbmask = _mm_set1_epi32(0x000000ff);
-  //load shuffle mask
-  xshuffle = _mm_set_epi8(
-    15, 11, 7, 3,
-    14, 10, 6, 2,
-    13, 9 , 5, 1,
-    12, 8 , 4, 0
-  );
 
   //main processing loop
   while (p+15<buffer_end) {
@@ -542,47 +979,232 @@ int hx4_x4djbx33a_128_ssse3(const void *buffer, size_t buffer_size, const void *
 
     //load 16 bytes aligned
     xpin = _mm_load_si128((__m128i*)p);
-    xpin = _mm_shuffle_epi8(xpin, xshuffle);
+    xstate = hx4_x4djbx33a_ssse3_round(xstate, xpin);
 
-#define HX4_SSSE3_DJB2ROUND(round) \
-    xp = _mm_srli_epi32(xpin, 8*round); \
-    xp = _mm_and_si128(xp, xbmask); \
-    xp = _mm_add_epi32(xp, xstate); \
-    xstate = _mm_slli_epi32(xstate, 5); \
-    xstate = _mm_add_epi32(xstate, xp); \
+    p += 16;
+  }
 
-    HX4_SSSE3_DJB2ROUND(0)
-    HX4_SSSE3_DJB2ROUND(1)
-    HX4_SSSE3_DJB2ROUND(2)
-    HX4_SSSE3_DJB2ROUND(3)
+  //store back state from register into memory
+  _mm_store_si128((__m128i*)state, xstate);
+
+  //rotate back the states
+  hx4_x4djb_unrotate_lanes(state, state_i);
+
+  //process any input that is left
+  while (p<buffer_end) {
+    //state[state_i] = state[state_i] * 33 + *p;
+    state[state_i] = (state[state_i] << 5) + state[state_i] + *p;   
+    p++;
+    state_i = (state_i + 1) & 0x03;
+  }
+  
+  memcpy(stream->state, state, sizeof(state));
+  stream->pos += buffer_size;
+}
+
+HX4_STREAM_ONESHOT_IMPL(hx4_x4djbx33a_128_ssse3, hx4_djb_stream, 128/8, hx4_x4djbx33a_128_init, hx4_x4djbx33a_128_final)
+HX4_STREAM_V_IMPL(hx4_x4djbx33a_128_ssse3, hx4_djb_stream, 128/8, hx4_x4djbx33a_128_init, hx4_x4djbx33a_128_final)
+
+HX4_API size_t hx4_x4djbx33a_128_ssse3_cstr_update(hx4_djb_stream *stream, const char *str) {
+  const uint8_t *p;
+  const int num_bytes_to_seek = hx4_bytes_to_aligned(str, 16);
+  HX4_ALIGNED(uint32_t state[4], 16);
+  __m128i xstate;
+  __m128i xpin;
+  int state_i = (int)(stream->pos & 0x03);
+  int i;
+  size_t len;
+
+  memcpy(state, stream->state, sizeof(state));
+
+  p = (const uint8_t*)str;
+
+  //hash input until p is aligned to alignment_target
+  for (i = 0; *p && i<num_bytes_to_seek; i++) {
+    //state[state_i] = state[state_i] * 33 + *p;
+    state[state_i] = (state[state_i] << 5) + state[state_i] + *p;
+    p++;
+    state_i = (state_i + 1) & 0x03;
+  }
+
+  //rotate states to match position on the input stream
+  //so that the main loop can be simple
+  hx4_x4djb_rotate_lanes(state, state_i);
+
+  //transfer state into register
+  xstate = _mm_load_si128((__m128i*)state);
+
+  //main processing loop, p is aligned unless the seek hit the terminator,
+  //the block holding the terminator is left to the scalar loop below
+  while(*p) {
+    HX4_ASSUME_ALIGNED(p, 16)
+
+    //load 16 bytes aligned
+    xpin = _mm_load_si128((__m128i*)p);
+    if(_mm_movemask_epi8(_mm_cmpeq_epi8(xpin, _mm_setzero_si128())) != 0) {
+      break;
+    }
+    xstate = hx4_x4djbx33a_ssse3_round(xstate, xpin);
 
     p += 16;
   }
-#undef HX4_SSSE3_DJB2ROUND
 
   //store back state from register into memory
   _mm_store_si128((__m128i*)state, xstate);
 
   //rotate back the states
-  for (i = 0; i<state_i; i++) {
-    state_tmp = state[3];
-    state[3] = state[2];
-    state[2] = state[1];
-    state[1] = state[0];
-    state[0] = state_tmp;
-  }
+  hx4_x4djb_unrotate_lanes(state, state_i);
 
   //process any input that is left
-  while (p<buffer_end) {
+  while(*p) {
     //state[state_i] = state[state_i] * 33 + *p;
     state[state_i] = (state[state_i] << 5) + state[state_i] + *p;   
     p++;
     state_i = (state_i + 1) & 0x03;
   }
   
-  hx4_xor_cookie_128(state, cookie);
-  memcpy(out_hash, state, sizeof(state));
+  memcpy(stream->state, state, sizeof(state));
+  len = (size_t)(p - (const uint8_t*)str);
+  stream->pos += len;
+  return len;
+}
+
+HX4_STREAM_CSTR_IMPL(hx4_x4djbx33a_128_ssse3, hx4_djb_stream, 128/8, hx4_x4djbx33a_128_init, hx4_x4djbx33a_128_final)
+
+HX4_API void hx4_x4djbx33a_128_ssse3_ci_update(hx4_djb_stream *stream, const void *buffer, size_t buffer_size) {
+  const uint8_t *p;
+  const uint8_t * const buffer_end = (uint8_t*)buffer + buffer_size;
+  const int num_bytes_to_seek = hx4_bytes_to_aligned(buffer, 16);
+  HX4_ALIGNED(uint32_t state[4], 16);
+  __m128i xstate;
+  __m128i xpin;
+  int state_i = (int)(stream->pos & 0x03);
+  int i;
+
+  memcpy(state, stream->state, sizeof(state));
+
+  p = (const uint8_t*)buffer;
+
+  //hash input until p is aligned to alignment_target
+  for (i = 0; p<buffer_end && i<num_bytes_to_seek; i++) {
+    //state[state_i] = state[state_i] * 33 + hx4_ascii_tolower(*p);
+    state[state_i] = (state[state_i] << 5) + state[state_i] + hx4_ascii_tolower(*p);
+    p++;
+    state_i = (state_i + 1) & 0x03;
+  }
+
+  HX4_ASSUME_ALIGNED(p, 16)
+
+  //rotate states to match position on the input stream
+  //so that the main loop can be simple
+  hx4_x4djb_rotate_lanes(state, state_i);
+
+  //transfer state into register
+  xstate = _mm_load_si128((__m128i*)state);
+
+  //main processing loop
+  while (p+15<buffer_end) {
+    HX4_ASSUME_ALIGNED(p, 16)
+
+    //load 16 bytes aligned
+    xpin = _mm_load_si128((__m128i*)p);
+    xpin = hx4_ascii_tolower_sse2(xpin);
+    xstate = hx4_x4djbx33a_ssse3_round(xstate, xpin);
+
+    p += 16;
+  }
+
+  //store back state from register into memory
+  _mm_store_si128((__m128i*)state, xstate);
+
+  //rotate back the states
+  hx4_x4djb_unrotate_lanes(state, state_i);
+
+  //process any input that is left
+  while (p<buffer_end) {
+    //state[state_i] = state[state_i] * 33 + hx4_ascii_tolower(*p);
+    state[state_i] = (state[state_i] << 5) + state[state_i] + hx4_ascii_tolower(*p);   
+    p++;
+    state_i = (state_i + 1) & 0x03;
+  }
+  
+  memcpy(stream->state, state, sizeof(state));
+  stream->pos += buffer_size;
+}
+
+HX4_STREAM_CI_IMPL(hx4_x4djbx33a_128_ssse3, hx4_djb_stream, 128/8, hx4_x4djbx33a_128_init, hx4_x4djbx33a_128_final)
 
-  return HX4_ERR_SUCCESS;
+//see hx4_x4djbx33a_128_sse2_copy_update
+HX4_API void hx4_x4djbx33a_128_ssse3_copy_update(hx4_djb_stream *stream, void *dst, const void *buffer, size_t buffer_size) {
+  const uint8_t *p;
+  const uint8_t * const buffer_end = (uint8_t*)buffer + buffer_size;
+  const int num_bytes_to_seek = hx4_bytes_to_aligned(dst, 16);
+  const int stream_stores = buffer_size >= HX4_COPY_STREAM_MIN_SIZE;
+  uint8_t *q;
+  HX4_ALIGNED(uint32_t state[4], 16);
+  __m128i xstate;
+  __m128i xpin;
+  int state_i = (int)(stream->pos & 0x03);
+  int i;
+
+  memcpy(state, stream->state, sizeof(state));
+
+  p = (const uint8_t*)buffer;
+  q = (uint8_t*)dst;
+
+  //copy and hash input until q is aligned
+  for (i = 0; p<buffer_end && i<num_bytes_to_seek; i++) {
+    state[state_i] = (state[state_i] << 5) + state[state_i] + *p;
+    *q++ = *p++;
+    state_i = (state_i + 1) & 0x03;
+  }
+
+  HX4_ASSUME_ALIGNED(q, 16)
+
+  //rotate states to match position on the input stream
+  hx4_x4djb_rotate_lanes(state, state_i);
+
+  xstate = _mm_load_si128((__m128i*)state);
+
+  //main processing loop
+  while (p+15<buffer_end) {
+    HX4_ASSUME_ALIGNED(q, 16)
+
+    xpin = _mm_loadu_si128((const __m128i*)p);
+    if (stream_stores) {
+      _mm_stream_si128((__m128i*)q, xpin);
+    } else {
+      _mm_store_si128((__m128i*)q, xpin);
+    }
+    xstate = hx4_x4djbx33a_ssse3_round(xstate, xpin);
+
+    p += 16;
+    q += 16;
+  }
+
+  //the non-temporal stores are weakly ordered
+  if (stream_stores) {
+    _mm_sfence();
+  }
+
+  _mm_store_si128((__m128i*)state, xstate);
+
+  //rotate back the states
+  hx4_x4djb_unrotate_lanes(state, state_i);
+
+  //copy and hash any input that is left
+  while (p<buffer_end) {
+    state[state_i] = (state[state_i] << 5) + state[state_i] + *p;
+    *q++ = *p++;
+    state_i = (state_i + 1) & 0x03;
+  }
+
+  memcpy(stream->state, state, sizeof(state));
+  stream->pos += buffer_size;
 }
+
+HX4_STREAM_COPY_IMPL(hx4_x4djbx33a_128_ssse3, hx4_djb_stream, 128/8, hx4_x4djbx33a_128_init, hx4_x4djbx33a_128_final)
 #endif //HX4_HAS_SSSE3
+
+#undef HX4_SSE2_MULLO_EPI32
+#undef HX4_X4DJBX33A_RUN_MIN_SIZE
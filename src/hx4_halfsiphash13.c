@@ -0,0 +1,673 @@
+/* 
+ * Copyright 2015 Kai Dietrich <mail@cleeus.de>
+ *
+ * This file is part of hashx4.
+ *
+ * Hashx4 is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Hashx4 is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with hashx4.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "hashx4_config.h"
+
+#if HX4_HAS_SSE2
+# include <emmintrin.h>
+#endif
+
+#include "hashx4.h"
+#include "hx4_util.h"
+#include "hx4_stream.h"
+
+#define ROTL(x,b) (uint32_t)( ((x) << (b)) | ( (x) >> (32 - (b))) )
+
+#define U32TO8_LE(p, v)         \
+    (p)[0] = (uint8_t)((v)      ); (p)[1] = (uint8_t)((v) >>  8); \
+    (p)[2] = (uint8_t)((v) >> 16); (p)[3] = (uint8_t)((v) >> 24);
+
+#define U8TO32_LE(p) \
+  (((uint32_t)((p)[0])      ) | \
+   ((uint32_t)((p)[1]) <<  8) | \
+   ((uint32_t)((p)[2]) << 16) | \
+   ((uint32_t)((p)[3]) << 24))
+
+#define SIPROUND            \
+  do {              \
+    v0 += v1; v1=ROTL(v1, 5); v1 ^= v0; v0=ROTL(v0,16); \
+    v2 += v3; v3=ROTL(v3, 8); v3 ^= v2;     \
+    v0 += v3; v3=ROTL(v3, 7); v3 ^= v0;     \
+    v2 += v1; v1=ROTL(v1,13); v1 ^= v2; v2=ROTL(v2,16); \
+  } while(0)
+
+/* the same round on lane i of the state arrays of the x4 variants */
+#define SIPROUND_LANE(i)            \
+  do {              \
+    v0[i] += v1[i]; v1[i]=ROTL(v1[i], 5); v1[i] ^= v0[i]; v0[i]=ROTL(v0[i],16); \
+    v2[i] += v3[i]; v3[i]=ROTL(v3[i], 8); v3[i] ^= v2[i];     \
+    v0[i] += v3[i]; v3[i]=ROTL(v3[i], 7); v3[i] ^= v0[i];     \
+    v2[i] += v1[i]; v1[i]=ROTL(v1[i],13); v1[i] ^= v2[i]; v2[i]=ROTL(v2[i],16); \
+  } while(0)
+
+static int hx4_halfsiphash13_32_copt_impl(const uint8_t *in, size_t in_sz, const uint8_t *cookie, size_t cookie_sz, uint8_t *out, size_t out_sz) {
+  uint32_t v0 = 0;
+  uint32_t v1 = 0;
+  uint32_t v2 = 0x6c796765;
+  uint32_t v3 = 0x74656462;
+  uint32_t b;
+  uint32_t k0 = U8TO32_LE( cookie );
+  uint32_t k1 = U8TO32_LE( cookie + 4 );
+  uint32_t m;
+  const uint8_t *end = in + in_sz - ( in_sz % sizeof( uint32_t ) );
+  const int left = in_sz & 3;
+
+  b = ( ( uint32_t )in_sz ) << 24;
+  v3 ^= k1;
+  v2 ^= k0;
+  v1 ^= k1;
+  v0 ^= k0;
+
+  for ( ; in != end; in += 4 )
+  {
+    m = U8TO32_LE( in );
+    v3 ^= m;
+    SIPROUND;
+    v0 ^= m;
+  }
+
+  switch( left )
+  {
+  case 3: b |= ( ( uint32_t )in[ 2] )  << 16;
+  case 2: b |= ( ( uint32_t )in[ 1] )  <<  8;
+  case 1: b |= ( ( uint32_t )in[ 0] ); break;
+  case 0: break;
+  }
+
+  v3 ^= b;
+  SIPROUND;
+  v0 ^= b;
+
+  v2 ^= 0xff;
+  SIPROUND;
+  SIPROUND;
+  SIPROUND;
+  b = v1 ^ v3;
+  U32TO8_LE( out, b );
+
+  return HX4_ERR_SUCCESS;
+}
+
+HX4_API int hx4_halfsiphash13_32_copt(const void *in, size_t in_sz, const void *cookie, size_t cookie_sz, void *out, size_t out_sz) {
+  int rc;
+  HX4_STATS_BEGIN(hx4_halfsiphash13_32_copt)
+  rc = hx4_check_params(32/8, in, in_sz, cookie, cookie_sz, out, out_sz);
+  if(rc != HX4_ERR_SUCCESS) {
+    return rc;
+  }
+  rc = hx4_halfsiphash13_32_copt_impl((const uint8_t*)in, in_sz, (const uint8_t*)cookie, cookie_sz, (uint8_t*)out, out_sz);
+  HX4_STATS_END(hx4_halfsiphash13_32_copt, in_sz)
+  return rc;
+}
+
+/*
+ * x4halfsiphash13 runs four HalfSipHash-1-3 instances over the input.
+ * The input is cut into 32bit words and the words are dealt round robin
+ * to the lanes, so lane i hashes the words i, i+4, i+8, ...
+ * The last, possibly partial, word goes to the next lane in turn.
+ * The output is the concatenation of the four 32bit lane hashes.
+ * One word for every lane is exactly one 128bit register.
+ */
+
+//number of input bytes that end up in a lane
+static size_t hx4_x4halfsiphash13_lane_size(size_t in_sz, int lane) {
+  const size_t remainder = in_sz % 16;
+  const size_t lane_remainder = remainder > (size_t)(4*lane) ? remainder - 4*lane : 0;
+  return (in_sz / 16) * 4 + (lane_remainder < 4 ? lane_remainder : 4);
+}
+
+HX4_API int hx4_x4halfsiphash13_128_ref(const void *in, size_t in_sz, const void *cookie, size_t cookie_sz, void *out, size_t out_sz) {
+  const uint8_t *p;
+  uint32_t v0, v1, v2, v3;
+  uint32_t k0, k1;
+  uint32_t b;
+  uint32_t m;
+  size_t lane_sz;
+  size_t i;
+  int lane;
+  int rc;
+  HX4_STATS_BEGIN(hx4_x4halfsiphash13_128_ref)
+
+  rc = hx4_check_params(128/8, in, in_sz, cookie, cookie_sz, out, out_sz);
+  if(rc != HX4_ERR_SUCCESS) {
+    return rc;
+  }
+
+  k0 = U8TO32_LE( (const uint8_t*)cookie );
+  k1 = U8TO32_LE( (const uint8_t*)cookie + 4 );
+
+  for(lane=0; lane<4; lane++) {
+    v0 = 0 ^ k0;
+    v1 = 0 ^ k1;
+    v2 = 0x6c796765 ^ k0;
+    v3 = 0x74656462 ^ k1;
+
+    lane_sz = hx4_x4halfsiphash13_lane_size(in_sz, lane);
+    b = ( ( uint32_t )lane_sz ) << 24;
+
+    //full words of this lane
+    for(i=0; i+4<=lane_sz; i+=4) {
+      p = (const uint8_t*)in + (i/4)*16 + lane*4;
+      m = U8TO32_LE( p );
+      v3 ^= m;
+      SIPROUND;
+      v0 ^= m;
+    }
+
+    //partial last word
+    p = (const uint8_t*)in + (i/4)*16 + lane*4;
+    for( ; i<lane_sz; i++, p++) {
+      b |= ( ( uint32_t )*p ) << (8*(i%4));
+    }
+
+    v3 ^= b;
+    SIPROUND;
+    v0 ^= b;
+
+    v2 ^= 0xff;
+    SIPROUND;
+    SIPROUND;
+    SIPROUND;
+    b = v1 ^ v3;
+    U32TO8_LE( (uint8_t*)out + 4*lane, b );
+  }
+
+  HX4_STATS_END(hx4_x4halfsiphash13_128_ref, in_sz)
+  return HX4_ERR_SUCCESS;
+}
+
+HX4_API void hx4_halfsiphash13_32_init(hx4_halfsiphash_stream *stream, const void *cookie) {
+  uint32_t k0, k1;
+
+  k0 = U8TO32_LE( (const uint8_t*)cookie );
+  k1 = U8TO32_LE( (const uint8_t*)cookie + 4 );
+  memset(stream, 0, sizeof(*stream));
+  stream->v[0] = 0 ^ k0;
+  stream->v[1] = 0 ^ k1;
+  stream->v[2] = 0x6c796765 ^ k0;
+  stream->v[3] = 0x74656462 ^ k1;
+  memcpy(stream->cookie, cookie, sizeof(stream->cookie));
+}
+
+HX4_API void hx4_halfsiphash13_32_final(hx4_halfsiphash_stream *stream, void *out) {
+  uint32_t v0 = stream->v[0];
+  uint32_t v1 = stream->v[1];
+  uint32_t v2 = stream->v[2];
+  uint32_t v3 = stream->v[3];
+  uint32_t b;
+  size_t i;
+
+  b = ( ( uint32_t )stream->pos ) << 24;
+  for(i=0; i<(size_t)(stream->pos & 3); i++) {
+    b |= ( ( uint32_t )stream->carry[i] ) << (8*i);
+  }
+
+  v3 ^= b;
+  SIPROUND;
+  v0 ^= b;
+
+  v2 ^= 0xff;
+  SIPROUND;
+  SIPROUND;
+  SIPROUND;
+  b = v1 ^ v3;
+  U32TO8_LE( (uint8_t*)out, b );
+}
+
+//bytewise through the carry, the straightforward way
+HX4_API void hx4_halfsiphash13_32_ref_update(hx4_halfsiphash_stream *stream, const void *in, size_t in_sz) {
+  const uint8_t *p = (const uint8_t*)in;
+  uint32_t v0 = stream->v[0];
+  uint32_t v1 = stream->v[1];
+  uint32_t v2 = stream->v[2];
+  uint32_t v3 = stream->v[3];
+  uint32_t m;
+  size_t i;
+
+  for(i=0; i<in_sz; i++) {
+    stream->carry[stream->pos & 3] = p[i];
+    stream->pos++;
+    if((stream->pos & 3) == 0) {
+      m = U8TO32_LE( stream->carry );
+      v3 ^= m;
+      SIPROUND;
+      v0 ^= m;
+    }
+  }
+
+  stream->v[0] = v0;
+  stream->v[1] = v1;
+  stream->v[2] = v2;
+  stream->v[3] = v3;
+}
+
+//completes the carried word, then runs the word loop of the one shot function
+HX4_API void hx4_halfsiphash13_32_copt_update(hx4_halfsiphash_stream *stream, const void *in, size_t in_sz) {
+  const uint8_t *p = (const uint8_t*)in;
+  const uint8_t * const p_end = p + in_sz;
+  size_t carry_sz = (size_t)(stream->pos & 3);
+  uint32_t v0 = stream->v[0];
+  uint32_t v1 = stream->v[1];
+  uint32_t v2 = stream->v[2];
+  uint32_t v3 = stream->v[3];
+  uint32_t m;
+
+  stream->pos += in_sz;
+
+  if(carry_sz > 0) {
+    while(carry_sz < 4 && p < p_end) {
+      stream->carry[carry_sz++] = *p++;
+    }
+    if(carry_sz < 4) {
+      return;
+    }
+    m = U8TO32_LE( stream->carry );
+    v3 ^= m;
+    SIPROUND;
+    v0 ^= m;
+  }
+
+  for( ; p_end - p >= 4; p += 4) {
+    m = U8TO32_LE( p );
+    v3 ^= m;
+    SIPROUND;
+    v0 ^= m;
+  }
+
+  memcpy(stream->carry, p, (size_t)(p_end - p));
+
+  stream->v[0] = v0;
+  stream->v[1] = v1;
+  stream->v[2] = v2;
+  stream->v[3] = v3;
+}
+
+HX4_STREAM_V_IMPL(hx4_halfsiphash13_32_ref, hx4_halfsiphash_stream, 32/8, hx4_halfsiphash13_32_init, hx4_halfsiphash13_32_final)
+HX4_STREAM_CSTR_STRLEN_IMPL(hx4_halfsiphash13_32_ref)
+HX4_STREAM_V_IMPL(hx4_halfsiphash13_32_copt, hx4_halfsiphash_stream, 32/8, hx4_halfsiphash13_32_init, hx4_halfsiphash13_32_final)
+HX4_STREAM_CSTR_STRLEN_IMPL(hx4_halfsiphash13_32_copt)
+
+HX4_API void hx4_x4halfsiphash13_128_init(hx4_x4halfsiphash_stream *stream, const void *cookie) {
+  uint32_t k0, k1;
+  int lane;
+
+  k0 = U8TO32_LE( (const uint8_t*)cookie );
+  k1 = U8TO32_LE( (const uint8_t*)cookie + 4 );
+  memset(stream, 0, sizeof(*stream));
+  for(lane=0; lane<4; lane++) {
+    stream->v0[lane] = 0 ^ k0;
+    stream->v1[lane] = 0 ^ k1;
+    stream->v2[lane] = 0x6c796765 ^ k0;
+    stream->v3[lane] = 0x74656462 ^ k1;
+  }
+  memcpy(stream->cookie, cookie, sizeof(stream->cookie));
+}
+
+//the remainder code of the one shot functions run over the carry
+HX4_API void hx4_x4halfsiphash13_128_final(hx4_x4halfsiphash_stream *stream, void *out) {
+  uint32_t * const v0 = stream->v0;
+  uint32_t * const v1 = stream->v1;
+  uint32_t * const v2 = stream->v2;
+  uint32_t * const v3 = stream->v3;
+  const size_t remainder = (size_t)(stream->pos % 16);
+  uint32_t b;
+  uint32_t m;
+  size_t j;
+  int lane;
+
+  for(lane=0; lane<4; lane++) {
+    b = ( ( uint32_t )hx4_x4halfsiphash13_lane_size((size_t)stream->pos, lane) ) << 24;
+    if((size_t)(4*lane+4) <= remainder) {
+      m = U8TO32_LE( stream->carry + 4*lane );
+      v3[lane] ^= m;
+      SIPROUND_LANE(lane);
+      v0[lane] ^= m;
+    } else if((size_t)(4*lane) < remainder) {
+      for(j=0; j<remainder-4*lane; j++) {
+        b |= ( ( uint32_t )stream->carry[4*lane+j] ) << (8*j);
+      }
+    }
+
+    v3[lane] ^= b;
+    SIPROUND_LANE(lane);
+    v0[lane] ^= b;
+
+    v2[lane] ^= 0xff;
+    SIPROUND_LANE(lane);
+    SIPROUND_LANE(lane);
+    SIPROUND_LANE(lane);
+    b = v1[lane] ^ v3[lane];
+    U32TO8_LE( (uint8_t*)out + 4*lane, b );
+  }
+}
+
+//bytewise through the carry, a word for every lane when it is full
+HX4_API void hx4_x4halfsiphash13_128_ref_update(hx4_x4halfsiphash_stream *stream, const void *in, size_t in_sz) {
+  const uint8_t *p = (const uint8_t*)in;
+  uint32_t * const v0 = stream->v0;
+  uint32_t * const v1 = stream->v1;
+  uint32_t * const v2 = stream->v2;
+  uint32_t * const v3 = stream->v3;
+  uint32_t m;
+  size_t i;
+  int lane;
+
+  for(i=0; i<in_sz; i++) {
+    stream->carry[stream->pos % 16] = p[i];
+    stream->pos++;
+    if((stream->pos % 16) == 0) {
+      for(lane=0; lane<4; lane++) {
+        m = U8TO32_LE( stream->carry + 4*lane );
+        v3[lane] ^= m;
+        SIPROUND_LANE(lane);
+        v0[lane] ^= m;
+      }
+    }
+  }
+}
+
+HX4_STREAM_V_IMPL(hx4_x4halfsiphash13_128_ref, hx4_x4halfsiphash_stream, 128/8, hx4_x4halfsiphash13_128_init, hx4_x4halfsiphash13_128_final)
+HX4_STREAM_CSTR_STRLEN_IMPL(hx4_x4halfsiphash13_128_ref)
+
+#if HX4_HAS_SSE2
+
+#define HX4_SSE2_ROTL32(x, b) _mm_or_si128(_mm_slli_epi32((x), (b)), _mm_srli_epi32((x), 32-(b)))
+//a rotation by 16 bits is a word shuffle
+#define HX4_SSE2_ROTL32_16(x) _mm_shufflehi_epi16(_mm_shufflelo_epi16((x), _MM_SHUFFLE(2,3,0,1)), _MM_SHUFFLE(2,3,0,1))
+
+#define HX4_SSE2_HALFSIPROUND(v0, v1, v2, v3) \
+    v0 = _mm_add_epi32(v0, v1); v1 = HX4_SSE2_ROTL32(v1,  5); v1 = _mm_xor_si128(v1, v0); v0 = HX4_SSE2_ROTL32_16(v0); \
+    v2 = _mm_add_epi32(v2, v3); v3 = HX4_SSE2_ROTL32(v3,  8); v3 = _mm_xor_si128(v3, v2); \
+    v0 = _mm_add_epi32(v0, v3); v3 = HX4_SSE2_ROTL32(v3,  7); v3 = _mm_xor_si128(v3, v0); \
+    v2 = _mm_add_epi32(v2, v1); v1 = HX4_SSE2_ROTL32(v1, 13); v1 = _mm_xor_si128(v1, v2); v2 = HX4_SSE2_ROTL32_16(v2);
+
+HX4_API int hx4_x4halfsiphash13_128_sse2(const void *in, size_t in_sz, const void *cookie, size_t cookie_sz, void *out, size_t out_sz) {
+  const uint8_t *p;
+  const uint8_t *end;
+  HX4_ALIGNED(uint32_t v0[4], 16);
+  HX4_ALIGNED(uint32_t v1[4], 16);
+  HX4_ALIGNED(uint32_t v2[4], 16);
+  HX4_ALIGNED(uint32_t v3[4], 16);
+  HX4_ALIGNED(uint32_t b[4], 16);
+  uint32_t k0, k1;
+  uint32_t m;
+  size_t remainder;
+  size_t tail;
+  size_t j;
+  int lane;
+  int rc;
+  __m128i xv0, xv1, xv2, xv3;
+  __m128i xm;
+  HX4_STATS_BEGIN(hx4_x4halfsiphash13_128_sse2)
+
+  rc = hx4_check_params(128/8, in, in_sz, cookie, cookie_sz, out, out_sz);
+  if(rc != HX4_ERR_SUCCESS) {
+    return rc;
+  }
+
+  k0 = U8TO32_LE( (const uint8_t*)cookie );
+  k1 = U8TO32_LE( (const uint8_t*)cookie + 4 );
+  for(lane=0; lane<4; lane++) {
+    v0[lane] = 0 ^ k0;
+    v1[lane] = 0 ^ k1;
+    v2[lane] = 0x6c796765 ^ k0;
+    v3[lane] = 0x74656462 ^ k1;
+  }
+
+  xv0 = _mm_load_si128((__m128i*)v0);
+  xv1 = _mm_load_si128((__m128i*)v1);
+  xv2 = _mm_load_si128((__m128i*)v2);
+  xv3 = _mm_load_si128((__m128i*)v3);
+
+  //main processing loop, one word for every lane
+  p = (const uint8_t*)in;
+  end = p + in_sz - (in_sz % 16);
+  for( ; p != end; p += 16) {
+    xm = _mm_loadu_si128((const __m128i*)p);
+    xv3 = _mm_xor_si128(xv3, xm);
+    HX4_SSE2_HALFSIPROUND(xv0, xv1, xv2, xv3)
+    xv0 = _mm_xor_si128(xv0, xm);
+  }
+
+  _mm_store_si128((__m128i*)v0, xv0);
+  _mm_store_si128((__m128i*)v1, xv1);
+  _mm_store_si128((__m128i*)v2, xv2);
+  _mm_store_si128((__m128i*)v3, xv3);
+
+  //the remainder holds at most one full word per lane, the lanes
+  //differ here so it is done one lane after the other
+  remainder = in_sz % 16;
+  for(lane=0; lane<4; lane++) {
+    b[lane] = ( ( uint32_t )hx4_x4halfsiphash13_lane_size(in_sz, lane) ) << 24;
+    if((size_t)(4*lane+4) <= remainder) {
+      m = U8TO32_LE( p + 4*lane );
+      v3[lane] ^= m;
+      SIPROUND_LANE(lane);
+      v0[lane] ^= m;
+    } else if((size_t)(4*lane) < remainder) {
+      tail = remainder - 4*lane;
+      for(j=0; j<tail; j++) {
+        b[lane] |= ( ( uint32_t )p[4*lane+j] ) << (8*j);
+      }
+    }
+  }
+
+  //finalization is the same for all lanes again
+  xv0 = _mm_load_si128((__m128i*)v0);
+  xv1 = _mm_load_si128((__m128i*)v1);
+  xv2 = _mm_load_si128((__m128i*)v2);
+  xv3 = _mm_load_si128((__m128i*)v3);
+  xm = _mm_load_si128((__m128i*)b);
+
+  xv3 = _mm_xor_si128(xv3, xm);
+  HX4_SSE2_HALFSIPROUND(xv0, xv1, xv2, xv3)
+  xv0 = _mm_xor_si128(xv0, xm);
+
+  xv2 = _mm_xor_si128(xv2, _mm_set1_epi32(0xff));
+  HX4_SSE2_HALFSIPROUND(xv0, xv1, xv2, xv3)
+  HX4_SSE2_HALFSIPROUND(xv0, xv1, xv2, xv3)
+  HX4_SSE2_HALFSIPROUND(xv0, xv1, xv2, xv3)
+
+  _mm_storeu_si128((__m128i*)out, _mm_xor_si128(xv1, xv3));
+
+  HX4_STATS_END(hx4_x4halfsiphash13_128_sse2, in_sz)
+  return HX4_ERR_SUCCESS;
+}
+
+//the finalization of hx4_x4halfsiphash13_128_sse2 run over the carry
+HX4_API void hx4_x4halfsiphash13_128_sse2_final(hx4_x4halfsiphash_stream *stream, void *out) {
+  uint32_t * const v0 = stream->v0;
+  uint32_t * const v1 = stream->v1;
+  uint32_t * const v2 = stream->v2;
+  uint32_t * const v3 = stream->v3;
+  const uint8_t * const p = stream->carry;
+  const size_t remainder = (size_t)(stream->pos % 16);
+  HX4_ALIGNED(uint32_t b[4], 16);
+  uint32_t m;
+  size_t tail;
+  size_t j;
+  int lane;
+  __m128i xv0, xv1, xv2, xv3;
+  __m128i xm;
+
+  for(lane=0; lane<4; lane++) {
+    b[lane] = ( ( uint32_t )hx4_x4halfsiphash13_lane_size((size_t)stream->pos, lane) ) << 24;
+    if((size_t)(4*lane+4) <= remainder) {
+      m = U8TO32_LE( p + 4*lane );
+      v3[lane] ^= m;
+      SIPROUND_LANE(lane);
+      v0[lane] ^= m;
+    } else if((size_t)(4*lane) < remainder) {
+      tail = remainder - 4*lane;
+      for(j=0; j<tail; j++) {
+        b[lane] |= ( ( uint32_t )p[4*lane+j] ) << (8*j);
+      }
+    }
+  }
+
+  xv0 = _mm_load_si128((__m128i*)v0);
+  xv1 = _mm_load_si128((__m128i*)v1);
+  xv2 = _mm_load_si128((__m128i*)v2);
+  xv3 = _mm_load_si128((__m128i*)v3);
+  xm = _mm_load_si128((__m128i*)b);
+
+  xv3 = _mm_xor_si128(xv3, xm);
+  HX4_SSE2_HALFSIPROUND(xv0, xv1, xv2, xv3)
+  xv0 = _mm_xor_si128(xv0, xm);
+
+  xv2 = _mm_xor_si128(xv2, _mm_set1_epi32(0xff));
+  HX4_SSE2_HALFSIPROUND(xv0, xv1, xv2, xv3)
+  HX4_SSE2_HALFSIPROUND(xv0, xv1, xv2, xv3)
+  HX4_SSE2_HALFSIPROUND(xv0, xv1, xv2, xv3)
+
+  _mm_storeu_si128((__m128i*)out, _mm_xor_si128(xv1, xv3));
+}
+
+HX4_API void hx4_x4halfsiphash13_128_sse2_update(hx4_x4halfsiphash_stream *stream, const void *in, size_t in_sz) {
+  const uint8_t *p = (const uint8_t*)in;
+  const uint8_t * const p_end = p + in_sz;
+  const size_t carry_sz = (size_t)(stream->pos % 16);
+  __m128i xv0, xv1, xv2, xv3;
+  __m128i xm;
+
+  stream->pos += in_sz;
+
+  //not yet a word for every lane
+  if(carry_sz + in_sz < 16) {
+    memcpy(stream->carry + carry_sz, p, in_sz);
+    return;
+  }
+
+  xv0 = _mm_load_si128((__m128i*)stream->v0);
+  xv1 = _mm_load_si128((__m128i*)stream->v1);
+  xv2 = _mm_load_si128((__m128i*)stream->v2);
+  xv3 = _mm_load_si128((__m128i*)stream->v3);
+
+  //complete the words that were started by the previous piece
+  if(carry_sz > 0) {
+    memcpy(stream->carry + carry_sz, p, 16 - carry_sz);
+    p += 16 - carry_sz;
+    xm = _mm_loadu_si128((const __m128i*)stream->carry);
+    xv3 = _mm_xor_si128(xv3, xm);
+    HX4_SSE2_HALFSIPROUND(xv0, xv1, xv2, xv3)
+    xv0 = _mm_xor_si128(xv0, xm);
+  }
+
+  //main processing loop, one word for every lane
+  for( ; p_end - p >= 16; p += 16) {
+    xm = _mm_loadu_si128((const __m128i*)p);
+    xv3 = _mm_xor_si128(xv3, xm);
+    HX4_SSE2_HALFSIPROUND(xv0, xv1, xv2, xv3)
+    xv0 = _mm_xor_si128(xv0, xm);
+  }
+
+  _mm_store_si128((__m128i*)stream->v0, xv0);
+  _mm_store_si128((__m128i*)stream->v1, xv1);
+  _mm_store_si128((__m128i*)stream->v2, xv2);
+  _mm_store_si128((__m128i*)stream->v3, xv3);
+
+  memcpy(stream->carry, p, (size_t)(p_end - p));
+}
+
+HX4_STREAM_V_IMPL(hx4_x4halfsiphash13_128_sse2, hx4_x4halfsiphash_stream, 128/8, hx4_x4halfsiphash13_128_init, hx4_x4halfsiphash13_128_sse2_final)
+HX4_STREAM_CSTR_STRLEN_IMPL(hx4_x4halfsiphash13_128_sse2)
+
+/* copy-and-hash, stores every loaded register to dst before it is hashed,
+ * large copies to an aligned dst use non-temporal stores */
+HX4_API void hx4_x4halfsiphash13_128_sse2_copy_update(hx4_x4halfsiphash_stream *stream, void *dst, const void *in, size_t in_sz) {
+  const uint8_t *p = (const uint8_t*)in;
+  const uint8_t * const p_end = p + in_sz;
+  const size_t carry_sz = (size_t)(stream->pos % 16);
+  uint8_t *q = (uint8_t*)dst;
+  int stream_stores;
+  __m128i xv0, xv1, xv2, xv3;
+  __m128i xm;
+
+  stream->pos += in_sz;
+
+  //not yet a word for every lane
+  if(carry_sz + in_sz < 16) {
+    memcpy(q, p, in_sz);
+    memcpy(stream->carry + carry_sz, p, in_sz);
+    return;
+  }
+
+  xv0 = _mm_load_si128((__m128i*)stream->v0);
+  xv1 = _mm_load_si128((__m128i*)stream->v1);
+  xv2 = _mm_load_si128((__m128i*)stream->v2);
+  xv3 = _mm_load_si128((__m128i*)stream->v3);
+
+  //complete the words that were started by the previous piece
+  if(carry_sz > 0) {
+    memcpy(q, p, 16 - carry_sz);
+    memcpy(stream->carry + carry_sz, p, 16 - carry_sz);
+    p += 16 - carry_sz;
+    q += 16 - carry_sz;
+    xm = _mm_loadu_si128((const __m128i*)stream->carry);
+    xv3 = _mm_xor_si128(xv3, xm);
+    HX4_SSE2_HALFSIPROUND(xv0, xv1, xv2, xv3)
+    xv0 = _mm_xor_si128(xv0, xm);
+  }
+
+  stream_stores = in_sz >= HX4_COPY_STREAM_MIN_SIZE && hx4_bytes_to_aligned(q, 16) == 0;
+
+  //main processing loop, one word for every lane
+  for( ; p_end - p >= 16; p += 16, q += 16) {
+    xm = _mm_loadu_si128((const __m128i*)p);
+    if(stream_stores) {
+      _mm_stream_si128((__m128i*)q, xm);
+    } else {
+      _mm_storeu_si128((__m128i*)q, xm);
+    }
+    xv3 = _mm_xor_si128(xv3, xm);
+    HX4_SSE2_HALFSIPROUND(xv0, xv1, xv2, xv3)
+    xv0 = _mm_xor_si128(xv0, xm);
+  }
+
+  //the non-temporal stores are weakly ordered
+  if(stream_stores) {
+    _mm_sfence();
+  }
+
+  _mm_store_si128((__m128i*)stream->v0, xv0);
+  _mm_store_si128((__m128i*)stream->v1, xv1);
+  _mm_store_si128((__m128i*)stream->v2, xv2);
+  _mm_store_si128((__m128i*)stream->v3, xv3);
+
+  memcpy(q, p, (size_t)(p_end - p));
+  memcpy(stream->carry, p, (size_t)(p_end - p));
+}
+
+HX4_STREAM_COPY_IMPL(hx4_x4halfsiphash13_128_sse2, hx4_x4halfsiphash_stream, 128/8, hx4_x4halfsiphash13_128_init, hx4_x4halfsiphash13_128_sse2_final)
+
+#undef HX4_SSE2_HALFSIPROUND
+#undef HX4_SSE2_ROTL32_16
+#undef HX4_SSE2_ROTL32
+#endif //HX4_HAS_SSE2
+
+#undef ROTL
+#undef SIPROUND
+#undef SIPROUND_LANE
+#undef U32TO8_LE
+#undef U8TO32_LE
@@ -0,0 +1,269 @@
+/* 
+ * Copyright 2015 Kai Dietrich <mail@cleeus.de>
+ *
+ * This file is part of hashx4.
+ *
+ * Hashx4 is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Hashx4 is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with hashx4.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "hashx4_config.h"
+
+#if HX4_HAS_SSE2
+# include <emmintrin.h>
+#endif
+
+#ifdef _MSC_VER
+# include <intrin.h>
+#endif
+
+#include "hashx4.h"
+#include "hashx4_intern.h"
+#include "hx4_util.h"
+
+// strings hashed and prefetched ahead of the probes in the batch functions
+#define HX4_INTERN_BATCH 16
+
+#define U8TO32_LE(p)                                                           \
+  (((uint32_t)((p)[0])) | ((uint32_t)((p)[1]) << 8) |                          \
+   ((uint32_t)((p)[2]) << 16) | ((uint32_t)((p)[3]) << 24))
+
+// a slot is the hash in the high and the handle in the low half, 0 is empty
+#ifdef __GNUC__
+# define HX4_INTERN_LOAD_SLOT(slot) __atomic_load_n((slot), __ATOMIC_ACQUIRE)
+# define HX4_INTERN_STORE_SLOT(slot, value) __atomic_store_n((slot), (value), __ATOMIC_RELEASE)
+#elif _MSC_VER
+// a compare exchange is a full barrier and 64bit wide on x86 too, the writer only ever fills empty slots
+# define HX4_INTERN_LOAD_SLOT(slot) ((uint64_t)_InterlockedCompareExchange64((volatile __int64*)(slot), 0, 0))
+# define HX4_INTERN_STORE_SLOT(slot, value) _InterlockedCompareExchange64((volatile __int64*)(slot), (__int64)(value), 0)
+#endif
+
+static int hx4_intern_hash_str(const hx4_intern *in, const void *str, size_t str_len, uint32_t *hash) {
+  uint8_t out[64/8];
+  int rc;
+
+  rc = hx4_siphash13_64_copt(str, str_len, in->cookie, sizeof(in->cookie), out, sizeof(out));
+  if(rc != HX4_ERR_SUCCESS) {
+    return rc;
+  }
+  *hash = U8TO32_LE(out);
+  return HX4_ERR_SUCCESS;
+}
+
+static void hx4_intern_prefetch(const hx4_intern *in, uint32_t hash) {
+#if HX4_HAS_SSE2
+  _mm_prefetch((const char*)(in->slots + (hash & (in->num_slots - 1))), _MM_HINT_T0);
+#else
+  (void)in;
+  (void)hash;
+#endif
+}
+
+/*
+ * Probes for the string. Writes its handle, or 0 and the index of the empty
+ * slot that ends the probe sequence.
+ */
+static void hx4_intern_probe(const hx4_intern *in, const void *str, size_t str_len, uint32_t hash, uint32_t *handle, size_t *empty) {
+  const size_t mask = in->num_slots - 1;
+  size_t pos = hash & mask;
+  const uint8_t *entry;
+  uint64_t slot;
+
+  for(;;) {
+    slot = HX4_INTERN_LOAD_SLOT(&in->slots[pos]);
+    if(slot == 0) {
+      *handle = 0;
+      *empty = pos;
+      return;
+    }
+    if((uint32_t)(slot >> 32) == hash) {
+      entry = in->arena + ((size_t)(uint32_t)slot - 1) * 8;
+      if(*(const uint32_t*)(entry + 4) == str_len && memcmp(entry + 8, str, str_len) == 0) {
+        *handle = (uint32_t)slot;
+        return;
+      }
+    }
+    // the table is never full, so there always is an empty slot
+    pos = (pos + 1) & mask;
+  }
+}
+
+// copies the string into the arena and publishes it in the empty slot
+static int hx4_intern_insert(hx4_intern *in, const void *str, size_t str_len, uint32_t hash, size_t empty, uint32_t *handle) {
+  const size_t entry_sz = HX4_INTERN_ENTRY_SIZE(str_len);
+  uint8_t *entry;
+  uint32_t len32 = (uint32_t)str_len;
+
+  if(in->count + 1 > HX4_INTERN_MAX_STRINGS(in->num_slots) || in->arena_sz - in->arena_used < entry_sz) {
+    return HX4_ERR_BUFFER_TOO_SMALL;
+  }
+  if((uint64_t)in->arena_used / 8 + 1 > 0xffffffffULL) {
+    return HX4_ERR_BUFFER_TOO_SMALL;
+  }
+
+  entry = in->arena + in->arena_used;
+  memcpy(entry, &hash, 4);
+  memcpy(entry + 4, &len32, 4);
+  memcpy(entry + 8, str, str_len);
+  memset(entry + 8 + str_len, 0, entry_sz - 8 - str_len);
+
+  *handle = (uint32_t)(in->arena_used / 8 + 1);
+  HX4_INTERN_STORE_SLOT(&in->slots[empty], ((uint64_t)hash << 32) | *handle);
+  in->arena_used += entry_sz;
+  in->count++;
+  return HX4_ERR_SUCCESS;
+}
+
+int hx4_intern_init(hx4_intern *in, void *memory, size_t memory_sz, size_t num_slots, const void *cookie, size_t cookie_sz) {
+  size_t align;
+
+  if(!in || !memory || !cookie) {
+    return HX4_ERR_PARAM_INVALID;
+  }
+  if(cookie_sz < 128/8) {
+    return HX4_ERR_COOKIE_TOO_SMALL;
+  }
+  if(num_slots < 4 || (uint64_t)num_slots > ( ( uint64_t )1 ) << 32 || (num_slots & (num_slots - 1)) != 0) {
+    return HX4_ERR_PARAM_INVALID;
+  }
+  align = hx4_bytes_to_aligned(memory, 8);
+  if(memory_sz < align || (memory_sz - align) / 8 < num_slots) {
+    return HX4_ERR_BUFFER_TOO_SMALL;
+  }
+
+  in->slots = (uint64_t*)((uint8_t*)memory + align);
+  in->num_slots = num_slots;
+  in->arena = (uint8_t*)(in->slots + num_slots);
+  in->arena_sz = (memory_sz - align - num_slots * 8) & ~(size_t)7;
+  in->arena_used = 0;
+  in->count = 0;
+  memcpy(in->cookie, cookie, sizeof(in->cookie));
+  memset(in->slots, 0, num_slots * 8);
+
+  return HX4_ERR_SUCCESS;
+}
+
+int hx4_intern_add(hx4_intern *in, const void *str, size_t str_len, uint32_t *handle) {
+  uint32_t hash;
+  size_t empty;
+  int rc;
+
+  if(!in || !in->slots || !handle || !str || (uint64_t)str_len > 0xffffffffULL) {
+    return HX4_ERR_PARAM_INVALID;
+  }
+  rc = hx4_intern_hash_str(in, str, str_len, &hash);
+  if(rc != HX4_ERR_SUCCESS) {
+    return rc;
+  }
+  hx4_intern_probe(in, str, str_len, hash, handle, &empty);
+  if(*handle != 0) {
+    return HX4_ERR_SUCCESS;
+  }
+  return hx4_intern_insert(in, str, str_len, hash, empty, handle);
+}
+
+int hx4_intern_find(const hx4_intern *in, const void *str, size_t str_len, uint32_t *handle) {
+  uint32_t hash;
+  size_t empty;
+  int rc;
+
+  if(!in || !in->slots || !handle || !str) {
+    return HX4_ERR_PARAM_INVALID;
+  }
+  rc = hx4_intern_hash_str(in, str, str_len, &hash);
+  if(rc != HX4_ERR_SUCCESS) {
+    return rc;
+  }
+  hx4_intern_probe(in, str, str_len, hash, handle, &empty);
+  return *handle != 0 ? HX4_ERR_SUCCESS : HX4_ERR_NOT_FOUND;
+}
+
+int hx4_intern_add_batch(hx4_intern *in, const void *const *strs, const size_t *str_lens, size_t n, uint32_t *handles) {
+  uint32_t hashes[HX4_INTERN_BATCH];
+  size_t group;
+  size_t empty;
+  size_t i;
+  size_t j;
+  int rc;
+
+  if(!in || !in->slots || !strs || !str_lens || !handles) {
+    return HX4_ERR_PARAM_INVALID;
+  }
+
+  for(i=0; i<n; i+=group) {
+    group = n - i < HX4_INTERN_BATCH ? n - i : HX4_INTERN_BATCH;
+    for(j=0; j<group; j++) {
+      if(!strs[i+j] || (uint64_t)str_lens[i+j] > 0xffffffffULL) {
+        return HX4_ERR_PARAM_INVALID;
+      }
+      rc = hx4_intern_hash_str(in, strs[i+j], str_lens[i+j], &hashes[j]);
+      if(rc != HX4_ERR_SUCCESS) {
+        return rc;
+      }
+      hx4_intern_prefetch(in, hashes[j]);
+    }
+    // one at a time, a string may repeat within the group
+    for(j=0; j<group; j++) {
+      hx4_intern_probe(in, strs[i+j], str_lens[i+j], hashes[j], &handles[i+j], &empty);
+      if(handles[i+j] == 0) {
+        rc = hx4_intern_insert(in, strs[i+j], str_lens[i+j], hashes[j], empty, &handles[i+j]);
+        if(rc != HX4_ERR_SUCCESS) {
+          return rc;
+        }
+      }
+    }
+  }
+
+  return HX4_ERR_SUCCESS;
+}
+
+int hx4_intern_find_batch(const hx4_intern *in, const void *const *strs, const size_t *str_lens, size_t n, uint32_t *handles) {
+  uint32_t hashes[HX4_INTERN_BATCH];
+  size_t group;
+  size_t empty;
+  size_t i;
+  size_t j;
+  int rc;
+
+  if(!in || !in->slots || !strs || !str_lens || !handles) {
+    return HX4_ERR_PARAM_INVALID;
+  }
+
+  for(i=0; i<n; i+=group) {
+    group = n - i < HX4_INTERN_BATCH ? n - i : HX4_INTERN_BATCH;
+    for(j=0; j<group; j++) {
+      if(!strs[i+j]) {
+        return HX4_ERR_PARAM_INVALID;
+      }
+      rc = hx4_intern_hash_str(in, strs[i+j], str_lens[i+j], &hashes[j]);
+      if(rc != HX4_ERR_SUCCESS) {
+        return rc;
+      }
+      hx4_intern_prefetch(in, hashes[j]);
+    }
+    for(j=0; j<group; j++) {
+      hx4_intern_probe(in, strs[i+j], str_lens[i+j], hashes[j], &handles[i+j], &empty);
+    }
+  }
+
+  return HX4_ERR_SUCCESS;
+}
+
+#undef HX4_INTERN_LOAD_SLOT
+#undef HX4_INTERN_STORE_SLOT
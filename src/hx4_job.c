@@ -0,0 +1,208 @@
+/* 
+ * Copyright 2015 Kai Dietrich <mail@cleeus.de>
+ *
+ * This file is part of hashx4.
+ *
+ * Hashx4 is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Hashx4 is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with hashx4.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "hashx4_config.h"
+
+#ifdef __GNUC__
+# include <time.h>
+#elif _MSC_VER
+# include <windows.h>
+#endif
+
+#include "hashx4.h"
+#include "hashx4_job.h"
+#include "hx4_util.h"
+#include "hx4_stream.h"
+
+typedef struct {
+  size_t out_size;
+  void (*init)(void *stream, const void *cookie);
+  void (*update)(void *stream, const void *in, size_t in_sz);
+  void (*final)(void *stream, void *out);
+} hx4_job_kernel;
+
+// the stream functions of a kernel behind void pointers, for the table below
+#define HX4_JOB_KERNEL_IMPL(name, stream_type, init_function, update_function, final_function) \
+static void name##_job_init(void *stream, const void *cookie) { \
+  init_function((stream_type*)stream, cookie); \
+} \
+static void name##_job_update(void *stream, const void *in, size_t in_sz) { \
+  update_function((stream_type*)stream, in, in_sz); \
+} \
+static void name##_job_final(void *stream, void *out) { \
+  final_function((stream_type*)stream, out); \
+}
+
+#define HX4_JOB_KERNEL_ITEM(name, output_bits) \
+  { (output_bits)/8, name##_job_init, name##_job_update, name##_job_final } ,
+
+HX4_JOB_KERNEL_IMPL(djbx33a_32, hx4_djb_stream, hx4_djbx33a_32_init, hx4_djbx33a_32_copt_update, hx4_djbx33a_32_final)
+#if HX4_HAS_SSSE3
+HX4_JOB_KERNEL_IMPL(x4djbx33a_128, hx4_djb_stream, hx4_x4djbx33a_128_init, hx4_x4djbx33a_128_ssse3_update, hx4_x4djbx33a_128_final)
+#elif HX4_HAS_SSE2
+HX4_JOB_KERNEL_IMPL(x4djbx33a_128, hx4_djb_stream, hx4_x4djbx33a_128_init, hx4_x4djbx33a_128_sse2_update, hx4_x4djbx33a_128_final)
+#else
+HX4_JOB_KERNEL_IMPL(x4djbx33a_128, hx4_djb_stream, hx4_x4djbx33a_128_init, hx4_x4djbx33a_128_copt_update, hx4_x4djbx33a_128_final)
+#endif
+HX4_JOB_KERNEL_IMPL(kdjbx33a_32, hx4_djb_stream, hx4_kdjbx33a_32_init, hx4_kdjbx33a_32_copt_update, hx4_kdjbx33a_32_final)
+#if HX4_HAS_SSSE3
+HX4_JOB_KERNEL_IMPL(x4kdjbx33a_128, hx4_djb_stream, hx4_x4kdjbx33a_128_init, hx4_x4kdjbx33a_128_ssse3_update, hx4_x4kdjbx33a_128_final)
+#elif HX4_HAS_SSE2
+HX4_JOB_KERNEL_IMPL(x4kdjbx33a_128, hx4_djb_stream, hx4_x4kdjbx33a_128_init, hx4_x4kdjbx33a_128_sse2_update, hx4_x4kdjbx33a_128_final)
+#else
+HX4_JOB_KERNEL_IMPL(x4kdjbx33a_128, hx4_djb_stream, hx4_x4kdjbx33a_128_init, hx4_x4kdjbx33a_128_copt_update, hx4_x4kdjbx33a_128_final)
+#endif
+HX4_JOB_KERNEL_IMPL(siphash24_64, hx4_siphash_stream, hx4_siphash24_64_init, hx4_siphash24_64_copt_update, hx4_siphash24_64_final)
+HX4_JOB_KERNEL_IMPL(siphash13_64, hx4_siphash_stream, hx4_siphash13_64_init, hx4_siphash13_64_copt_update, hx4_siphash13_64_final)
+#if HX4_HAS_SSE2
+HX4_JOB_KERNEL_IMPL(x4siphash13_256, hx4_x4siphash_stream, hx4_x4siphash13_256_init, hx4_x4siphash13_256_sse2_update, hx4_x4siphash13_256_sse2_final)
+#else
+HX4_JOB_KERNEL_IMPL(x4siphash13_256, hx4_x4siphash_stream, hx4_x4siphash13_256_init, hx4_x4siphash13_256_ref_update, hx4_x4siphash13_256_final)
+#endif
+HX4_JOB_KERNEL_IMPL(halfsiphash13_32, hx4_halfsiphash_stream, hx4_halfsiphash13_32_init, hx4_halfsiphash13_32_copt_update, hx4_halfsiphash13_32_final)
+#if HX4_HAS_SSE2
+HX4_JOB_KERNEL_IMPL(x4halfsiphash13_128, hx4_x4halfsiphash_stream, hx4_x4halfsiphash13_128_init, hx4_x4halfsiphash13_128_sse2_update, hx4_x4halfsiphash13_128_sse2_final)
+#else
+HX4_JOB_KERNEL_IMPL(x4halfsiphash13_128, hx4_x4halfsiphash_stream, hx4_x4halfsiphash13_128_init, hx4_x4halfsiphash13_128_ref_update, hx4_x4halfsiphash13_128_final)
+#endif
+
+// in the order of the HX4_ALG_ constants
+static const hx4_job_kernel hx4_job_kernels[] = {
+  HX4_JOB_KERNEL_ITEM(djbx33a_32, 32)
+  HX4_JOB_KERNEL_ITEM(x4djbx33a_128, 128)
+  HX4_JOB_KERNEL_ITEM(kdjbx33a_32, 32)
+  HX4_JOB_KERNEL_ITEM(x4kdjbx33a_128, 128)
+  HX4_JOB_KERNEL_ITEM(siphash24_64, 64)
+  HX4_JOB_KERNEL_ITEM(siphash13_64, 64)
+  HX4_JOB_KERNEL_ITEM(x4siphash13_256, 256)
+  HX4_JOB_KERNEL_ITEM(halfsiphash13_32, 32)
+  HX4_JOB_KERNEL_ITEM(x4halfsiphash13_128, 128)
+};
+
+// every stream state has to fit into a job
+typedef char hx4_job_stream_size_check[sizeof(hx4_x4siphash_stream) <= HX4_JOB_STREAM_SIZE ? 1 : -1];
+
+static uint64_t hx4_job_now_us(void) {
+#ifdef __GNUC__
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000 + (uint64_t)ts.tv_nsec / 1000;
+#elif _MSC_VER
+  LARGE_INTEGER counter;
+  LARGE_INTEGER frequency;
+  QueryPerformanceCounter(&counter);
+  QueryPerformanceFrequency(&frequency);
+  return (uint64_t)(counter.QuadPart / frequency.QuadPart) * 1000000 + (uint64_t)(counter.QuadPart % frequency.QuadPart) * 1000000 / (uint64_t)frequency.QuadPart;
+#endif
+}
+
+// the aligned stream state, moved along if the job was copied to an address with another alignment
+static void *hx4_job_stream(hx4_job *job) {
+  const size_t offset = (size_t)hx4_bytes_to_aligned(job->stream, 16);
+  if(offset != job->stream_offset) {
+    memmove(job->stream + offset, job->stream + job->stream_offset, HX4_JOB_STREAM_SIZE);
+    job->stream_offset = offset;
+  }
+  return job->stream + offset;
+}
+
+static int hx4_job_valid(const hx4_job *job) {
+  return job && job->algorithm >= 0 && (size_t)job->algorithm < sizeof(hx4_job_kernels)/sizeof(hx4_job_kernels[0])
+    && job->in && job->pos <= job->in_sz && job->stream_offset < 16;
+}
+
+int hx4_job_init(hx4_job *job, int algorithm, const void *in, size_t in_sz, const void *cookie, size_t cookie_sz) {
+  if(!job || !in || !cookie) {
+    return HX4_ERR_PARAM_INVALID;
+  }
+  if(algorithm < 0 || (size_t)algorithm >= sizeof(hx4_job_kernels)/sizeof(hx4_job_kernels[0])) {
+    return HX4_ERR_PARAM_INVALID;
+  }
+  if(cookie_sz < 128/8) {
+    return HX4_ERR_COOKIE_TOO_SMALL;
+  }
+
+  memset(job, 0, sizeof(*job));
+  job->stream_offset = (size_t)hx4_bytes_to_aligned(job->stream, 16);
+  job->algorithm = algorithm;
+  job->in = (const uint8_t*)in;
+  job->in_sz = in_sz;
+  job->pos = 0;
+  hx4_job_kernels[algorithm].init(hx4_job_stream(job), cookie);
+
+  return HX4_ERR_SUCCESS;
+}
+
+int hx4_job_step(hx4_job *job, size_t max_bytes, uint32_t max_us) {
+  const hx4_job_kernel *kernel;
+  void *stream;
+  size_t end;
+  size_t chunk;
+  uint64_t deadline = 0;
+
+  if(!hx4_job_valid(job)) {
+    return HX4_ERR_PARAM_INVALID;
+  }
+  kernel = &hx4_job_kernels[job->algorithm];
+  stream = hx4_job_stream(job);
+
+  end = max_bytes > 0 && max_bytes < job->in_sz - job->pos ? job->pos + max_bytes : job->in_sz;
+  if(max_us > 0) {
+    deadline = hx4_job_now_us() + max_us;
+  }
+
+  while(job->pos < end) {
+    // chunks end on multiples of the chunk size from the start of the input, whatever the byte limits were
+    chunk = HX4_JOB_CHUNK_SIZE - job->pos % HX4_JOB_CHUNK_SIZE;
+    if(chunk > end - job->pos) {
+      chunk = end - job->pos;
+    }
+    kernel->update(stream, job->in + job->pos, chunk);
+    job->pos += chunk;
+    if(max_us > 0 && hx4_job_now_us() >= deadline) {
+      break;
+    }
+  }
+
+  return job->pos < job->in_sz ? HX4_JOB_PENDING : HX4_ERR_SUCCESS;
+}
+
+int hx4_job_final(hx4_job *job, void *out, size_t out_sz) {
+  const hx4_job_kernel *kernel;
+
+  if(!hx4_job_valid(job) || !out || job->pos < job->in_sz) {
+    return HX4_ERR_PARAM_INVALID;
+  }
+  kernel = &hx4_job_kernels[job->algorithm];
+  if(out_sz < kernel->out_size) {
+    return HX4_ERR_BUFFER_TOO_SMALL;
+  }
+  kernel->final(hx4_job_stream(job), out);
+
+  return HX4_ERR_SUCCESS;
+}
+
+#undef HX4_JOB_KERNEL_IMPL
+#undef HX4_JOB_KERNEL_ITEM
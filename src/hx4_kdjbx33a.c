@@ -0,0 +1,603 @@
+/* 
+ * Copyright 2015 Kai Dietrich <mail@cleeus.de>
+ *
+ * This file is part of hashx4.
+ *
+ * Hashx4 is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Hashx4 is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with hashx4.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/*
+ * Keyed variants of djbx33a and x4djbx33a.
+ *
+ * DJBX33A is affine in its start value, so two inputs of the same length
+ * that collide for one start value collide for all of them. Mixing the
+ * cookie into the start value alone can't make collisions key dependent.
+ * The keyed variants therefore also whiten every input byte with the cookie
+ * byte at the same position modulo 16 before it enters the state. In the
+ * SIMD kernels this is one xor per 16 byte block.
+ *
+ *   lane_j   = 5381 ^ cookie_word[j]
+ *   lane_j   = lane_j * 33 + (in[i] ^ cookie[i % 16])   for every byte i of lane j
+ *   out_j    = fmix32(lane_j ^ cookie_word[(j+1) % 4])
+ *
+ * The single lane kdjbx33a_32 is lane 0 of this fed with all bytes.
+ * This makes ready made collision lists useless, but it is not a PRF.
+ * Use siphash if the keys are chosen by an adversary who can observe
+ * the table.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "hashx4_config.h"
+
+#if HX4_HAS_SSE2
+# include <emmintrin.h>
+#endif
+
+#if HX4_HAS_SSSE3
+# include <tmmintrin.h>
+#endif
+
+#include "hashx4.h"
+#include "hx4_util.h"
+#include "hx4_stream.h"
+
+//murmur3 finalizer with the key mixed in first
+static uint32_t hx4_kdjbx33a_final(uint32_t state, uint32_t key) {
+  state ^= key;
+  state ^= state >> 16;
+  state *= 0x85ebca6b;
+  state ^= state >> 13;
+  state *= 0xc2b2ae35;
+  state ^= state >> 16;
+  return state;
+}
+
+static void hx4_x4kdjbx33a_final(uint32_t state[4], const uint32_t key[4]) {
+  int i;
+  for(i=0; i<4; i++) {
+    state[i] = hx4_kdjbx33a_final(state[i], key[(i+1) & 0x03]);
+  }
+}
+
+//the cookie bytes rotated so that key[0] is the key byte for the first aligned input byte
+static void hx4_kdjbx33a_rotate_key(uint8_t *key_rotated, const uint8_t *key, int offset) {
+  int i;
+  for(i=0; i<16; i++) {
+    key_rotated[i] = key[(i+offset) & 0x0f];
+  }
+}
+
+HX4_API void hx4_kdjbx33a_32_init(hx4_djb_stream *stream, const void *cookie) {
+  uint32_t key_words[4];
+  memset(stream, 0, sizeof(*stream));
+  memcpy(key_words, cookie, sizeof(key_words));
+  stream->state[0] = 5381 ^ key_words[0];
+  memcpy(stream->cookie, cookie, sizeof(stream->cookie));
+}
+
+HX4_API void hx4_kdjbx33a_32_final(hx4_djb_stream *stream, void *out) {
+  uint32_t key_words[4];
+  uint32_t state;
+  memcpy(key_words, stream->cookie, sizeof(key_words));
+  state = hx4_kdjbx33a_final(stream->state[0], key_words[1]);
+  memcpy(out, &state, sizeof(state));
+}
+
+HX4_API void hx4_x4kdjbx33a_128_init(hx4_djb_stream *stream, const void *cookie) {
+  uint32_t key_words[4];
+  int i;
+  memset(stream, 0, sizeof(*stream));
+  memcpy(key_words, cookie, sizeof(key_words));
+  for(i=0; i<4; i++) {
+    stream->state[i] = 5381 ^ key_words[i];
+  }
+  memcpy(stream->cookie, cookie, sizeof(stream->cookie));
+}
+
+HX4_API void hx4_x4kdjbx33a_128_final(hx4_djb_stream *stream, void *out) {
+  uint32_t key_words[4];
+  uint32_t state[4];
+  memcpy(key_words, stream->cookie, sizeof(key_words));
+  memcpy(state, stream->state, sizeof(state));
+  hx4_x4kdjbx33a_final(state, key_words);
+  memcpy(out, state, sizeof(state));
+}
+
+HX4_API void hx4_kdjbx33a_32_ref_update(hx4_djb_stream *stream, const void *buffer, size_t buffer_size) {
+  const uint8_t *p;
+  const uint8_t * const buffer_end = (uint8_t*)buffer + buffer_size;
+  const uint8_t * const key = stream->cookie;
+  const int key_i = (int)(stream->pos & 0x0f);
+  uint32_t state;
+  size_t i;
+
+  state = stream->state[0];
+
+  p = (const uint8_t*)buffer;
+  i = (size_t)key_i;
+  while(p<buffer_end) {
+    state = state * 33  + (*p ^ key[i % 16]);
+    p++;
+    i++;
+  }
+
+  stream->state[0] = state;
+  stream->pos += buffer_size;
+}
+
+HX4_STREAM_ONESHOT_IMPL(hx4_kdjbx33a_32_ref, hx4_djb_stream, 32/8, hx4_kdjbx33a_32_init, hx4_kdjbx33a_32_final)
+HX4_STREAM_V_IMPL(hx4_kdjbx33a_32_ref, hx4_djb_stream, 32/8, hx4_kdjbx33a_32_init, hx4_kdjbx33a_32_final)
+HX4_STREAM_CSTR_STRLEN_IMPL(hx4_kdjbx33a_32_ref)
+
+HX4_API void hx4_kdjbx33a_32_copt_update(hx4_djb_stream *stream, const void *buffer, size_t buffer_size) {
+  const uint8_t *p;
+  const uint8_t * const buffer_end = (uint8_t*)buffer + buffer_size;
+  const uint8_t * const key = stream->cookie;
+  const int key_i = (int)(stream->pos & 0x0f);
+  const int num_bytes_to_seek = hx4_bytes_to_aligned(buffer, 16);
+  uint8_t key_rotated[16];
+  uint32_t state;
+  int i;
+
+  state = stream->state[0];
+
+  p = (const uint8_t*)buffer;
+
+  //hash input until p is aligned to alignment_target
+  for(i=0; p<buffer_end && i<num_bytes_to_seek; i++) {
+    state = (state << 5) + state + (*p ^ key[(key_i+i) & 0x0f]);
+    p++;
+  }
+
+  hx4_kdjbx33a_rotate_key(key_rotated, key, key_i+i);
+
+  HX4_ASSUME_ALIGNED(p, 16)
+
+  //main processing loop
+  while(p+15<buffer_end) {
+    HX4_ASSUME_ALIGNED(p, 16)
+
+#define HX4_KDJBX33A_ROUND(round) \
+    state = (state << 5) + state + (p[round] ^ key_rotated[round]);
+
+    HX4_KDJBX33A_ROUND(0)
+    HX4_KDJBX33A_ROUND(1)
+    HX4_KDJBX33A_ROUND(2)
+    HX4_KDJBX33A_ROUND(3)
+    HX4_KDJBX33A_ROUND(4)
+    HX4_KDJBX33A_ROUND(5)
+    HX4_KDJBX33A_ROUND(6)
+    HX4_KDJBX33A_ROUND(7)
+    HX4_KDJBX33A_ROUND(8)
+    HX4_KDJBX33A_ROUND(9)
+    HX4_KDJBX33A_ROUND(10)
+    HX4_KDJBX33A_ROUND(11)
+    HX4_KDJBX33A_ROUND(12)
+    HX4_KDJBX33A_ROUND(13)
+    HX4_KDJBX33A_ROUND(14)
+    HX4_KDJBX33A_ROUND(15)
+
+    p+=16;
+  }
+#undef HX4_KDJBX33A_ROUND
+
+  //hash remainder
+  for(i=0; p<buffer_end; i++) {
+    state = (state << 5) + state + (*p ^ key_rotated[i]);
+    p++;
+  }
+
+  stream->state[0] = state;
+  stream->pos += buffer_size;
+}
+
+HX4_STREAM_ONESHOT_IMPL(hx4_kdjbx33a_32_copt, hx4_djb_stream, 32/8, hx4_kdjbx33a_32_init, hx4_kdjbx33a_32_final)
+HX4_STREAM_V_IMPL(hx4_kdjbx33a_32_copt, hx4_djb_stream, 32/8, hx4_kdjbx33a_32_init, hx4_kdjbx33a_32_final)
+HX4_STREAM_CSTR_STRLEN_IMPL(hx4_kdjbx33a_32_copt)
+
+HX4_API void hx4_x4kdjbx33a_128_ref_update(hx4_djb_stream *stream, const void *buffer, size_t buffer_size) {
+  const uint8_t *p;
+  const uint8_t * const buffer_end = (uint8_t*)buffer + buffer_size;
+  const uint8_t * const key = stream->cookie;
+  const int key_i = (int)(stream->pos & 0x0f);
+  uint32_t state[4];
+  size_t i;
+
+  memcpy(state, stream->state, sizeof(state));
+
+  p = (const uint8_t*)buffer;
+  i = (size_t)key_i;
+  while(p<buffer_end) {
+    state[i % 4] = state[i % 4] * 33  + (*p ^ key[i % 16]);
+    p++;
+    i++;
+  }
+
+  memcpy(stream->state, state, sizeof(state));
+  stream->pos += buffer_size;
+}
+
+HX4_STREAM_ONESHOT_IMPL(hx4_x4kdjbx33a_128_ref, hx4_djb_stream, 128/8, hx4_x4kdjbx33a_128_init, hx4_x4kdjbx33a_128_final)
+HX4_STREAM_V_IMPL(hx4_x4kdjbx33a_128_ref, hx4_djb_stream, 128/8, hx4_x4kdjbx33a_128_init, hx4_x4kdjbx33a_128_final)
+HX4_STREAM_CSTR_STRLEN_IMPL(hx4_x4kdjbx33a_128_ref)
+
+HX4_API void hx4_x4kdjbx33a_128_copt_update(hx4_djb_stream *stream, const void *buffer, size_t buffer_size) {
+  const uint8_t *p;
+  const uint8_t * const buffer_end = (uint8_t*)buffer + buffer_size;
+  const uint8_t * const key = stream->cookie;
+  const int key_i = (int)(stream->pos & 0x0f);
+  const int num_bytes_to_seek = hx4_bytes_to_aligned(buffer, 16);
+  uint8_t key_rotated[16];
+  uint32_t state[4];
+  int state_i = (int)(stream->pos & 0x03);
+  int i;
+
+  memcpy(state, stream->state, sizeof(state));
+
+  p = (const uint8_t*)buffer;
+
+  //hash input until p is aligned to alignment_target
+  for(i=0; p<buffer_end && i<num_bytes_to_seek; i++) {
+    state[state_i] = (state[state_i] << 5) + state[state_i]  + (*p ^ key[(key_i+i) & 0x0f]);
+    p++;
+    state_i = (state_i+1) & 0x03;
+  }
+
+  hx4_kdjbx33a_rotate_key(key_rotated, key, key_i+i);
+
+  HX4_ASSUME_ALIGNED(p, 16)
+
+  //rotate states to match position on the input stream
+  //so that the main loop can be simple
+  hx4_x4djb_rotate_lanes(state, state_i);
+
+  //main processing loop
+  while(p+15<buffer_end) {
+    HX4_ASSUME_ALIGNED(p, 16)
+
+#define HX4_KDJB2X4_COPT_ROUND(state_i, round) \
+    state[state_i] = (state[state_i] << 5) + state[state_i] + (p[round] ^ key_rotated[round]);
+
+    HX4_KDJB2X4_COPT_ROUND(0,0)
+    HX4_KDJB2X4_COPT_ROUND(1,1)
+    HX4_KDJB2X4_COPT_ROUND(2,2)
+    HX4_KDJB2X4_COPT_ROUND(3,3)
+    HX4_KDJB2X4_COPT_ROUND(0,4)
+    HX4_KDJB2X4_COPT_ROUND(1,5)
+    HX4_KDJB2X4_COPT_ROUND(2,6)
+    HX4_KDJB2X4_COPT_ROUND(3,7)
+    HX4_KDJB2X4_COPT_ROUND(0,8)
+    HX4_KDJB2X4_COPT_ROUND(1,9)
+    HX4_KDJB2X4_COPT_ROUND(2,10)
+    HX4_KDJB2X4_COPT_ROUND(3,11)
+    HX4_KDJB2X4_COPT_ROUND(0,12)
+    HX4_KDJB2X4_COPT_ROUND(1,13)
+    HX4_KDJB2X4_COPT_ROUND(2,14)
+    HX4_KDJB2X4_COPT_ROUND(3,15)
+
+    p+=16;
+  }
+
+#undef HX4_KDJB2X4_COPT_ROUND
+
+  //rotate back the states
+  hx4_x4djb_unrotate_lanes(state, state_i);
+
+  //process remainder
+  for(i=0; p<buffer_end; i++) {
+    state[state_i] = (state[state_i] << 5) + state[state_i]  + (*p ^ key_rotated[i]);
+    p++;
+    state_i = (state_i+1) & 0x03;
+  }
+
+  memcpy(stream->state, state, sizeof(state));
+  stream->pos += buffer_size;
+}
+
+HX4_STREAM_ONESHOT_IMPL(hx4_x4kdjbx33a_128_copt, hx4_djb_stream, 128/8, hx4_x4kdjbx33a_128_init, hx4_x4kdjbx33a_128_final)
+HX4_STREAM_V_IMPL(hx4_x4kdjbx33a_128_copt, hx4_djb_stream, 128/8, hx4_x4kdjbx33a_128_init, hx4_x4kdjbx33a_128_final)
+HX4_STREAM_CSTR_STRLEN_IMPL(hx4_x4kdjbx33a_128_copt)
+
+#if HX4_HAS_SSE2
+HX4_API void hx4_x4kdjbx33a_128_sse2_update(hx4_djb_stream *stream, const void *buffer, size_t buffer_size) {
+  const uint8_t *p;
+  const uint8_t * const buffer_end = (uint8_t*)buffer + buffer_size;
+  const uint8_t * const key = stream->cookie;
+  const int key_i = (int)(stream->pos & 0x0f);
+  const int num_bytes_to_seek = hx4_bytes_to_aligned(buffer, 16);
+  HX4_ALIGNED(uint8_t key_rotated[16], 16);
+  HX4_ALIGNED(uint32_t state[4], 16);
+  int state_i = (int)(stream->pos & 0x03);
+  int i;
+  __m128i xstate;
+  __m128i xkey;
+  __m128i xpin;
+
+  memcpy(state, stream->state, sizeof(state));
+
+  p = (const uint8_t*)buffer;
+
+  //hash input until p is aligned to alignment_target
+  for(i=0; p<buffer_end && i<num_bytes_to_seek; i++) {
+    state[state_i] = (state[state_i] << 5) + state[state_i]  + (*p ^ key[(key_i+i) & 0x0f]);
+    p++;
+    state_i = (state_i+1) & 0x03;
+  }
+
+  hx4_kdjbx33a_rotate_key(key_rotated, key, key_i+i);
+
+  HX4_ASSUME_ALIGNED(p, 16)
+
+  //rotate states to match position on the input stream
+  //so that the main loop can be simple
+  hx4_x4djb_rotate_lanes(state, state_i);
+
+  //transfer state and key into registers
+  xstate = _mm_load_si128((__m128i*)state);
+  xkey = _mm_load_si128((__m128i*)key_rotated);
+
+  //main processing loop
+  while(p+15<buffer_end) {
+    HX4_ASSUME_ALIGNED(p, 16)
+
+    //load 16 bytes aligned and whiten them with the key
+    xpin = _mm_load_si128((__m128i*)p);
+    xpin = _mm_xor_si128(xpin, xkey);
+
+    xstate = hx4_x4djbx33a_sse2_round(xstate, xpin);
+
+    p+=16;
+  }
+
+  //store back state from register into memory
+  _mm_store_si128((__m128i*)state, xstate);
+
+  //rotate back the states
+  hx4_x4djb_unrotate_lanes(state, state_i);
+
+  //process any input that is left
+  for(i=0; p<buffer_end; i++) {
+    state[state_i] = (state[state_i] << 5) + state[state_i]  + (*p ^ key_rotated[i]);
+    p++;
+    state_i = (state_i+1) & 0x03;
+  }
+
+  memcpy(stream->state, state, sizeof(state));
+  stream->pos += buffer_size;
+}
+
+HX4_STREAM_ONESHOT_IMPL(hx4_x4kdjbx33a_128_sse2, hx4_djb_stream, 128/8, hx4_x4kdjbx33a_128_init, hx4_x4kdjbx33a_128_final)
+HX4_STREAM_V_IMPL(hx4_x4kdjbx33a_128_sse2, hx4_djb_stream, 128/8, hx4_x4kdjbx33a_128_init, hx4_x4kdjbx33a_128_final)
+
+/* the terminator is searched in the raw input, before it is whitened */
+HX4_API size_t hx4_x4kdjbx33a_128_sse2_cstr_update(hx4_djb_stream *stream, const char *str) {
+  const uint8_t *p;
+  const uint8_t * const key = stream->cookie;
+  const int key_i = (int)(stream->pos & 0x0f);
+  const int num_bytes_to_seek = hx4_bytes_to_aligned(str, 16);
+  HX4_ALIGNED(uint8_t key_rotated[16], 16);
+  HX4_ALIGNED(uint32_t state[4], 16);
+  int state_i = (int)(stream->pos & 0x03);
+  int i;
+  size_t len;
+  __m128i xstate;
+  __m128i xkey;
+  __m128i xpin;
+
+  memcpy(state, stream->state, sizeof(state));
+
+  p = (const uint8_t*)str;
+
+  //hash input until p is aligned to alignment_target
+  for(i=0; *p && i<num_bytes_to_seek; i++) {
+    state[state_i] = (state[state_i] << 5) + state[state_i]  + (*p ^ key[(key_i+i) & 0x0f]);
+    p++;
+    state_i = (state_i+1) & 0x03;
+  }
+
+  hx4_kdjbx33a_rotate_key(key_rotated, key, key_i+i);
+
+  //rotate states to match position on the input stream
+  //so that the main loop can be simple
+  hx4_x4djb_rotate_lanes(state, state_i);
+
+  //transfer state and key into registers
+  xstate = _mm_load_si128((__m128i*)state);
+  xkey = _mm_load_si128((__m128i*)key_rotated);
+
+  //main processing loop, p is aligned unless the seek hit the terminator,
+  //the block holding the terminator is left to the scalar loop below
+  while(*p) {
+    HX4_ASSUME_ALIGNED(p, 16)
+
+    //load 16 bytes aligned and whiten them with the key
+    xpin = _mm_load_si128((__m128i*)p);
+    if(_mm_movemask_epi8(_mm_cmpeq_epi8(xpin, _mm_setzero_si128())) != 0) {
+      break;
+    }
+    xpin = _mm_xor_si128(xpin, xkey);
+
+    xstate = hx4_x4djbx33a_sse2_round(xstate, xpin);
+
+    p+=16;
+  }
+
+  //store back state from register into memory
+  _mm_store_si128((__m128i*)state, xstate);
+
+  //rotate back the states
+  hx4_x4djb_unrotate_lanes(state, state_i);
+
+  //process any input that is left
+  for(i=0; *p; i++) {
+    state[state_i] = (state[state_i] << 5) + state[state_i]  + (*p ^ key_rotated[i]);
+    p++;
+    state_i = (state_i+1) & 0x03;
+  }
+
+  memcpy(stream->state, state, sizeof(state));
+  len = (size_t)(p - (const uint8_t*)str);
+  stream->pos += len;
+  return len;
+}
+
+HX4_STREAM_CSTR_IMPL(hx4_x4kdjbx33a_128_sse2, hx4_djb_stream, 128/8, hx4_x4kdjbx33a_128_init, hx4_x4kdjbx33a_128_final)
+#endif //HX4_HAS_SSE2
+
+#if HX4_HAS_SSSE3
+HX4_API void hx4_x4kdjbx33a_128_ssse3_update(hx4_djb_stream *stream, const void *buffer, size_t buffer_size) {
+  const uint8_t *p;
+  const uint8_t * const buffer_end = (uint8_t*)buffer + buffer_size;
+  const uint8_t * const key = stream->cookie;
+  const int key_i = (int)(stream->pos & 0x0f);
+  const int num_bytes_to_seek = hx4_bytes_to_aligned(buffer, 16);
+  HX4_ALIGNED(uint8_t key_rotated[16], 16);
+  HX4_ALIGNED(uint32_t state[4], 16);
+  __m128i xstate;
+  __m128i xkey;
+  __m128i xpin;
+  int state_i = (int)(stream->pos & 0x03);
+  int i;
+
+  memcpy(state, stream->state, sizeof(state));
+
+  p = (const uint8_t*)buffer;
+
+  //hash input until p is aligned to alignment_target
+  for (i = 0; p<buffer_end && i<num_bytes_to_seek; i++) {
+    state[state_i] = (state[state_i] << 5) + state[state_i] + (*p ^ key[(key_i+i) & 0x0f]);
+    p++;
+    state_i = (state_i + 1) & 0x03;
+  }
+
+  hx4_kdjbx33a_rotate_key(key_rotated, key, key_i+i);
+
+  HX4_ASSUME_ALIGNED(p, 16)
+
+  //rotate states to match position on the input stream
+  //so that the main loop can be simple
+  hx4_x4djb_rotate_lanes(state, state_i);
+
+  //transfer state and key into registers
+  xstate = _mm_load_si128((__m128i*)state);
+  xkey = _mm_load_si128((__m128i*)key_rotated);
+
+  //main processing loop
+  while (p+15<buffer_end) {
+    HX4_ASSUME_ALIGNED(p, 16)
+
+    //load 16 bytes aligned and whiten them with the key
+    xpin = _mm_load_si128((__m128i*)p);
+    xpin = _mm_xor_si128(xpin, xkey);
+    xstate = hx4_x4djbx33a_ssse3_round(xstate, xpin);
+
+    p += 16;
+  }
+
+  //store back state from register into memory
+  _mm_store_si128((__m128i*)state, xstate);
+
+  //rotate back the states
+  hx4_x4djb_unrotate_lanes(state, state_i);
+
+  //process any input that is left
+  for (i = 0; p<buffer_end; i++) {
+    state[state_i] = (state[state_i] << 5) + state[state_i] + (*p ^ key_rotated[i]);
+    p++;
+    state_i = (state_i + 1) & 0x03;
+  }
+
+  memcpy(stream->state, state, sizeof(state));
+  stream->pos += buffer_size;
+}
+
+HX4_STREAM_ONESHOT_IMPL(hx4_x4kdjbx33a_128_ssse3, hx4_djb_stream, 128/8, hx4_x4kdjbx33a_128_init, hx4_x4kdjbx33a_128_final)
+HX4_STREAM_V_IMPL(hx4_x4kdjbx33a_128_ssse3, hx4_djb_stream, 128/8, hx4_x4kdjbx33a_128_init, hx4_x4kdjbx33a_128_final)
+
+HX4_API size_t hx4_x4kdjbx33a_128_ssse3_cstr_update(hx4_djb_stream *stream, const char *str) {
+  const uint8_t *p;
+  const uint8_t * const key = stream->cookie;
+  const int key_i = (int)(stream->pos & 0x0f);
+  const int num_bytes_to_seek = hx4_bytes_to_aligned(str, 16);
+  HX4_ALIGNED(uint8_t key_rotated[16], 16);
+  HX4_ALIGNED(uint32_t state[4], 16);
+  __m128i xstate;
+  __m128i xkey;
+  __m128i xpin;
+  int state_i = (int)(stream->pos & 0x03);
+  int i;
+  size_t len;
+
+  memcpy(state, stream->state, sizeof(state));
+
+  p = (const uint8_t*)str;
+
+  //hash input until p is aligned to alignment_target
+  for (i = 0; *p && i<num_bytes_to_seek; i++) {
+    state[state_i] = (state[state_i] << 5) + state[state_i] + (*p ^ key[(key_i+i) & 0x0f]);
+    p++;
+    state_i = (state_i + 1) & 0x03;
+  }
+
+  hx4_kdjbx33a_rotate_key(key_rotated, key, key_i+i);
+
+  //rotate states to match position on the input stream
+  //so that the main loop can be simple
+  hx4_x4djb_rotate_lanes(state, state_i);
+
+  //transfer state and key into registers
+  xstate = _mm_load_si128((__m128i*)state);
+  xkey = _mm_load_si128((__m128i*)key_rotated);
+
+  //main processing loop, p is aligned unless the seek hit the terminator,
+  //the block holding the terminator is left to the scalar loop below
+  while(*p) {
+    HX4_ASSUME_ALIGNED(p, 16)
+
+    //load 16 bytes aligned and whiten them with the key
+    xpin = _mm_load_si128((__m128i*)p);
+    if(_mm_movemask_epi8(_mm_cmpeq_epi8(xpin, _mm_setzero_si128())) != 0) {
+      break;
+    }
+    xpin = _mm_xor_si128(xpin, xkey);
+    xstate = hx4_x4djbx33a_ssse3_round(xstate, xpin);
+
+    p += 16;
+  }
+
+  //store back state from register into memory
+  _mm_store_si128((__m128i*)state, xstate);
+
+  //rotate back the states
+  hx4_x4djb_unrotate_lanes(state, state_i);
+
+  //process any input that is left
+  for (i = 0; *p; i++) {
+    state[state_i] = (state[state_i] << 5) + state[state_i] + (*p ^ key_rotated[i]);
+    p++;
+    state_i = (state_i + 1) & 0x03;
+  }
+
+  memcpy(stream->state, state, sizeof(state));
+  len = (size_t)(p - (const uint8_t*)str);
+  stream->pos += len;
+  return len;
+}
+
+HX4_STREAM_CSTR_IMPL(hx4_x4kdjbx33a_128_ssse3, hx4_djb_stream, 128/8, hx4_x4kdjbx33a_128_init, hx4_x4kdjbx33a_128_final)
+#endif //HX4_HAS_SSSE3
@@ -0,0 +1,294 @@
+/* 
+ * Copyright 2015 Kai Dietrich <mail@cleeus.de>
+ *
+ * This file is part of hashx4.
+ *
+ * Hashx4 is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Hashx4 is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with hashx4.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "hashx4_config.h"
+
+#if HX4_HAS_SSE2
+# include <emmintrin.h>
+#endif
+
+#if HX4_HAS_SSE41
+# include <smmintrin.h>
+#endif
+
+#if HX4_HAS_AVX2
+# include <immintrin.h>
+#endif
+
+#include "hashx4.h"
+#include "hashx4_minhash.h"
+#include "hx4_util.h"
+
+// shingles hashed at once, the SIMD kernels keep two vectors per shingle of a block in L1
+#define HX4_MINHASH_BLOCK 256
+
+// values of the SSE2 kernel are kept with the sign bit flipped so that a signed compare orders them unsigned
+#define HX4_MINHASH_BIAS 0x80000000u
+
+#define U8TO32_LE(p)                                                           \
+  (((uint32_t)((p)[0])) | ((uint32_t)((p)[1]) << 8) |                          \
+   ((uint32_t)((p)[2]) << 16) | ((uint32_t)((p)[3]) << 24))
+
+#define U8TO64_LE(p) \
+  (((uint64_t)U8TO32_LE(p)) | ((uint64_t)U8TO32_LE((p) + 4) << 32))
+
+typedef int (*hx4_minhash_hash_function)(const uint64_t *keys, size_t n, const void *cookie, size_t cookie_sz, uint64_t *out);
+typedef void (*hx4_minhash_block_function)(const uint64_t *hashes, size_t n, size_t num_hashes, uint32_t *minima);
+
+int hx4_minhash_init(hx4_minhash *minhash, size_t shingle_sz, size_t num_hashes, const void *cookie, size_t cookie_sz) {
+  if(!minhash || !cookie) {
+    return HX4_ERR_PARAM_INVALID;
+  }
+  if(shingle_sz < 1 || shingle_sz > HX4_MINHASH_MAX_SHINGLE_SIZE) {
+    return HX4_ERR_PARAM_INVALID;
+  }
+  if(num_hashes < HX4_MINHASH_HASH_STEP || num_hashes > HX4_MINHASH_MAX_HASHES || num_hashes % HX4_MINHASH_HASH_STEP) {
+    return HX4_ERR_PARAM_INVALID;
+  }
+  if(cookie_sz < 128/8) {
+    return HX4_ERR_COOKIE_TOO_SMALL;
+  }
+
+  minhash->shingle_sz = shingle_sz;
+  minhash->num_hashes = num_hashes;
+  memcpy(minhash->cookie, cookie, sizeof(minhash->cookie));
+
+  return HX4_ERR_SUCCESS;
+}
+
+// the shingles starting at first .. first+n-1 as zero padded little endian integers
+static void hx4_minhash_shingles(const uint8_t *doc, size_t doc_sz, size_t shingle_sz, size_t first, size_t n, uint64_t *shingles) {
+  const uint64_t mask = shingle_sz == 8 ? ~(uint64_t)0 : ((uint64_t)1 << (8*shingle_sz)) - 1;
+  size_t i;
+  size_t j;
+
+  for(i=0; i<n; i++) {
+    const size_t pos = first + i;
+    if(pos + 8 <= doc_sz) {
+      shingles[i] = U8TO64_LE(doc + pos) & mask;
+    } else {
+      // the tail of the document, or a document shorter than one shingle
+      uint64_t s = 0;
+      for(j=0; j<shingle_sz && pos + j < doc_sz; j++) {
+        s |= (uint64_t)doc[pos + j] << (8*j);
+      }
+      shingles[i] = s;
+    }
+  }
+}
+
+static int hx4_minhash_signature_impl(const hx4_minhash *minhash, const void *doc, size_t doc_sz, uint32_t *signature,
+                                      hx4_minhash_hash_function hash, hx4_minhash_block_function block, uint32_t bias) {
+  HX4_ALIGNED(uint32_t minima[HX4_MINHASH_MAX_HASHES], 32);
+  uint64_t shingles[HX4_MINHASH_BLOCK];
+  uint64_t hashes[HX4_MINHASH_BLOCK];
+  size_t num_shingles;
+  size_t i;
+  size_t n;
+
+  if(!minhash || (!doc && doc_sz) || !signature) {
+    return HX4_ERR_PARAM_INVALID;
+  }
+
+  if(doc_sz >= minhash->shingle_sz) {
+    num_shingles = doc_sz - minhash->shingle_sz + 1;
+  } else {
+    num_shingles = doc_sz ? 1 : 0;
+  }
+
+  for(i=0; i<minhash->num_hashes; i++) {
+    minima[i] = 0xffffffff ^ bias;
+  }
+
+  for(i=0; i<num_shingles; i+=n) {
+    n = num_shingles - i < HX4_MINHASH_BLOCK ? num_shingles - i : HX4_MINHASH_BLOCK;
+    hx4_minhash_shingles((const uint8_t*)doc, doc_sz, minhash->shingle_sz, i, n, shingles);
+    hash(shingles, n, minhash->cookie, sizeof(minhash->cookie), hashes);
+    block(hashes, n, minhash->num_hashes, minima);
+  }
+
+  for(i=0; i<minhash->num_hashes; i++) {
+    signature[i] = minima[i] ^ bias;
+  }
+
+  return HX4_ERR_SUCCESS;
+}
+
+static void hx4_minhash_block_ref(const uint64_t *hashes, size_t n, size_t num_hashes, uint32_t *minima) {
+  size_t i;
+  size_t j;
+
+  for(i=0; i<n; i++) {
+    const uint32_t h2 = (uint32_t)(hashes[i] >> 32);
+    uint32_t v = (uint32_t)hashes[i];
+    for(j=0; j<num_hashes; j++) {
+      if(v < minima[j]) {
+        minima[j] = v;
+      }
+      v += h2;
+    }
+  }
+}
+
+int hx4_minhash_signature_ref(const hx4_minhash *minhash, const void *doc, size_t doc_sz, uint32_t *signature) {
+  return hx4_minhash_signature_impl(minhash, doc, doc_sz, signature, hx4_hash_u64_array_ref, hx4_minhash_block_ref, 0);
+}
+
+// Every shingle gets a vector of its values under 4 consecutive permutations and a step vector
+// that advances them by 4 permutations. The minima of 16 permutations stay in 4 registers
+// while the kernel runs over all shingles of the block, then the next 16 follow.
+#define HX4_MINHASH_BLOCK_SSE(name, min, bias)                                                  \
+static void name(const uint64_t *hashes, size_t n, size_t num_hashes, uint32_t *minima) {      \
+  HX4_ALIGNED(__m128i cur[HX4_MINHASH_BLOCK], 16);                                              \
+  HX4_ALIGNED(__m128i step[HX4_MINHASH_BLOCK], 16);                                             \
+  __m128i m0, m1, m2, m3;                                                                       \
+  __m128i v, st;                                                                                \
+  size_t i;                                                                                     \
+  size_t j;                                                                                     \
+                                                                                                \
+  for(i=0; i<n; i++) {                                                                          \
+    const uint32_t h1 = (uint32_t)hashes[i] ^ (bias);                                           \
+    const uint32_t h2 = (uint32_t)(hashes[i] >> 32);                                            \
+    cur[i] = _mm_set_epi32((int)(h1 + 3*h2), (int)(h1 + 2*h2), (int)(h1 + h2), (int)h1);        \
+    step[i] = _mm_set1_epi32((int)(4*h2));                                                      \
+  }                                                                                             \
+                                                                                                \
+  for(j=0; j<num_hashes; j+=HX4_MINHASH_HASH_STEP) {                                            \
+    __m128i *mp = (__m128i*)(minima + j);                                                       \
+    m0 = _mm_load_si128(mp + 0);                                                                \
+    m1 = _mm_load_si128(mp + 1);                                                                \
+    m2 = _mm_load_si128(mp + 2);                                                                \
+    m3 = _mm_load_si128(mp + 3);                                                                \
+    for(i=0; i<n; i++) {                                                                        \
+      v = cur[i];                                                                               \
+      st = step[i];                                                                             \
+      m0 = min(m0, v);                                                                          \
+      v = _mm_add_epi32(v, st);                                                                 \
+      m1 = min(m1, v);                                                                          \
+      v = _mm_add_epi32(v, st);                                                                 \
+      m2 = min(m2, v);                                                                          \
+      v = _mm_add_epi32(v, st);                                                                 \
+      m3 = min(m3, v);                                                                          \
+      cur[i] = _mm_add_epi32(v, st);                                                            \
+    }                                                                                           \
+    _mm_store_si128(mp + 0, m0);                                                                \
+    _mm_store_si128(mp + 1, m1);                                                                \
+    _mm_store_si128(mp + 2, m2);                                                                \
+    _mm_store_si128(mp + 3, m3);                                                                \
+  }                                                                                             \
+}
+
+#if HX4_HAS_SSE2
+// SSE2 has no unsigned 32bit min, the values are biased and compared signed
+HX4_INLINE __m128i hx4_minhash_min_sse2(__m128i m, __m128i v) {
+  const __m128i gt = _mm_cmpgt_epi32(m, v);
+  return _mm_or_si128(_mm_and_si128(gt, v), _mm_andnot_si128(gt, m));
+}
+
+HX4_MINHASH_BLOCK_SSE(hx4_minhash_block_sse2, hx4_minhash_min_sse2, HX4_MINHASH_BIAS)
+
+int hx4_minhash_signature_sse2(const hx4_minhash *minhash, const void *doc, size_t doc_sz, uint32_t *signature) {
+  return hx4_minhash_signature_impl(minhash, doc, doc_sz, signature, hx4_hash_u64_array, hx4_minhash_block_sse2, HX4_MINHASH_BIAS);
+}
+#endif
+
+#if HX4_HAS_SSE41
+HX4_MINHASH_BLOCK_SSE(hx4_minhash_block_sse41, _mm_min_epu32, 0)
+
+int hx4_minhash_signature_sse41(const hx4_minhash *minhash, const void *doc, size_t doc_sz, uint32_t *signature) {
+  return hx4_minhash_signature_impl(minhash, doc, doc_sz, signature, hx4_hash_u64_array, hx4_minhash_block_sse41, 0);
+}
+#endif
+
+#if HX4_HAS_AVX2
+// 8 permutations per vector, the 16 minima of a step are in 2 registers
+static void hx4_minhash_block_avx2(const uint64_t *hashes, size_t n, size_t num_hashes, uint32_t *minima) {
+  HX4_ALIGNED(__m256i cur[HX4_MINHASH_BLOCK], 32);
+  HX4_ALIGNED(__m256i step[HX4_MINHASH_BLOCK], 32);
+  const __m256i lanes = _mm256_set_epi32(7, 6, 5, 4, 3, 2, 1, 0);
+  __m256i m0, m1;
+  __m256i v, st;
+  size_t i;
+  size_t j;
+
+  for(i=0; i<n; i++) {
+    const __m256i h1 = _mm256_set1_epi32((int)(uint32_t)hashes[i]);
+    const __m256i h2 = _mm256_set1_epi32((int)(uint32_t)(hashes[i] >> 32));
+    cur[i] = _mm256_add_epi32(h1, _mm256_mullo_epi32(h2, lanes));
+    step[i] = _mm256_slli_epi32(h2, 3);
+  }
+
+  for(j=0; j<num_hashes; j+=HX4_MINHASH_HASH_STEP) {
+    __m256i *mp = (__m256i*)(minima + j);
+    m0 = _mm256_load_si256(mp + 0);
+    m1 = _mm256_load_si256(mp + 1);
+    for(i=0; i<n; i++) {
+      v = cur[i];
+      st = step[i];
+      m0 = _mm256_min_epu32(m0, v);
+      v = _mm256_add_epi32(v, st);
+      m1 = _mm256_min_epu32(m1, v);
+      cur[i] = _mm256_add_epi32(v, st);
+    }
+    _mm256_store_si256(mp + 0, m0);
+    _mm256_store_si256(mp + 1, m1);
+  }
+}
+
+int hx4_minhash_signature_avx2(const hx4_minhash *minhash, const void *doc, size_t doc_sz, uint32_t *signature) {
+  return hx4_minhash_signature_impl(minhash, doc, doc_sz, signature, hx4_hash_u64_array, hx4_minhash_block_avx2, 0);
+}
+#endif
+
+int hx4_minhash_signature(const hx4_minhash *minhash, const void *doc, size_t doc_sz, uint32_t *signature) {
+#if HX4_HAS_AVX2
+  return hx4_minhash_signature_avx2(minhash, doc, doc_sz, signature);
+#elif HX4_HAS_SSE41
+  return hx4_minhash_signature_sse41(minhash, doc, doc_sz, signature);
+#elif HX4_HAS_SSE2
+  return hx4_minhash_signature_sse2(minhash, doc, doc_sz, signature);
+#else
+  return hx4_minhash_signature_ref(minhash, doc, doc_sz, signature);
+#endif
+}
+
+int hx4_minhash_similarity(const uint32_t *a, const uint32_t *b, size_t num_hashes, double *similarity) {
+  size_t equal = 0;
+  size_t i;
+
+  if(!a || !b || !num_hashes || !similarity) {
+    return HX4_ERR_PARAM_INVALID;
+  }
+
+  for(i=0; i<num_hashes; i++) {
+    equal += a[i] == b[i];
+  }
+  *similarity = (double)equal / (double)num_hashes;
+
+  return HX4_ERR_SUCCESS;
+}
+
+#undef HX4_MINHASH_BLOCK_SSE
+#undef U8TO64_LE
+#undef U8TO32_LE
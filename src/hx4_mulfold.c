@@ -0,0 +1,361 @@
+/* 
+ * Copyright 2015 Kai Dietrich <mail@cleeus.de>
+ *
+ * This file is part of hashx4.
+ *
+ * Hashx4 is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Hashx4 is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with hashx4.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "hashx4_config.h"
+
+#if HX4_HAS_SSE2
+# include <emmintrin.h>
+#endif
+
+#if HX4_HAS_AVX2
+# include <immintrin.h>
+#endif
+
+#include "hashx4.h"
+#include "hx4_util.h"
+
+// x4mulfold_128 is an x4 hash like x4djbx33a, but its lanes take the input
+// in 4 byte words instead of single bytes: word i goes to lane i % 4. Every
+// word is xored with the cookie word of its lane, multiplied with a 32bit
+// constant to 64 bits and the two halves of the product are folded into 32
+// bits with an xor (the multiply-fold of xxHash and wyhash). The lane state
+// takes the folded words in the murmur3 way, two words of a lane from every
+// 32 byte chunk at once:
+//
+//   m(w) = (uint32_t)p ^ (uint32_t)(p >> 32), p = (uint64_t)(w ^ cookie[lane]) * 0x9e3779b1
+//   h = rotl(h ^ (m(w[lane]) + rotl(m(w[4 + lane]), 16)), 13) * 5 + 0xe6546b64
+//
+// The multiplications only depend on the input, so they are off the critical
+// path of the lane, which is only xor, rotate and the multiplication with 5
+// as shift and add once for every 32 bytes. Less than 8 words at the end go
+// into the lanes one at a time. The lanes start from the cookie words. The
+// last 1-3 bytes are padded with zeros to a word, the lengths are told apart
+// by the finalization, which xors the input length into every lane. It then
+// finalizes like murmur3 x86_128: the lanes are added into each other, each
+// runs the murmur3 finalizer, and they are added into each other again.
+//
+// The words are read at any alignment, an alignment seek like in the
+// x4djbx33a kernels would move the word boundaries.
+
+#define HX4_MULFOLD_CHUNK 32
+
+#define HX4_MULFOLD_PRIME 0x9e3779b1UL
+#define HX4_MULFOLD_ADD 0xe6546b64UL
+
+#define U8TO32_LE(p) \
+  (((uint32_t)((p)[0])      ) | \
+   ((uint32_t)((p)[1]) <<  8) | \
+   ((uint32_t)((p)[2]) << 16) | \
+   ((uint32_t)((p)[3]) << 24))
+
+#define HX4_ROTL32(x, b) (uint32_t)(((x) << (b)) | ((x) >> (32 - (b))))
+
+HX4_INLINE uint32_t hx4_mulfold_word(uint32_t w, uint32_t key) {
+  const uint64_t p = (uint64_t)(w ^ key) * HX4_MULFOLD_PRIME;
+  return (uint32_t)p ^ (uint32_t)(p >> 32);
+}
+
+//two words of the same lane
+HX4_INLINE uint32_t hx4_mulfold_pair(uint32_t w0, uint32_t w1, uint32_t key) {
+  const uint32_t m1 = hx4_mulfold_word(w1, key);
+  return hx4_mulfold_word(w0, key) + HX4_ROTL32(m1, 16);
+}
+
+HX4_INLINE uint32_t hx4_mulfold_round(uint32_t h, uint32_t m) {
+  h = HX4_ROTL32(h ^ m, 13);
+  return h * 5 + HX4_MULFOLD_ADD;
+}
+
+//cookie words as lane keys, in the order of the input words
+static void hx4_mulfold_keys(uint32_t key[4], const void *cookie) {
+  int lane;
+
+  for(lane=0; lane<4; lane++) {
+    key[lane] = U8TO32_LE((const uint8_t*)cookie + 4*lane);
+  }
+}
+
+HX4_INLINE void hx4_mulfold_cross(uint32_t state[4]) {
+  state[0] += state[1] + state[2] + state[3];
+  state[1] += state[0];
+  state[2] += state[0];
+  state[3] += state[0];
+}
+
+//the last 1-3 bytes as a zero padded word, the length and the finalizer
+static void hx4_mulfold_tail_final(uint32_t state[4], const uint32_t key[4], const uint8_t *p, size_t tail_sz, size_t in_sz, void *out) {
+  uint8_t word[4] = { 0, 0, 0, 0 };
+  const int lane = (int)((in_sz >> 2) & 0x03);
+  uint32_t h;
+  int i;
+
+  if(tail_sz > 0) {
+    memcpy(word, p, tail_sz);
+    state[lane] = hx4_mulfold_round(state[lane], hx4_mulfold_word(U8TO32_LE(word), key[lane]));
+  }
+
+  for(i=0; i<4; i++) {
+    state[i] ^= (uint32_t)in_sz;
+  }
+
+  //the lanes are added into each other before and after the finalizer like in
+  //murmur3 x86_128, so every output word depends on all input words
+  hx4_mulfold_cross(state);
+  for(i=0; i<4; i++) {
+    h = state[i];
+    h ^= h >> 16;
+    h *= 0x85ebca6bUL;
+    h ^= h >> 13;
+    h *= 0xc2b2ae35UL;
+    h ^= h >> 16;
+    state[i] = h;
+  }
+  hx4_mulfold_cross(state);
+  memcpy(out, state, 4*sizeof(uint32_t));
+}
+
+HX4_API int hx4_x4mulfold_128_ref(const void *in, size_t in_sz, const void *cookie, size_t cookie_sz, void *out, size_t out_sz) {
+  const uint8_t *p = (const uint8_t*)in;
+  uint32_t key[4];
+  uint32_t state[4];
+  size_t left;
+  size_t words;
+  size_t i;
+  int lane;
+  int rc;
+  HX4_STATS_BEGIN(hx4_x4mulfold_128_ref)
+
+  rc = hx4_check_params(128/8, in, in_sz, cookie, cookie_sz, out, out_sz);
+  if(rc != HX4_ERR_SUCCESS) {
+    return rc;
+  }
+
+  hx4_mulfold_keys(key, cookie);
+  memcpy(state, key, sizeof(state));
+
+  for(left = in_sz; left >= HX4_MULFOLD_CHUNK; left -= HX4_MULFOLD_CHUNK, p += HX4_MULFOLD_CHUNK) {
+    for(lane=0; lane<4; lane++) {
+      state[lane] = hx4_mulfold_round(state[lane], hx4_mulfold_pair(U8TO32_LE(p + 4*lane), U8TO32_LE(p + 16 + 4*lane), key[lane]));
+    }
+  }
+
+  words = left / 4;
+  for(i=0; i<words; i++) {
+    lane = (int)(i % 4);
+    state[lane] = hx4_mulfold_round(state[lane], hx4_mulfold_word(U8TO32_LE(p + 4*i), key[lane]));
+  }
+
+  hx4_mulfold_tail_final(state, key, p + 4*words, left % 4, in_sz, out);
+  HX4_STATS_END(hx4_x4mulfold_128_ref, in_sz)
+  return HX4_ERR_SUCCESS;
+}
+
+HX4_API int hx4_x4mulfold_128_copt(const void *in, size_t in_sz, const void *cookie, size_t cookie_sz, void *out, size_t out_sz) {
+  const uint8_t *p = (const uint8_t*)in;
+  const uint8_t * const p_end = p + in_sz;
+  uint32_t key[4];
+  uint32_t state[4];
+  uint32_t w[8];
+  int lane;
+  int rc;
+  HX4_STATS_BEGIN(hx4_x4mulfold_128_copt)
+
+  rc = hx4_check_params(128/8, in, in_sz, cookie, cookie_sz, out, out_sz);
+  if(rc != HX4_ERR_SUCCESS) {
+    return rc;
+  }
+
+  hx4_mulfold_keys(key, cookie);
+  memcpy(state, key, sizeof(state));
+
+  //main processing loop, two words for every lane
+  for( ; p_end - p >= HX4_MULFOLD_CHUNK; p += HX4_MULFOLD_CHUNK) {
+    memcpy(w, p, sizeof(w));
+    state[0] = hx4_mulfold_round(state[0], hx4_mulfold_pair(w[0], w[4], key[0]));
+    state[1] = hx4_mulfold_round(state[1], hx4_mulfold_pair(w[1], w[5], key[1]));
+    state[2] = hx4_mulfold_round(state[2], hx4_mulfold_pair(w[2], w[6], key[2]));
+    state[3] = hx4_mulfold_round(state[3], hx4_mulfold_pair(w[3], w[7], key[3]));
+  }
+
+  //whole words that are left
+  for(lane=0; p_end - p >= 4; lane = (lane + 1) & 0x03, p += 4) {
+    state[lane] = hx4_mulfold_round(state[lane], hx4_mulfold_word(U8TO32_LE(p), key[lane]));
+  }
+
+  hx4_mulfold_tail_final(state, key, p, (size_t)(p_end - p), in_sz, out);
+  HX4_STATS_END(hx4_x4mulfold_128_copt, in_sz)
+  return HX4_ERR_SUCCESS;
+}
+
+#if HX4_HAS_SSE2
+
+//multiply-fold of 4 words: the even words are multiplied in place, the odd
+//ones shifted down first, the folds end up in the low halves and are merged
+HX4_INLINE __m128i hx4_mulfold_words_sse2(__m128i xw, __m128i xkey) {
+  const __m128i xprime = _mm_set1_epi32((int)HX4_MULFOLD_PRIME);
+  const __m128i xlow = _mm_set_epi32(0, -1, 0, -1);
+  __m128i xeven;
+  __m128i xodd;
+
+  xw = _mm_xor_si128(xw, xkey);
+  xeven = _mm_mul_epu32(xw, xprime);
+  xodd = _mm_mul_epu32(_mm_srli_epi64(xw, 32), xprime);
+  xeven = _mm_xor_si128(xeven, _mm_srli_epi64(xeven, 32));
+  xodd = _mm_xor_si128(xodd, _mm_srli_epi64(xodd, 32));
+  return _mm_or_si128(_mm_and_si128(xeven, xlow), _mm_slli_epi64(xodd, 32));
+}
+
+//m0 + rotl(m1, 16)
+HX4_INLINE __m128i hx4_mulfold_pair_sse2(__m128i xm0, __m128i xm1) {
+  xm1 = _mm_shufflehi_epi16(_mm_shufflelo_epi16(xm1, _MM_SHUFFLE(2,3,0,1)), _MM_SHUFFLE(2,3,0,1));
+  return _mm_add_epi32(xm0, xm1);
+}
+
+HX4_INLINE __m128i hx4_mulfold_round_sse2(__m128i xstate, __m128i xm) {
+  const __m128i xadd = _mm_set1_epi32((int)HX4_MULFOLD_ADD);
+
+  xstate = _mm_xor_si128(xstate, xm);
+  xstate = _mm_or_si128(_mm_slli_epi32(xstate, 13), _mm_srli_epi32(xstate, 32-13));
+  //xstate * 5 + add
+  return _mm_add_epi32(_mm_add_epi32(_mm_slli_epi32(xstate, 2), xstate), xadd);
+}
+
+HX4_API int hx4_x4mulfold_128_sse2(const void *in, size_t in_sz, const void *cookie, size_t cookie_sz, void *out, size_t out_sz) {
+  const uint8_t *p = (const uint8_t*)in;
+  const uint8_t * const p_end = p + in_sz;
+  HX4_ALIGNED(uint32_t state[4], 16);
+  uint32_t key[4];
+  __m128i xkey;
+  __m128i xstate;
+  __m128i xm0;
+  __m128i xm1;
+  int lane;
+  int rc;
+  HX4_STATS_BEGIN(hx4_x4mulfold_128_sse2)
+
+  rc = hx4_check_params(128/8, in, in_sz, cookie, cookie_sz, out, out_sz);
+  if(rc != HX4_ERR_SUCCESS) {
+    return rc;
+  }
+
+  hx4_mulfold_keys(key, cookie);
+  xkey = _mm_loadu_si128((const __m128i*)key);
+  xstate = xkey;
+
+  //main processing loop
+  for( ; p_end - p >= HX4_MULFOLD_CHUNK; p += HX4_MULFOLD_CHUNK) {
+    xm0 = hx4_mulfold_words_sse2(_mm_loadu_si128((const __m128i*)p), xkey);
+    xm1 = hx4_mulfold_words_sse2(_mm_loadu_si128((const __m128i*)(p + 16)), xkey);
+    xstate = hx4_mulfold_round_sse2(xstate, hx4_mulfold_pair_sse2(xm0, xm1));
+  }
+  if(p_end - p >= 16) {
+    xstate = hx4_mulfold_round_sse2(xstate, hx4_mulfold_words_sse2(_mm_loadu_si128((const __m128i*)p), xkey));
+    p += 16;
+  }
+
+  //store back state from register into memory
+  _mm_store_si128((__m128i*)state, xstate);
+
+  //whole words that are left
+  for(lane=0; p_end - p >= 4; lane = (lane + 1) & 0x03, p += 4) {
+    state[lane] = hx4_mulfold_round(state[lane], hx4_mulfold_word(U8TO32_LE(p), key[lane]));
+  }
+
+  hx4_mulfold_tail_final(state, key, p, (size_t)(p_end - p), in_sz, out);
+  HX4_STATS_END(hx4_x4mulfold_128_sse2, in_sz)
+  return HX4_ERR_SUCCESS;
+}
+
+#endif //HX4_HAS_SSE2
+
+#if HX4_HAS_AVX2
+
+//hx4_mulfold_words_sse2 on two blocks of 16 bytes at once
+HX4_INLINE __m256i hx4_mulfold_words_avx2(__m256i yw, __m256i ykey) {
+  const __m256i yprime = _mm256_set1_epi32((int)HX4_MULFOLD_PRIME);
+  const __m256i ylow = _mm256_set1_epi64x(0xffffffffLL);
+  __m256i yeven;
+  __m256i yodd;
+
+  yw = _mm256_xor_si256(yw, ykey);
+  yeven = _mm256_mul_epu32(yw, yprime);
+  yodd = _mm256_mul_epu32(_mm256_srli_epi64(yw, 32), yprime);
+  yeven = _mm256_xor_si256(yeven, _mm256_srli_epi64(yeven, 32));
+  yodd = _mm256_xor_si256(yodd, _mm256_srli_epi64(yodd, 32));
+  return _mm256_blend_epi32(_mm256_and_si256(yeven, ylow), _mm256_slli_epi64(yodd, 32), 0xaa);
+}
+
+HX4_API int hx4_x4mulfold_128_avx2(const void *in, size_t in_sz, const void *cookie, size_t cookie_sz, void *out, size_t out_sz) {
+  const uint8_t *p = (const uint8_t*)in;
+  const uint8_t * const p_end = p + in_sz;
+  HX4_ALIGNED(uint32_t state[4], 16);
+  uint32_t key[4];
+  __m256i ykey;
+  __m256i ym;
+  __m128i xkey;
+  __m128i xstate;
+  int lane;
+  int rc;
+  HX4_STATS_BEGIN(hx4_x4mulfold_128_avx2)
+
+  rc = hx4_check_params(128/8, in, in_sz, cookie, cookie_sz, out, out_sz);
+  if(rc != HX4_ERR_SUCCESS) {
+    return rc;
+  }
+
+  hx4_mulfold_keys(key, cookie);
+  xkey = _mm_loadu_si128((const __m128i*)key);
+  ykey = _mm256_broadcastsi128_si256(xkey);
+  xstate = xkey;
+
+  //main processing loop, a whole chunk in one register
+  for( ; p_end - p >= HX4_MULFOLD_CHUNK; p += HX4_MULFOLD_CHUNK) {
+    ym = hx4_mulfold_words_avx2(_mm256_loadu_si256((const __m256i*)p), ykey);
+    xstate = hx4_mulfold_round_sse2(xstate, hx4_mulfold_pair_sse2(_mm256_castsi256_si128(ym), _mm256_extracti128_si256(ym, 1)));
+  }
+  if(p_end - p >= 16) {
+    xstate = hx4_mulfold_round_sse2(xstate, hx4_mulfold_words_sse2(_mm_loadu_si128((const __m128i*)p), xkey));
+    p += 16;
+  }
+
+  //store back state from register into memory
+  _mm_store_si128((__m128i*)state, xstate);
+
+  //whole words that are left
+  for(lane=0; p_end - p >= 4; lane = (lane + 1) & 0x03, p += 4) {
+    state[lane] = hx4_mulfold_round(state[lane], hx4_mulfold_word(U8TO32_LE(p), key[lane]));
+  }
+
+  hx4_mulfold_tail_final(state, key, p, (size_t)(p_end - p), in_sz, out);
+  HX4_STATS_END(hx4_x4mulfold_128_avx2, in_sz)
+  return HX4_ERR_SUCCESS;
+}
+
+#endif //HX4_HAS_AVX2
+
+#undef HX4_ROTL32
+#undef U8TO32_LE
+#undef HX4_MULFOLD_ADD
+#undef HX4_MULFOLD_PRIME
+#undef HX4_MULFOLD_CHUNK
@@ -0,0 +1,243 @@
+/* 
+ * Copyright 2015 Kai Dietrich <mail@cleeus.de>
+ *
+ * This file is part of hashx4.
+ *
+ * Hashx4 is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Hashx4 is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with hashx4.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "hashx4_config.h"
+
+#if HX4_HAS_SSE2
+# include <emmintrin.h>
+#endif
+
+#include "hashx4.h"
+#include "hashx4_partition.h"
+#include "hx4_util.h"
+
+// number of keys hashed in one go during the histogram phase
+#define HX4_PARTITION_HASH_BLOCK 256
+
+// tuples in one 64 byte write combining line
+#define HX4_PARTITION_LINE_TUPLES 4
+
+static uint16_t hx4_partition_id(uint64_t hash, int bits) {
+  return bits == 0 ? 0 : (uint16_t)(hash >> (64 - bits));
+}
+
+int hx4_partition_histogram(const uint64_t *keys, size_t n, const void *cookie, size_t cookie_sz, int bits, uint16_t *pids, size_t *histogram) {
+  uint64_t hashes[HX4_PARTITION_HASH_BLOCK];
+  uint16_t pid;
+  size_t block;
+  size_t i;
+  size_t j;
+  int rc;
+
+  if(!keys || !pids || !histogram) {
+    return HX4_ERR_PARAM_INVALID;
+  }
+  if(bits < 0 || bits > HX4_PARTITION_MAX_BITS) {
+    return HX4_ERR_PARAM_INVALID;
+  }
+
+  memset(histogram, 0, sizeof(size_t) << bits);
+
+  //the keys are hashed a block at a time with the bulk kernel, the block
+  //stays in L1 while the partition ids are taken from it
+  for(i=0; i<n; i+=block) {
+    block = n - i < HX4_PARTITION_HASH_BLOCK ? n - i : HX4_PARTITION_HASH_BLOCK;
+    rc = hx4_hash_u64_array(keys + i, block, cookie, cookie_sz, hashes);
+    if(rc != HX4_ERR_SUCCESS) {
+      return rc;
+    }
+    for(j=0; j<block; j++) {
+      pid = hx4_partition_id(hashes[j], bits);
+      pids[i+j] = pid;
+      histogram[pid]++;
+    }
+  }
+
+  return HX4_ERR_SUCCESS;
+}
+
+int hx4_partition_prefix_sum(size_t *histograms, size_t num_histograms, int bits, size_t *partition_offsets) {
+  size_t num_partitions;
+  size_t sum = 0;
+  size_t count;
+  size_t p;
+  size_t t;
+
+  if(!histograms) {
+    return HX4_ERR_PARAM_INVALID;
+  }
+  if(bits < 0 || bits > HX4_PARTITION_MAX_BITS) {
+    return HX4_ERR_PARAM_INVALID;
+  }
+
+  //partition major, so the chunks of one partition are adjacent and in thread order
+  num_partitions = (size_t)1 << bits;
+  for(p=0; p<num_partitions; p++) {
+    if(partition_offsets) {
+      partition_offsets[p] = sum;
+    }
+    for(t=0; t<num_histograms; t++) {
+      count = histograms[t*num_partitions + p];
+      histograms[t*num_partitions + p] = sum;
+      sum += count;
+    }
+  }
+  if(partition_offsets) {
+    partition_offsets[num_partitions] = sum;
+  }
+
+  return HX4_ERR_SUCCESS;
+}
+
+// Writes the tuples first..last-1 of a buffer line to the output line that
+// ends before tuple index line_end.
+static void hx4_partition_copy_tuples(hx4_tuple *out, size_t line_end, const hx4_tuple *line, size_t first, size_t last) {
+  size_t i;
+  for(i=first; i<last; i++) {
+    out[line_end - HX4_PARTITION_LINE_TUPLES + i] = line[i];
+  }
+}
+
+// Writes one full buffer line. The line can only be streamed if it lies
+// completely inside the range of this partition (and this chunk), the
+// first line of a range is shared with the range before it and gets
+// normal stores for the tuples that belong to us.
+static void hx4_partition_flush_line(hx4_tuple *out, size_t line_end, const hx4_tuple *line, size_t range_start, int stream) {
+  size_t first = range_start + HX4_PARTITION_LINE_TUPLES > line_end ? range_start + HX4_PARTITION_LINE_TUPLES - line_end : 0;
+#if HX4_HAS_SSE2
+  __m128i *dst;
+  if(stream && first == 0) {
+    dst = (__m128i*)(out + line_end - HX4_PARTITION_LINE_TUPLES);
+    _mm_stream_si128(dst + 0, _mm_load_si128((const __m128i*)(line + 0)));
+    _mm_stream_si128(dst + 1, _mm_load_si128((const __m128i*)(line + 1)));
+    _mm_stream_si128(dst + 2, _mm_load_si128((const __m128i*)(line + 2)));
+    _mm_stream_si128(dst + 3, _mm_load_si128((const __m128i*)(line + 3)));
+    return;
+  }
+#else
+  (void)stream;
+#endif
+  hx4_partition_copy_tuples(out, line_end, line, first, HX4_PARTITION_LINE_TUPLES);
+}
+
+int hx4_partition_scatter(const uint64_t *keys, const uint64_t *payloads, const uint16_t *pids, size_t n, int bits, size_t *cursors, void *swwc, size_t swwc_sz, hx4_tuple *out) {
+  hx4_tuple *lines;
+  hx4_tuple *line;
+  size_t *range_starts;
+  size_t num_partitions;
+  size_t cursor;
+  size_t phase;
+  size_t first;
+  size_t slot;
+  size_t i;
+  size_t p;
+  int stream;
+
+  if(!keys || !payloads || !pids || !cursors || !swwc || !out) {
+    return HX4_ERR_PARAM_INVALID;
+  }
+  if(bits < 0 || bits > HX4_PARTITION_MAX_BITS) {
+    return HX4_ERR_PARAM_INVALID;
+  }
+  if(swwc_sz < HX4_PARTITION_SWWC_SIZE(bits)) {
+    return HX4_ERR_BUFFER_TOO_SMALL;
+  }
+
+  //one 64 byte aligned line per partition, then the start of every range
+  num_partitions = (size_t)1 << bits;
+  lines = (hx4_tuple*)((uint8_t*)swwc + hx4_bytes_to_aligned(swwc, 64));
+  range_starts = (size_t*)(lines + num_partitions*HX4_PARTITION_LINE_TUPLES);
+  memcpy(range_starts, cursors, sizeof(size_t) * num_partitions);
+
+  //The buffer lines must map onto whole cache lines of out, otherwise every
+  //streamed line turns into two partial writes to memory. Tuple index c sits
+  //in slot (c + phase) of its line. Streaming needs out 16 byte aligned.
+  stream = hx4_bytes_to_aligned(out, 16) == 0;
+  phase = stream ? (HX4_PARTITION_LINE_TUPLES - hx4_bytes_to_aligned(out, 64) / 16) % HX4_PARTITION_LINE_TUPLES : 0;
+
+  for(i=0; i<n; i++) {
+    p = pids[i];
+    cursor = cursors[p]++;
+    slot = (cursor + phase) % HX4_PARTITION_LINE_TUPLES;
+    line = lines + p*HX4_PARTITION_LINE_TUPLES;
+#if HX4_HAS_SSE2
+    //one 16 byte store, so the 16 byte loads of the flush can be forwarded from it
+    _mm_store_si128((__m128i*)(line + slot), _mm_unpacklo_epi64(
+      _mm_loadl_epi64((const __m128i*)(keys + i)),
+      _mm_loadl_epi64((const __m128i*)(payloads + i))));
+#else
+    line[slot].key = keys[i];
+    line[slot].payload = payloads[i];
+#endif
+    if(slot == HX4_PARTITION_LINE_TUPLES-1) {
+      hx4_partition_flush_line(out, cursor + 1, line, range_starts[p], stream);
+    }
+  }
+
+  //the partially filled lines at the end of every range
+  for(p=0; p<num_partitions; p++) {
+    cursor = cursors[p];
+    slot = (cursor + phase) % HX4_PARTITION_LINE_TUPLES;
+    if(slot != 0 && cursor != range_starts[p]) {
+      first = range_starts[p] + slot > cursor ? range_starts[p] + slot - cursor : 0;
+      hx4_partition_copy_tuples(out, cursor - slot + HX4_PARTITION_LINE_TUPLES, lines + p*HX4_PARTITION_LINE_TUPLES, first, slot);
+    }
+  }
+
+#if HX4_HAS_SSE2
+  //make the streamed lines visible to the other threads before the caller signals them
+  _mm_sfence();
+#endif
+
+  return HX4_ERR_SUCCESS;
+}
+
+int hx4_partition_u64(const uint64_t *keys, const uint64_t *payloads, size_t n, const void *cookie, size_t cookie_sz, int bits, uint16_t *pids, void *swwc, size_t swwc_sz, hx4_tuple *out, size_t *partition_offsets) {
+  size_t *cursors;
+  int rc;
+
+  if(!partition_offsets) {
+    return HX4_ERR_PARAM_INVALID;
+  }
+
+  //the first 2^bits offsets serve as histogram and then as cursors
+  cursors = partition_offsets;
+  rc = hx4_partition_histogram(keys, n, cookie, cookie_sz, bits, pids, cursors);
+  if(rc != HX4_ERR_SUCCESS) {
+    return rc;
+  }
+  rc = hx4_partition_prefix_sum(cursors, 1, bits, NULL);
+  if(rc != HX4_ERR_SUCCESS) {
+    return rc;
+  }
+  rc = hx4_partition_scatter(keys, payloads, pids, n, bits, cursors, swwc, swwc_sz, out);
+  if(rc != HX4_ERR_SUCCESS) {
+    return rc;
+  }
+
+  //after the scatter every cursor points to the start of the next partition
+  memmove(partition_offsets + 1, partition_offsets, sizeof(size_t) << bits);
+  partition_offsets[0] = 0;
+
+  return HX4_ERR_SUCCESS;
+}
@@ -0,0 +1,214 @@
+/* 
+ * Copyright 2015 Kai Dietrich <mail@cleeus.de>
+ *
+ * This file is part of hashx4.
+ *
+ * Hashx4 is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Hashx4 is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with hashx4.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "hashx4_config.h"
+#include "hashx4.h"
+#include "hashx4_phf.h"
+#include "hx4_util.h"
+
+#define U8TO32_LE(p)                                                           \
+  (((uint32_t)((p)[0])) | ((uint32_t)((p)[1]) << 8) |                          \
+   ((uint32_t)((p)[2]) << 16) | ((uint32_t)((p)[3]) << 24))
+
+// slots are an int in the return value of hx4_phf_lookup
+#define HX4_PHF_MAX_KEYS 0x7fffffff
+
+static uint64_t hx4_phf_fmix64(uint64_t k) {
+  k ^= k >> 33;
+  k *= 0xff51afd7ed558ccdULL;
+  k ^= k >> 33;
+  k *= 0xc4ceb9fe1a85ec53ULL;
+  k ^= k >> 33;
+  return k;
+}
+
+// x4djbx33a_128 like hashx4_fixed.h, a plain loop without parameter checks is
+// faster than the SIMD functions on keyword sized keys
+static void hx4_phf_hash(const uint8_t *cookie, const void *key, size_t key_sz, uint64_t *bucket_hash, uint64_t *value) {
+  const uint8_t *p = (const uint8_t*)key;
+  uint32_t state[4] = { 5381, 5381, 5381, 5381 };
+  uint64_t a, b;
+  size_t i;
+
+  for(; key_sz>=4; key_sz-=4, p+=4) {
+    state[0] = state[0] * 33 + p[0];
+    state[1] = state[1] * 33 + p[1];
+    state[2] = state[2] * 33 + p[2];
+    state[3] = state[3] * 33 + p[3];
+  }
+  for(i=0; i<key_sz; i++) {
+    state[i] = state[i] * 33 + p[i];
+  }
+
+  //every lane only saw every fourth byte, mix them all into both words
+  a = (uint64_t)(state[0] ^ U8TO32_LE(cookie)) | ((uint64_t)(state[1] ^ U8TO32_LE(cookie + 4)) << 32);
+  b = (uint64_t)(state[2] ^ U8TO32_LE(cookie + 8)) | ((uint64_t)(state[3] ^ U8TO32_LE(cookie + 12)) << 32);
+  *bucket_hash = hx4_phf_fmix64(a ^ (b * 0x9e3779b97f4a7c15ULL));
+  *value = hx4_phf_fmix64(b ^ *bucket_hash);
+}
+
+// multiply and shift instead of a modulo
+HX4_INLINE uint32_t hx4_phf_reduce(uint64_t hash, uint32_t n) {
+  return (uint32_t)(((hash >> 32) * (uint64_t)n) >> 32);
+}
+
+HX4_INLINE uint32_t hx4_phf_slot(uint64_t value, uint32_t displacement, uint32_t num_keys) {
+  return hx4_phf_reduce(hx4_phf_fmix64(value ^ ((uint64_t)displacement * 0x9e3779b97f4a7c15ULL)), num_keys);
+}
+
+int hx4_phf_build(const void *const *keys, const size_t *key_sizes, size_t n, const void *cookie, size_t cookie_sz,
+                  uint32_t *displacements, uint32_t *slots, void *memory, size_t memory_sz) {
+  const uint32_t num_buckets = (uint32_t)HX4_PHF_NUM_BUCKETS(n);
+  uint64_t *values;
+  uint32_t *buckets;
+  uint32_t *order;
+  uint32_t *bucket_start;
+  uint8_t *taken;
+  uint64_t bucket_hash;
+  uint32_t max_size = 0;
+  uint32_t size;
+  uint32_t b;
+  uint32_t d;
+  uint32_t slot;
+  size_t i;
+  size_t j;
+
+  if(!cookie || !memory || (n && (!keys || !key_sizes || !displacements || !slots))) {
+    return HX4_ERR_PARAM_INVALID;
+  }
+  if(n > HX4_PHF_MAX_KEYS) {
+    return HX4_ERR_PARAM_INVALID;
+  }
+  if(cookie_sz < 128/8) {
+    return HX4_ERR_COOKIE_TOO_SMALL;
+  }
+  if(memory_sz < HX4_PHF_BUILD_MEMORY_SIZE(n)) {
+    return HX4_ERR_BUFFER_TOO_SMALL;
+  }
+
+  values = (uint64_t*)((uint8_t*)memory + hx4_bytes_to_aligned(memory, 8));
+  buckets = (uint32_t*)(values + n);
+  order = buckets + n;
+  bucket_start = order + n;
+  taken = (uint8_t*)(bucket_start + num_buckets + 1);
+
+  for(i=0; i<n; i++) {
+    if(!keys[i]) {
+      return HX4_ERR_PARAM_INVALID;
+    }
+    hx4_phf_hash((const uint8_t*)cookie, keys[i], key_sizes[i], &bucket_hash, &values[i]);
+    buckets[i] = hx4_phf_reduce(bucket_hash, num_buckets);
+  }
+
+  //counting sort of the keys by bucket, bucket_start[b] .. bucket_start[b+1]-1 in order
+  memset(bucket_start, 0, (num_buckets + 1) * sizeof(uint32_t));
+  for(i=0; i<n; i++) {
+    bucket_start[buckets[i] + 1]++;
+  }
+  for(b=0; b<num_buckets; b++) {
+    bucket_start[b + 1] += bucket_start[b];
+  }
+  for(i=0; i<n; i++) {
+    order[bucket_start[buckets[i]]++] = (uint32_t)i;
+  }
+  for(b=num_buckets; b>0; b--) {
+    bucket_start[b] = bucket_start[b - 1];
+  }
+  bucket_start[0] = 0;
+
+  //keys with the same value in one bucket always collide, for equal keys no cookie helps
+  for(b=0; b<num_buckets; b++) {
+    for(i=bucket_start[b]; i<bucket_start[b + 1]; i++) {
+      for(j=i+1; j<bucket_start[b + 1]; j++) {
+        if(values[order[i]] == values[order[j]]) {
+          if(key_sizes[order[i]] == key_sizes[order[j]] && memcmp(keys[order[i]], keys[order[j]], key_sizes[order[i]]) == 0) {
+            return HX4_ERR_PARAM_INVALID;
+          }
+          return HX4_ERR_SEARCH_FAILED;
+        }
+      }
+    }
+    size = bucket_start[b + 1] - bucket_start[b];
+    max_size = size > max_size ? size : max_size;
+    displacements[b] = 0;
+  }
+
+  //the largest buckets first, while most slots are still free
+  memset(taken, 0, n);
+  for(size=max_size; size>0; size--) {
+    for(b=0; b<num_buckets; b++) {
+      if(bucket_start[b + 1] - bucket_start[b] != size) {
+        continue;
+      }
+      for(d=0; d<HX4_PHF_MAX_DISPLACEMENT; d++) {
+        for(i=bucket_start[b]; i<bucket_start[b + 1]; i++) {
+          slot = hx4_phf_slot(values[order[i]], d, (uint32_t)n);
+          if(taken[slot]) {
+            break;
+          }
+          taken[slot] = 1;
+          slots[order[i]] = slot;
+        }
+        if(i == bucket_start[b + 1]) {
+          break;
+        }
+        //give back the slots of this try
+        for(j=bucket_start[b]; j<i; j++) {
+          taken[slots[order[j]]] = 0;
+        }
+      }
+      if(d == HX4_PHF_MAX_DISPLACEMENT) {
+        return HX4_ERR_SEARCH_FAILED;
+      }
+      displacements[b] = d;
+    }
+  }
+
+  return HX4_ERR_SUCCESS;
+}
+
+int hx4_phf_lookup(const hx4_phf *phf, const void *key, size_t key_sz) {
+  uint64_t bucket_hash;
+  uint64_t value;
+  uint32_t slot;
+  uint32_t offset;
+
+  if(!phf || !key) {
+    return HX4_ERR_PARAM_INVALID;
+  }
+  if(!phf->num_keys) {
+    return HX4_ERR_NOT_FOUND;
+  }
+
+  hx4_phf_hash(phf->cookie, key, key_sz, &bucket_hash, &value);
+  slot = hx4_phf_slot(value, phf->displacements[hx4_phf_reduce(bucket_hash, phf->num_buckets)], phf->num_keys);
+
+  offset = phf->key_offsets[slot];
+  if(phf->key_offsets[slot + 1] - offset != key_sz || memcmp(phf->key_data + offset, key, key_sz) != 0) {
+    return HX4_ERR_NOT_FOUND;
+  }
+  return (int)slot;
+}
+
+#undef U8TO32_LE
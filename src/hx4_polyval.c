@@ -0,0 +1,268 @@
+/* 
+ * Copyright 2015 Kai Dietrich <mail@cleeus.de>
+ *
+ * This file is part of hashx4.
+ *
+ * Hashx4 is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Hashx4 is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with hashx4.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "hashx4_config.h"
+
+#if HX4_HAS_PCLMUL
+# include <emmintrin.h>
+# include <wmmintrin.h>
+#endif
+
+#include "hashx4.h"
+#include "hx4_util.h"
+
+// POLYVAL from AES-GCM-SIV (RFC 8452), a polynomial universal hash over
+// GF(2^128) with the little endian bit order of x86. The first 16 bytes of
+// the cookie are the key H. The input is split into 16 byte blocks, the
+// last one padded with zeros, followed by a length block of 8 zero bytes and
+// the input length in bits (little endian). The output is the same as the
+// POLYVAL of AES-GCM-SIV for a message without additional data.
+//
+// Every block costs one multiplication in GF(2^128), S = (S ^ X) * H * x^-128
+// modulo x^128 + x^127 + x^126 + x^121 + 1. The pclmul variant multiplies 8
+// blocks with the powers H^8 .. H^1 and adds up the 256bit products, so the
+// reduction is only done once for every 128 bytes.
+//
+// This is a universal hash, not a MAC on its own: two inputs collide for a
+// random key with a probability of about length/2^128, but an attacker who
+// sees outputs can solve for the key. For a MAC the output has to be
+// encrypted with a value that is different for every message, like a nonce
+// run through AES.
+
+#define HX4_POLYVAL_BLOCK 16
+
+//high 64 bits of P without the x^128, the low 64 bits are 1
+#define HX4_POLYVAL_POLY_HI 0xc200000000000000ULL
+
+typedef struct {
+  uint64_t lo;
+  uint64_t hi;
+} hx4_polyval_elem;
+
+HX4_INLINE uint64_t hx4_polyval_u8to64_le(const uint8_t *p) {
+  return ((uint64_t)p[0]      ) | ((uint64_t)p[1] <<  8) |
+         ((uint64_t)p[2] << 16) | ((uint64_t)p[3] << 24) |
+         ((uint64_t)p[4] << 32) | ((uint64_t)p[5] << 40) |
+         ((uint64_t)p[6] << 48) | ((uint64_t)p[7] << 56);
+}
+
+HX4_INLINE void hx4_polyval_u64to8_le(uint8_t *p, uint64_t v) {
+  int i;
+  for(i=0; i<8; i++) {
+    p[i] = (uint8_t)(v >> (8*i));
+  }
+}
+
+HX4_INLINE hx4_polyval_elem hx4_polyval_load_ref(const uint8_t *p) {
+  hx4_polyval_elem e;
+  e.lo = hx4_polyval_u8to64_le(p);
+  e.hi = hx4_polyval_u8to64_le(p + 8);
+  return e;
+}
+
+//a * b mod P, bitwise: Horner over the bits of a from the top
+static hx4_polyval_elem hx4_polyval_mul_ref(hx4_polyval_elem a, hx4_polyval_elem b) {
+  hx4_polyval_elem r = { 0, 0 };
+  uint64_t carry;
+  uint64_t bit;
+  int i;
+
+  for(i=127; i>=0; i--) {
+    //r = r * x
+    carry = r.hi >> 63;
+    r.hi = (r.hi << 1) | (r.lo >> 63);
+    r.lo = r.lo << 1;
+    r.hi ^= HX4_POLYVAL_POLY_HI & (0 - carry);
+    r.lo ^= 1 & (0 - carry);
+
+    bit = (i >= 64 ? a.hi >> (i - 64) : a.lo >> i) & 1;
+    r.hi ^= b.hi & (0 - bit);
+    r.lo ^= b.lo & (0 - bit);
+  }
+  return r;
+}
+
+//a * x^-128 mod P: 128 divisions by x, P is added whenever the lowest bit is set
+static hx4_polyval_elem hx4_polyval_div_x128_ref(hx4_polyval_elem a) {
+  uint64_t low;
+  int i;
+
+  for(i=0; i<128; i++) {
+    low = a.lo & 1;
+    a.hi ^= HX4_POLYVAL_POLY_HI & (0 - low);
+    a.lo ^= low;
+    a.lo = (a.lo >> 1) | (a.hi << 63);
+    a.hi = (a.hi >> 1) | (low << 63);
+  }
+  return a;
+}
+
+HX4_API int hx4_polyval_128_ref(const void *in, size_t in_sz, const void *cookie, size_t cookie_sz, void *out, size_t out_sz) {
+  const uint8_t *p = (const uint8_t*)in;
+  uint8_t block[HX4_POLYVAL_BLOCK];
+  hx4_polyval_elem h;
+  hx4_polyval_elem s = { 0, 0 };
+  hx4_polyval_elem x;
+  size_t left = in_sz;
+  int rc;
+  HX4_STATS_BEGIN(hx4_polyval_128_ref)
+
+  rc = hx4_check_params(128/8, in, in_sz, cookie, cookie_sz, out, out_sz);
+  if(rc != HX4_ERR_SUCCESS) {
+    return rc;
+  }
+
+  //dot(a, h) = a * h * x^-128, the x^-128 goes into the key once
+  h = hx4_polyval_div_x128_ref(hx4_polyval_load_ref((const uint8_t*)cookie));
+
+  for( ; left > 0; left -= HX4_POLYVAL_BLOCK, p += HX4_POLYVAL_BLOCK) {
+    if(left < HX4_POLYVAL_BLOCK) {
+      memset(block, 0, sizeof(block));
+      memcpy(block, p, left);
+      left = HX4_POLYVAL_BLOCK;
+      p = block;
+    }
+    x = hx4_polyval_load_ref(p);
+    s.lo ^= x.lo;
+    s.hi ^= x.hi;
+    s = hx4_polyval_mul_ref(s, h);
+  }
+
+  //length block
+  s.hi ^= (uint64_t)in_sz * 8;
+  s = hx4_polyval_mul_ref(s, h);
+
+  hx4_polyval_u64to8_le((uint8_t*)out, s.lo);
+  hx4_polyval_u64to8_le((uint8_t*)out + 8, s.hi);
+  HX4_STATS_END(hx4_polyval_128_ref, in_sz)
+  return HX4_ERR_SUCCESS;
+}
+
+#if HX4_HAS_PCLMUL
+
+#define HX4_POLYVAL_AGGREGATE 8
+
+// The 256bit product lo + mid * x^64 + hi * x^128 times x^-128 mod P, two
+// folds of 64 bits each with the low half of P (Montgomery reduction).
+HX4_INLINE __m128i hx4_polyval_reduce_pclmul(__m128i lo, __m128i mid, __m128i hi) {
+  const __m128i poly = _mm_set_epi32((int)0xc2000000, 0, 0, 1);
+  __m128i t;
+
+  lo = _mm_xor_si128(lo, _mm_slli_si128(mid, 8));
+  hi = _mm_xor_si128(hi, _mm_srli_si128(mid, 8));
+
+  t = _mm_clmulepi64_si128(lo, poly, 0x10);
+  lo = _mm_xor_si128(_mm_shuffle_epi32(lo, 0x4e), t);
+  t = _mm_clmulepi64_si128(lo, poly, 0x10);
+  lo = _mm_xor_si128(_mm_shuffle_epi32(lo, 0x4e), t);
+
+  return _mm_xor_si128(hi, lo);
+}
+
+//adds the unreduced product a * b to lo, mid and hi
+#define HX4_POLYVAL_MUL_ADD(a, b) do { \
+  lo = _mm_xor_si128(lo, _mm_clmulepi64_si128((a), (b), 0x00)); \
+  hi = _mm_xor_si128(hi, _mm_clmulepi64_si128((a), (b), 0x11)); \
+  mid = _mm_xor_si128(mid, _mm_clmulepi64_si128((a), (b), 0x01)); \
+  mid = _mm_xor_si128(mid, _mm_clmulepi64_si128((a), (b), 0x10)); \
+} while(0)
+
+HX4_INLINE __m128i hx4_polyval_dot_pclmul(__m128i a, __m128i b) {
+  __m128i lo = _mm_setzero_si128();
+  __m128i mid = _mm_setzero_si128();
+  __m128i hi = _mm_setzero_si128();
+
+  HX4_POLYVAL_MUL_ADD(a, b);
+  return hx4_polyval_reduce_pclmul(lo, mid, hi);
+}
+
+HX4_API int hx4_polyval_128_pclmul(const void *in, size_t in_sz, const void *cookie, size_t cookie_sz, void *out, size_t out_sz) {
+  const uint8_t *p = (const uint8_t*)in;
+  const uint8_t * const p_end = p + in_sz;
+  uint8_t block[HX4_POLYVAL_BLOCK];
+  const uint64_t bits = (uint64_t)in_sz * 8;
+  __m128i powers[HX4_POLYVAL_AGGREGATE];
+  __m128i s = _mm_setzero_si128();
+  __m128i lo;
+  __m128i mid;
+  __m128i hi;
+  __m128i x;
+  int i;
+  int rc;
+  HX4_STATS_BEGIN(hx4_polyval_128_pclmul)
+
+  rc = hx4_check_params(128/8, in, in_sz, cookie, cookie_sz, out, out_sz);
+  if(rc != HX4_ERR_SUCCESS) {
+    return rc;
+  }
+
+  //powers[i] = H^(i+1), only worth computing when there are enough blocks
+  powers[0] = _mm_loadu_si128((const __m128i*)cookie);
+  if(in_sz >= HX4_POLYVAL_AGGREGATE*HX4_POLYVAL_BLOCK) {
+    for(i=1; i<HX4_POLYVAL_AGGREGATE; i++) {
+      powers[i] = hx4_polyval_dot_pclmul(powers[i-1], powers[0]);
+    }
+  }
+
+  //main processing loop, 8 blocks per reduction:
+  //S' = (S ^ X0) * H^8 + X1 * H^7 + .. + X7 * H
+  for( ; p_end - p >= HX4_POLYVAL_AGGREGATE*HX4_POLYVAL_BLOCK; p += HX4_POLYVAL_AGGREGATE*HX4_POLYVAL_BLOCK) {
+    lo = _mm_setzero_si128();
+    mid = _mm_setzero_si128();
+    hi = _mm_setzero_si128();
+    x = _mm_xor_si128(s, _mm_loadu_si128((const __m128i*)p));
+    HX4_POLYVAL_MUL_ADD(x, powers[7]);
+    for(i=1; i<HX4_POLYVAL_AGGREGATE; i++) {
+      x = _mm_loadu_si128((const __m128i*)(p + i*HX4_POLYVAL_BLOCK));
+      HX4_POLYVAL_MUL_ADD(x, powers[HX4_POLYVAL_AGGREGATE-1-i]);
+    }
+    s = hx4_polyval_reduce_pclmul(lo, mid, hi);
+  }
+
+  //process any input that is left, one block at a time
+  for( ; p_end - p >= HX4_POLYVAL_BLOCK; p += HX4_POLYVAL_BLOCK) {
+    s = hx4_polyval_dot_pclmul(_mm_xor_si128(s, _mm_loadu_si128((const __m128i*)p)), powers[0]);
+  }
+  if(p < p_end) {
+    memset(block, 0, sizeof(block));
+    memcpy(block, p, (size_t)(p_end - p));
+    s = hx4_polyval_dot_pclmul(_mm_xor_si128(s, _mm_loadu_si128((const __m128i*)block)), powers[0]);
+  }
+
+  //length block
+  x = _mm_set_epi32((int)(uint32_t)(bits >> 32), (int)(uint32_t)bits, 0, 0);
+  s = hx4_polyval_dot_pclmul(_mm_xor_si128(s, x), powers[0]);
+
+  _mm_storeu_si128((__m128i*)out, s);
+  HX4_STATS_END(hx4_polyval_128_pclmul, in_sz)
+  return HX4_ERR_SUCCESS;
+}
+
+#undef HX4_POLYVAL_MUL_ADD
+#undef HX4_POLYVAL_AGGREGATE
+#endif //HX4_HAS_PCLMUL
+
+#undef HX4_POLYVAL_POLY_HI
+#undef HX4_POLYVAL_BLOCK
@@ -0,0 +1,799 @@
+/* 
+ * Copyright 2015 Kai Dietrich <mail@cleeus.de>
+ *
+ * This file is part of hashx4.
+ *
+ * Hashx4 is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Hashx4 is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with hashx4.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "hashx4_config.h"
+
+#if HX4_HAS_SSE2
+# include <emmintrin.h>
+#endif
+
+#include "hashx4.h"
+#include "hx4_util.h"
+#include "hx4_stream.h"
+
+#define ROTL(x,b) (uint64_t)( ((x) << (b)) | ( (x) >> (64 - (b))) )
+
+#define U32TO8_LE(p, v)         \
+    (p)[0] = (uint8_t)((v)      ); (p)[1] = (uint8_t)((v) >>  8); \
+    (p)[2] = (uint8_t)((v) >> 16); (p)[3] = (uint8_t)((v) >> 24);
+
+#define U64TO8_LE(p, v)         \
+  U32TO8_LE((p),     (uint32_t)((v)      ));   \
+  U32TO8_LE((p) + 4, (uint32_t)((v) >> 32));
+
+#define U8TO64_LE(p) \
+  (((uint64_t)((p)[0])      ) | \
+   ((uint64_t)((p)[1]) <<  8) | \
+   ((uint64_t)((p)[2]) << 16) | \
+   ((uint64_t)((p)[3]) << 24) | \
+   ((uint64_t)((p)[4]) << 32) | \
+   ((uint64_t)((p)[5]) << 40) | \
+   ((uint64_t)((p)[6]) << 48) | \
+   ((uint64_t)((p)[7]) << 56))
+
+#define SIPROUND            \
+  do {              \
+    v0 += v1; v1=ROTL(v1,13); v1 ^= v0; v0=ROTL(v0,32); \
+    v2 += v3; v3=ROTL(v3,16); v3 ^= v2;     \
+    v0 += v3; v3=ROTL(v3,21); v3 ^= v0;     \
+    v2 += v1; v1=ROTL(v1,17); v1 ^= v2; v2=ROTL(v2,32); \
+  } while(0)
+
+/* the same round on lane i of the state arrays of the x4 variants */
+#define SIPROUND_LANE(i)            \
+  do {              \
+    v0[i] += v1[i]; v1[i]=ROTL(v1[i],13); v1[i] ^= v0[i]; v0[i]=ROTL(v0[i],32); \
+    v2[i] += v3[i]; v3[i]=ROTL(v3[i],16); v3[i] ^= v2[i];     \
+    v0[i] += v3[i]; v3[i]=ROTL(v3[i],21); v3[i] ^= v0[i];     \
+    v2[i] += v1[i]; v1[i]=ROTL(v1[i],17); v1[i] ^= v2[i]; v2[i]=ROTL(v2[i],32); \
+  } while(0)
+
+static int hx4_siphash13_64_copt_impl(const uint8_t *in, size_t in_sz, const uint8_t *cookie, size_t cookie_sz, uint8_t *out, size_t out_sz) {
+  uint64_t v0 = 0x736f6d6570736575ULL;
+  uint64_t v1 = 0x646f72616e646f6dULL;
+  uint64_t v2 = 0x6c7967656e657261ULL;
+  uint64_t v3 = 0x7465646279746573ULL;
+  uint64_t b;
+  uint64_t k0 = U8TO64_LE( cookie );
+  uint64_t k1 = U8TO64_LE( (uint8_t*)cookie + 8 );
+  uint64_t m;
+  const uint8_t *end = in + in_sz - ( in_sz % sizeof( uint64_t ) );
+  const int left = in_sz & 7;
+
+  b = ( ( uint64_t )in_sz ) << 56;
+  v3 ^= k1;
+  v2 ^= k0;
+  v1 ^= k1;
+  v0 ^= k0;
+
+  for ( ; in != end; in += 8 )
+  {
+    m = U8TO64_LE( in );
+    v3 ^= m;
+    SIPROUND;
+    v0 ^= m;
+  }
+
+  switch( left )
+  {
+  case 7: b |= ( ( uint64_t )in[ 6] )  << 48;
+  case 6: b |= ( ( uint64_t )in[ 5] )  << 40;
+  case 5: b |= ( ( uint64_t )in[ 4] )  << 32;
+  case 4: b |= ( ( uint64_t )in[ 3] )  << 24;
+  case 3: b |= ( ( uint64_t )in[ 2] )  << 16;
+  case 2: b |= ( ( uint64_t )in[ 1] )  <<  8;
+  case 1: b |= ( ( uint64_t )in[ 0] ); break;
+  case 0: break;
+  }
+
+  v3 ^= b;
+  SIPROUND;
+  v0 ^= b;
+
+  v2 ^= 0xff;
+  SIPROUND;
+  SIPROUND;
+  SIPROUND;
+  b = v0 ^ v1 ^ v2  ^ v3;
+  U64TO8_LE( out, b );
+
+  return HX4_ERR_SUCCESS;
+}
+
+HX4_API int hx4_siphash13_64_copt(const void *in, size_t in_sz, const void *cookie, size_t cookie_sz, void *out, size_t out_sz) {
+  int rc;
+  HX4_STATS_BEGIN(hx4_siphash13_64_copt)
+  rc = hx4_check_params(64/8, in, in_sz, cookie, cookie_sz, out, out_sz);
+  if(rc != HX4_ERR_SUCCESS) {
+    return rc;
+  }
+  rc = hx4_siphash13_64_copt_impl((const uint8_t*)in, in_sz, (const uint8_t*)cookie, cookie_sz, (uint8_t*)out, out_sz);
+  HX4_STATS_END(hx4_siphash13_64_copt, in_sz)
+  return rc;
+}
+
+/*
+ * x4siphash13 runs four SipHash-1-3 instances over the input.
+ * The input is cut into 64bit words and the words are dealt round robin
+ * to the lanes, so lane i hashes the words i, i+4, i+8, ...
+ * The last, possibly partial, word goes to the next lane in turn.
+ * The output is the concatenation of the four 64bit lane hashes.
+ */
+
+//number of input bytes that end up in a lane
+static size_t hx4_x4siphash13_lane_size(size_t in_sz, int lane) {
+  const size_t remainder = in_sz % 32;
+  const size_t lane_remainder = remainder > (size_t)(8*lane) ? remainder - 8*lane : 0;
+  return (in_sz / 32) * 8 + (lane_remainder < 8 ? lane_remainder : 8);
+}
+
+HX4_API int hx4_x4siphash13_256_ref(const void *in, size_t in_sz, const void *cookie, size_t cookie_sz, void *out, size_t out_sz) {
+  const uint8_t *p;
+  uint64_t v0, v1, v2, v3;
+  uint64_t k0, k1;
+  uint64_t b;
+  uint64_t m;
+  size_t lane_sz;
+  size_t i;
+  int lane;
+  int rc;
+  HX4_STATS_BEGIN(hx4_x4siphash13_256_ref)
+
+  rc = hx4_check_params(256/8, in, in_sz, cookie, cookie_sz, out, out_sz);
+  if(rc != HX4_ERR_SUCCESS) {
+    return rc;
+  }
+
+  k0 = U8TO64_LE( (const uint8_t*)cookie );
+  k1 = U8TO64_LE( (const uint8_t*)cookie + 8 );
+
+  for(lane=0; lane<4; lane++) {
+    v0 = 0x736f6d6570736575ULL ^ k0;
+    v1 = 0x646f72616e646f6dULL ^ k1;
+    v2 = 0x6c7967656e657261ULL ^ k0;
+    v3 = 0x7465646279746573ULL ^ k1;
+
+    lane_sz = hx4_x4siphash13_lane_size(in_sz, lane);
+    b = ( ( uint64_t )lane_sz ) << 56;
+
+    //full words of this lane
+    for(i=0; i+8<=lane_sz; i+=8) {
+      p = (const uint8_t*)in + (i/8)*32 + lane*8;
+      m = U8TO64_LE( p );
+      v3 ^= m;
+      SIPROUND;
+      v0 ^= m;
+    }
+
+    //partial last word
+    p = (const uint8_t*)in + (i/8)*32 + lane*8;
+    for( ; i<lane_sz; i++, p++) {
+      b |= ( ( uint64_t )*p ) << (8*(i%8));
+    }
+
+    v3 ^= b;
+    SIPROUND;
+    v0 ^= b;
+
+    v2 ^= 0xff;
+    SIPROUND;
+    SIPROUND;
+    SIPROUND;
+    b = v0 ^ v1 ^ v2  ^ v3;
+    U64TO8_LE( (uint8_t*)out + 8*lane, b );
+  }
+
+  HX4_STATS_END(hx4_x4siphash13_256_ref, in_sz)
+  return HX4_ERR_SUCCESS;
+}
+
+HX4_API void hx4_siphash13_64_init(hx4_siphash_stream *stream, const void *cookie) {
+  uint64_t k0, k1;
+
+  k0 = U8TO64_LE( (const uint8_t*)cookie );
+  k1 = U8TO64_LE( (const uint8_t*)cookie + 8 );
+  memset(stream, 0, sizeof(*stream));
+  stream->v[0] = 0x736f6d6570736575ULL ^ k0;
+  stream->v[1] = 0x646f72616e646f6dULL ^ k1;
+  stream->v[2] = 0x6c7967656e657261ULL ^ k0;
+  stream->v[3] = 0x7465646279746573ULL ^ k1;
+  memcpy(stream->cookie, cookie, sizeof(stream->cookie));
+}
+
+HX4_API void hx4_siphash13_64_final(hx4_siphash_stream *stream, void *out) {
+  uint64_t v0 = stream->v[0];
+  uint64_t v1 = stream->v[1];
+  uint64_t v2 = stream->v[2];
+  uint64_t v3 = stream->v[3];
+  uint64_t b;
+  size_t i;
+
+  b = ( ( uint64_t )stream->pos ) << 56;
+  for(i=0; i<(size_t)(stream->pos & 7); i++) {
+    b |= ( ( uint64_t )stream->carry[i] ) << (8*i);
+  }
+
+  v3 ^= b;
+  SIPROUND;
+  v0 ^= b;
+
+  v2 ^= 0xff;
+  SIPROUND;
+  SIPROUND;
+  SIPROUND;
+  b = v0 ^ v1 ^ v2  ^ v3;
+  U64TO8_LE( (uint8_t*)out, b );
+}
+
+//bytewise through the carry, the straightforward way
+HX4_API void hx4_siphash13_64_ref_update(hx4_siphash_stream *stream, const void *in, size_t in_sz) {
+  const uint8_t *p = (const uint8_t*)in;
+  uint64_t v0 = stream->v[0];
+  uint64_t v1 = stream->v[1];
+  uint64_t v2 = stream->v[2];
+  uint64_t v3 = stream->v[3];
+  uint64_t m;
+  size_t i;
+
+  for(i=0; i<in_sz; i++) {
+    stream->carry[stream->pos & 7] = p[i];
+    stream->pos++;
+    if((stream->pos & 7) == 0) {
+      m = U8TO64_LE( stream->carry );
+      v3 ^= m;
+      SIPROUND;
+      v0 ^= m;
+    }
+  }
+
+  stream->v[0] = v0;
+  stream->v[1] = v1;
+  stream->v[2] = v2;
+  stream->v[3] = v3;
+}
+
+//completes the carried word, then runs the word loop of the one shot function
+HX4_API void hx4_siphash13_64_copt_update(hx4_siphash_stream *stream, const void *in, size_t in_sz) {
+  const uint8_t *p = (const uint8_t*)in;
+  const uint8_t * const p_end = p + in_sz;
+  size_t carry_sz = (size_t)(stream->pos & 7);
+  uint64_t v0 = stream->v[0];
+  uint64_t v1 = stream->v[1];
+  uint64_t v2 = stream->v[2];
+  uint64_t v3 = stream->v[3];
+  uint64_t m;
+
+  stream->pos += in_sz;
+
+  if(carry_sz > 0) {
+    while(carry_sz < 8 && p < p_end) {
+      stream->carry[carry_sz++] = *p++;
+    }
+    if(carry_sz < 8) {
+      return;
+    }
+    m = U8TO64_LE( stream->carry );
+    v3 ^= m;
+    SIPROUND;
+    v0 ^= m;
+  }
+
+  for( ; p_end - p >= 8; p += 8) {
+    m = U8TO64_LE( p );
+    v3 ^= m;
+    SIPROUND;
+    v0 ^= m;
+  }
+
+  memcpy(stream->carry, p, (size_t)(p_end - p));
+
+  stream->v[0] = v0;
+  stream->v[1] = v1;
+  stream->v[2] = v2;
+  stream->v[3] = v3;
+}
+
+HX4_STREAM_V_IMPL(hx4_siphash13_64_ref, hx4_siphash_stream, 64/8, hx4_siphash13_64_init, hx4_siphash13_64_final)
+HX4_STREAM_CSTR_STRLEN_IMPL(hx4_siphash13_64_ref)
+HX4_STREAM_V_IMPL(hx4_siphash13_64_copt, hx4_siphash_stream, 64/8, hx4_siphash13_64_init, hx4_siphash13_64_final)
+HX4_STREAM_CSTR_STRLEN_IMPL(hx4_siphash13_64_copt)
+
+//case-insensitive updates, A-Z are folded as they are read, the copt one folds whole words
+HX4_API void hx4_siphash13_64_ref_ci_update(hx4_siphash_stream *stream, const void *in, size_t in_sz) {
+  const uint8_t *p = (const uint8_t*)in;
+  uint64_t v0 = stream->v[0];
+  uint64_t v1 = stream->v[1];
+  uint64_t v2 = stream->v[2];
+  uint64_t v3 = stream->v[3];
+  uint64_t m;
+  size_t i;
+
+  for(i=0; i<in_sz; i++) {
+    stream->carry[stream->pos & 7] = hx4_ascii_tolower(p[i]);
+    stream->pos++;
+    if((stream->pos & 7) == 0) {
+      m = U8TO64_LE( stream->carry );
+      v3 ^= m;
+      SIPROUND;
+      v0 ^= m;
+    }
+  }
+
+  stream->v[0] = v0;
+  stream->v[1] = v1;
+  stream->v[2] = v2;
+  stream->v[3] = v3;
+}
+
+HX4_API void hx4_siphash13_64_copt_ci_update(hx4_siphash_stream *stream, const void *in, size_t in_sz) {
+  const uint8_t *p = (const uint8_t*)in;
+  const uint8_t * const p_end = p + in_sz;
+  size_t carry_sz = (size_t)(stream->pos & 7);
+  uint64_t v0 = stream->v[0];
+  uint64_t v1 = stream->v[1];
+  uint64_t v2 = stream->v[2];
+  uint64_t v3 = stream->v[3];
+  uint64_t m;
+
+  stream->pos += in_sz;
+
+  if(carry_sz > 0) {
+    while(carry_sz < 8 && p < p_end) {
+      stream->carry[carry_sz++] = hx4_ascii_tolower(*p++);
+    }
+    if(carry_sz < 8) {
+      return;
+    }
+    m = U8TO64_LE( stream->carry );
+    v3 ^= m;
+    SIPROUND;
+    v0 ^= m;
+  }
+
+  for( ; p_end - p >= 8; p += 8) {
+    m = hx4_ascii_tolower64(U8TO64_LE( p ));
+    v3 ^= m;
+    SIPROUND;
+    v0 ^= m;
+  }
+
+  for(carry_sz=0; p < p_end; carry_sz++) {
+    stream->carry[carry_sz] = hx4_ascii_tolower(*p++);
+  }
+
+  stream->v[0] = v0;
+  stream->v[1] = v1;
+  stream->v[2] = v2;
+  stream->v[3] = v3;
+}
+
+HX4_STREAM_CI_IMPL(hx4_siphash13_64_ref, hx4_siphash_stream, 64/8, hx4_siphash13_64_init, hx4_siphash13_64_final)
+HX4_STREAM_CI_IMPL(hx4_siphash13_64_copt, hx4_siphash_stream, 64/8, hx4_siphash13_64_init, hx4_siphash13_64_final)
+
+HX4_API void hx4_x4siphash13_256_init(hx4_x4siphash_stream *stream, const void *cookie) {
+  uint64_t k0, k1;
+  int lane;
+
+  k0 = U8TO64_LE( (const uint8_t*)cookie );
+  k1 = U8TO64_LE( (const uint8_t*)cookie + 8 );
+  memset(stream, 0, sizeof(*stream));
+  for(lane=0; lane<4; lane++) {
+    stream->v0[lane] = 0x736f6d6570736575ULL ^ k0;
+    stream->v1[lane] = 0x646f72616e646f6dULL ^ k1;
+    stream->v2[lane] = 0x6c7967656e657261ULL ^ k0;
+    stream->v3[lane] = 0x7465646279746573ULL ^ k1;
+  }
+  memcpy(stream->cookie, cookie, sizeof(stream->cookie));
+}
+
+//the remainder code of the one shot functions run over the carry
+HX4_API void hx4_x4siphash13_256_final(hx4_x4siphash_stream *stream, void *out) {
+  uint64_t * const v0 = stream->v0;
+  uint64_t * const v1 = stream->v1;
+  uint64_t * const v2 = stream->v2;
+  uint64_t * const v3 = stream->v3;
+  const size_t remainder = (size_t)(stream->pos % 32);
+  uint64_t b;
+  uint64_t m;
+  size_t j;
+  int lane;
+
+  for(lane=0; lane<4; lane++) {
+    b = ( ( uint64_t )hx4_x4siphash13_lane_size((size_t)stream->pos, lane) ) << 56;
+    if((size_t)(8*lane+8) <= remainder) {
+      m = U8TO64_LE( stream->carry + 8*lane );
+      v3[lane] ^= m;
+      SIPROUND_LANE(lane);
+      v0[lane] ^= m;
+    } else if((size_t)(8*lane) < remainder) {
+      for(j=0; j<remainder-8*lane; j++) {
+        b |= ( ( uint64_t )stream->carry[8*lane+j] ) << (8*j);
+      }
+    }
+
+    v3[lane] ^= b;
+    SIPROUND_LANE(lane);
+    v0[lane] ^= b;
+
+    v2[lane] ^= 0xff;
+    SIPROUND_LANE(lane);
+    SIPROUND_LANE(lane);
+    SIPROUND_LANE(lane);
+    b = v0[lane] ^ v1[lane] ^ v2[lane]  ^ v3[lane];
+    U64TO8_LE( (uint8_t*)out + 8*lane, b );
+  }
+}
+
+//bytewise through the carry, a word for every lane when it is full
+HX4_API void hx4_x4siphash13_256_ref_update(hx4_x4siphash_stream *stream, const void *in, size_t in_sz) {
+  const uint8_t *p = (const uint8_t*)in;
+  uint64_t * const v0 = stream->v0;
+  uint64_t * const v1 = stream->v1;
+  uint64_t * const v2 = stream->v2;
+  uint64_t * const v3 = stream->v3;
+  uint64_t m;
+  size_t i;
+  int lane;
+
+  for(i=0; i<in_sz; i++) {
+    stream->carry[stream->pos % 32] = p[i];
+    stream->pos++;
+    if((stream->pos % 32) == 0) {
+      for(lane=0; lane<4; lane++) {
+        m = U8TO64_LE( stream->carry + 8*lane );
+        v3[lane] ^= m;
+        SIPROUND_LANE(lane);
+        v0[lane] ^= m;
+      }
+    }
+  }
+}
+
+HX4_STREAM_V_IMPL(hx4_x4siphash13_256_ref, hx4_x4siphash_stream, 256/8, hx4_x4siphash13_256_init, hx4_x4siphash13_256_final)
+HX4_STREAM_CSTR_STRLEN_IMPL(hx4_x4siphash13_256_ref)
+
+#if HX4_HAS_SSE2
+
+#define HX4_SSE2_ROTL64(x, b) _mm_or_si128(_mm_slli_epi64((x), (b)), _mm_srli_epi64((x), 64-(b)))
+//rotations by multiples of 16 bits are word shuffles
+#define HX4_SSE2_ROTL64_16(x) _mm_shufflehi_epi16(_mm_shufflelo_epi16((x), _MM_SHUFFLE(2,1,0,3)), _MM_SHUFFLE(2,1,0,3))
+#define HX4_SSE2_ROTL64_32(x) _mm_shuffle_epi32((x), _MM_SHUFFLE(2,3,0,1))
+
+#define HX4_SSE2_SIPROUND(v0, v1, v2, v3) \
+    v0 = _mm_add_epi64(v0, v1); v1 = HX4_SSE2_ROTL64(v1, 13); v1 = _mm_xor_si128(v1, v0); v0 = HX4_SSE2_ROTL64_32(v0); \
+    v2 = _mm_add_epi64(v2, v3); v3 = HX4_SSE2_ROTL64_16(v3);  v3 = _mm_xor_si128(v3, v2); \
+    v0 = _mm_add_epi64(v0, v3); v3 = HX4_SSE2_ROTL64(v3, 21); v3 = _mm_xor_si128(v3, v0); \
+    v2 = _mm_add_epi64(v2, v1); v1 = HX4_SSE2_ROTL64(v1, 17); v1 = _mm_xor_si128(v1, v2); v2 = HX4_SSE2_ROTL64_32(v2);
+
+HX4_API int hx4_x4siphash13_256_sse2(const void *in, size_t in_sz, const void *cookie, size_t cookie_sz, void *out, size_t out_sz) {
+  const uint8_t *p;
+  const uint8_t *end;
+  HX4_ALIGNED(uint64_t v0[4], 16);
+  HX4_ALIGNED(uint64_t v1[4], 16);
+  HX4_ALIGNED(uint64_t v2[4], 16);
+  HX4_ALIGNED(uint64_t v3[4], 16);
+  HX4_ALIGNED(uint64_t b[4], 16);
+  HX4_ALIGNED(const uint64_t final_const[2], 16) = { 0xff, 0xff };
+  uint64_t k0, k1;
+  uint64_t m;
+  size_t remainder;
+  size_t tail;
+  size_t j;
+  int lane;
+  int rc;
+  __m128i xv0a, xv1a, xv2a, xv3a;
+  __m128i xv0b, xv1b, xv2b, xv3b;
+  __m128i xma, xmb;
+  __m128i xfinal;
+  HX4_STATS_BEGIN(hx4_x4siphash13_256_sse2)
+
+  rc = hx4_check_params(256/8, in, in_sz, cookie, cookie_sz, out, out_sz);
+  if(rc != HX4_ERR_SUCCESS) {
+    return rc;
+  }
+
+  k0 = U8TO64_LE( (const uint8_t*)cookie );
+  k1 = U8TO64_LE( (const uint8_t*)cookie + 8 );
+  for(lane=0; lane<4; lane++) {
+    v0[lane] = 0x736f6d6570736575ULL ^ k0;
+    v1[lane] = 0x646f72616e646f6dULL ^ k1;
+    v2[lane] = 0x6c7967656e657261ULL ^ k0;
+    v3[lane] = 0x7465646279746573ULL ^ k1;
+  }
+
+  //lanes 0 and 1 live in the a registers, lanes 2 and 3 in the b registers
+  xv0a = _mm_load_si128((__m128i*)v0); xv0b = _mm_load_si128((__m128i*)v0 + 1);
+  xv1a = _mm_load_si128((__m128i*)v1); xv1b = _mm_load_si128((__m128i*)v1 + 1);
+  xv2a = _mm_load_si128((__m128i*)v2); xv2b = _mm_load_si128((__m128i*)v2 + 1);
+  xv3a = _mm_load_si128((__m128i*)v3); xv3b = _mm_load_si128((__m128i*)v3 + 1);
+
+  //main processing loop, one word for every lane
+  p = (const uint8_t*)in;
+  end = p + in_sz - (in_sz % 32);
+  for( ; p != end; p += 32) {
+    xma = _mm_loadu_si128((const __m128i*)p);
+    xmb = _mm_loadu_si128((const __m128i*)(p+16));
+    xv3a = _mm_xor_si128(xv3a, xma);
+    xv3b = _mm_xor_si128(xv3b, xmb);
+    HX4_SSE2_SIPROUND(xv0a, xv1a, xv2a, xv3a)
+    HX4_SSE2_SIPROUND(xv0b, xv1b, xv2b, xv3b)
+    xv0a = _mm_xor_si128(xv0a, xma);
+    xv0b = _mm_xor_si128(xv0b, xmb);
+  }
+
+  _mm_store_si128((__m128i*)v0, xv0a); _mm_store_si128((__m128i*)v0 + 1, xv0b);
+  _mm_store_si128((__m128i*)v1, xv1a); _mm_store_si128((__m128i*)v1 + 1, xv1b);
+  _mm_store_si128((__m128i*)v2, xv2a); _mm_store_si128((__m128i*)v2 + 1, xv2b);
+  _mm_store_si128((__m128i*)v3, xv3a); _mm_store_si128((__m128i*)v3 + 1, xv3b);
+
+  //the remainder holds at most one full word per lane, the lanes
+  //differ here so it is done one lane after the other
+  remainder = in_sz % 32;
+  for(lane=0; lane<4; lane++) {
+    b[lane] = ( ( uint64_t )hx4_x4siphash13_lane_size(in_sz, lane) ) << 56;
+    if((size_t)(8*lane+8) <= remainder) {
+      m = U8TO64_LE( p + 8*lane );
+      v3[lane] ^= m;
+      SIPROUND_LANE(lane);
+      v0[lane] ^= m;
+    } else if((size_t)(8*lane) < remainder) {
+      tail = remainder - 8*lane;
+      for(j=0; j<tail; j++) {
+        b[lane] |= ( ( uint64_t )p[8*lane+j] ) << (8*j);
+      }
+    }
+  }
+
+  //finalization is the same for all lanes again
+  xv0a = _mm_load_si128((__m128i*)v0); xv0b = _mm_load_si128((__m128i*)v0 + 1);
+  xv1a = _mm_load_si128((__m128i*)v1); xv1b = _mm_load_si128((__m128i*)v1 + 1);
+  xv2a = _mm_load_si128((__m128i*)v2); xv2b = _mm_load_si128((__m128i*)v2 + 1);
+  xv3a = _mm_load_si128((__m128i*)v3); xv3b = _mm_load_si128((__m128i*)v3 + 1);
+  xma = _mm_load_si128((__m128i*)b);
+  xmb = _mm_load_si128((__m128i*)b + 1);
+  xfinal = _mm_load_si128((const __m128i*)final_const);
+
+  xv3a = _mm_xor_si128(xv3a, xma);
+  xv3b = _mm_xor_si128(xv3b, xmb);
+  HX4_SSE2_SIPROUND(xv0a, xv1a, xv2a, xv3a)
+  HX4_SSE2_SIPROUND(xv0b, xv1b, xv2b, xv3b)
+  xv0a = _mm_xor_si128(xv0a, xma);
+  xv0b = _mm_xor_si128(xv0b, xmb);
+
+  xv2a = _mm_xor_si128(xv2a, xfinal);
+  xv2b = _mm_xor_si128(xv2b, xfinal);
+  HX4_SSE2_SIPROUND(xv0a, xv1a, xv2a, xv3a)
+  HX4_SSE2_SIPROUND(xv0b, xv1b, xv2b, xv3b)
+  HX4_SSE2_SIPROUND(xv0a, xv1a, xv2a, xv3a)
+  HX4_SSE2_SIPROUND(xv0b, xv1b, xv2b, xv3b)
+  HX4_SSE2_SIPROUND(xv0a, xv1a, xv2a, xv3a)
+  HX4_SSE2_SIPROUND(xv0b, xv1b, xv2b, xv3b)
+
+  xv0a = _mm_xor_si128(_mm_xor_si128(xv0a, xv1a), _mm_xor_si128(xv2a, xv3a));
+  xv0b = _mm_xor_si128(_mm_xor_si128(xv0b, xv1b), _mm_xor_si128(xv2b, xv3b));
+  _mm_storeu_si128((__m128i*)out, xv0a);
+  _mm_storeu_si128((__m128i*)out + 1, xv0b);
+
+  HX4_STATS_END(hx4_x4siphash13_256_sse2, in_sz)
+  return HX4_ERR_SUCCESS;
+}
+
+//the finalization of hx4_x4siphash13_256_sse2 run over the carry
+HX4_API void hx4_x4siphash13_256_sse2_final(hx4_x4siphash_stream *stream, void *out) {
+  uint64_t * const v0 = stream->v0;
+  uint64_t * const v1 = stream->v1;
+  uint64_t * const v2 = stream->v2;
+  uint64_t * const v3 = stream->v3;
+  const uint8_t * const p = stream->carry;
+  const size_t remainder = (size_t)(stream->pos % 32);
+  HX4_ALIGNED(uint64_t b[4], 16);
+  HX4_ALIGNED(const uint64_t final_const[2], 16) = { 0xff, 0xff };
+  uint64_t m;
+  size_t tail;
+  size_t j;
+  int lane;
+  __m128i xv0a, xv1a, xv2a, xv3a;
+  __m128i xv0b, xv1b, xv2b, xv3b;
+  __m128i xma, xmb;
+  __m128i xfinal;
+
+  for(lane=0; lane<4; lane++) {
+    b[lane] = ( ( uint64_t )hx4_x4siphash13_lane_size((size_t)stream->pos, lane) ) << 56;
+    if((size_t)(8*lane+8) <= remainder) {
+      m = U8TO64_LE( p + 8*lane );
+      v3[lane] ^= m;
+      SIPROUND_LANE(lane);
+      v0[lane] ^= m;
+    } else if((size_t)(8*lane) < remainder) {
+      tail = remainder - 8*lane;
+      for(j=0; j<tail; j++) {
+        b[lane] |= ( ( uint64_t )p[8*lane+j] ) << (8*j);
+      }
+    }
+  }
+
+  xv0a = _mm_load_si128((__m128i*)v0); xv0b = _mm_load_si128((__m128i*)v0 + 1);
+  xv1a = _mm_load_si128((__m128i*)v1); xv1b = _mm_load_si128((__m128i*)v1 + 1);
+  xv2a = _mm_load_si128((__m128i*)v2); xv2b = _mm_load_si128((__m128i*)v2 + 1);
+  xv3a = _mm_load_si128((__m128i*)v3); xv3b = _mm_load_si128((__m128i*)v3 + 1);
+  xma = _mm_load_si128((__m128i*)b);
+  xmb = _mm_load_si128((__m128i*)b + 1);
+  xfinal = _mm_load_si128((const __m128i*)final_const);
+
+  xv3a = _mm_xor_si128(xv3a, xma);
+  xv3b = _mm_xor_si128(xv3b, xmb);
+  HX4_SSE2_SIPROUND(xv0a, xv1a, xv2a, xv3a)
+  HX4_SSE2_SIPROUND(xv0b, xv1b, xv2b, xv3b)
+  xv0a = _mm_xor_si128(xv0a, xma);
+  xv0b = _mm_xor_si128(xv0b, xmb);
+
+  xv2a = _mm_xor_si128(xv2a, xfinal);
+  xv2b = _mm_xor_si128(xv2b, xfinal);
+  HX4_SSE2_SIPROUND(xv0a, xv1a, xv2a, xv3a)
+  HX4_SSE2_SIPROUND(xv0b, xv1b, xv2b, xv3b)
+  HX4_SSE2_SIPROUND(xv0a, xv1a, xv2a, xv3a)
+  HX4_SSE2_SIPROUND(xv0b, xv1b, xv2b, xv3b)
+  HX4_SSE2_SIPROUND(xv0a, xv1a, xv2a, xv3a)
+  HX4_SSE2_SIPROUND(xv0b, xv1b, xv2b, xv3b)
+
+  xv0a = _mm_xor_si128(_mm_xor_si128(xv0a, xv1a), _mm_xor_si128(xv2a, xv3a));
+  xv0b = _mm_xor_si128(_mm_xor_si128(xv0b, xv1b), _mm_xor_si128(xv2b, xv3b));
+  _mm_storeu_si128((__m128i*)out, xv0a);
+  _mm_storeu_si128((__m128i*)out + 1, xv0b);
+}
+
+//lanes 0 and 1 in the a registers, lanes 2 and 3 in the b registers
+#define HX4_SSE2_X4SIPHASH13_WORDS(p) \
+    xma = _mm_loadu_si128((const __m128i*)(p)); \
+    xmb = _mm_loadu_si128((const __m128i*)(p) + 1); \
+    xv3a = _mm_xor_si128(xv3a, xma); \
+    xv3b = _mm_xor_si128(xv3b, xmb); \
+    HX4_SSE2_SIPROUND(xv0a, xv1a, xv2a, xv3a) \
+    HX4_SSE2_SIPROUND(xv0b, xv1b, xv2b, xv3b) \
+    xv0a = _mm_xor_si128(xv0a, xma); \
+    xv0b = _mm_xor_si128(xv0b, xmb);
+
+HX4_API void hx4_x4siphash13_256_sse2_update(hx4_x4siphash_stream *stream, const void *in, size_t in_sz) {
+  const uint8_t *p = (const uint8_t*)in;
+  const uint8_t * const p_end = p + in_sz;
+  const size_t carry_sz = (size_t)(stream->pos % 32);
+  __m128i xv0a, xv1a, xv2a, xv3a;
+  __m128i xv0b, xv1b, xv2b, xv3b;
+  __m128i xma, xmb;
+
+  stream->pos += in_sz;
+
+  //not yet a word for every lane
+  if(carry_sz + in_sz < 32) {
+    memcpy(stream->carry + carry_sz, p, in_sz);
+    return;
+  }
+
+  xv0a = _mm_load_si128((__m128i*)stream->v0); xv0b = _mm_load_si128((__m128i*)stream->v0 + 1);
+  xv1a = _mm_load_si128((__m128i*)stream->v1); xv1b = _mm_load_si128((__m128i*)stream->v1 + 1);
+  xv2a = _mm_load_si128((__m128i*)stream->v2); xv2b = _mm_load_si128((__m128i*)stream->v2 + 1);
+  xv3a = _mm_load_si128((__m128i*)stream->v3); xv3b = _mm_load_si128((__m128i*)stream->v3 + 1);
+
+  //complete the words that were started by the previous piece
+  if(carry_sz > 0) {
+    memcpy(stream->carry + carry_sz, p, 32 - carry_sz);
+    p += 32 - carry_sz;
+    HX4_SSE2_X4SIPHASH13_WORDS(stream->carry)
+  }
+
+  //main processing loop, one word for every lane
+  for( ; p_end - p >= 32; p += 32) {
+    HX4_SSE2_X4SIPHASH13_WORDS(p)
+  }
+
+  _mm_store_si128((__m128i*)stream->v0, xv0a); _mm_store_si128((__m128i*)stream->v0 + 1, xv0b);
+  _mm_store_si128((__m128i*)stream->v1, xv1a); _mm_store_si128((__m128i*)stream->v1 + 1, xv1b);
+  _mm_store_si128((__m128i*)stream->v2, xv2a); _mm_store_si128((__m128i*)stream->v2 + 1, xv2b);
+  _mm_store_si128((__m128i*)stream->v3, xv3a); _mm_store_si128((__m128i*)stream->v3 + 1, xv3b);
+
+  memcpy(stream->carry, p, (size_t)(p_end - p));
+}
+
+HX4_STREAM_V_IMPL(hx4_x4siphash13_256_sse2, hx4_x4siphash_stream, 256/8, hx4_x4siphash13_256_init, hx4_x4siphash13_256_sse2_final)
+HX4_STREAM_CSTR_STRLEN_IMPL(hx4_x4siphash13_256_sse2)
+
+/* copy-and-hash, stores every loaded register to dst before it is hashed,
+ * large copies to an aligned dst use non-temporal stores */
+HX4_API void hx4_x4siphash13_256_sse2_copy_update(hx4_x4siphash_stream *stream, void *dst, const void *in, size_t in_sz) {
+  const uint8_t *p = (const uint8_t*)in;
+  const uint8_t * const p_end = p + in_sz;
+  const size_t carry_sz = (size_t)(stream->pos % 32);
+  uint8_t *q = (uint8_t*)dst;
+  int stream_stores;
+  __m128i xv0a, xv1a, xv2a, xv3a;
+  __m128i xv0b, xv1b, xv2b, xv3b;
+  __m128i xma, xmb;
+
+  stream->pos += in_sz;
+
+  //not yet a word for every lane
+  if(carry_sz + in_sz < 32) {
+    memcpy(q, p, in_sz);
+    memcpy(stream->carry + carry_sz, p, in_sz);
+    return;
+  }
+
+  xv0a = _mm_load_si128((__m128i*)stream->v0); xv0b = _mm_load_si128((__m128i*)stream->v0 + 1);
+  xv1a = _mm_load_si128((__m128i*)stream->v1); xv1b = _mm_load_si128((__m128i*)stream->v1 + 1);
+  xv2a = _mm_load_si128((__m128i*)stream->v2); xv2b = _mm_load_si128((__m128i*)stream->v2 + 1);
+  xv3a = _mm_load_si128((__m128i*)stream->v3); xv3b = _mm_load_si128((__m128i*)stream->v3 + 1);
+
+  //complete the words that were started by the previous piece
+  if(carry_sz > 0) {
+    memcpy(q, p, 32 - carry_sz);
+    memcpy(stream->carry + carry_sz, p, 32 - carry_sz);
+    p += 32 - carry_sz;
+    q += 32 - carry_sz;
+    HX4_SSE2_X4SIPHASH13_WORDS(stream->carry)
+  }
+
+  stream_stores = in_sz >= HX4_COPY_STREAM_MIN_SIZE && hx4_bytes_to_aligned(q, 16) == 0;
+
+  //main processing loop, one word for every lane
+  for( ; p_end - p >= 32; p += 32, q += 32) {
+    HX4_SSE2_X4SIPHASH13_WORDS(p)
+    if(stream_stores) {
+      _mm_stream_si128((__m128i*)q, xma);
+      _mm_stream_si128((__m128i*)q + 1, xmb);
+    } else {
+      _mm_storeu_si128((__m128i*)q, xma);
+      _mm_storeu_si128((__m128i*)q + 1, xmb);
+    }
+  }
+
+  //the non-temporal stores are weakly ordered
+  if(stream_stores) {
+    _mm_sfence();
+  }
+
+  _mm_store_si128((__m128i*)stream->v0, xv0a); _mm_store_si128((__m128i*)stream->v0 + 1, xv0b);
+  _mm_store_si128((__m128i*)stream->v1, xv1a); _mm_store_si128((__m128i*)stream->v1 + 1, xv1b);
+  _mm_store_si128((__m128i*)stream->v2, xv2a); _mm_store_si128((__m128i*)stream->v2 + 1, xv2b);
+  _mm_store_si128((__m128i*)stream->v3, xv3a); _mm_store_si128((__m128i*)stream->v3 + 1, xv3b);
+
+  memcpy(q, p, (size_t)(p_end - p));
+  memcpy(stream->carry, p, (size_t)(p_end - p));
+}
+
+HX4_STREAM_COPY_IMPL(hx4_x4siphash13_256_sse2, hx4_x4siphash_stream, 256/8, hx4_x4siphash13_256_init, hx4_x4siphash13_256_sse2_final)
+
+#undef HX4_SSE2_X4SIPHASH13_WORDS
+
+#undef HX4_SSE2_SIPROUND
+#undef HX4_SSE2_ROTL64_32
+#undef HX4_SSE2_ROTL64_16
+#undef HX4_SSE2_ROTL64
+#endif //HX4_HAS_SSE2
+
+#undef ROTL
+#undef SIPROUND
+#undef SIPROUND_LANE
+#undef U32TO8_LE
+#undef U64TO8_LE
+#undef U8TO64_LE
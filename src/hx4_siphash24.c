@@ -1,7 +1,10 @@
+#include <stddef.h>
 #include <stdint.h>
+#include <string.h>
 
 #include "hashx4.h"
 #include "hx4_util.h"
+#include "hx4_stream.h"
 
 #define ROTL(x,b) (uint64_t)( ((x) << (b)) | ( (x) >> (64 - (b))) )
 
@@ -88,12 +91,211 @@ static int hx4_siphash24_64_copt_impl(const uint8_t *in, size_t in_sz, const uin
 
 
 
-int hx4_siphash24_64_copt(const void *in, size_t in_sz, const void *cookie, size_t cookie_sz, void *out, size_t out_sz) {
+HX4_API int hx4_siphash24_64_copt(const void *in, size_t in_sz, const void *cookie, size_t cookie_sz, void *out, size_t out_sz) {
   int rc;
+  HX4_STATS_BEGIN(hx4_siphash24_64_copt)
   rc = hx4_check_params(64/8, in, in_sz, cookie, cookie_sz, out, out_sz);
   if(rc != HX4_ERR_SUCCESS) {
     return rc;
   }
-  return hx4_siphash24_64_copt_impl(in, in_sz, cookie, cookie_sz, out, out_sz);
+  rc = hx4_siphash24_64_copt_impl((const uint8_t*)in, in_sz, (const uint8_t*)cookie, cookie_sz, (uint8_t*)out, out_sz);
+  HX4_STATS_END(hx4_siphash24_64_copt, in_sz)
+  return rc;
 }
- 
+
+HX4_API void hx4_siphash24_64_init(hx4_siphash_stream *stream, const void *cookie) {
+  uint64_t k0, k1;
+
+  k0 = U8TO64_LE( (const uint8_t*)cookie );
+  k1 = U8TO64_LE( (const uint8_t*)cookie + 8 );
+  memset(stream, 0, sizeof(*stream));
+  stream->v[0] = 0x736f6d6570736575ULL ^ k0;
+  stream->v[1] = 0x646f72616e646f6dULL ^ k1;
+  stream->v[2] = 0x6c7967656e657261ULL ^ k0;
+  stream->v[3] = 0x7465646279746573ULL ^ k1;
+  memcpy(stream->cookie, cookie, sizeof(stream->cookie));
+}
+
+HX4_API void hx4_siphash24_64_final(hx4_siphash_stream *stream, void *out) {
+  uint64_t v0 = stream->v[0];
+  uint64_t v1 = stream->v[1];
+  uint64_t v2 = stream->v[2];
+  uint64_t v3 = stream->v[3];
+  uint64_t b;
+  size_t i;
+
+  b = ( ( uint64_t )stream->pos ) << 56;
+  for(i=0; i<(size_t)(stream->pos & 7); i++) {
+    b |= ( ( uint64_t )stream->carry[i] ) << (8*i);
+  }
+
+  v3 ^= b;
+  SIPROUND;
+  SIPROUND;
+  v0 ^= b;
+
+  v2 ^= 0xff;
+  SIPROUND;
+  SIPROUND;
+  SIPROUND;
+  SIPROUND;
+  b = v0 ^ v1 ^ v2  ^ v3;
+  U64TO8_LE( (uint8_t*)out, b );
+}
+
+//bytewise through the carry, the straightforward way
+HX4_API void hx4_siphash24_64_ref_update(hx4_siphash_stream *stream, const void *in, size_t in_sz) {
+  const uint8_t *p = (const uint8_t*)in;
+  uint64_t v0 = stream->v[0];
+  uint64_t v1 = stream->v[1];
+  uint64_t v2 = stream->v[2];
+  uint64_t v3 = stream->v[3];
+  uint64_t m;
+  size_t i;
+
+  for(i=0; i<in_sz; i++) {
+    stream->carry[stream->pos & 7] = p[i];
+    stream->pos++;
+    if((stream->pos & 7) == 0) {
+      m = U8TO64_LE( stream->carry );
+      v3 ^= m;
+      SIPROUND;
+      SIPROUND;
+      v0 ^= m;
+    }
+  }
+
+  stream->v[0] = v0;
+  stream->v[1] = v1;
+  stream->v[2] = v2;
+  stream->v[3] = v3;
+}
+
+//completes the carried word, then runs the word loop of the one shot function
+HX4_API void hx4_siphash24_64_copt_update(hx4_siphash_stream *stream, const void *in, size_t in_sz) {
+  const uint8_t *p = (const uint8_t*)in;
+  const uint8_t * const p_end = p + in_sz;
+  size_t carry_sz = (size_t)(stream->pos & 7);
+  uint64_t v0 = stream->v[0];
+  uint64_t v1 = stream->v[1];
+  uint64_t v2 = stream->v[2];
+  uint64_t v3 = stream->v[3];
+  uint64_t m;
+
+  stream->pos += in_sz;
+
+  if(carry_sz > 0) {
+    while(carry_sz < 8 && p < p_end) {
+      stream->carry[carry_sz++] = *p++;
+    }
+    if(carry_sz < 8) {
+      return;
+    }
+    m = U8TO64_LE( stream->carry );
+    v3 ^= m;
+    SIPROUND;
+    SIPROUND;
+    v0 ^= m;
+  }
+
+  for( ; p_end - p >= 8; p += 8) {
+    m = U8TO64_LE( p );
+    v3 ^= m;
+    SIPROUND;
+    SIPROUND;
+    v0 ^= m;
+  }
+
+  memcpy(stream->carry, p, (size_t)(p_end - p));
+
+  stream->v[0] = v0;
+  stream->v[1] = v1;
+  stream->v[2] = v2;
+  stream->v[3] = v3;
+}
+
+HX4_STREAM_V_IMPL(hx4_siphash24_64_ref, hx4_siphash_stream, 64/8, hx4_siphash24_64_init, hx4_siphash24_64_final)
+HX4_STREAM_CSTR_STRLEN_IMPL(hx4_siphash24_64_ref)
+HX4_STREAM_V_IMPL(hx4_siphash24_64_copt, hx4_siphash_stream, 64/8, hx4_siphash24_64_init, hx4_siphash24_64_final)
+HX4_STREAM_CSTR_STRLEN_IMPL(hx4_siphash24_64_copt)
+
+//case-insensitive updates, A-Z are folded as they are read, the copt one folds whole words
+HX4_API void hx4_siphash24_64_ref_ci_update(hx4_siphash_stream *stream, const void *in, size_t in_sz) {
+  const uint8_t *p = (const uint8_t*)in;
+  uint64_t v0 = stream->v[0];
+  uint64_t v1 = stream->v[1];
+  uint64_t v2 = stream->v[2];
+  uint64_t v3 = stream->v[3];
+  uint64_t m;
+  size_t i;
+
+  for(i=0; i<in_sz; i++) {
+    stream->carry[stream->pos & 7] = hx4_ascii_tolower(p[i]);
+    stream->pos++;
+    if((stream->pos & 7) == 0) {
+      m = U8TO64_LE( stream->carry );
+      v3 ^= m;
+      SIPROUND;
+      SIPROUND;
+      v0 ^= m;
+    }
+  }
+
+  stream->v[0] = v0;
+  stream->v[1] = v1;
+  stream->v[2] = v2;
+  stream->v[3] = v3;
+}
+
+HX4_API void hx4_siphash24_64_copt_ci_update(hx4_siphash_stream *stream, const void *in, size_t in_sz) {
+  const uint8_t *p = (const uint8_t*)in;
+  const uint8_t * const p_end = p + in_sz;
+  size_t carry_sz = (size_t)(stream->pos & 7);
+  uint64_t v0 = stream->v[0];
+  uint64_t v1 = stream->v[1];
+  uint64_t v2 = stream->v[2];
+  uint64_t v3 = stream->v[3];
+  uint64_t m;
+
+  stream->pos += in_sz;
+
+  if(carry_sz > 0) {
+    while(carry_sz < 8 && p < p_end) {
+      stream->carry[carry_sz++] = hx4_ascii_tolower(*p++);
+    }
+    if(carry_sz < 8) {
+      return;
+    }
+    m = U8TO64_LE( stream->carry );
+    v3 ^= m;
+    SIPROUND;
+    SIPROUND;
+    v0 ^= m;
+  }
+
+  for( ; p_end - p >= 8; p += 8) {
+    m = hx4_ascii_tolower64(U8TO64_LE( p ));
+    v3 ^= m;
+    SIPROUND;
+    SIPROUND;
+    v0 ^= m;
+  }
+
+  for(carry_sz=0; p < p_end; carry_sz++) {
+    stream->carry[carry_sz] = hx4_ascii_tolower(*p++);
+  }
+
+  stream->v[0] = v0;
+  stream->v[1] = v1;
+  stream->v[2] = v2;
+  stream->v[3] = v3;
+}
+
+HX4_STREAM_CI_IMPL(hx4_siphash24_64_ref, hx4_siphash_stream, 64/8, hx4_siphash24_64_init, hx4_siphash24_64_final)
+HX4_STREAM_CI_IMPL(hx4_siphash24_64_copt, hx4_siphash_stream, 64/8, hx4_siphash24_64_init, hx4_siphash24_64_final)
+
+#undef ROTL
+#undef SIPROUND
+#undef U32TO8_LE
+#undef U64TO8_LE
+#undef U8TO64_LE
@@ -0,0 +1,629 @@
+/* 
+ * Copyright 2015 Kai Dietrich <mail@cleeus.de>
+ *
+ * This file is part of hashx4.
+ *
+ * Hashx4 is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Hashx4 is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with hashx4.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "hashx4_config.h"
+
+#if HX4_HAS_SSE2
+# include <emmintrin.h>
+#endif
+
+#include "hashx4.h"
+#include "hashx4_sketch.h"
+#include "hx4_util.h"
+
+// number of keys hashed in one go by the batch functions
+#define HX4_SKETCH_HASH_BLOCK 256
+
+// Count-Min keys whose rows are prefetched ahead of the updates
+#define HX4_CMS_PREFETCH_GROUP 8
+
+#define U8TO32_LE(p)                                                           \
+  (((uint32_t)((p)[0])) | ((uint32_t)((p)[1]) << 8) |                          \
+   ((uint32_t)((p)[2]) << 16) | ((uint32_t)((p)[3]) << 24))
+
+#define U8TO64_LE(p) \
+  (((uint64_t)U8TO32_LE(p)) | ((uint64_t)U8TO32_LE((p) + 4) << 32))
+
+static int hx4_sketch_hash(const uint8_t *cookie, const void *key, size_t key_sz, uint64_t *hash) {
+  uint8_t out[64/8];
+  int rc;
+
+  rc = hx4_siphash13_64_copt(key, key_sz, cookie, 128/8, out, sizeof(out));
+  *hash = U8TO64_LE(out);
+  return rc;
+}
+
+static int hx4_clz64(uint64_t x) {
+#ifdef __GNUC__
+  return __builtin_clzll(x);
+#else
+  int n = 0;
+  while(!(x & (( ( uint64_t )1 ) << 63))) {
+    x <<= 1;
+    n++;
+  }
+  return n;
+#endif
+}
+
+/* HyperLogLog */
+
+// a sparse entry is the register index and the rank at the sparse precision
+// (the rank is at most 64 - 25 + 1 = 40), sorting them sorts by index then rank
+#define HX4_HLL_SPARSE_PRECISION 25
+#define HX4_HLL_ENTRY(index, rank) ( ((uint32_t)(index) << 6) | (uint32_t)(rank) )
+#define HX4_HLL_ENTRY_INDEX(entry) ( (entry) >> 6 )
+#define HX4_HLL_ENTRY_RANK(entry) ( (uint8_t)((entry) & 0x3f) )
+
+int hx4_hll_init(hx4_hll *hll, int precision, void *memory, size_t memory_sz, const void *cookie, size_t cookie_sz) {
+  size_t m;
+
+  if(!hll || !memory || !cookie) {
+    return HX4_ERR_PARAM_INVALID;
+  }
+  if(precision < HX4_HLL_MIN_PRECISION || precision > HX4_HLL_MAX_PRECISION) {
+    return HX4_ERR_PARAM_INVALID;
+  }
+  if(cookie_sz < 128/8) {
+    return HX4_ERR_COOKIE_TOO_SMALL;
+  }
+  if(memory_sz < HX4_HLL_MEMORY_SIZE(precision)) {
+    return HX4_ERR_BUFFER_TOO_SMALL;
+  }
+
+  m = (size_t)1 << precision;
+  hll->registers = (uint8_t*)memory + hx4_bytes_to_aligned(memory, 16);
+  hll->sparse = (uint32_t*)(hll->registers + m);
+  hll->sparse_count = 0;
+  hll->sparse_capacity = m / 8;
+  hll->precision = precision;
+  hll->dense = 0;
+  memcpy(hll->cookie, cookie, sizeof(hll->cookie));
+
+  return HX4_ERR_SUCCESS;
+}
+
+static int hx4_hll_compare_entries(const void *a, const void *b) {
+  uint32_t ea = *(const uint32_t*)a;
+  uint32_t eb = *(const uint32_t*)b;
+  return ea < eb ? -1 : (ea > eb ? 1 : 0);
+}
+
+// sorts the sparse list and keeps the highest rank of every register
+static void hx4_hll_compact(hx4_hll *hll) {
+  size_t out = 0;
+  size_t i;
+
+  if(hll->sparse_count == 0) {
+    return;
+  }
+  qsort(hll->sparse, hll->sparse_count, sizeof(uint32_t), hx4_hll_compare_entries);
+  for(i=0; i<hll->sparse_count; i++) {
+    if(i+1 < hll->sparse_count && HX4_HLL_ENTRY_INDEX(hll->sparse[i]) == HX4_HLL_ENTRY_INDEX(hll->sparse[i+1])) {
+      continue;
+    }
+    hll->sparse[out++] = hll->sparse[i];
+  }
+  hll->sparse_count = out;
+}
+
+// folds a sparse entry down to the dense precision: the top bits of the index
+// select the register, the bits below them are the start of the bit string
+// the dense rank counts in, only when they are all zero the sparse rank adds
+static void hx4_hll_add_dense(hx4_hll *hll, uint32_t entry) {
+  int shift = HX4_HLL_SPARSE_PRECISION - hll->precision;
+  uint32_t index = HX4_HLL_ENTRY_INDEX(entry);
+  uint32_t low = index & ((( uint32_t )1 << shift) - 1);
+  uint8_t rank;
+
+  if(low != 0) {
+    rank = (uint8_t)(hx4_clz64((uint64_t)low << (64 - shift)) + 1);
+  } else {
+    rank = (uint8_t)(shift + HX4_HLL_ENTRY_RANK(entry));
+  }
+  index >>= shift;
+  if(hll->registers[index] < rank) {
+    hll->registers[index] = rank;
+  }
+}
+
+static void hx4_hll_densify(hx4_hll *hll) {
+  size_t i;
+
+  memset(hll->registers, 0, (size_t)1 << hll->precision);
+  for(i=0; i<hll->sparse_count; i++) {
+    hx4_hll_add_dense(hll, hll->sparse[i]);
+  }
+  hll->sparse_count = 0;
+  hll->dense = 1;
+}
+
+// the list switches to dense registers once it holds more than this many
+// distinct entries after a compaction
+#define HX4_HLL_SPARSE_LIMIT(hll) ( (hll)->sparse_capacity / 4 * 3 )
+
+static void hx4_hll_add_sparse(hx4_hll *hll, uint32_t entry) {
+  if(hll->sparse_count == hll->sparse_capacity) {
+    hx4_hll_compact(hll);
+    if(hll->sparse_count > HX4_HLL_SPARSE_LIMIT(hll)) {
+      hx4_hll_densify(hll);
+      hx4_hll_add_dense(hll, entry);
+      return;
+    }
+  }
+  hll->sparse[hll->sparse_count++] = entry;
+}
+
+int hx4_hll_add_hashes(hx4_hll *hll, const uint64_t *hashes, size_t n) {
+  uint8_t *registers;
+  uint64_t hash;
+  uint64_t marker;
+  size_t index;
+  uint8_t rank;
+  size_t i;
+  int p;
+
+  if(!hll || !hll->registers || !hashes) {
+    return HX4_ERR_PARAM_INVALID;
+  }
+
+  //the top bits select the register, the rank is the position of the first one
+  //bit in the rest, the marker bit limits it to 64 - p + 1
+  p = HX4_HLL_SPARSE_PRECISION;
+  marker = ( ( uint64_t )1 ) << (p - 1);
+  for(i=0; i<n && !hll->dense; i++) {
+    hash = hashes[i];
+    hx4_hll_add_sparse(hll, HX4_HLL_ENTRY(hash >> (64 - p), hx4_clz64((hash << p) | marker) + 1));
+  }
+
+  p = hll->precision;
+  marker = ( ( uint64_t )1 ) << (p - 1);
+  registers = hll->registers;
+  for( ; i<n; i++) {
+    hash = hashes[i];
+    index = (size_t)(hash >> (64 - p));
+    rank = (uint8_t)(hx4_clz64((hash << p) | marker) + 1);
+    if(registers[index] < rank) {
+      registers[index] = rank;
+    }
+  }
+
+  return HX4_ERR_SUCCESS;
+}
+
+int hx4_hll_add(hx4_hll *hll, const void *key, size_t key_sz) {
+  uint64_t hash;
+  int rc;
+
+  if(!hll) {
+    return HX4_ERR_PARAM_INVALID;
+  }
+  rc = hx4_sketch_hash(hll->cookie, key, key_sz, &hash);
+  if(rc != HX4_ERR_SUCCESS) {
+    return rc;
+  }
+  return hx4_hll_add_hashes(hll, &hash, 1);
+}
+
+int hx4_hll_add_batch(hx4_hll *hll, const void *const *keys, const size_t *key_sizes, size_t n) {
+  uint64_t hashes[HX4_SKETCH_HASH_BLOCK];
+  size_t block;
+  size_t i;
+  size_t j;
+  int rc;
+
+  if(!hll || !keys || !key_sizes) {
+    return HX4_ERR_PARAM_INVALID;
+  }
+  for(i=0; i<n; i+=block) {
+    block = n - i < HX4_SKETCH_HASH_BLOCK ? n - i : HX4_SKETCH_HASH_BLOCK;
+    for(j=0; j<block; j++) {
+      rc = hx4_sketch_hash(hll->cookie, keys[i+j], key_sizes[i+j], &hashes[j]);
+      if(rc != HX4_ERR_SUCCESS) {
+        return rc;
+      }
+    }
+    rc = hx4_hll_add_hashes(hll, hashes, block);
+    if(rc != HX4_ERR_SUCCESS) {
+      return rc;
+    }
+  }
+  return HX4_ERR_SUCCESS;
+}
+
+int hx4_hll_add_u64_batch(hx4_hll *hll, const uint64_t *keys, size_t n) {
+  uint64_t hashes[HX4_SKETCH_HASH_BLOCK];
+  size_t block;
+  size_t i;
+  int rc;
+
+  if(!hll || !keys) {
+    return HX4_ERR_PARAM_INVALID;
+  }
+  for(i=0; i<n; i+=block) {
+    block = n - i < HX4_SKETCH_HASH_BLOCK ? n - i : HX4_SKETCH_HASH_BLOCK;
+    rc = hx4_hash_u64_array(keys + i, block, hll->cookie, sizeof(hll->cookie), hashes);
+    if(rc != HX4_ERR_SUCCESS) {
+      return rc;
+    }
+    rc = hx4_hll_add_hashes(hll, hashes, block);
+    if(rc != HX4_ERR_SUCCESS) {
+      return rc;
+    }
+  }
+  return HX4_ERR_SUCCESS;
+}
+
+int hx4_hll_merge(hx4_hll *dst, const hx4_hll *src) {
+  size_t m;
+  size_t i;
+
+  if(!dst || !src || !dst->registers || !src->registers) {
+    return HX4_ERR_PARAM_INVALID;
+  }
+  if(dst->precision != src->precision || memcmp(dst->cookie, src->cookie, sizeof(dst->cookie)) != 0) {
+    return HX4_ERR_PARAM_INVALID;
+  }
+
+  if(!src->dense) {
+    for(i=0; i<src->sparse_count; i++) {
+      if(dst->dense) {
+        hx4_hll_add_dense(dst, src->sparse[i]);
+      } else {
+        hx4_hll_add_sparse(dst, src->sparse[i]);
+      }
+    }
+    return HX4_ERR_SUCCESS;
+  }
+
+  if(!dst->dense) {
+    hx4_hll_densify(dst);
+  }
+
+  //the union of two sets is the register wise maximum
+  m = (size_t)1 << dst->precision;
+  i = 0;
+#if HX4_HAS_SSE2
+  for( ; i+16 <= m; i+=16) {
+    _mm_store_si128((__m128i*)(dst->registers + i), _mm_max_epu8(
+      _mm_load_si128((const __m128i*)(dst->registers + i)),
+      _mm_load_si128((const __m128i*)(src->registers + i))));
+  }
+#endif
+  for( ; i<m; i++) {
+    if(dst->registers[i] < src->registers[i]) {
+      dst->registers[i] = src->registers[i];
+    }
+  }
+
+  return HX4_ERR_SUCCESS;
+}
+
+int hx4_hll_estimate(hx4_hll *hll, double *estimate) {
+  size_t histogram[65];
+  size_t m;
+  size_t zeros;
+  size_t i;
+  double alpha;
+  double sum;
+  double e;
+
+  if(!hll || !hll->registers || !estimate) {
+    return HX4_ERR_PARAM_INVALID;
+  }
+
+  //a sparse list that holds more than the limit goes dense here as well, so
+  //the estimate of a set does not depend on the order it was added in
+  if(!hll->dense) {
+    hx4_hll_compact(hll);
+    if(hll->sparse_count > HX4_HLL_SPARSE_LIMIT(hll)) {
+      hx4_hll_densify(hll);
+    }
+  }
+
+  //the sparse list is linear counting over 2^25 registers, nearly exact for
+  //the few keys it holds
+  if(!hll->dense) {
+    m = (size_t)1 << HX4_HLL_SPARSE_PRECISION;
+    *estimate = (double)m * log((double)m / (double)(m - hll->sparse_count));
+    return HX4_ERR_SUCCESS;
+  }
+
+  //the estimate only depends on how many registers hold which rank
+  memset(histogram, 0, sizeof(histogram));
+  m = (size_t)1 << hll->precision;
+  for(i=0; i<m; i++) {
+    histogram[hll->registers[i]]++;
+  }
+
+  sum = 0;
+  for(i=0; i<65; i++) {
+    sum += (double)histogram[i] * ldexp(1.0, -(int)i);
+  }
+  zeros = histogram[0];
+
+  switch(m) {
+    case 16: alpha = 0.673; break;
+    case 32: alpha = 0.697; break;
+    case 64: alpha = 0.709; break;
+    default: alpha = 0.7213 / (1.0 + 1.079 / (double)m); break;
+  }
+  e = alpha * (double)m * (double)m / sum;
+
+  //linear counting is better while many registers are still empty, with
+  //64bit hashes there is no large range correction
+  if(e <= 2.5 * (double)m && zeros != 0) {
+    e = (double)m * log((double)m / (double)zeros);
+  }
+
+  *estimate = e;
+  return HX4_ERR_SUCCESS;
+}
+
+#undef HX4_HLL_SPARSE_LIMIT
+#undef HX4_HLL_ENTRY_RANK
+#undef HX4_HLL_ENTRY_INDEX
+#undef HX4_HLL_ENTRY
+#undef HX4_HLL_SPARSE_PRECISION
+
+/* Count-Min */
+
+int hx4_cms_init(hx4_cms *cms, size_t width, int depth, void *memory, size_t memory_sz, const void *cookie, size_t cookie_sz) {
+  if(!cms || !memory || !cookie) {
+    return HX4_ERR_PARAM_INVALID;
+  }
+  if(width == 0 || (width & (width - 1)) != 0 || (uint64_t)width > (( ( uint64_t )1 ) << 32)) {
+    return HX4_ERR_PARAM_INVALID;
+  }
+  if(depth < 1 || depth > HX4_CMS_MAX_DEPTH) {
+    return HX4_ERR_PARAM_INVALID;
+  }
+  if(cookie_sz < 128/8) {
+    return HX4_ERR_COOKIE_TOO_SMALL;
+  }
+  if(memory_sz < HX4_CMS_MEMORY_SIZE(width, depth)) {
+    return HX4_ERR_BUFFER_TOO_SMALL;
+  }
+  if(hx4_bytes_to_aligned(memory, sizeof(uint32_t)) != 0) {
+    return HX4_ERR_PARAM_INVALID;
+  }
+
+  cms->counters = memory;
+  cms->width = width;
+  cms->depth = depth;
+  memcpy(cms->cookie, cookie, sizeof(cms->cookie));
+  memset(cms->counters, 0, HX4_CMS_MEMORY_SIZE(width, depth));
+
+  return HX4_ERR_SUCCESS;
+}
+
+// the counter of row i, double hashing with the two halves of the hash
+#define HX4_CMS_COUNTER(cms, hash, i) \
+  ( (cms)->counters + (i) * (cms)->width + \
+    (((size_t)(uint32_t)(hash) + (size_t)(i) * (size_t)((uint32_t)((hash) >> 32) | 1)) & ((cms)->width - 1)) )
+
+static void hx4_cms_add_hash(hx4_cms *cms, uint64_t hash, uint32_t count) {
+  uint32_t *counter;
+  int i;
+  for(i=0; i<cms->depth; i++) {
+    counter = HX4_CMS_COUNTER(cms, hash, i);
+    //saturate instead of wrapping around to a small count
+    *counter = *counter + count < *counter ? UINT32_MAX : *counter + count;
+  }
+}
+
+static void hx4_cms_prefetch_hash(const hx4_cms *cms, uint64_t hash) {
+#if HX4_HAS_SSE2
+  int i;
+  for(i=0; i<cms->depth; i++) {
+    _mm_prefetch((const char*)HX4_CMS_COUNTER(cms, hash, i), _MM_HINT_T0);
+  }
+#else
+  (void)cms;
+  (void)hash;
+#endif
+}
+
+static uint32_t hx4_cms_query_hash(const hx4_cms *cms, uint64_t hash) {
+  uint32_t count = UINT32_MAX;
+  uint32_t c;
+  int i;
+  for(i=0; i<cms->depth; i++) {
+    c = *HX4_CMS_COUNTER(cms, hash, i);
+    count = c < count ? c : count;
+  }
+  return count;
+}
+
+int hx4_cms_add_hashes(hx4_cms *cms, const uint64_t *hashes, size_t n) {
+  size_t i;
+
+  if(!cms || !cms->counters || !hashes) {
+    return HX4_ERR_PARAM_INVALID;
+  }
+
+  //the rows of a key are depth random cache lines, fetch them a few keys ahead
+  for(i=0; i<n && i<HX4_CMS_PREFETCH_GROUP; i++) {
+    hx4_cms_prefetch_hash(cms, hashes[i]);
+  }
+  for(i=0; i<n; i++) {
+    if(i + HX4_CMS_PREFETCH_GROUP < n) {
+      hx4_cms_prefetch_hash(cms, hashes[i + HX4_CMS_PREFETCH_GROUP]);
+    }
+    hx4_cms_add_hash(cms, hashes[i], 1);
+  }
+
+  return HX4_ERR_SUCCESS;
+}
+
+int hx4_cms_add(hx4_cms *cms, const void *key, size_t key_sz, uint32_t count) {
+  uint64_t hash;
+  int rc;
+
+  if(!cms || !cms->counters) {
+    return HX4_ERR_PARAM_INVALID;
+  }
+  rc = hx4_sketch_hash(cms->cookie, key, key_sz, &hash);
+  if(rc != HX4_ERR_SUCCESS) {
+    return rc;
+  }
+  hx4_cms_add_hash(cms, hash, count);
+  return HX4_ERR_SUCCESS;
+}
+
+int hx4_cms_add_batch(hx4_cms *cms, const void *const *keys, const size_t *key_sizes, size_t n) {
+  uint64_t hashes[HX4_SKETCH_HASH_BLOCK];
+  size_t block;
+  size_t i;
+  size_t j;
+  int rc;
+
+  if(!cms || !keys || !key_sizes) {
+    return HX4_ERR_PARAM_INVALID;
+  }
+  for(i=0; i<n; i+=block) {
+    block = n - i < HX4_SKETCH_HASH_BLOCK ? n - i : HX4_SKETCH_HASH_BLOCK;
+    for(j=0; j<block; j++) {
+      rc = hx4_sketch_hash(cms->cookie, keys[i+j], key_sizes[i+j], &hashes[j]);
+      if(rc != HX4_ERR_SUCCESS) {
+        return rc;
+      }
+    }
+    rc = hx4_cms_add_hashes(cms, hashes, block);
+    if(rc != HX4_ERR_SUCCESS) {
+      return rc;
+    }
+  }
+  return HX4_ERR_SUCCESS;
+}
+
+int hx4_cms_add_u64_batch(hx4_cms *cms, const uint64_t *keys, size_t n) {
+  uint64_t hashes[HX4_SKETCH_HASH_BLOCK];
+  size_t block;
+  size_t i;
+  int rc;
+
+  if(!cms || !keys) {
+    return HX4_ERR_PARAM_INVALID;
+  }
+  for(i=0; i<n; i+=block) {
+    block = n - i < HX4_SKETCH_HASH_BLOCK ? n - i : HX4_SKETCH_HASH_BLOCK;
+    rc = hx4_hash_u64_array(keys + i, block, cms->cookie, sizeof(cms->cookie), hashes);
+    if(rc != HX4_ERR_SUCCESS) {
+      return rc;
+    }
+    rc = hx4_cms_add_hashes(cms, hashes, block);
+    if(rc != HX4_ERR_SUCCESS) {
+      return rc;
+    }
+  }
+  return HX4_ERR_SUCCESS;
+}
+
+int hx4_cms_query(const hx4_cms *cms, const void *key, size_t key_sz, uint32_t *count) {
+  uint64_t hash;
+  int rc;
+
+  if(!cms || !cms->counters || !count) {
+    return HX4_ERR_PARAM_INVALID;
+  }
+  rc = hx4_sketch_hash(cms->cookie, key, key_sz, &hash);
+  if(rc != HX4_ERR_SUCCESS) {
+    return rc;
+  }
+  *count = hx4_cms_query_hash(cms, hash);
+  return HX4_ERR_SUCCESS;
+}
+
+int hx4_cms_query_u64_batch(const hx4_cms *cms, const uint64_t *keys, size_t n, uint32_t *counts) {
+  uint64_t hashes[HX4_SKETCH_HASH_BLOCK];
+  size_t block;
+  size_t i;
+  size_t j;
+  int rc;
+
+  if(!cms || !cms->counters || !keys || !counts) {
+    return HX4_ERR_PARAM_INVALID;
+  }
+  for(i=0; i<n; i+=block) {
+    block = n - i < HX4_SKETCH_HASH_BLOCK ? n - i : HX4_SKETCH_HASH_BLOCK;
+    rc = hx4_hash_u64_array(keys + i, block, cms->cookie, sizeof(cms->cookie), hashes);
+    if(rc != HX4_ERR_SUCCESS) {
+      return rc;
+    }
+    for(j=0; j<block && j<HX4_CMS_PREFETCH_GROUP; j++) {
+      hx4_cms_prefetch_hash(cms, hashes[j]);
+    }
+    for(j=0; j<block; j++) {
+      if(j + HX4_CMS_PREFETCH_GROUP < block) {
+        hx4_cms_prefetch_hash(cms, hashes[j + HX4_CMS_PREFETCH_GROUP]);
+      }
+      counts[i+j] = hx4_cms_query_hash(cms, hashes[j]);
+    }
+  }
+  return HX4_ERR_SUCCESS;
+}
+
+int hx4_cms_merge(hx4_cms *dst, const hx4_cms *src) {
+  uint32_t *d;
+  const uint32_t *s;
+  size_t num_counters;
+  size_t i;
+#if HX4_HAS_SSE2
+  __m128i xsum;
+  __m128i xd;
+  __m128i xbias;
+#endif
+
+  if(!dst || !src || !dst->counters || !src->counters) {
+    return HX4_ERR_PARAM_INVALID;
+  }
+  if(dst->width != src->width || dst->depth != src->depth || memcmp(dst->cookie, src->cookie, sizeof(dst->cookie)) != 0) {
+    return HX4_ERR_PARAM_INVALID;
+  }
+
+  d = dst->counters;
+  s = src->counters;
+  num_counters = dst->width * (size_t)dst->depth;
+  i = 0;
+#if HX4_HAS_SSE2
+  //saturating add: a sum that wrapped around compares below the old counter,
+  //SSE2 only compares signed, hence the bias
+  xbias = _mm_set1_epi32((int)0x80000000);
+  for( ; i+4 <= num_counters; i+=4) {
+    xd = _mm_loadu_si128((const __m128i*)(d + i));
+    xsum = _mm_add_epi32(xd, _mm_loadu_si128((const __m128i*)(s + i)));
+    xsum = _mm_or_si128(xsum, _mm_cmpgt_epi32(_mm_xor_si128(xd, xbias), _mm_xor_si128(xsum, xbias)));
+    _mm_storeu_si128((__m128i*)(d + i), xsum);
+  }
+#endif
+  for( ; i<num_counters; i++) {
+    d[i] = d[i] + s[i] < d[i] ? UINT32_MAX : d[i] + s[i];
+  }
+
+  return HX4_ERR_SUCCESS;
+}
+
+#undef HX4_CMS_COUNTER
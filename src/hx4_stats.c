@@ -0,0 +1,198 @@
+/* 
+ * Copyright 2015 Kai Dietrich <mail@cleeus.de>
+ *
+ * This file is part of hashx4.
+ *
+ * Hashx4 is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Hashx4 is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with hashx4.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#if HX4_STATS
+# ifdef __GNUC__
+#  if defined(__x86_64__) || defined(__i386__)
+#   include <x86intrin.h>
+#  endif
+# elif _MSC_VER
+#  include <intrin.h>
+# endif
+#endif
+
+#include "hashx4_config.h"
+#include "hashx4.h"
+#include "hashx4_stats.h"
+#include "hx4_util.h"
+
+#define HX4_STATS_KERNEL_NAME(name) #name,
+static const char * const hx4_stats_kernel_names[HX4_STATS_KERNEL_COUNT] = {
+  HX4_STATS_KERNELS(HX4_STATS_KERNEL_NAME)
+};
+#undef HX4_STATS_KERNEL_NAME
+
+const char *hx4_stats_kernel_name(int kernel) {
+  if(kernel < 0 || kernel >= HX4_STATS_KERNEL_COUNT) {
+    return NULL;
+  }
+  return hx4_stats_kernel_names[kernel];
+}
+
+int hx4_stats_size_bucket(uint64_t in_sz) {
+  int bucket = 0;
+  while(in_sz > 0 && bucket < HX4_STATS_HISTOGRAM_SIZE-1) {
+    in_sz >>= 1;
+    bucket++;
+  }
+  return bucket;
+}
+
+#if HX4_STATS
+
+#ifdef __GNUC__
+# define HX4_STATS_THREAD_LOCAL __thread
+# define HX4_STATS_FETCH_AND_INC(counter) __sync_fetch_and_add((counter), 1)
+#elif _MSC_VER
+# define HX4_STATS_THREAD_LOCAL __declspec(thread)
+# define HX4_STATS_FETCH_AND_INC(counter) (_InterlockedIncrement((counter)) - 1)
+#endif
+
+// one slot per thread, the alignment keeps the slots of two threads off a
+// common cache line
+typedef struct {
+  HX4_ALIGNED(hx4_stats_counters kernel[HX4_STATS_KERNEL_COUNT], 64);
+} hx4_stats_slot;
+
+static hx4_stats_slot hx4_stats_slots[HX4_STATS_MAX_THREADS];
+static volatile long hx4_stats_slots_used = 0;
+static HX4_STATS_THREAD_LOCAL hx4_stats_slot *hx4_stats_thread_slot = NULL;
+
+HX4_INLINE hx4_stats_slot *hx4_stats_get_slot(void) {
+  long i;
+  if(hx4_stats_thread_slot == NULL) {
+    i = HX4_STATS_FETCH_AND_INC(&hx4_stats_slots_used);
+    if(i >= HX4_STATS_MAX_THREADS) {
+      i = HX4_STATS_MAX_THREADS-1;
+    }
+    hx4_stats_thread_slot = &hx4_stats_slots[i];
+  }
+  return hx4_stats_thread_slot;
+}
+
+HX4_INLINE uint64_t hx4_stats_cycles(void) {
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+  return __rdtsc();
+#elif defined(_MSC_VER)
+  return __rdtsc();
+#else
+  return 0;
+#endif
+}
+
+uint64_t hx4_stats_begin(int kernel) {
+  const hx4_stats_counters *c = &hx4_stats_get_slot()->kernel[kernel];
+  if((c->calls & (HX4_STATS_SAMPLE_INTERVAL-1)) != 0) {
+    return 0;
+  }
+  return hx4_stats_cycles();
+}
+
+void hx4_stats_end(int kernel, uint64_t in_sz, uint64_t start) {
+  hx4_stats_counters *c = &hx4_stats_get_slot()->kernel[kernel];
+  uint64_t cycles;
+
+  c->calls++;
+  c->bytes += in_sz;
+  c->size_histogram[hx4_stats_size_bucket(in_sz)]++;
+
+  // start is 0 for the calls that are not timed
+  if(start != 0) {
+    cycles = hx4_stats_cycles() - start;
+    c->latency_samples++;
+    c->latency_cycles += cycles;
+    if(cycles > c->latency_max_cycles) {
+      c->latency_max_cycles = cycles;
+    }
+  }
+}
+
+uint64_t hx4_stats_iov_size(const hx4_iovec *iov, size_t iov_cnt) {
+  uint64_t sz = 0;
+  size_t i;
+  for(i=0; i<iov_cnt; i++) {
+    sz += iov[i].iov_len;
+  }
+  return sz;
+}
+
+int hx4_stats_snapshot(hx4_stats *snapshot) {
+  const hx4_stats_counters *c;
+  hx4_stats_counters *sum;
+  size_t num_slots;
+  size_t i;
+  int k;
+  int b;
+
+  if(!snapshot) {
+    return HX4_ERR_PARAM_INVALID;
+  }
+  memset(snapshot, 0, sizeof(*snapshot));
+
+  num_slots = (size_t)hx4_stats_slots_used;
+  snapshot->threads = num_slots;
+  if(num_slots > HX4_STATS_MAX_THREADS) {
+    num_slots = HX4_STATS_MAX_THREADS;
+  }
+
+  for(i=0; i<num_slots; i++) {
+    for(k=0; k<HX4_STATS_KERNEL_COUNT; k++) {
+      c = &hx4_stats_slots[i].kernel[k];
+      sum = &snapshot->kernel[k];
+      sum->calls += c->calls;
+      sum->bytes += c->bytes;
+      for(b=0; b<HX4_STATS_HISTOGRAM_SIZE; b++) {
+        sum->size_histogram[b] += c->size_histogram[b];
+      }
+      sum->latency_samples += c->latency_samples;
+      sum->latency_cycles += c->latency_cycles;
+      if(c->latency_max_cycles > sum->latency_max_cycles) {
+        sum->latency_max_cycles = c->latency_max_cycles;
+      }
+    }
+  }
+  return HX4_ERR_SUCCESS;
+}
+
+void hx4_stats_reset(void) {
+  memset(hx4_stats_slots, 0, sizeof(hx4_stats_slots));
+}
+
+#undef HX4_STATS_THREAD_LOCAL
+#undef HX4_STATS_FETCH_AND_INC
+
+#else //HX4_STATS
+
+int hx4_stats_snapshot(hx4_stats *snapshot) {
+  if(!snapshot) {
+    return HX4_ERR_PARAM_INVALID;
+  }
+  memset(snapshot, 0, sizeof(*snapshot));
+  return HX4_ERR_NOT_FOUND;
+}
+
+void hx4_stats_reset(void) {
+}
+
+#endif //HX4_STATS
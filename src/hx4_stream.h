@@ -0,0 +1,451 @@
+#ifndef HASHX4_STREAM_H
+#define HASHX4_STREAM_H
+/* 
+ * Copyright 2015 Kai Dietrich <mail@cleeus.de>
+ *
+ * This file is part of hashx4.
+ *
+ * Hashx4 is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Hashx4 is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with hashx4.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+#include "hashx4.h"
+#include "hx4_util.h"
+
+#if HX4_HAS_SSE2
+# include <emmintrin.h>
+#endif
+
+#if HX4_HAS_SSSE3
+# include <tmmintrin.h>
+#endif
+
+/*
+ * Incremental state of the hash functions.
+ *
+ * Every algorithm has an init and a final function, and every variant has
+ * an update function that hashes the next piece of the input. Hashing the
+ * pieces one after the other gives the same result as hashing their
+ * concatenation. The updates still seek to alignment and run the SIMD main
+ * loop inside every piece, the state carries what crosses a boundary: the
+ * lane a byte goes to and the key position for the djb family, the partial
+ * word or word group for the siphash family.
+ *
+ * The one shot functions, the _v (iovec), the _cstr (NUL terminated) and
+ * the _ci (case-insensitive) functions are built from this.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* djbx33a, kdjbx33a and their x4 variants, the 32bit variants use state[0] */
+typedef struct {
+  HX4_ALIGNED(uint32_t state[4], 16);
+  uint8_t cookie[128/8];
+  uint64_t pos;
+} hx4_djb_stream;
+
+/* siphash24_64 and siphash13_64, carry holds pos % 8 bytes */
+typedef struct {
+  uint64_t v[4];
+  uint8_t carry[8];
+  uint8_t cookie[128/8];
+  uint64_t pos;
+} hx4_siphash_stream;
+
+/* x4siphash13_256, carry holds pos % 32 bytes, one word for every lane */
+typedef struct {
+  HX4_ALIGNED(uint64_t v0[4], 16);
+  HX4_ALIGNED(uint64_t v1[4], 16);
+  HX4_ALIGNED(uint64_t v2[4], 16);
+  HX4_ALIGNED(uint64_t v3[4], 16);
+  uint8_t carry[32];
+  uint8_t cookie[128/8];
+  uint64_t pos;
+} hx4_x4siphash_stream;
+
+/* halfsiphash13_32, carry holds pos % 4 bytes */
+typedef struct {
+  uint32_t v[4];
+  uint8_t carry[4];
+  uint8_t cookie[128/8];
+  uint64_t pos;
+} hx4_halfsiphash_stream;
+
+/* x4halfsiphash13_128, carry holds pos % 16 bytes, one word for every lane */
+typedef struct {
+  HX4_ALIGNED(uint32_t v0[4], 16);
+  HX4_ALIGNED(uint32_t v1[4], 16);
+  HX4_ALIGNED(uint32_t v2[4], 16);
+  HX4_ALIGNED(uint32_t v3[4], 16);
+  uint8_t carry[16];
+  uint8_t cookie[128/8];
+  uint64_t pos;
+} hx4_x4halfsiphash_stream;
+
+HX4_API void hx4_djbx33a_32_init       (hx4_djb_stream *stream, const void *cookie);
+HX4_API void hx4_djbx33a_32_final      (hx4_djb_stream *stream, void *out);
+HX4_API void hx4_djbx33a_32_ref_update (hx4_djb_stream *stream, const void *in, size_t in_sz);
+HX4_API void hx4_djbx33a_32_copt_update(hx4_djb_stream *stream, const void *in, size_t in_sz);
+
+HX4_API void hx4_x4djbx33a_128_init       (hx4_djb_stream *stream, const void *cookie);
+HX4_API void hx4_x4djbx33a_128_final      (hx4_djb_stream *stream, void *out);
+HX4_API void hx4_x4djbx33a_128_ref_update (hx4_djb_stream *stream, const void *in, size_t in_sz);
+HX4_API void hx4_x4djbx33a_128_copt_update(hx4_djb_stream *stream, const void *in, size_t in_sz);
+#if HX4_HAS_MMX
+HX4_API void hx4_x4djbx33a_128_mmx_update (hx4_djb_stream *stream, const void *in, size_t in_sz);
+#endif
+#if HX4_HAS_SSE2
+HX4_API void hx4_x4djbx33a_128_sse2_update(hx4_djb_stream *stream, const void *in, size_t in_sz);
+HX4_API void hx4_x4djbx33a_128_sse2rle_update(hx4_djb_stream *stream, const void *in, size_t in_sz);
+#endif
+#if HX4_HAS_SSSE3
+HX4_API void hx4_x4djbx33a_128_ssse3_update(hx4_djb_stream *stream, const void *in, size_t in_sz);
+#endif
+
+/* the update functions of the copy-and-hash variants also copy in to dst */
+#if HX4_HAS_SSE2
+HX4_API void hx4_x4djbx33a_128_sse2_copy_update(hx4_djb_stream *stream, void *dst, const void *in, size_t in_sz);
+#endif
+#if HX4_HAS_SSSE3
+HX4_API void hx4_x4djbx33a_128_ssse3_copy_update(hx4_djb_stream *stream, void *dst, const void *in, size_t in_sz);
+#endif
+
+/* the update functions of the case-insensitive variants fold A-Z to a-z */
+HX4_API void hx4_djbx33a_32_ref_ci_update    (hx4_djb_stream *stream, const void *in, size_t in_sz);
+HX4_API void hx4_djbx33a_32_copt_ci_update   (hx4_djb_stream *stream, const void *in, size_t in_sz);
+HX4_API void hx4_x4djbx33a_128_ref_ci_update (hx4_djb_stream *stream, const void *in, size_t in_sz);
+HX4_API void hx4_x4djbx33a_128_copt_ci_update(hx4_djb_stream *stream, const void *in, size_t in_sz);
+#if HX4_HAS_SSE2
+HX4_API void hx4_x4djbx33a_128_sse2_ci_update(hx4_djb_stream *stream, const void *in, size_t in_sz);
+#endif
+#if HX4_HAS_SSSE3
+HX4_API void hx4_x4djbx33a_128_ssse3_ci_update(hx4_djb_stream *stream, const void *in, size_t in_sz);
+#endif
+
+/* the update functions of the C string variants hash up to the terminator
+ * and return the number of bytes hashed */
+#if HX4_HAS_SSE2
+HX4_API size_t hx4_x4djbx33a_128_sse2_cstr_update(hx4_djb_stream *stream, const char *str);
+#endif
+#if HX4_HAS_SSSE3
+HX4_API size_t hx4_x4djbx33a_128_ssse3_cstr_update(hx4_djb_stream *stream, const char *str);
+#endif
+
+HX4_API void hx4_kdjbx33a_32_init       (hx4_djb_stream *stream, const void *cookie);
+HX4_API void hx4_kdjbx33a_32_final      (hx4_djb_stream *stream, void *out);
+HX4_API void hx4_kdjbx33a_32_ref_update (hx4_djb_stream *stream, const void *in, size_t in_sz);
+HX4_API void hx4_kdjbx33a_32_copt_update(hx4_djb_stream *stream, const void *in, size_t in_sz);
+
+HX4_API void hx4_x4kdjbx33a_128_init       (hx4_djb_stream *stream, const void *cookie);
+HX4_API void hx4_x4kdjbx33a_128_final      (hx4_djb_stream *stream, void *out);
+HX4_API void hx4_x4kdjbx33a_128_ref_update (hx4_djb_stream *stream, const void *in, size_t in_sz);
+HX4_API void hx4_x4kdjbx33a_128_copt_update(hx4_djb_stream *stream, const void *in, size_t in_sz);
+#if HX4_HAS_SSE2
+HX4_API void hx4_x4kdjbx33a_128_sse2_update(hx4_djb_stream *stream, const void *in, size_t in_sz);
+#endif
+#if HX4_HAS_SSSE3
+HX4_API void hx4_x4kdjbx33a_128_ssse3_update(hx4_djb_stream *stream, const void *in, size_t in_sz);
+#endif
+
+#if HX4_HAS_SSE2
+HX4_API size_t hx4_x4kdjbx33a_128_sse2_cstr_update(hx4_djb_stream *stream, const char *str);
+#endif
+#if HX4_HAS_SSSE3
+HX4_API size_t hx4_x4kdjbx33a_128_ssse3_cstr_update(hx4_djb_stream *stream, const char *str);
+#endif
+
+/* Rotates the lanes of an x4 djb state left by n, so that lane 0 takes the
+ * byte at the aligned position the main loop starts at, and back again. */
+HX4_INLINE void hx4_x4djb_rotate_lanes(uint32_t state[4], int n) {
+  uint32_t state_tmp;
+  int i;
+  for(i=0; i<n; i++) {
+    state_tmp = state[0];
+    state[0] = state[1];
+    state[1] = state[2];
+    state[2] = state[3];
+    state[3] = state_tmp;
+  }
+}
+
+HX4_INLINE void hx4_x4djb_unrotate_lanes(uint32_t state[4], int n) {
+  uint32_t state_tmp;
+  int i;
+  for(i=0; i<n; i++) {
+    state_tmp = state[3];
+    state[3] = state[2];
+    state[2] = state[1];
+    state[1] = state[0];
+    state[0] = state_tmp;
+  }
+}
+
+/* One 16 byte round of the SIMD x4djbx33a main loops: byte i of xpin goes
+ * to lane i % 4 of the rotated state. The update, _cstr, _ci and _copy
+ * variants and x4kdjbx33a only differ in how they load xpin (and check,
+ * fold, whiten or store it) before the round. */
+#if HX4_HAS_SSE2
+HX4_INLINE __m128i hx4_x4djbx33a_sse2_round(__m128i xstate, __m128i xpin) {
+  const __m128i xzero = _mm_setzero_si128();
+  __m128i xqword;
+  __m128i xp;
+
+#define HX4_SSE2_X4DJBX33A(xstate, xp) \
+  xp = _mm_add_epi32(xp, xstate); \
+  xstate = _mm_slli_epi32(xstate, 5 ); \
+  xstate = _mm_add_epi32(xstate, xp);
+
+  //qword0, lower 8byte: dword0 and dword1
+  xqword = _mm_unpacklo_epi8(xpin, xzero);
+  xp = _mm_unpacklo_epi8(xqword, xzero);
+  HX4_SSE2_X4DJBX33A(xstate, xp);
+  xp = _mm_unpackhi_epi8(xqword, xzero);
+  HX4_SSE2_X4DJBX33A(xstate, xp);
+
+  //qword1, upper 8byte: dword2 and dword3
+  xqword = _mm_unpackhi_epi8(xpin, xzero);
+  xp = _mm_unpacklo_epi8(xqword, xzero);
+  HX4_SSE2_X4DJBX33A(xstate, xp);
+  xp = _mm_unpackhi_epi8(xqword, xzero);
+  HX4_SSE2_X4DJBX33A(xstate, xp);
+#undef HX4_SSE2_X4DJBX33A
+
+  return xstate;
+}
+#endif
+
+#if HX4_HAS_SSSE3
+HX4_INLINE __m128i hx4_x4djbx33a_ssse3_round(__m128i xstate, __m128i xpin) {
+  //byte k of lane l, input byte 4k+l, goes to byte 4l+k, so dword l holds lane l
+  const __m128i xshuffle = _mm_set_epi8(
+    15, 11, 7, 3,
+    14, 10, 6, 2,
+    13, 9 , 5, 1,
+    12, 8 , 4, 0
+  );
+  const __m128i xbmask = _mm_set1_epi32(0x000000ff);
+  __m128i xp;
+
+  xpin = _mm_shuffle_epi8(xpin, xshuffle);
+
+#define HX4_SSSE3_DJB2ROUND(round) \
+  xp = _mm_srli_epi32(xpin, 8*round); \
+  xp = _mm_and_si128(xp, xbmask); \
+  xp = _mm_add_epi32(xp, xstate); \
+  xstate = _mm_slli_epi32(xstate, 5); \
+  xstate = _mm_add_epi32(xstate, xp);
+
+  HX4_SSSE3_DJB2ROUND(0)
+  HX4_SSSE3_DJB2ROUND(1)
+  HX4_SSSE3_DJB2ROUND(2)
+  HX4_SSSE3_DJB2ROUND(3)
+#undef HX4_SSSE3_DJB2ROUND
+
+  return xstate;
+}
+#endif
+
+HX4_API void hx4_siphash24_64_init       (hx4_siphash_stream *stream, const void *cookie);
+HX4_API void hx4_siphash24_64_final      (hx4_siphash_stream *stream, void *out);
+HX4_API void hx4_siphash24_64_ref_update (hx4_siphash_stream *stream, const void *in, size_t in_sz);
+HX4_API void hx4_siphash24_64_copt_update(hx4_siphash_stream *stream, const void *in, size_t in_sz);
+
+HX4_API void hx4_siphash24_64_ref_ci_update (hx4_siphash_stream *stream, const void *in, size_t in_sz);
+HX4_API void hx4_siphash24_64_copt_ci_update(hx4_siphash_stream *stream, const void *in, size_t in_sz);
+
+HX4_API void hx4_siphash13_64_init       (hx4_siphash_stream *stream, const void *cookie);
+HX4_API void hx4_siphash13_64_final      (hx4_siphash_stream *stream, void *out);
+HX4_API void hx4_siphash13_64_ref_update (hx4_siphash_stream *stream, const void *in, size_t in_sz);
+HX4_API void hx4_siphash13_64_copt_update(hx4_siphash_stream *stream, const void *in, size_t in_sz);
+
+HX4_API void hx4_siphash13_64_ref_ci_update (hx4_siphash_stream *stream, const void *in, size_t in_sz);
+HX4_API void hx4_siphash13_64_copt_ci_update(hx4_siphash_stream *stream, const void *in, size_t in_sz);
+
+HX4_API void hx4_x4siphash13_256_init      (hx4_x4siphash_stream *stream, const void *cookie);
+HX4_API void hx4_x4siphash13_256_final     (hx4_x4siphash_stream *stream, void *out);
+HX4_API void hx4_x4siphash13_256_ref_update(hx4_x4siphash_stream *stream, const void *in, size_t in_sz);
+#if HX4_HAS_SSE2
+HX4_API void hx4_x4siphash13_256_sse2_update(hx4_x4siphash_stream *stream, const void *in, size_t in_sz);
+HX4_API void hx4_x4siphash13_256_sse2_final (hx4_x4siphash_stream *stream, void *out);
+HX4_API void hx4_x4siphash13_256_sse2_copy_update(hx4_x4siphash_stream *stream, void *dst, const void *in, size_t in_sz);
+#endif
+
+HX4_API void hx4_halfsiphash13_32_init       (hx4_halfsiphash_stream *stream, const void *cookie);
+HX4_API void hx4_halfsiphash13_32_final      (hx4_halfsiphash_stream *stream, void *out);
+HX4_API void hx4_halfsiphash13_32_ref_update (hx4_halfsiphash_stream *stream, const void *in, size_t in_sz);
+HX4_API void hx4_halfsiphash13_32_copt_update(hx4_halfsiphash_stream *stream, const void *in, size_t in_sz);
+
+HX4_API void hx4_x4halfsiphash13_128_init      (hx4_x4halfsiphash_stream *stream, const void *cookie);
+HX4_API void hx4_x4halfsiphash13_128_final     (hx4_x4halfsiphash_stream *stream, void *out);
+HX4_API void hx4_x4halfsiphash13_128_ref_update(hx4_x4halfsiphash_stream *stream, const void *in, size_t in_sz);
+#if HX4_HAS_SSE2
+HX4_API void hx4_x4halfsiphash13_128_sse2_update(hx4_x4halfsiphash_stream *stream, const void *in, size_t in_sz);
+HX4_API void hx4_x4halfsiphash13_128_sse2_final (hx4_x4halfsiphash_stream *stream, void *out);
+HX4_API void hx4_x4halfsiphash13_128_sse2_copy_update(hx4_x4halfsiphash_stream *stream, void *dst, const void *in, size_t in_sz);
+#endif
+
+/* bytes at the start of the next fragment that are prefetched while the
+ * current one is hashed, the fragments of a chain are rarely adjacent in
+ * memory and the hardware prefetcher starts over on every one of them */
+#define HX4_STREAM_PREFETCH_SIZE 2048
+
+HX4_INLINE void hx4_stream_prefetch(const hx4_iovec *iov) {
+#if HX4_HAS_SSE2
+  const char *p = (const char*)iov->iov_base;
+  size_t i;
+  for(i=0; i<iov->iov_len && i<HX4_STREAM_PREFETCH_SIZE; i+=64) {
+    _mm_prefetch(p+i, _MM_HINT_T0);
+  }
+#else
+  (void)iov;
+#endif
+}
+
+/* the one shot function name() on top of name_update */
+#define HX4_STREAM_ONESHOT_IMPL(name, stream_type, out_size, init, final) \
+HX4_API int name(const void *in, size_t in_sz, const void *cookie, size_t cookie_sz, void *out, size_t out_sz) { \
+  stream_type stream; \
+  int rc; \
+  HX4_STATS_BEGIN(name) \
+  \
+  rc = hx4_check_params((out_size), in, in_sz, cookie, cookie_sz, out, out_sz); \
+  if(rc != HX4_ERR_SUCCESS) { \
+    return rc; \
+  } \
+  init(&stream, cookie); \
+  name##_update(&stream, in, in_sz); \
+  final(&stream, out); \
+  HX4_STATS_END(name, in_sz) \
+  return HX4_ERR_SUCCESS; \
+}
+
+/* name_v() over an iovec array on top of name_update */
+#define HX4_STREAM_V_IMPL(name, stream_type, out_size, init, final) \
+HX4_API int name##_v(const hx4_iovec *iov, size_t iov_cnt, const void *cookie, size_t cookie_sz, void *out, size_t out_sz) { \
+  stream_type stream; \
+  size_t i; \
+  int rc; \
+  HX4_STATS_BEGIN(name) \
+  \
+  rc = hx4_check_params_v((out_size), iov, iov_cnt, cookie, cookie_sz, out, out_sz); \
+  if(rc != HX4_ERR_SUCCESS) { \
+    return rc; \
+  } \
+  init(&stream, cookie); \
+  for(i=0; i<iov_cnt; i++) { \
+    if(i+1 < iov_cnt) { \
+      hx4_stream_prefetch(&iov[i+1]); \
+    } \
+    if(iov[i].iov_len > 0) { \
+      name##_update(&stream, iov[i].iov_base, iov[i].iov_len); \
+    } \
+  } \
+  final(&stream, out); \
+  HX4_STATS_END_V(name, iov, iov_cnt) \
+  return HX4_ERR_SUCCESS; \
+}
+
+/* name_ci() on top of name_ci_update */
+#define HX4_STREAM_CI_IMPL(name, stream_type, out_size, init, final) \
+HX4_API int name##_ci(const void *in, size_t in_sz, const void *cookie, size_t cookie_sz, void *out, size_t out_sz) { \
+  stream_type stream; \
+  int rc; \
+  HX4_STATS_BEGIN(name) \
+  \
+  rc = hx4_check_params((out_size), in, in_sz, cookie, cookie_sz, out, out_sz); \
+  if(rc != HX4_ERR_SUCCESS) { \
+    return rc; \
+  } \
+  init(&stream, cookie); \
+  name##_ci_update(&stream, in, in_sz); \
+  final(&stream, out); \
+  HX4_STATS_END(name, in_sz) \
+  return HX4_ERR_SUCCESS; \
+}
+
+/* below this size the copy and the one shot hash of the still cached input
+ * are faster than setting up the stream for the fused pass */
+#define HX4_COPY_FUSED_MIN_SIZE 1024
+
+/* name_copy() on top of name_copy_update */
+#define HX4_STREAM_COPY_IMPL(name, stream_type, out_size, init, final) \
+HX4_API int name##_copy(void *dst, const void *in, size_t in_sz, const void *cookie, size_t cookie_sz, void *out, size_t out_sz) { \
+  stream_type stream; \
+  int rc; \
+  HX4_STATS_BEGIN(name) \
+  \
+  rc = hx4_check_params_copy((out_size), dst, in, in_sz, cookie, cookie_sz, out, out_sz); \
+  if(rc != HX4_ERR_SUCCESS) { \
+    return rc; \
+  } \
+  if(in_sz < HX4_COPY_FUSED_MIN_SIZE) { \
+    memcpy(dst, in, in_sz); \
+    return name(in, in_sz, cookie, cookie_sz, out, out_sz); \
+  } \
+  init(&stream, cookie); \
+  name##_copy_update(&stream, dst, in, in_sz); \
+  final(&stream, out); \
+  HX4_STATS_END(name, in_sz) \
+  return HX4_ERR_SUCCESS; \
+}
+
+/* name_cstr() for the variants without a fused name_cstr_update, a plain
+ * strlen followed by the one shot function, which checks the other params.
+ * Scanning ahead of name_update in chunks was measured slower than this for
+ * every kernel that has no fused update. */
+#define HX4_STREAM_CSTR_STRLEN_IMPL(name) \
+HX4_API int name##_cstr(const char *str, size_t *str_len, const void *cookie, size_t cookie_sz, void *out, size_t out_sz) { \
+  size_t len; \
+  if(str == NULL) { \
+    return HX4_ERR_PARAM_INVALID; \
+  } \
+  len = strlen(str); \
+  if(str_len != NULL) { \
+    *str_len = len; \
+  } \
+  return name(str, len, cookie, cookie_sz, out, out_sz); \
+}
+
+/* name_cstr() on top of name_cstr_update, str_len may be NULL */
+#define HX4_STREAM_CSTR_IMPL(name, stream_type, out_size, init, final) \
+HX4_API int name##_cstr(const char *str, size_t *str_len, const void *cookie, size_t cookie_sz, void *out, size_t out_sz) { \
+  stream_type stream; \
+  size_t len; \
+  int rc; \
+  HX4_STATS_BEGIN(name) \
+  \
+  rc = hx4_check_params_cstr((out_size), str, cookie, cookie_sz, out, out_sz); \
+  if(rc != HX4_ERR_SUCCESS) { \
+    return rc; \
+  } \
+  init(&stream, cookie); \
+  len = name##_cstr_update(&stream, str); \
+  final(&stream, out); \
+  if(str_len != NULL) { \
+    *str_len = len; \
+  } \
+  HX4_STATS_END(name, len) \
+  return HX4_ERR_SUCCESS; \
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -3,18 +3,21 @@
 #include "hashx4.h"
 #include "hx4_util.h"
 
-static int ptr_in_buffer(const void *ptr, const void *buffer, size_t buffer_size) {
+HX4_INLINE int ptr_in_buffer(const void *ptr, const void *buffer, size_t buffer_size) {
   return  (ptr >= buffer) && ((const uint8_t*)ptr < ((const uint8_t*)buffer + buffer_size));
 }
 
-static int buffers_overlapping(const void *buffer1, size_t buffer1_size, const void *buffer2, size_t buffer2_size) {
+HX4_INLINE int buffers_overlapping(const void *buffer1, size_t buffer1_size, const void *buffer2, size_t buffer2_size) {
+  if(buffer1_size == 0 || buffer2_size == 0) {
+    return 0;
+  }
   return ptr_in_buffer(buffer1, buffer2, buffer2_size) ||
     ptr_in_buffer((const uint8_t*)buffer1+buffer1_size-1, buffer2, buffer2_size) ||
     ptr_in_buffer(buffer2, buffer1, buffer1_size) ||
     ptr_in_buffer((const uint8_t*)buffer2+buffer2_size-1, buffer1, buffer1_size);
 }
 
-int hx4_check_params(size_t sizeof_state, const void *in, size_t in_sz, const void *cookie, size_t cookie_sz, void *out, size_t out_sz) {
+HX4_API int hx4_check_params(size_t sizeof_state, const void *in, size_t in_sz, const void *cookie, size_t cookie_sz, void *out, size_t out_sz) {
   if(!in || !cookie || !out) {
     return HX4_ERR_PARAM_INVALID;
   }
@@ -37,17 +40,88 @@ int hx4_check_params(size_t sizeof_state, const void *in, size_t in_sz, const vo
   return HX4_ERR_SUCCESS;
 }
 
-int hx4_bytes_to_aligned(const void *ptr, int alignment) {
+//the fragments are checked one by one, empty fragments may have a NULL base
+HX4_API int hx4_check_params_v(size_t sizeof_state, const hx4_iovec *iov, size_t iov_cnt, const void *cookie, size_t cookie_sz, void *out, size_t out_sz) {
+  size_t i;
+  int rc;
+
+  if((!iov && iov_cnt) || !cookie || !out) {
+    return HX4_ERR_PARAM_INVALID;
+  }
+  if(out_sz < sizeof_state) {
+    return HX4_ERR_BUFFER_TOO_SMALL;
+  }
+  if(cookie_sz < 128/8) {
+    return HX4_ERR_COOKIE_TOO_SMALL;
+  }
+  if(buffers_overlapping(out, out_sz, cookie, cookie_sz)) {
+    return HX4_ERR_OVERLAP;
+  }
+  for(i=0; i<iov_cnt; i++) {
+    if(iov[i].iov_len) {
+      rc = hx4_check_params(sizeof_state, iov[i].iov_base, iov[i].iov_len, cookie, cookie_sz, out, out_sz);
+      if(rc != HX4_ERR_SUCCESS) {
+        return rc;
+      }
+    }
+  }
+
+  return HX4_ERR_SUCCESS;
+}
+
+//the destination of the copy-and-hash functions must not overlap any other buffer
+HX4_API int hx4_check_params_copy(size_t sizeof_state, void *dst, const void *in, size_t in_sz, const void *cookie, size_t cookie_sz, void *out, size_t out_sz) {
+  int rc;
+
+  rc = hx4_check_params(sizeof_state, in, in_sz, cookie, cookie_sz, out, out_sz);
+  if(rc != HX4_ERR_SUCCESS) {
+    return rc;
+  }
+  if(!dst) {
+    return HX4_ERR_PARAM_INVALID;
+  }
+  if(buffers_overlapping(dst, in_sz, in, in_sz) ||
+     buffers_overlapping(dst, in_sz, cookie, cookie_sz) ||
+     buffers_overlapping(dst, in_sz, out, out_sz)) {
+    return HX4_ERR_OVERLAP;
+  }
+
+  return HX4_ERR_SUCCESS;
+}
+
+//the length of str is not known before it is hashed, only str itself can be checked against out
+HX4_API int hx4_check_params_cstr(size_t sizeof_state, const char *str, const void *cookie, size_t cookie_sz, void *out, size_t out_sz) {
+  if(!str || !cookie || !out) {
+    return HX4_ERR_PARAM_INVALID;
+  }
+  if(out_sz < sizeof_state) {
+    return HX4_ERR_BUFFER_TOO_SMALL;
+  }
+  if(cookie_sz < 128/8) {
+    return HX4_ERR_COOKIE_TOO_SMALL;
+  }
+  if(buffers_overlapping(str, 1, out, out_sz)) {
+    return HX4_ERR_OVERLAP;
+  }
+  if(buffers_overlapping(out, out_sz, cookie, cookie_sz)) {
+    return HX4_ERR_OVERLAP;
+  }
+
+  return HX4_ERR_SUCCESS;
+}
+
+
+HX4_API int hx4_bytes_to_aligned(const void *ptr, int alignment) {
   return ((size_t)ptr) % alignment == 0 ? 0 : alignment - (((size_t)ptr) % alignment);
 }
 
-void hx4_xor_cookie_32(void *target, const void *cookie) {
+HX4_API void hx4_xor_cookie_32(void *target, const void *cookie) {
   int i; 
   for(i=0; i<4; i++) {
     ((uint8_t*)target)[i] ^= ((uint8_t*)cookie)[i];
   }
 }
-void hx4_xor_cookie_128(void *target, const void *cookie) {
+HX4_API void hx4_xor_cookie_128(void *target, const void *cookie) {
   int i;
   for(i=0; i<16; i++) {
     ((uint8_t*)target)[i] ^= ((uint8_t*)cookie)[i];
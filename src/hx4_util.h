@@ -4,8 +4,14 @@
 #include <stdint.h>
 #include <stddef.h>
 
+#include "hashx4.h"
+
+#if HX4_HAS_SSE2
+# include <emmintrin.h>
+#endif
+
 #ifdef __GNUC__
-# define HX4_ASSUME_ALIGNED(ptr, alignment) { ptr = __builtin_assume_aligned( (ptr) , (alignment) ); }
+# define HX4_ASSUME_ALIGNED(ptr, alignment) { ptr = (__typeof__(ptr))__builtin_assume_aligned( (ptr) , (alignment) ); }
 #elif _MSC_VER
 # define HX4_ASSUME_ALIGNED(ptr, alignment) __assume((size_t)p % 16 == 0);
 #else
@@ -21,14 +27,57 @@
 # error HX4_ALIGNED not yet implemented on this compiler
 #endif
 
+/* the counters of a public hash function, HX4_STATS_BEGIN goes after the
+ * declarations and HX4_STATS_END before the return of a successful call */
+#if HX4_STATS
+# include "hashx4_stats.h"
+# define HX4_STATS_BEGIN(name) const uint64_t hx4_stats_start = hx4_stats_begin(HX4_STATS_##name);
+# define HX4_STATS_END(name, in_sz) hx4_stats_end(HX4_STATS_##name, (in_sz), hx4_stats_start);
+# define HX4_STATS_END_V(name, iov, iov_cnt) hx4_stats_end(HX4_STATS_##name, hx4_stats_iov_size((iov), (iov_cnt)), hx4_stats_start);
+#else
+# define HX4_STATS_BEGIN(name)
+# define HX4_STATS_END(name, in_sz)
+# define HX4_STATS_END_V(name, iov, iov_cnt)
+#endif
+
+/* ASCII case folding of the _ci functions, only A-Z change, every other byte
+ * including the ones of UTF-8 sequences is hashed as it is */
+HX4_INLINE uint8_t hx4_ascii_tolower(uint8_t c) {
+  return (uint8_t)(c | (((unsigned int)(c - 'A') < 26) << 5));
+}
+
+/* eight bytes at once, no byte can carry into the next one: the 7 low bits
+ * of a byte plus at most 0x3f stay below 0x100 */
+HX4_INLINE uint64_t hx4_ascii_tolower64(uint64_t w) {
+  const uint64_t ones = 0x0101010101010101ULL;
+  const uint64_t low7 = w & (0x7f * ones);
+  const uint64_t ge_a = low7 + (0x80 - 'A') * ones;
+  const uint64_t gt_z = low7 + (0x7f - 'Z') * ones;
+  const uint64_t upper = (ge_a ^ gt_z) & ~w & (0x80 * ones);
+  return w | (upper >> 2);
+}
+
+#if HX4_HAS_SSE2
+/* shifts A-Z to the bottom of the signed range, one compare finds them and
+ * the masked 0x20 is added to them */
+HX4_INLINE __m128i hx4_ascii_tolower_sse2(__m128i x) {
+  const __m128i shifted = _mm_add_epi8(x, _mm_set1_epi8((char)(0x80 - 'A')));
+  const __m128i upper = _mm_cmplt_epi8(shifted, _mm_set1_epi8((char)(0x80 - 0x100 + 26)));
+  return _mm_add_epi8(x, _mm_and_si128(upper, _mm_set1_epi8(0x20)));
+}
+#endif
+
 #ifdef __cplusplus
 extern "C" {
 #endif
 
-int hx4_check_params(size_t sizeof_state, const void *in, size_t in_sz, const void *cookie, size_t cookie_sz, void *out, size_t out_sz);
-int hx4_bytes_to_aligned(const void *ptr, int alignment);
-void hx4_xor_cookie_32(void *target, const void *cookie);
-void hx4_xor_cookie_128(void *target, const void *cookie);
+HX4_API int hx4_check_params(size_t sizeof_state, const void *in, size_t in_sz, const void *cookie, size_t cookie_sz, void *out, size_t out_sz);
+HX4_API int hx4_check_params_v(size_t sizeof_state, const hx4_iovec *iov, size_t iov_cnt, const void *cookie, size_t cookie_sz, void *out, size_t out_sz);
+HX4_API int hx4_check_params_copy(size_t sizeof_state, void *dst, const void *in, size_t in_sz, const void *cookie, size_t cookie_sz, void *out, size_t out_sz);
+HX4_API int hx4_check_params_cstr(size_t sizeof_state, const char *str, const void *cookie, size_t cookie_sz, void *out, size_t out_sz);
+HX4_API int hx4_bytes_to_aligned(const void *ptr, int alignment);
+HX4_API void hx4_xor_cookie_32(void *target, const void *cookie);
+HX4_API void hx4_xor_cookie_128(void *target, const void *cookie);
 
 
 #ifdef __cplusplus
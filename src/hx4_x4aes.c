@@ -0,0 +1,239 @@
+/* 
+ * Copyright 2015 Kai Dietrich <mail@cleeus.de>
+ *
+ * This file is part of hashx4.
+ *
+ * Hashx4 is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Hashx4 is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with hashx4.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "hashx4_config.h"
+
+#if HX4_HAS_AESNI
+# include <wmmintrin.h>
+#endif
+
+#include "hashx4.h"
+#include "hx4_util.h"
+
+// x4aes_128 feeds the input into 4 independent 128bit lanes, one AES round
+// per 16 byte block: block i of every 64 byte chunk goes to lane i, is xored
+// into the lane state and the state runs through an AES encryption round
+// with the cookie as round key. A round costs one aesenc and has a latency
+// of about 4 cycles, the 4 lanes keep the unit busy.
+//
+// A partial last chunk is padded with zeros. The finalization xors the input
+// length into lane 0, runs it through one round with each of the other lanes
+// as round key and then through three rounds with the cookie keys.
+//
+// This is a fast keyed hash for tables, in the style of aHash and meow hash.
+// It is neither a MAC nor a PRF, use siphash when the keys are chosen by an
+// adversary who can observe the results.
+
+#define HX4_X4AES_CHUNK 64
+
+//fractional digits of pi: the second round key is the cookie xored with
+//the first constant, the lanes start from the cookie xored with the others
+static const uint8_t hx4_x4aes_const[5][16] = {
+  { 0x88, 0x6a, 0x3f, 0x24, 0xd3, 0x08, 0xa3, 0x85, 0x2e, 0x8a, 0x19, 0x13, 0x44, 0x73, 0x70, 0x03 },
+  { 0x22, 0x38, 0x09, 0xa4, 0xd0, 0x31, 0x9f, 0x29, 0x98, 0xfa, 0x2e, 0x08, 0x89, 0x6c, 0x4e, 0xec },
+  { 0xe6, 0x21, 0x28, 0x45, 0x77, 0x13, 0xd0, 0x38, 0xcf, 0x66, 0x54, 0xbe, 0x6c, 0x0c, 0xe9, 0x34 },
+  { 0xb7, 0x29, 0xac, 0xc0, 0xdd, 0x50, 0x7c, 0xc9, 0xb5, 0xd5, 0x84, 0x3f, 0x17, 0x09, 0x47, 0xb5 },
+  { 0xd9, 0xd5, 0x16, 0x92, 0x1b, 0xfb, 0x79, 0x89, 0xa6, 0x0b, 0x31, 0xd1, 0xac, 0xb5, 0xdf, 0x98 },
+};
+
+static const uint8_t hx4_aes_sbox[256] = {
+  0x63, 0x7c, 0x77, 0x7b, 0xf2, 0x6b, 0x6f, 0xc5, 0x30, 0x01, 0x67, 0x2b, 0xfe, 0xd7, 0xab, 0x76,
+  0xca, 0x82, 0xc9, 0x7d, 0xfa, 0x59, 0x47, 0xf0, 0xad, 0xd4, 0xa2, 0xaf, 0x9c, 0xa4, 0x72, 0xc0,
+  0xb7, 0xfd, 0x93, 0x26, 0x36, 0x3f, 0xf7, 0xcc, 0x34, 0xa5, 0xe5, 0xf1, 0x71, 0xd8, 0x31, 0x15,
+  0x04, 0xc7, 0x23, 0xc3, 0x18, 0x96, 0x05, 0x9a, 0x07, 0x12, 0x80, 0xe2, 0xeb, 0x27, 0xb2, 0x75,
+  0x09, 0x83, 0x2c, 0x1a, 0x1b, 0x6e, 0x5a, 0xa0, 0x52, 0x3b, 0xd6, 0xb3, 0x29, 0xe3, 0x2f, 0x84,
+  0x53, 0xd1, 0x00, 0xed, 0x20, 0xfc, 0xb1, 0x5b, 0x6a, 0xcb, 0xbe, 0x39, 0x4a, 0x4c, 0x58, 0xcf,
+  0xd0, 0xef, 0xaa, 0xfb, 0x43, 0x4d, 0x33, 0x85, 0x45, 0xf9, 0x02, 0x7f, 0x50, 0x3c, 0x9f, 0xa8,
+  0x51, 0xa3, 0x40, 0x8f, 0x92, 0x9d, 0x38, 0xf5, 0xbc, 0xb6, 0xda, 0x21, 0x10, 0xff, 0xf3, 0xd2,
+  0xcd, 0x0c, 0x13, 0xec, 0x5f, 0x97, 0x44, 0x17, 0xc4, 0xa7, 0x7e, 0x3d, 0x64, 0x5d, 0x19, 0x73,
+  0x60, 0x81, 0x4f, 0xdc, 0x22, 0x2a, 0x90, 0x88, 0x46, 0xee, 0xb8, 0x14, 0xde, 0x5e, 0x0b, 0xdb,
+  0xe0, 0x32, 0x3a, 0x0a, 0x49, 0x06, 0x24, 0x5c, 0xc2, 0xd3, 0xac, 0x62, 0x91, 0x95, 0xe4, 0x79,
+  0xe7, 0xc8, 0x37, 0x6d, 0x8d, 0xd5, 0x4e, 0xa9, 0x6c, 0x56, 0xf4, 0xea, 0x65, 0x7a, 0xae, 0x08,
+  0xba, 0x78, 0x25, 0x2e, 0x1c, 0xa6, 0xb4, 0xc6, 0xe8, 0xdd, 0x74, 0x1f, 0x4b, 0xbd, 0x8b, 0x8a,
+  0x70, 0x3e, 0xb5, 0x66, 0x48, 0x03, 0xf6, 0x0e, 0x61, 0x35, 0x57, 0xb9, 0x86, 0xc1, 0x1d, 0x9e,
+  0xe1, 0xf8, 0x98, 0x11, 0x69, 0xd9, 0x8e, 0x94, 0x9b, 0x1e, 0x87, 0xe9, 0xce, 0x55, 0x28, 0xdf,
+  0x8c, 0xa1, 0x89, 0x0d, 0xbf, 0xe6, 0x42, 0x68, 0x41, 0x99, 0x2d, 0x0f, 0xb0, 0x54, 0xbb, 0x16,
+};
+
+HX4_INLINE uint8_t hx4_aes_xtime(uint8_t b) {
+  return (uint8_t)((b << 1) ^ ((b & 0x80) ? 0x1b : 0x00));
+}
+
+//one AES encryption round like aesenc: ShiftRows, SubBytes, MixColumns and
+//the xor with the round key, bytes in memory order, column major
+static void hx4_aes_round_ref(uint8_t state[16], const uint8_t key[16]) {
+  uint8_t t[16];
+  uint8_t a0, a1, a2, a3;
+  uint8_t all;
+  int c;
+  int r;
+
+  for(c=0; c<4; c++) {
+    for(r=0; r<4; r++) {
+      t[4*c + r] = hx4_aes_sbox[state[4*((c + r) & 0x03) + r]];
+    }
+  }
+
+  for(c=0; c<4; c++) {
+    a0 = t[4*c];
+    a1 = t[4*c + 1];
+    a2 = t[4*c + 2];
+    a3 = t[4*c + 3];
+    all = a0 ^ a1 ^ a2 ^ a3;
+    state[4*c]     = a0 ^ all ^ hx4_aes_xtime(a0 ^ a1) ^ key[4*c];
+    state[4*c + 1] = a1 ^ all ^ hx4_aes_xtime(a1 ^ a2) ^ key[4*c + 1];
+    state[4*c + 2] = a2 ^ all ^ hx4_aes_xtime(a2 ^ a3) ^ key[4*c + 2];
+    state[4*c + 3] = a3 ^ all ^ hx4_aes_xtime(a3 ^ a0) ^ key[4*c + 3];
+  }
+}
+
+static void hx4_x4aes_absorb_ref(uint8_t state[4][16], const uint8_t *chunk, const uint8_t key[16]) {
+  int lane;
+  int i;
+
+  for(lane=0; lane<4; lane++) {
+    for(i=0; i<16; i++) {
+      state[lane][i] ^= chunk[16*lane + i];
+    }
+    hx4_aes_round_ref(state[lane], key);
+  }
+}
+
+HX4_API int hx4_x4aes_128_ref(const void *in, size_t in_sz, const void *cookie, size_t cookie_sz, void *out, size_t out_sz) {
+  const uint8_t *p = (const uint8_t*)in;
+  uint8_t key0[16];
+  uint8_t key1[16];
+  uint8_t state[4][16];
+  uint8_t chunk[HX4_X4AES_CHUNK];
+  uint64_t len = in_sz;
+  size_t left = in_sz;
+  int lane;
+  int i;
+  int rc;
+  HX4_STATS_BEGIN(hx4_x4aes_128_ref)
+
+  rc = hx4_check_params(128/8, in, in_sz, cookie, cookie_sz, out, out_sz);
+  if(rc != HX4_ERR_SUCCESS) {
+    return rc;
+  }
+
+  memcpy(key0, cookie, 16);
+  for(i=0; i<16; i++) {
+    key1[i] = key0[i] ^ hx4_x4aes_const[0][i];
+  }
+  for(lane=0; lane<4; lane++) {
+    for(i=0; i<16; i++) {
+      state[lane][i] = key0[i] ^ hx4_x4aes_const[1 + lane][i];
+    }
+  }
+
+  for( ; left >= HX4_X4AES_CHUNK; left -= HX4_X4AES_CHUNK, p += HX4_X4AES_CHUNK) {
+    hx4_x4aes_absorb_ref(state, p, key1);
+  }
+  if(left > 0) {
+    memset(chunk, 0, sizeof(chunk));
+    memcpy(chunk, p, left);
+    hx4_x4aes_absorb_ref(state, chunk, key1);
+  }
+
+  //finalization
+  for(i=0; i<8; i++) {
+    state[0][i] ^= (uint8_t)(len >> (8*i));
+  }
+  hx4_aes_round_ref(state[0], state[1]);
+  hx4_aes_round_ref(state[0], state[2]);
+  hx4_aes_round_ref(state[0], state[3]);
+  hx4_aes_round_ref(state[0], key0);
+  hx4_aes_round_ref(state[0], key1);
+  hx4_aes_round_ref(state[0], key0);
+
+  memcpy(out, state[0], 16);
+  HX4_STATS_END(hx4_x4aes_128_ref, in_sz)
+  return HX4_ERR_SUCCESS;
+}
+
+#if HX4_HAS_AESNI
+
+HX4_API int hx4_x4aes_128_aesni(const void *in, size_t in_sz, const void *cookie, size_t cookie_sz, void *out, size_t out_sz) {
+  const uint8_t *p = (const uint8_t*)in;
+  const uint8_t * const p_end = p + in_sz;
+  uint8_t chunk[HX4_X4AES_CHUNK];
+  const uint64_t len = in_sz;
+  __m128i key0;
+  __m128i key1;
+  __m128i s0;
+  __m128i s1;
+  __m128i s2;
+  __m128i s3;
+  int rc;
+  HX4_STATS_BEGIN(hx4_x4aes_128_aesni)
+
+  rc = hx4_check_params(128/8, in, in_sz, cookie, cookie_sz, out, out_sz);
+  if(rc != HX4_ERR_SUCCESS) {
+    return rc;
+  }
+
+  key0 = _mm_loadu_si128((const __m128i*)cookie);
+  key1 = _mm_xor_si128(key0, _mm_loadu_si128((const __m128i*)hx4_x4aes_const[0]));
+  s0 = _mm_xor_si128(key0, _mm_loadu_si128((const __m128i*)hx4_x4aes_const[1]));
+  s1 = _mm_xor_si128(key0, _mm_loadu_si128((const __m128i*)hx4_x4aes_const[2]));
+  s2 = _mm_xor_si128(key0, _mm_loadu_si128((const __m128i*)hx4_x4aes_const[3]));
+  s3 = _mm_xor_si128(key0, _mm_loadu_si128((const __m128i*)hx4_x4aes_const[4]));
+
+  //main processing loop, 4 independent dependency chains
+  for( ; p_end - p >= HX4_X4AES_CHUNK; p += HX4_X4AES_CHUNK) {
+    s0 = _mm_aesenc_si128(_mm_xor_si128(s0, _mm_loadu_si128((const __m128i*)(p + 0))), key1);
+    s1 = _mm_aesenc_si128(_mm_xor_si128(s1, _mm_loadu_si128((const __m128i*)(p + 16))), key1);
+    s2 = _mm_aesenc_si128(_mm_xor_si128(s2, _mm_loadu_si128((const __m128i*)(p + 32))), key1);
+    s3 = _mm_aesenc_si128(_mm_xor_si128(s3, _mm_loadu_si128((const __m128i*)(p + 48))), key1);
+  }
+
+  //zero padded last chunk
+  if(p < p_end) {
+    memset(chunk, 0, sizeof(chunk));
+    memcpy(chunk, p, (size_t)(p_end - p));
+    s0 = _mm_aesenc_si128(_mm_xor_si128(s0, _mm_loadu_si128((const __m128i*)(chunk + 0))), key1);
+    s1 = _mm_aesenc_si128(_mm_xor_si128(s1, _mm_loadu_si128((const __m128i*)(chunk + 16))), key1);
+    s2 = _mm_aesenc_si128(_mm_xor_si128(s2, _mm_loadu_si128((const __m128i*)(chunk + 32))), key1);
+    s3 = _mm_aesenc_si128(_mm_xor_si128(s3, _mm_loadu_si128((const __m128i*)(chunk + 48))), key1);
+  }
+
+  //finalization
+  s0 = _mm_xor_si128(s0, _mm_set_epi32(0, 0, (int)(uint32_t)(len >> 32), (int)(uint32_t)len));
+  s0 = _mm_aesenc_si128(s0, s1);
+  s0 = _mm_aesenc_si128(s0, s2);
+  s0 = _mm_aesenc_si128(s0, s3);
+  s0 = _mm_aesenc_si128(s0, key0);
+  s0 = _mm_aesenc_si128(s0, key1);
+  s0 = _mm_aesenc_si128(s0, key0);
+
+  _mm_storeu_si128((__m128i*)out, s0);
+  HX4_STATS_END(hx4_x4aes_128_aesni, in_sz)
+  return HX4_ERR_SUCCESS;
+}
+
+#endif //HX4_HAS_AESNI
+
+#undef HX4_X4AES_CHUNK
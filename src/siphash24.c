@@ -18,9 +18,13 @@
 #include "hashx4.h"
 #include "hx4_util.h"
 
+// the siphash sources share these in the header-only build
+#ifndef HX4_SIPHASH_TYPEDEFS
+#define HX4_SIPHASH_TYPEDEFS
 typedef uint64_t u64;
 typedef uint32_t u32;
 typedef uint8_t u8;
+#endif
 
 #define ROTL(x,b) (u64)( ((x) << (b)) | ( (x) >> (64 - (b))) )
 
@@ -107,18 +111,23 @@ static int crypto_auth( unsigned char *out, const unsigned char *in, unsigned lo
   return 0;
 }
 
-int hx4_siphash24_64_ref(const void *in, size_t in_sz, const void *cookie, size_t cookie_sz, void *out, size_t out_sz) {
+HX4_API int hx4_siphash24_64_ref(const void *in, size_t in_sz, const void *cookie, size_t cookie_sz, void *out, size_t out_sz) {
   int rc;
+  HX4_STATS_BEGIN(hx4_siphash24_64_ref)
 
   rc = hx4_check_params(64/8, in, in_sz, cookie, cookie_sz, out, out_sz);
   if(rc != HX4_ERR_SUCCESS) {
     return rc;
   }
 
-  crypto_auth(out, in, in_sz, (const unsigned char*)cookie);
+  crypto_auth((unsigned char*)out, (const unsigned char*)in, in_sz, (const unsigned char*)cookie);
   
+  HX4_STATS_END(hx4_siphash24_64_ref, in_sz)
   return HX4_ERR_SUCCESS;
 }
 
-
-
+#undef ROTL
+#undef SIPROUND
+#undef U32TO8_LE
+#undef U64TO8_LE
+#undef U8TO64_LE
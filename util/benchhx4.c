@@ -0,0 +1,505 @@
+/* 
+ * Copyright 2015 Kai Dietrich <mail@cleeus.de>
+ *
+ * This file is part of hashx4.
+ *
+ * Hashx4 is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Hashx4 is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with hashx4.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+
+/*
+ * benchhx4 - hashes realistic key sets one key at a time and runs them
+ * through hash table simulations.
+ *
+ *   benchhx4 [-n keys] [corpus.txt ...]
+ *
+ * Without files five corpora are generated: dictionary like words, URLs,
+ * UUIDs in text form, 8 byte integer IDs counting up and log lines. Every
+ * file given is a corpus of its own with one key per non empty line, a
+ * trailing \r is dropped. Duplicate lines stay duplicates.
+ *
+ * For every corpus and hash function it prints
+ *   - the keys hashed per second, one call per key
+ *   - lookups per second of all keys in an open addressing table with
+ *     linear probing at a load factor of at most 0.75, and the average
+ *     number of slots a lookup reads
+ *   - lookups per second in a chained table with as many buckets as
+ *     keys (rounded up to a power of two), and the variance of the bucket
+ *     loads. A random function gives a variance close to the load factor.
+ * The tables index by the low bits of the output folded to 64 bits, every
+ * 64bit word of it is mixed in like in hx4::fold of hashx4.hpp.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "hashx4.h"
+
+#include "hx4tool.h"
+
+#define BENCHHX4_DEFAULT_KEYS 100000
+// every measurement repeats until this many seconds have passed
+#define BENCHHX4_DURATION_S 0.2
+
+typedef int (*hash_function_t)(const void *, size_t, const void *, size_t, void *, size_t);
+typedef struct {
+  hash_function_t function;
+  const char *name;
+  size_t output_size;
+} hash_function_item_t;
+
+#define HASH_FUNCTION_ITEM(function_name, output_bits) { function_name , #function_name , (output_bits)/8 } ,
+
+// the fastest kernel of every algorithm the build has
+static const hash_function_item_t hash_functions[] = {
+  HASH_FUNCTION_ITEM(hx4_djbx33a_32_copt, 32)
+#if HX4_HAS_SSSE3
+  HASH_FUNCTION_ITEM(hx4_x4djbx33a_128_ssse3, 128)
+#elif HX4_HAS_SSE2
+  HASH_FUNCTION_ITEM(hx4_x4djbx33a_128_sse2, 128)
+#else
+  HASH_FUNCTION_ITEM(hx4_x4djbx33a_128_copt, 128)
+#endif
+  HASH_FUNCTION_ITEM(hx4_siphash24_64_copt, 64)
+  HASH_FUNCTION_ITEM(hx4_siphash13_64_copt, 64)
+#if HX4_HAS_SSE2
+  HASH_FUNCTION_ITEM(hx4_x4siphash13_256_sse2, 256)
+#endif
+  HASH_FUNCTION_ITEM(hx4_halfsiphash13_32_copt, 32)
+#if HX4_HAS_SSE42 && HX4_HAS_PCLMUL
+  HASH_FUNCTION_ITEM(hx4_crc32c_32_pclmul, 32)
+#elif HX4_HAS_SSE42
+  HASH_FUNCTION_ITEM(hx4_crc32c_32_sse42, 32)
+#else
+  HASH_FUNCTION_ITEM(hx4_crc32c_32_ref, 32)
+#endif
+#if HX4_HAS_AESNI
+  HASH_FUNCTION_ITEM(hx4_x4aes_128_aesni, 128)
+#endif
+#if HX4_HAS_AVX2
+  HASH_FUNCTION_ITEM(hx4_x4mulfold_128_avx2, 128)
+#elif HX4_HAS_SSE2
+  HASH_FUNCTION_ITEM(hx4_x4mulfold_128_sse2, 128)
+#else
+  HASH_FUNCTION_ITEM(hx4_x4mulfold_128_copt, 128)
+#endif
+};
+
+typedef struct {
+  char name[64];
+  const uint8_t **keys;
+  size_t *key_sizes;
+  size_t num_keys;
+  size_t total_size;
+  uint8_t *buffer;
+} corpus_t;
+
+static void corpus_free(corpus_t *c) {
+  free((void*)c->keys);
+  free(c->key_sizes);
+  free(c->buffer);
+  memset(c, 0, sizeof(*c));
+}
+
+static const char * const syllables[16] = {
+  "ka", "lo", "mi", "ne", "ru", "sa", "to", "vi", "ber", "dan", "gor", "hil", "ing", "pra", "sto", "wen"
+};
+
+// a unique pronounceable word for every i < 2^32: the hex digits of a permutation of i as syllables
+static size_t make_word(char *out, uint32_t i) {
+  uint32_t x = i * 0x9e3779b1u;
+  size_t len = 0;
+  size_t s;
+  do {
+    s = strlen(syllables[x & 0x0f]);
+    memcpy(out + len, syllables[x & 0x0f], s);
+    len += s;
+    x >>= 4;
+  } while(x != 0 && len < 10);
+  if(x != 0) {
+    // the rest of the digits as they are, keeps the words unique
+    len += (size_t)sprintf(out + len, "%x", (unsigned)x);
+  }
+  return len;
+}
+
+// fills key i of the generated corpus kind into out (at most 256 bytes), returns its size
+typedef size_t (*key_generator_t)(uint8_t *out, uint32_t i, uint64_t *rng);
+
+static size_t generate_word(uint8_t *out, uint32_t i, uint64_t *rng) {
+  (void)rng;
+  return make_word((char*)out, i);
+}
+
+static size_t generate_url(uint8_t *out, uint32_t i, uint64_t *rng) {
+  static const char * const tlds[4] = { "com", "org", "net", "de" };
+  char host[32];
+  char path1[32];
+  char path2[32];
+  const uint64_t r = splitmix64(rng);
+  host[make_word(host, (uint32_t)(r % 5000))] = 0;
+  path1[make_word(path1, (uint32_t)((r >> 16) % 200))] = 0;
+  path2[make_word(path2, (uint32_t)((r >> 32) % 100000))] = 0;
+  return (size_t)sprintf((char*)out, "https://www.%s.%s/%s/%s?id=%u", host, tlds[(r >> 60) & 3], path1, path2, (unsigned)i);
+}
+
+static size_t generate_uuid(uint8_t *out, uint32_t i, uint64_t *rng) {
+  const uint64_t hi = splitmix64(rng);
+  const uint64_t lo = splitmix64(rng);
+  (void)i;
+  return (size_t)sprintf((char*)out, "%08x-%04x-4%03x-%04x-%012llx",
+      (unsigned)(hi >> 32), (unsigned)((hi >> 16) & 0xffff), (unsigned)(hi & 0x0fff),
+      (unsigned)(0x8000 | ((lo >> 48) & 0x3fff)), (unsigned long long)(lo & 0xffffffffffffULL));
+}
+
+static size_t generate_id(uint8_t *out, uint32_t i, uint64_t *rng) {
+  const uint64_t id = 1000000 + (uint64_t)i;
+  size_t j;
+  (void)rng;
+  for(j=0; j<8; j++) {
+    out[j] = (uint8_t)(id >> (8*j));
+  }
+  return 8;
+}
+
+static size_t generate_log_line(uint8_t *out, uint32_t i, uint64_t *rng) {
+  static const char * const levels[4] = { "INFO", "INFO", "WARN", "DEBUG" };
+  static const char * const paths[4] = { "/api/v1/users", "/api/v1/orders", "/static/app.js", "/healthz" };
+  const uint64_t r = splitmix64(rng);
+  const unsigned ms = (unsigned)i * 37;
+  return (size_t)sprintf((char*)out, "2026-10-19T%02u:%02u:%02u.%03uZ %s [worker-%u] request %08x %s took %ums status=%u",
+      (ms / 3600000) % 24, (ms / 60000) % 60, (ms / 1000) % 60, ms % 1000,
+      levels[r & 3], (unsigned)((r >> 2) & 15), (unsigned)i, paths[(r >> 6) & 3],
+      (unsigned)((r >> 8) % 500), (r >> 20) % 16 == 0 ? 500u : 200u);
+}
+
+static int generate_corpus(corpus_t *c, const char *name, key_generator_t generator, size_t num_keys) {
+  uint8_t key[256];
+  uint64_t rng = 42;
+  size_t capacity = 4096;
+  size_t offset = 0;
+  size_t sz;
+  uint8_t *grown;
+  size_t i;
+
+  memset(c, 0, sizeof(*c));
+  strncpy(c->name, name, sizeof(c->name) - 1);
+  c->keys = malloc(num_keys * sizeof(uint8_t*));
+  c->key_sizes = malloc(num_keys * sizeof(size_t));
+  c->buffer = malloc(capacity);
+  if(!c->keys || !c->key_sizes || !c->buffer) {
+    return 1;
+  }
+
+  // offsets first, the buffer moves while it grows
+  for(i=0; i<num_keys; i++) {
+    sz = generator(key, (uint32_t)i, &rng);
+    if(offset + sz > capacity) {
+      capacity = 2 * (offset + sz);
+      grown = realloc(c->buffer, capacity);
+      if(!grown) {
+        return 1;
+      }
+      c->buffer = grown;
+    }
+    memcpy(c->buffer + offset, key, sz);
+    c->key_sizes[i] = sz;
+    offset += sz;
+  }
+  for(i=0, offset=0; i<num_keys; i++) {
+    c->keys[i] = c->buffer + offset;
+    offset += c->key_sizes[i];
+  }
+  c->num_keys = num_keys;
+  c->total_size = offset;
+  return 0;
+}
+
+// the lines of the file, at most max_keys of them
+static int read_corpus(corpus_t *c, const char *filename, size_t max_keys) {
+  hx_keys k;
+  const char *base;
+  size_t i;
+
+  memset(c, 0, sizeof(*c));
+  base = strrchr(filename, '/');
+  strncpy(c->name, base ? base + 1 : filename, sizeof(c->name) - 1);
+  if(hx_read_keys("benchhx4", filename, max_keys, &k) != 0) {
+    hx_keys_free(&k);
+    return 1;
+  }
+  c->keys = (const uint8_t**)k.keys;
+  c->key_sizes = k.key_sizes;
+  c->num_keys = k.num_keys;
+  c->buffer = (uint8_t*)k.buffer;
+  for(i=0; i<c->num_keys; i++) {
+    c->total_size += c->key_sizes[i];
+  }
+  if(c->num_keys == 0) {
+    fprintf(stderr, "benchhx4: no keys in %s\n", filename);
+    return 1;
+  }
+  return 0;
+}
+
+// every 64bit word of the output mixed in like hx4::fold, the first 8 bytes
+// alone only hold the first lanes of an x4 function
+static uint64_t hash_key(const hash_function_item_t *h, const uint8_t *key, size_t key_sz, const uint8_t *cookie) {
+  uint8_t out[256/8];
+  uint64_t value = 0;
+  uint64_t word;
+  size_t i;
+  size_t j;
+  h->function(key, key_sz, cookie, 16, out, h->output_size);
+  for(i=0; i<h->output_size; i+=8) {
+    word = 0;
+    for(j=0; j<8 && i+j<h->output_size; j++) {
+      word |= (uint64_t)out[i+j] << (8*j);
+    }
+    value = (value ^ word) * 0x9e3779b97f4a7c15ULL;
+  }
+  return value ^ (value >> 32);
+}
+
+static size_t next_power_of_two(size_t n) {
+  size_t p = 1;
+  while(p < n) {
+    p *= 2;
+  }
+  return p;
+}
+
+// runs the loop over all keys until BENCHHX4_DURATION_S have passed, result is keys per second
+#define BENCHHX4_TIME_KEYS(result, loop) \
+  { \
+    hx_time start = hx_gettime(); \
+    hx_time stop; \
+    size_t rounds = 0; \
+    double elapsed; \
+    do { \
+      loop; \
+      rounds++; \
+      stop = hx_gettime(); \
+      elapsed = hx_timedelta_s(&start, &stop); \
+    } while(elapsed < BENCHHX4_DURATION_S); \
+    result = (double)(rounds * c->num_keys) / elapsed; \
+  }
+
+typedef struct {
+  double hash_keys_per_s;
+  double open_lookups_per_s;
+  double open_average_probes;
+  double chained_lookups_per_s;
+  double chained_load_variance;
+} corpus_result_t;
+
+static int run_corpus(const corpus_t *c, const hash_function_item_t *h, const uint8_t *cookie, corpus_result_t *result) {
+  const size_t n = c->num_keys;
+  const size_t open_slots = next_power_of_two(n + n/3 + 1);
+  const size_t buckets = next_power_of_two(n);
+  // slot and chain entries are key index + 1, 0 is empty
+  uint32_t *slots = calloc(open_slots, sizeof(uint32_t));
+  uint64_t *slot_hashes = calloc(open_slots, sizeof(uint64_t));
+  uint32_t *heads = calloc(buckets, sizeof(uint32_t));
+  uint32_t *next = calloc(n + 1, sizeof(uint32_t));
+  uint64_t *hashes = malloc(n * sizeof(uint64_t));
+  volatile uint64_t sink = 0;
+  uint64_t probes = 0;
+  uint64_t hash;
+  size_t pos;
+  size_t i;
+  uint32_t e;
+  double mean;
+  double d;
+  double variance;
+
+  if(!slots || !slot_hashes || !heads || !next || !hashes) {
+    free(slots);
+    free(slot_hashes);
+    free(heads);
+    free(next);
+    free(hashes);
+    return 1;
+  }
+
+  BENCHHX4_TIME_KEYS(result->hash_keys_per_s,
+    for(i=0; i<n; i++) {
+      sink ^= hash_key(h, c->keys[i], c->key_sizes[i], cookie);
+    }
+  )
+
+  // build both tables
+  for(i=0; i<n; i++) {
+    hash = hash_key(h, c->keys[i], c->key_sizes[i], cookie);
+    hashes[i] = hash;
+    for(pos = hash & (open_slots - 1); slots[pos] != 0; pos = (pos + 1) & (open_slots - 1)) {
+    }
+    slots[pos] = (uint32_t)(i + 1);
+    slot_hashes[pos] = hash;
+    next[i + 1] = heads[hash & (buckets - 1)];
+    heads[hash & (buckets - 1)] = (uint32_t)(i + 1);
+  }
+
+  // the probes of the successful lookups, a lookup stops at the first equal key
+  for(i=0; i<n; i++) {
+    pos = hashes[i] & (open_slots - 1);
+    probes++;
+    while(slot_hashes[pos] != hashes[i] || c->key_sizes[slots[pos] - 1] != c->key_sizes[i] || memcmp(c->keys[slots[pos] - 1], c->keys[i], c->key_sizes[i]) != 0) {
+      pos = (pos + 1) & (open_slots - 1);
+      probes++;
+    }
+  }
+  result->open_average_probes = (double)probes / (double)n;
+
+  BENCHHX4_TIME_KEYS(result->open_lookups_per_s,
+    for(i=0; i<n; i++) {
+      hash = hash_key(h, c->keys[i], c->key_sizes[i], cookie);
+      for(pos = hash & (open_slots - 1); slots[pos] != 0; pos = (pos + 1) & (open_slots - 1)) {
+        e = slots[pos] - 1;
+        if(slot_hashes[pos] == hash && c->key_sizes[e] == c->key_sizes[i] && memcmp(c->keys[e], c->keys[i], c->key_sizes[i]) == 0) {
+          sink += e;
+          break;
+        }
+      }
+    }
+  )
+
+  BENCHHX4_TIME_KEYS(result->chained_lookups_per_s,
+    for(i=0; i<n; i++) {
+      hash = hash_key(h, c->keys[i], c->key_sizes[i], cookie);
+      for(e = heads[hash & (buckets - 1)]; e != 0; e = next[e]) {
+        if(hashes[e - 1] == hash && c->key_sizes[e - 1] == c->key_sizes[i] && memcmp(c->keys[e - 1], c->keys[i], c->key_sizes[i]) == 0) {
+          sink += e;
+          break;
+        }
+      }
+    }
+  )
+
+  mean = (double)n / (double)buckets;
+  variance = 0;
+  for(pos=0; pos<buckets; pos++) {
+    d = -mean;
+    for(e = heads[pos]; e != 0; e = next[e]) {
+      d += 1.0;
+    }
+    variance += d * d;
+  }
+  result->chained_load_variance = variance / (double)buckets;
+
+  free(slots);
+  free(slot_hashes);
+  free(heads);
+  free(next);
+  free(hashes);
+  return 0;
+}
+
+static int run(const corpus_t *c) {
+  uint8_t cookie[16];
+  corpus_result_t result;
+  size_t i;
+
+  for(i=0; i<sizeof(cookie); i++) {
+    cookie[i] = (uint8_t)(0x5a ^ (i * 29));
+  }
+
+  printf("%s: %d keys, %.1f bytes on average, load factor %.2f open, %.2f chained\n",
+      c->name, (int)c->num_keys, (double)c->total_size / (double)c->num_keys,
+      (double)c->num_keys / (double)next_power_of_two(c->num_keys + c->num_keys/3 + 1),
+      (double)c->num_keys / (double)next_power_of_two(c->num_keys));
+  printf("  %-28s %10s | %12s %8s | %12s %8s\n", "", "Mkeys/s", "open Mlk/s", "probes", "chain Mlk/s", "load var");
+  for(i=0; i<sizeof(hash_functions)/sizeof(hash_functions[0]); i++) {
+    if(run_corpus(c, &hash_functions[i], cookie, &result) != 0) {
+      fprintf(stderr, "benchhx4: out of memory\n");
+      return 1;
+    }
+    printf("  %-28s %10.2f | %12.2f %8.3f | %12.2f %8.3f\n", hash_functions[i].name,
+        result.hash_keys_per_s / 1000000.0,
+        result.open_lookups_per_s / 1000000.0, result.open_average_probes,
+        result.chained_lookups_per_s / 1000000.0, result.chained_load_variance);
+  }
+  printf("\n");
+  return 0;
+}
+
+static void usage(void) {
+  fprintf(stderr, "usage: benchhx4 [-n keys] [corpus.txt ...]\n");
+  fprintf(stderr, "  times every hash function on a key set and in hash table simulations\n");
+  fprintf(stderr, "  -n keys  keys per corpus, default %d\n", BENCHHX4_DEFAULT_KEYS);
+  fprintf(stderr, "  without files words, URLs, UUIDs, integer IDs and log lines are generated\n");
+}
+
+int main(int argc, char *argv[]) {
+  static const struct {
+    const char *name;
+    key_generator_t generator;
+  } generated[] = {
+    { "words", generate_word },
+    { "urls", generate_url },
+    { "uuids", generate_uuid },
+    { "integer ids", generate_id },
+    { "log lines", generate_log_line },
+  };
+  size_t num_keys = BENCHHX4_DEFAULT_KEYS;
+  int num_files = 0;
+  corpus_t c;
+  size_t i;
+  int i_arg;
+  int rc = 0;
+
+  for(i_arg=1; i_arg<argc; i_arg++) {
+    if(strcmp(argv[i_arg], "-n") == 0 && i_arg + 1 < argc) {
+      num_keys = (size_t)strtoul(argv[++i_arg], NULL, 10);
+    } else if(argv[i_arg][0] == '-') {
+      usage();
+      return 1;
+    } else {
+      num_files++;
+    }
+  }
+  if(num_keys == 0 || num_keys >= 0xffffffffu) {
+    usage();
+    return 1;
+  }
+
+  if(num_files == 0) {
+    for(i=0; i<sizeof(generated)/sizeof(generated[0]) && rc == 0; i++) {
+      if(generate_corpus(&c, generated[i].name, generated[i].generator, num_keys) != 0) {
+        fprintf(stderr, "benchhx4: out of memory\n");
+        rc = 1;
+      } else {
+        rc = run(&c);
+      }
+      corpus_free(&c);
+    }
+    return rc;
+  }
+
+  for(i_arg=1; i_arg<argc && rc == 0; i_arg++) {
+    if(strcmp(argv[i_arg], "-n") == 0) {
+      i_arg++;
+      continue;
+    }
+    rc = read_corpus(&c, argv[i_arg], num_keys);
+    if(rc == 0) {
+      rc = run(&c);
+    }
+    corpus_free(&c);
+  }
+  return rc;
+}
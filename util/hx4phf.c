@@ -0,0 +1,323 @@
+/* 
+ * Copyright 2015 Kai Dietrich <mail@cleeus.de>
+ *
+ * This file is part of hashx4.
+ *
+ * Hashx4 is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Hashx4 is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with hashx4.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/*
+ * hx4phf - writes a minimal perfect hash table (hashx4_phf.h) of a static
+ * key set as C source.
+ *
+ *   hx4phf [-n name] [-b] keys.txt > table.c
+ *
+ * Every non empty line of keys.txt is a key, a trailing \r is dropped.
+ * The table is declared as `const hx4_phf name`, name_lines[slot] is the
+ * line index (0 based, empty lines not counted) of the key in a slot.
+ * With -b no table is written, lookups of all keys (hits) and of all keys
+ * with an appended byte (misses) are timed against bsearch over the sorted
+ * keys and a chain of strcmp calls.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "hashx4.h"
+#include "hashx4_phf.h"
+
+#include "hx4tool.h"
+
+// cookies tried before giving up, the table is the same for the same key file
+#define HX4PHF_MAX_ATTEMPTS 64
+#define HX4PHF_DEFAULT_NAME "hx4_phf_table"
+
+// searches cookies until hx4_phf_build succeeds and lays the keys out in slot order
+static int build_table(const hx_keys *k, hx4_phf *phf, uint32_t *displacements, uint32_t *key_offsets, char *key_data, uint32_t *lines) {
+  const size_t n = k->num_keys;
+  uint32_t *slots;
+  void *memory;
+  uint64_t state = 0;
+  uint64_t word = 0;
+  uint32_t offset;
+  size_t attempt;
+  size_t i;
+  int rc = HX4_ERR_SEARCH_FAILED;
+
+  slots = malloc((n + 1) * sizeof(uint32_t));
+  memory = malloc(HX4_PHF_BUILD_MEMORY_SIZE(n));
+  if(!slots || !memory) {
+    fprintf(stderr, "hx4phf: out of memory\n");
+    free(slots);
+    free(memory);
+    return 1;
+  }
+
+  for(attempt=0; attempt<HX4PHF_MAX_ATTEMPTS && rc == HX4_ERR_SEARCH_FAILED; attempt++) {
+    for(i=0; i<sizeof(phf->cookie); i++) {
+      if(i % 8 == 0) {
+        word = splitmix64(&state);
+      }
+      phf->cookie[i] = (uint8_t)(word >> (8*(i%8)));
+    }
+    rc = hx4_phf_build((const void *const *)k->keys, k->key_sizes, n, phf->cookie, sizeof(phf->cookie), displacements, slots, memory, HX4_PHF_BUILD_MEMORY_SIZE(n));
+  }
+  if(rc == HX4_ERR_PARAM_INVALID) {
+    fprintf(stderr, "hx4phf: duplicate keys\n");
+  } else if(rc != HX4_ERR_SUCCESS) {
+    fprintf(stderr, "hx4phf: no table found after %d cookies (%d)\n", HX4PHF_MAX_ATTEMPTS, rc);
+  }
+
+  if(rc == HX4_ERR_SUCCESS) {
+    phf->num_keys = (uint32_t)n;
+    phf->num_buckets = (uint32_t)HX4_PHF_NUM_BUCKETS(n);
+    phf->displacements = displacements;
+    phf->key_offsets = key_offsets;
+    phf->key_data = key_data;
+
+    //slots is a permutation, invert it into the line of every slot
+    for(i=0; i<n; i++) {
+      lines[slots[i]] = (uint32_t)i;
+    }
+    for(i=0, offset=0; i<n; i++) {
+      key_offsets[i] = offset;
+      memcpy(key_data + offset, k->keys[lines[i]], k->key_sizes[lines[i]]);
+      offset += (uint32_t)k->key_sizes[lines[i]];
+    }
+    key_offsets[n] = offset;
+  }
+
+  free(slots);
+  free(memory);
+  return rc == HX4_ERR_SUCCESS ? 0 : 1;
+}
+
+static void write_u32_array(FILE *out, const char *name, const char *suffix, const uint32_t *values, size_t n) {
+  size_t i;
+
+  fprintf(out, "static const uint32_t %s_%s[%d] = {", name, suffix, (int)(n ? n : 1));
+  for(i=0; i<n; i++) {
+    fprintf(out, "%s%u,", i % 8 == 0 ? "\n  " : " ", (unsigned)values[i]);
+  }
+  fprintf(out, "%s\n};\n\n", n ? "" : " 0");
+}
+
+// one string literal per key, octal escapes never run into the next character
+static void write_key_literal(FILE *out, const char *key, size_t key_sz) {
+  size_t i;
+
+  fprintf(out, "  \"");
+  for(i=0; i<key_sz; i++) {
+    unsigned char c = (unsigned char)key[i];
+    if(c < 0x20 || c >= 0x7f || c == '"' || c == '\\' || c == '?') {
+      fprintf(out, "\\%03o", c);
+    } else {
+      fputc(c, out);
+    }
+  }
+  fprintf(out, "\"\n");
+}
+
+static void write_table(FILE *out, const char *name, const char *filename, const hx4_phf *phf, const uint32_t *lines) {
+  size_t i;
+
+  fprintf(out, "/* generated by hx4phf from %s, %u keys, do not edit */\n\n", filename, (unsigned)phf->num_keys);
+  fprintf(out, "#include <stdint.h>\n#include \"hashx4_phf.h\"\n\n");
+  write_u32_array(out, name, "displacements", phf->displacements, phf->num_buckets);
+  write_u32_array(out, name, "key_offsets", phf->key_offsets, phf->num_keys + 1);
+
+  fprintf(out, "static const char %s_key_data[] =\n", name);
+  for(i=0; i<phf->num_keys; i++) {
+    write_key_literal(out, phf->key_data + phf->key_offsets[i], phf->key_offsets[i + 1] - phf->key_offsets[i]);
+  }
+  fprintf(out, "  \"\";\n\n");
+
+  fprintf(out, "/* the line of the key in every slot */\n");
+  fprintf(out, "const uint32_t %s_lines[%d] = {", name, (int)(phf->num_keys ? phf->num_keys : 1));
+  for(i=0; i<phf->num_keys; i++) {
+    fprintf(out, "%s%u,", i % 8 == 0 ? "\n  " : " ", (unsigned)lines[i]);
+  }
+  fprintf(out, "%s\n};\n\n", phf->num_keys ? "" : " 0");
+
+  fprintf(out, "const hx4_phf %s = {\n  {", name);
+  for(i=0; i<sizeof(phf->cookie); i++) {
+    fprintf(out, "%s0x%02x", i ? ", " : " ", phf->cookie[i]);
+  }
+  fprintf(out, " },\n  %u, %u,\n  %s_displacements,\n  %s_key_offsets,\n  %s_key_data\n};\n",
+      (unsigned)phf->num_keys, (unsigned)phf->num_buckets, name, name, name);
+}
+
+static int compare_strings(const void *a, const void *b) {
+  return strcmp(*(const char *const *)a, *(const char *const *)b);
+}
+
+// runs the lookups of one method until half a second has passed, returns ns per lookup
+#define HX4PHF_TIME_LOOKUPS(result, lookup) \
+  { \
+    hx_time start = hx_gettime(); \
+    hx_time stop; \
+    size_t rounds = 0; \
+    size_t q; \
+    double elapsed; \
+    do { \
+      for(q=0; q<num_queries; q++) { \
+        lookup; \
+      } \
+      rounds++; \
+      stop = hx_gettime(); \
+      elapsed = hx_timedelta_s(&start, &stop); \
+    } while(elapsed < 0.5); \
+    result = elapsed * 1000000000.0 / (double)(rounds * num_queries); \
+  }
+
+static int benchmark(const hx_keys *k, const hx4_phf *phf) {
+  const size_t n = k->num_keys;
+  const size_t num_queries = n;
+  char **sorted;
+  char **misses;
+  size_t *miss_sizes;
+  char *miss_buffer;
+  size_t miss_buffer_sz = 0;
+  char *p;
+  volatile size_t sink = 0;
+  const void *found;
+  double ns[3][2];
+  size_t i;
+  size_t j;
+  int rc = 0;
+
+  for(i=0; i<n; i++) {
+    miss_buffer_sz += k->key_sizes[i] + 2;
+  }
+  sorted = malloc(n * sizeof(char*));
+  misses = malloc(n * sizeof(char*));
+  miss_sizes = malloc(n * sizeof(size_t));
+  miss_buffer = malloc(miss_buffer_sz + 1);
+  if(!n) {
+    fprintf(stderr, "hx4phf: no keys to benchmark\n");
+    rc = 1;
+    goto out;
+  }
+  if(!sorted || !misses || !miss_sizes || !miss_buffer) {
+    fprintf(stderr, "hx4phf: out of memory\n");
+    rc = 1;
+    goto out;
+  }
+  memcpy(sorted, k->keys, n * sizeof(char*));
+  qsort(sorted, n, sizeof(char*), compare_strings);
+  for(i=0, p=miss_buffer; i<n; i++) {
+    misses[i] = p;
+    memcpy(p, k->keys[i], k->key_sizes[i]);
+    p[k->key_sizes[i]] = '~';
+    p[k->key_sizes[i] + 1] = 0;
+    miss_sizes[i] = k->key_sizes[i] + 1;
+    p += miss_sizes[i] + 1;
+  }
+
+  HX4PHF_TIME_LOOKUPS(ns[0][0], sink += (size_t)hx4_phf_lookup(phf, k->keys[q], k->key_sizes[q]))
+  HX4PHF_TIME_LOOKUPS(ns[0][1], sink += (size_t)hx4_phf_lookup(phf, misses[q], miss_sizes[q]))
+  HX4PHF_TIME_LOOKUPS(ns[1][0], found = bsearch(&k->keys[q], sorted, n, sizeof(char*), compare_strings); sink += found != NULL)
+  HX4PHF_TIME_LOOKUPS(ns[1][1], found = bsearch(&misses[q], sorted, n, sizeof(char*), compare_strings); sink += found != NULL)
+  HX4PHF_TIME_LOOKUPS(ns[2][0], for(j=0; j<n && strcmp(k->keys[q], k->keys[j]) != 0; j++) {} sink += j)
+  HX4PHF_TIME_LOOKUPS(ns[2][1], for(j=0; j<n && strcmp(misses[q], k->keys[j]) != 0; j++) {} sink += j)
+
+  printf("%d keys, ns per lookup\n", (int)n);
+  printf("%-16s %10s %10s\n", "", "hit", "miss");
+  printf("%-16s %10.1f %10.1f\n", "hx4_phf_lookup", ns[0][0], ns[0][1]);
+  printf("%-16s %10.1f %10.1f\n", "bsearch", ns[1][0], ns[1][1]);
+  printf("%-16s %10.1f %10.1f\n", "strcmp chain", ns[2][0], ns[2][1]);
+
+out:
+  free(sorted);
+  free(misses);
+  free(miss_sizes);
+  free(miss_buffer);
+  return rc;
+}
+
+static void usage(void) {
+  fprintf(stderr, "usage: hx4phf [-n name] [-b] keys.txt\n");
+  fprintf(stderr, "  writes a minimal perfect hash table of the lines of keys.txt as C to stdout\n");
+  fprintf(stderr, "  -n name  name of the hx4_phf table, default " HX4PHF_DEFAULT_NAME "\n");
+  fprintf(stderr, "  -b       benchmark lookups against bsearch and a strcmp chain instead\n");
+}
+
+int main(int argc, char *argv[]) {
+  const char *name = HX4PHF_DEFAULT_NAME;
+  const char *filename = NULL;
+  int bench = 0;
+  hx_keys k;
+  hx4_phf phf;
+  uint32_t *displacements = NULL;
+  uint32_t *key_offsets = NULL;
+  uint32_t *lines = NULL;
+  char *key_data = NULL;
+  size_t key_data_sz = 0;
+  size_t i;
+  int i_arg;
+  int rc;
+
+  for(i_arg=1; i_arg<argc; i_arg++) {
+    if(strcmp(argv[i_arg], "-n") == 0 && i_arg + 1 < argc) {
+      name = argv[++i_arg];
+    } else if(strcmp(argv[i_arg], "-b") == 0) {
+      bench = 1;
+    } else if(argv[i_arg][0] != '-' && !filename) {
+      filename = argv[i_arg];
+    } else {
+      usage();
+      return 1;
+    }
+  }
+  if(!filename) {
+    usage();
+    return 1;
+  }
+
+  rc = hx_read_keys("hx4phf", filename, (size_t)-1, &k);
+  if(rc == 0) {
+    for(i=0; i<k.num_keys; i++) {
+      key_data_sz += k.key_sizes[i];
+    }
+    displacements = malloc((HX4_PHF_NUM_BUCKETS(k.num_keys) + 1) * sizeof(uint32_t));
+    key_offsets = malloc((k.num_keys + 1) * sizeof(uint32_t));
+    lines = malloc((k.num_keys + 1) * sizeof(uint32_t));
+    key_data = malloc(key_data_sz + 1);
+    if(!displacements || !key_offsets || !lines || !key_data) {
+      fprintf(stderr, "hx4phf: out of memory\n");
+      rc = 1;
+    }
+  }
+  if(rc == 0) {
+    memset(&phf, 0, sizeof(phf));
+    rc = build_table(&k, &phf, displacements, key_offsets, key_data, lines);
+  }
+  if(rc == 0) {
+    if(bench) {
+      rc = benchmark(&k, &phf);
+    } else {
+      write_table(stdout, name, filename, &phf, lines);
+    }
+  }
+
+  free(displacements);
+  free(key_offsets);
+  free(lines);
+  free(key_data);
+  hx_keys_free(&k);
+  return rc;
+}
@@ -0,0 +1,160 @@
+#ifndef HX4TOOL_H
+#define HX4TOOL_H
+/* 
+ * Copyright 2015 Kai Dietrich <mail@cleeus.de>
+ *
+ * This file is part of hashx4.
+ *
+ * Hashx4 is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Hashx4 is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with hashx4.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Helpers of the command line tools in util/ (hx4phf, benchhx4): a monotonic
+ * clock, a seeded random generator and reading a text file as keys.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#ifdef __GNUC__
+# include <time.h>
+#elif _MSC_VER
+# include <windows.h>
+#endif
+
+#include "hashx4_config.h"
+
+typedef struct {
+#ifdef __GNUC__
+  struct timespec ts;
+#elif _MSC_VER
+  DWORD ticks;
+#endif
+} hx_time;
+
+HX4_INLINE hx_time hx_gettime() {
+  hx_time out;
+  memset(&out, 0, sizeof(out));
+
+#ifdef __GNUC__
+  clock_gettime(CLOCK_MONOTONIC, &out.ts);
+#elif _MSC_VER
+  out.ticks = GetTickCount();
+#endif
+  return out;
+}
+
+HX4_INLINE double hx_timedelta_s(const hx_time *start, const hx_time *stop) {
+#ifdef __GNUC__
+  return (double)(stop->ts.tv_sec - start->ts.tv_sec) + (double)(stop->ts.tv_nsec - start->ts.tv_nsec) / 1000000000.0;
+#elif _MSC_VER
+  return (double)(stop->ticks - start->ticks) / 1000.0;
+#endif
+}
+
+HX4_INLINE uint64_t splitmix64(uint64_t *state) {
+  uint64_t z = (*state += 0x9e3779b97f4a7c15ULL);
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+  return z ^ (z >> 31);
+}
+
+/* the non empty lines of a file, NUL terminated in buffer */
+typedef struct {
+  char **keys;
+  size_t *key_sizes;
+  size_t num_keys;
+  char *buffer;
+} hx_keys;
+
+HX4_INLINE void hx_keys_free(hx_keys *k) {
+  free(k->keys);
+  free(k->key_sizes);
+  free(k->buffer);
+  memset(k, 0, sizeof(*k));
+}
+
+/* reads the file and splits it into NUL terminated lines in place, at most
+ * max_keys of them. A trailing \r is dropped and empty lines are skipped.
+ * Errors are printed to stderr behind the name of the tool. */
+HX4_INLINE int hx_read_keys(const char *tool, const char *filename, size_t max_keys, hx_keys *k) {
+  FILE *f;
+  char *grown;
+  size_t buffer_sz = 0;
+  size_t buffer_capacity = 4096;
+  size_t n;
+  size_t i;
+  size_t start;
+
+  memset(k, 0, sizeof(*k));
+  f = fopen(filename, "rb");
+  if(!f) {
+    fprintf(stderr, "%s: can not open %s\n", tool, filename);
+    return 1;
+  }
+  k->buffer = (char*)malloc(buffer_capacity + 1);
+  while(k->buffer) {
+    n = fread(k->buffer + buffer_sz, 1, buffer_capacity - buffer_sz, f);
+    buffer_sz += n;
+    if(buffer_sz < buffer_capacity) {
+      break;
+    }
+    buffer_capacity *= 2;
+    grown = (char*)realloc(k->buffer, buffer_capacity + 1);
+    if(!grown) {
+      free(k->buffer);
+    }
+    k->buffer = grown;
+  }
+  fclose(f);
+  if(!k->buffer) {
+    fprintf(stderr, "%s: out of memory\n", tool);
+    return 1;
+  }
+  k->buffer[buffer_sz] = '\n';
+
+  //at most one key per newline plus the unterminated last line
+  n = 1;
+  for(i=0; i<buffer_sz; i++) {
+    n += k->buffer[i] == '\n';
+  }
+  k->keys = (char**)malloc(n * sizeof(char*));
+  k->key_sizes = (size_t*)malloc(n * sizeof(size_t));
+  if(!k->keys || !k->key_sizes) {
+    fprintf(stderr, "%s: out of memory\n", tool);
+    return 1;
+  }
+
+  for(i=0, start=0; i<=buffer_sz && k->num_keys < max_keys; i++) {
+    if(k->buffer[i] != '\n') {
+      continue;
+    }
+    n = i - start;
+    if(n && k->buffer[start + n - 1] == '\r') {
+      n--;
+    }
+    k->buffer[start + n] = 0;
+    if(n) {
+      k->keys[k->num_keys] = k->buffer + start;
+      k->key_sizes[k->num_keys] = n;
+      k->num_keys++;
+    }
+    start = i + 1;
+  }
+  return 0;
+}
+
+#endif
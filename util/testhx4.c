@@ -24,11 +24,32 @@
 
 #ifdef __GNUC__
 # include <time.h>
+# include <pthread.h>
+# include <unistd.h>
+# include <sys/mman.h>
 #elif _MSC_VER
 # include <windows.h>
 #endif
 
 #include "hashx4.h"
+#include "hashx4_fixed.h"
+#include "hashx4_partition.h"
+#include "hashx4_bloom.h"
+#include "hashx4_sketch.h"
+#include "hashx4_minhash.h"
+#include "hashx4_phf.h"
+#include "hashx4_intern.h"
+#include "hashx4_job.h"
+#include "hashx4_dispatch.h"
+#include "hashx4_stats.h"
+
+/* the tests of the C++ interface are in testhx4_cpp.cpp */
+int test_hx4_cpp_correctness(FILE *stream, const void *in, size_t in_sz, const void *cookie, size_t cookie_sz);
+int test_hx4_cpp_hasher_performance(FILE *stream, const void *in, size_t in_sz, const void *cookie, size_t cookie_sz);
+int test_hx4_cpp_intern_performance(FILE *stream, const void *in, size_t in_sz, const void *cookie, size_t cookie_sz);
+
+/* and in testhx4_job.cpp, built as C++20 if the compiler can */
+int test_hx4_job_cpp_correctness(FILE *stream, const void *in, size_t in_sz, const void *cookie, size_t cookie_sz);
 
 typedef struct {
 #ifdef __GNUC__
@@ -58,11 +79,34 @@ float hx_time_to_s(const hx_time *t) {
 #endif
 }
 
+#ifdef __GNUC__
+typedef pthread_t hx_thread;
+# define HX_THREAD_FUNCTION(name) static void *name(void *arg)
+# define HX_THREAD_RETURN return NULL
+# define hx_thread_start(thread, function, arg) pthread_create((thread), NULL, (function), (arg))
+# define hx_thread_join(thread) pthread_join((thread), NULL)
+#elif _MSC_VER
+typedef HANDLE hx_thread;
+# define HX_THREAD_FUNCTION(name) static DWORD WINAPI name(LPVOID arg)
+# define HX_THREAD_RETURN return 0
+# define hx_thread_start(thread, function, arg) ((*(thread) = CreateThread(NULL, 0, (function), (arg), 0, NULL)) == NULL)
+# define hx_thread_join(thread) (WaitForSingleObject((thread), INFINITE), CloseHandle(thread))
+#endif
+
 float hx_timedelta_s(const hx_time *start, const hx_time *end) {
   float delta = hx_time_to_s(end) - hx_time_to_s(start);
   return delta >= 0 ? delta : -delta;
 }
 
+/* in double precision, for short intervals */
+double hx_timedelta_us(const hx_time *start, const hx_time *end) {
+#ifdef __GNUC__
+  return (double)(end->ts.tv_sec - start->ts.tv_sec) * 1000000.0 + (double)(end->ts.tv_nsec - start->ts.tv_nsec) / 1000.0;
+#elif _MSC_VER
+  return (double)(end->ticks - start->ticks) * 1000.0;
+#endif
+}
+
 float MiB_per_s(float bytes, const hx_time *start, const hx_time *end) {
   float duration_s = hx_timedelta_s(start, end);
   if(duration_s == 0) {
@@ -141,11 +185,364 @@ HX4_PERF_TEST_IMPL(hx4_x4djbx33a_128_mmx, 128)
 #endif
 #if HX4_HAS_SSE2
 HX4_PERF_TEST_IMPL(hx4_x4djbx33a_128_sse2, 128)
+HX4_PERF_TEST_IMPL(hx4_x4djbx33a_128_sse2rle, 128)
 #endif
 #if HX4_HAS_SSSE3
 HX4_PERF_TEST_IMPL(hx4_x4djbx33a_128_ssse3, 128)
 #endif
+#if HX4_HAS_SSE2
+HX4_PERF_TEST_IMPL(hx4_x4kdjbx33a_128_sse2, 128)
+#endif
+#if HX4_HAS_SSSE3
+HX4_PERF_TEST_IMPL(hx4_x4kdjbx33a_128_ssse3, 128)
+#endif
 HX4_PERF_TEST_IMPL(hx4_siphash24_64_ref, 64)
+#if HX4_HAS_SSE42
+HX4_PERF_TEST_IMPL(hx4_crc32c_32_sse42, 32)
+HX4_PERF_TEST_IMPL(hx4_x4crc32c_128_sse42, 128)
+#endif
+#if HX4_HAS_SSE42 && HX4_HAS_PCLMUL
+HX4_PERF_TEST_IMPL(hx4_crc32c_32_pclmul, 32)
+#endif
+#if HX4_HAS_AESNI
+HX4_PERF_TEST_IMPL(hx4_x4aes_128_aesni, 128)
+#endif
+#if HX4_HAS_SSE2
+HX4_PERF_TEST_IMPL(hx4_x4mulfold_128_sse2, 128)
+#endif
+#if HX4_HAS_AVX2
+HX4_PERF_TEST_IMPL(hx4_x4mulfold_128_avx2, 128)
+#endif
+
+typedef int (*hash_function_t)(const void *, size_t, const void *, size_t, void *, size_t);
+typedef struct {
+  hash_function_t function;
+  const char *name;
+  size_t output_size;
+} hash_function_item_t;
+
+#define HASH_FUNCTION_ITEM(function_name, output_bits) { function_name , #function_name , (output_bits)/8 } ,
+
+static float measure_MiB_per_s(hash_function_t hash_function, const void *in, size_t in_sz, const void *cookie, size_t cookie_sz, size_t out_sz, float duration_s) {
+  volatile int rc = 0;
+  hx_time start;
+  hx_time stop;
+  float timedelta = 0;
+  uint64_t repeat_count = 0;
+  uint64_t i = 0;
+  const uint64_t micro_repeats = 1 + (1024*1024 / in_sz);
+  volatile unsigned char hash_output[512/8];
+
+  start = hx_gettime();
+  stop = start;
+  while (timedelta < duration_s) {
+    repeat_count += micro_repeats;
+    for(i=0; i<micro_repeats; i++) {
+      rc += hash_function(in, in_sz, cookie, cookie_sz, (void*)hash_output, out_sz);
+    }
+    stop = hx_gettime();
+    timedelta = hx_timedelta_s(&start, &stop);
+  }
+  return MiB_per_s((float)((double)in_sz*(double)repeat_count), &start, &stop);
+}
+
+/* prints a table of the hashrates in MiB/s of several functions at input sizes from 8 bytes to 4 KiB */
+static void print_short_input_performance(FILE *stream, const hash_function_item_t *items, size_t num_items, const void *in, const void *cookie, size_t cookie_sz) {
+  size_t i;
+  size_t sz;
+
+  fprintf(stream, "\t| %-32s |", "MiB/s");
+  for(sz = 8; sz <= 4096; sz *= 2) {
+    fprintf(stream, " %5d |", (int)sz);
+  }
+  fprintf(stream, "\n");
+
+  for(i=0; i<num_items; i++) {
+    fprintf(stream, "\t| %-32s |", items[i].name);
+    for(sz = 8; sz <= 4096; sz *= 2) {
+      fprintf(stream, " %5.0f |", (double)measure_MiB_per_s(items[i].function, in, sz, cookie, cookie_sz, items[i].output_size, 0.2f));
+    }
+    fprintf(stream, "\n");
+  }
+}
+
+static int test_hx4_siphash_short_input_performance(FILE *stream, const void *in, size_t in_sz, const void *cookie, size_t cookie_sz) {
+  const hash_function_item_t items[] = {
+    HASH_FUNCTION_ITEM(hx4_siphash24_64_ref, 64)
+    HASH_FUNCTION_ITEM(hx4_siphash24_64_copt, 64)
+    HASH_FUNCTION_ITEM(hx4_siphash13_64_ref, 64)
+    HASH_FUNCTION_ITEM(hx4_siphash13_64_copt, 64)
+    HASH_FUNCTION_ITEM(hx4_x4siphash13_256_ref, 256)
+#if HX4_HAS_SSE2
+    HASH_FUNCTION_ITEM(hx4_x4siphash13_256_sse2, 256)
+#endif
+    HASH_FUNCTION_ITEM(hx4_halfsiphash13_32_ref, 32)
+    HASH_FUNCTION_ITEM(hx4_halfsiphash13_32_copt, 32)
+    HASH_FUNCTION_ITEM(hx4_x4halfsiphash13_128_ref, 128)
+#if HX4_HAS_SSE2
+    HASH_FUNCTION_ITEM(hx4_x4halfsiphash13_128_sse2, 128)
+#endif
+  };
+
+  (void)in_sz;
+  print_short_input_performance(stream, items, sizeof(items)/sizeof(items[0]), in, cookie, cookie_sz);
+  return 0;
+}
+
+static int test_hx4_crc32c_short_input_performance(FILE *stream, const void *in, size_t in_sz, const void *cookie, size_t cookie_sz) {
+  const hash_function_item_t items[] = {
+    HASH_FUNCTION_ITEM(hx4_crc32c_32_ref, 32)
+    HASH_FUNCTION_ITEM(hx4_x4crc32c_128_ref, 128)
+#if HX4_HAS_SSE42
+    HASH_FUNCTION_ITEM(hx4_crc32c_32_sse42, 32)
+    HASH_FUNCTION_ITEM(hx4_x4crc32c_128_sse42, 128)
+#endif
+#if HX4_HAS_SSE42 && HX4_HAS_PCLMUL
+    HASH_FUNCTION_ITEM(hx4_crc32c_32_pclmul, 32)
+#endif
+#if HX4_HAS_SSE2
+    HASH_FUNCTION_ITEM(hx4_x4djbx33a_128_sse2, 128)
+#endif
+  };
+
+  (void)in_sz;
+  print_short_input_performance(stream, items, sizeof(items)/sizeof(items[0]), in, cookie, cookie_sz);
+  return 0;
+}
+
+static int test_hx4_x4aes_short_input_performance(FILE *stream, const void *in, size_t in_sz, const void *cookie, size_t cookie_sz) {
+  const hash_function_item_t items[] = {
+    HASH_FUNCTION_ITEM(hx4_x4aes_128_ref, 128)
+#if HX4_HAS_AESNI
+    HASH_FUNCTION_ITEM(hx4_x4aes_128_aesni, 128)
+#endif
+#if HX4_HAS_SSE2
+    HASH_FUNCTION_ITEM(hx4_x4djbx33a_128_sse2, 128)
+#endif
+    HASH_FUNCTION_ITEM(hx4_siphash13_64_copt, 64)
+  };
+
+  (void)in_sz;
+  print_short_input_performance(stream, items, sizeof(items)/sizeof(items[0]), in, cookie, cookie_sz);
+  return 0;
+}
+
+static int test_hx4_polyval_performance(FILE *stream, const void *in, size_t in_sz, const void *cookie, size_t cookie_sz) {
+  const hash_function_item_t items[] = {
+    HASH_FUNCTION_ITEM(hx4_polyval_128_ref, 128)
+#if HX4_HAS_PCLMUL
+    HASH_FUNCTION_ITEM(hx4_polyval_128_pclmul, 128)
+#endif
+    HASH_FUNCTION_ITEM(hx4_siphash24_64_copt, 64)
+    HASH_FUNCTION_ITEM(hx4_siphash13_64_copt, 64)
+  };
+  const size_t sizes[] = { 64, 1024, 64*1024, 1024*1024, 16*1024*1024 };
+  size_t i;
+  size_t j;
+
+  if(in_sz < sizes[sizeof(sizes)/sizeof(sizes[0]) - 1]) {
+    fprintf(stream, "\tinput buffer too small\n");
+    return 1;
+  }
+
+  fprintf(stream, "\t| %-32s |", "GiB/s");
+  for(j=0; j<sizeof(sizes)/sizeof(sizes[0]); j++) {
+    if(sizes[j] >= 1024*1024) {
+      fprintf(stream, " %4dMiB |", (int)(sizes[j] / (1024*1024)));
+    } else if(sizes[j] >= 1024) {
+      fprintf(stream, " %4dKiB |", (int)(sizes[j] / 1024));
+    } else {
+      fprintf(stream, " %6dB |", (int)sizes[j]);
+    }
+  }
+  fprintf(stream, "\n");
+
+  for(i=0; i<sizeof(items)/sizeof(items[0]); i++) {
+    fprintf(stream, "\t| %-32s |", items[i].name);
+    for(j=0; j<sizeof(sizes)/sizeof(sizes[0]); j++) {
+      fprintf(stream, " %7.2f |", (double)measure_MiB_per_s(items[i].function, in, sizes[j], cookie, cookie_sz, items[i].output_size, 0.5f) / 1024.0);
+    }
+    fprintf(stream, "\n");
+  }
+  return 0;
+}
+
+static int test_hx4_x4mulfold_short_input_performance(FILE *stream, const void *in, size_t in_sz, const void *cookie, size_t cookie_sz) {
+  const hash_function_item_t items[] = {
+    HASH_FUNCTION_ITEM(hx4_x4djbx33a_128_copt, 128)
+#if HX4_HAS_SSE2
+    HASH_FUNCTION_ITEM(hx4_x4djbx33a_128_sse2, 128)
+#endif
+#if HX4_HAS_SSSE3
+    HASH_FUNCTION_ITEM(hx4_x4djbx33a_128_ssse3, 128)
+#endif
+    HASH_FUNCTION_ITEM(hx4_x4mulfold_128_ref, 128)
+    HASH_FUNCTION_ITEM(hx4_x4mulfold_128_copt, 128)
+#if HX4_HAS_SSE2
+    HASH_FUNCTION_ITEM(hx4_x4mulfold_128_sse2, 128)
+#endif
+#if HX4_HAS_AVX2
+    HASH_FUNCTION_ITEM(hx4_x4mulfold_128_avx2, 128)
+#endif
+  };
+
+  (void)in_sz;
+  print_short_input_performance(stream, items, sizeof(items)/sizeof(items[0]), in, cookie, cookie_sz);
+  return 0;
+}
+
+/* the same short key loops as in testhx4_inline.c, but calling into the library */
+#define HX4_LIBRARY_KEYS_IMPL(function_name, output_bits, key_sz) \
+uint64_t hx4_inline_keys_##function_name##_##key_sz(const uint8_t *keys, size_t num_keys, const void *cookie, size_t cookie_sz); \
+static uint64_t hx4_library_keys_##function_name##_##key_sz(const uint8_t *keys, size_t num_keys, const void *cookie, size_t cookie_sz) { \
+  uint8_t out[(output_bits)/8]; \
+  uint64_t word; \
+  uint64_t checksum = 0; \
+  size_t i; \
+  for(i=0; i<num_keys; i++) { \
+    function_name(keys + i*(key_sz), (key_sz), cookie, cookie_sz, out, sizeof(out)); \
+    word = 0; \
+    memcpy(&word, out, sizeof(out) < sizeof(word) ? sizeof(out) : sizeof(word)); \
+    checksum ^= word + i; \
+  } \
+  return checksum; \
+}
+
+HX4_LIBRARY_KEYS_IMPL(hx4_x4djbx33a_128_copt, 128, 8)
+HX4_LIBRARY_KEYS_IMPL(hx4_x4djbx33a_128_copt, 128, 16)
+HX4_LIBRARY_KEYS_IMPL(hx4_siphash13_64_copt, 64, 8)
+HX4_LIBRARY_KEYS_IMPL(hx4_siphash13_64_copt, 64, 16)
+HX4_LIBRARY_KEYS_IMPL(hx4_x4mulfold_128_copt, 128, 8)
+HX4_LIBRARY_KEYS_IMPL(hx4_x4mulfold_128_copt, 128, 16)
+
+typedef uint64_t (*keys_function_t)(const uint8_t *, size_t, const void *, size_t);
+typedef struct {
+  keys_function_t inline_function;
+  keys_function_t library_function;
+  const char *name;
+  size_t key_sz;
+} keys_function_item_t;
+
+#define KEYS_FUNCTION_ITEM(function_name, key_sz) { hx4_inline_keys_##function_name##_##key_sz , hx4_library_keys_##function_name##_##key_sz , #function_name , (key_sz) } ,
+
+static float measure_Mkeys_per_s(keys_function_t keys_function, const uint8_t *keys, size_t num_keys, const void *cookie, size_t cookie_sz, float duration_s) {
+  volatile uint64_t checksum = 0;
+  hx_time start;
+  hx_time stop;
+  float timedelta = 0;
+  uint64_t repeat_count = 0;
+
+  start = hx_gettime();
+  stop = start;
+  while (timedelta < duration_s) {
+    checksum ^= keys_function(keys, num_keys, cookie, cookie_sz);
+    repeat_count++;
+    stop = hx_gettime();
+    timedelta = hx_timedelta_s(&start, &stop);
+  }
+  return (float)((double)num_keys * (double)repeat_count / (double)timedelta / 1000000.0);
+}
+
+/*
+ * Hashes 8 and 16 byte keys through the header-only build (testhx4_inline.c)
+ * and through the library and prints the keys per second of both.
+ * Both builds have to produce the same checksum.
+ */
+static int test_hx4_inline_short_key_performance(FILE *stream, const void *in, size_t in_sz, const void *cookie, size_t cookie_sz) {
+  const keys_function_item_t items[] = {
+    KEYS_FUNCTION_ITEM(hx4_x4djbx33a_128_copt, 8)
+    KEYS_FUNCTION_ITEM(hx4_x4djbx33a_128_copt, 16)
+    KEYS_FUNCTION_ITEM(hx4_siphash13_64_copt, 8)
+    KEYS_FUNCTION_ITEM(hx4_siphash13_64_copt, 16)
+    KEYS_FUNCTION_ITEM(hx4_x4mulfold_128_copt, 8)
+    KEYS_FUNCTION_ITEM(hx4_x4mulfold_128_copt, 16)
+  };
+  const size_t num_items = sizeof(items)/sizeof(items[0]);
+  const uint8_t *keys = (const uint8_t*)in;
+  size_t num_keys;
+  size_t i;
+  int failed = 0;
+
+  fprintf(stream, "\t| %-24s | %3s | %14s | %14s |\n", "Mkeys/s", "key", "inline", "library");
+  for(i=0; i<num_items; i++) {
+    num_keys = in_sz / items[i].key_sz;
+    if(num_keys > 4096) {
+      num_keys = 4096;
+    }
+    if(items[i].inline_function(keys, num_keys, cookie, cookie_sz) != items[i].library_function(keys, num_keys, cookie, cookie_sz)) {
+      fprintf(stream, "\t%s: the inline and the library checksums of %d byte keys differ\n", items[i].name, (int)items[i].key_sz);
+      failed = 1;
+      continue;
+    }
+    fprintf(stream, "\t| %-24s | %3d | %14.2f | %14.2f |\n",
+      items[i].name,
+      (int)items[i].key_sz,
+      (double)measure_Mkeys_per_s(items[i].inline_function, keys, num_keys, cookie, cookie_sz, 0.5f),
+      (double)measure_Mkeys_per_s(items[i].library_function, keys, num_keys, cookie, cookie_sz, 0.5f)
+    );
+  }
+
+  return failed;
+}
+
+#undef HX4_LIBRARY_KEYS_IMPL
+#undef KEYS_FUNCTION_ITEM
+
+/* written and removed again by the dispatch tests, in the working directory */
+#define HX4_DISPATCH_TEST_PROFILE "testhx4_dispatch.tmp"
+
+static int test_hx4_dispatch_calibrate_performance(FILE *stream, const void *in, size_t in_sz, const void *cookie, size_t cookie_sz) {
+  hx4_dispatch_table table;
+  hx4_dispatch_table loaded;
+  void *memory;
+  hx_time start;
+  hx_time stop;
+  float calibrate_s;
+  float load_s;
+  int algorithm;
+  int size_class;
+  int rc;
+
+  (void)in;
+  (void)in_sz;
+  (void)cookie;
+  (void)cookie_sz;
+
+  memory = malloc(HX4_DISPATCH_CALIBRATE_MEMORY_SIZE);
+  if(memory == NULL) {
+    return 1;
+  }
+  remove(HX4_DISPATCH_TEST_PROFILE);
+  start = hx_gettime();
+  rc = hx4_dispatch_load_or_calibrate(&table, HX4_DISPATCH_TEST_PROFILE, memory, HX4_DISPATCH_CALIBRATE_MEMORY_SIZE);
+  stop = hx_gettime();
+  calibrate_s = hx_timedelta_s(&start, &stop);
+  free(memory);
+  if(rc != HX4_ERR_SUCCESS) {
+    return rc;
+  }
+
+  start = hx_gettime();
+  rc = hx4_dispatch_load(&loaded, HX4_DISPATCH_TEST_PROFILE);
+  stop = hx_gettime();
+  load_s = hx_timedelta_s(&start, &stop);
+  remove(HX4_DISPATCH_TEST_PROFILE);
+  if(rc != HX4_ERR_SUCCESS) {
+    return rc;
+  }
+
+  fprintf(stream, "\t%s\n", table.cpu);
+  fprintf(stream, "\tcalibration %.3fs, loading the profile %.6fs\n", (double)calibrate_s, (double)load_s);
+  fprintf(stream, "\t| %-20s | %8s | %8s | %8s | %8s | %8s |\n", "kernel", "<=16", "<=64", "<=256", "<=4K", ">4K");
+  for(algorithm=0; algorithm<HX4_ALG_COUNT; algorithm++) {
+    fprintf(stream, "\t| %-20s |", hx4_dispatch_algorithm_name(algorithm));
+    for(size_class=0; size_class<HX4_DISPATCH_SIZE_CLASSES; size_class++) {
+      fprintf(stream, " %8s |", hx4_dispatch_kernel_name(algorithm, table.kernel[algorithm][size_class]));
+    }
+    fprintf(stream, "\n");
+  }
+  return 0;
+}
 
 static int test_hx4_x4djbx33a_128_all_correctness(FILE *stream, const void *in, size_t in_sz, const void *cookie, size_t cookie_sz) {
   int rc = 0;
@@ -157,6 +554,7 @@ static int test_hx4_x4djbx33a_128_all_correctness(FILE *stream, const void *in,
 #endif
 #if HX4_HAS_SSE2
   uint8_t hash_output_sse2[128/8];
+  uint8_t hash_output_sse2rle[128/8];
 #endif
 #if HX4_HAS_SSSE3
   uint8_t hash_output_ssse3[128 / 8];
@@ -192,6 +590,10 @@ static int test_hx4_x4djbx33a_128_all_correctness(FILE *stream, const void *in,
     if(rc != HX4_ERR_SUCCESS) {
       return rc;
     }
+    rc = hx4_x4djbx33a_128_sse2rle((uint8_t*)in+i, in_sz-i, cookie, cookie_sz, hash_output_sse2rle, sizeof(hash_output_sse2rle));
+    if(rc != HX4_ERR_SUCCESS) {
+      return rc;
+    }
 #endif
 #if HX4_HAS_SSSE3
     rc = hx4_x4djbx33a_128_ssse3((uint8_t*)in+i, in_sz-i, cookie, cookie_sz, hash_output_ssse3, sizeof(hash_output_ssse3));
@@ -215,6 +617,10 @@ static int test_hx4_x4djbx33a_128_all_correctness(FILE *stream, const void *in,
       fprintf(stream, "\tsse2 output doesn't match ref output at offset %d\n", i);
       return 1;
     }
+    if(memcmp(hash_output_ref, hash_output_sse2rle, sizeof(hash_output_ref)) != 0) {
+      fprintf(stream, "\tsse2rle output doesn't match ref output at offset %d\n", i);
+      return 1;
+    }
 #endif
 #if HX4_HAS_SSSE3
     if (memcmp(hash_output_ref, hash_output_ssse3, sizeof(hash_output_ref)) != 0) {
@@ -228,6 +634,85 @@ static int test_hx4_x4djbx33a_128_all_correctness(FILE *stream, const void *in,
   return 0;
 }
 
+#if HX4_HAS_SSE2
+static void init_runs_buffer(unsigned char *buffer, size_t buffer_size) {
+  size_t i = 0;
+  size_t run_length;
+  unsigned char c;
+
+  srand(42);
+  while(i < buffer_size) {
+    //mostly zero runs like in sparse files, mixed with short noise and runs of other bytes
+    run_length = 1 + (size_t)rand() % (rand() % 4 == 0 ? 16 : 4000);
+    c = rand() % 3 == 0 ? (unsigned char)rand() : 0;
+    for(; run_length > 0 && i < buffer_size; run_length--, i++) {
+      buffer[i] = c;
+    }
+  }
+}
+
+static int test_hx4_x4djbx33a_128_sse2rle_runs_correctness(FILE *stream, const void *in, size_t in_sz, const void *cookie, size_t cookie_sz) {
+  int rc = 0;
+  int i;
+  uint8_t hash_output_ref[128/8];
+  uint8_t hash_output_sse2rle[128/8];
+  unsigned char *runs_buffer;
+  const size_t runs_buffer_size = 1024*1024;
+
+  (void)in;
+  (void)in_sz;
+
+  runs_buffer = malloc(runs_buffer_size);
+  if(!runs_buffer) {
+    fprintf(stream, "\tout of memory\n");
+    return 1;
+  }
+  init_runs_buffer(runs_buffer, runs_buffer_size);
+
+  for(i=0; i<32 && rc == 0; i++) {
+    rc = hx4_x4djbx33a_128_ref(runs_buffer+i, runs_buffer_size-i*1023, cookie, cookie_sz, hash_output_ref, sizeof(hash_output_ref));
+    if(rc != HX4_ERR_SUCCESS) {
+      break;
+    }
+    rc = hx4_x4djbx33a_128_sse2rle(runs_buffer+i, runs_buffer_size-i*1023, cookie, cookie_sz, hash_output_sse2rle, sizeof(hash_output_sse2rle));
+    if(rc != HX4_ERR_SUCCESS) {
+      break;
+    }
+    if(memcmp(hash_output_ref, hash_output_sse2rle, sizeof(hash_output_ref)) != 0) {
+      fprintf(stream, "\tsse2rle output doesn't match ref output at offset %d\n", i);
+      rc = 1;
+    }
+  }
+
+  free(runs_buffer);
+  return rc;
+}
+
+static int test_hx4_x4djbx33a_128_sse2rle_runs_performance(FILE *stream, const void *in, size_t in_sz, const void *cookie, size_t cookie_sz) {
+  int rc = 0;
+  unsigned char *runs_buffer;
+  const size_t runs_buffer_size = 1024*1024*16;
+
+  (void)in;
+  (void)in_sz;
+
+  runs_buffer = malloc(runs_buffer_size);
+  if(!runs_buffer) {
+    fprintf(stream, "\tout of memory\n");
+    return 1;
+  }
+  init_runs_buffer(runs_buffer, runs_buffer_size);
+
+  fprintf(stream, "\tsse2 on sparse input:\n");
+  rc += test_hx4_x4djbx33a_128_sse2_performance(stream, runs_buffer, runs_buffer_size, cookie, cookie_sz);
+  fprintf(stream, "\tsse2rle on sparse input:\n");
+  rc += test_hx4_x4djbx33a_128_sse2rle_performance(stream, runs_buffer, runs_buffer_size, cookie, cookie_sz);
+
+  free(runs_buffer);
+  return rc;
+}
+#endif
+
 static int test_hx4_djbx33a_32_all_correctness(FILE *stream, const void *in, size_t in_sz, const void *cookie, size_t cookie_sz) {
   int rc = 0;
   int i;
@@ -263,79 +748,3916 @@ static int test_hx4_djbx33a_32_all_correctness(FILE *stream, const void *in, siz
   return 0;
 }
 
-#define HX4_TEST_COOKIE_APPLIED_IMPL(hash_function, output_bits) \
-static int test_##hash_function##_cookie_applied(FILE *stream, const void *in, size_t in_sz, const void *cookie, size_t cookie_sz) { \
-  uint8_t out_i_cookie[(output_bits)/8]; \
-  uint8_t out_z_cookie[(output_bits)/8]; \
-  uint8_t out_1_cookie[(output_bits)/8]; \
-  uint8_t zero_cookie[128/8]; \
-  uint8_t ones_cookie[128/8]; \
-  int rc; \
-  if(in_sz < 1024) { \
-    fprintf(stream, "\tinput buffer too small\n"); \
-    return 1; \
-  } \
-  in_sz = 1024; \
-  memset(zero_cookie, 0, sizeof(zero_cookie)); \
-  memset(ones_cookie, 1, sizeof(ones_cookie)); \
-  memset(out_i_cookie, 0, sizeof(out_i_cookie)); \
-  memset(out_z_cookie, 0, sizeof(out_z_cookie)); \
-  rc = hash_function(in, in_sz, cookie, cookie_sz, out_i_cookie, sizeof(out_i_cookie)); \
-  if(rc != HX4_ERR_SUCCESS) { \
-    return rc; \
-  } \
-  rc = hash_function(in, in_sz, zero_cookie, sizeof(zero_cookie), out_z_cookie, sizeof(out_z_cookie)); \
-  if(rc != HX4_ERR_SUCCESS) { \
-    return rc; \
-  } \
-  rc = hash_function(in, in_sz, ones_cookie, sizeof(ones_cookie), out_1_cookie, sizeof(out_1_cookie)); \
-  if(rc != HX4_ERR_SUCCESS) { \
-    return rc; \
-  } \
-  if(memcmp(out_i_cookie, out_z_cookie, sizeof(out_i_cookie)) == 0) { \
-    fprintf(stream, "\tcookie not applied\n"); \
-    return 2; \
-  } \
-  if(memcmp(out_i_cookie, out_1_cookie, sizeof(out_i_cookie)) == 0) { \
-    fprintf(stream, "\tcookie not applied\n"); \
-    return 3; \
-  } \
-  return 0; \
-}
+/* test vectors with key 00 01 .. 0f and message 00 01 .. (length-1) */
+typedef struct {
+  int length;
+  uint64_t hash;
+} hash_vector_t;
 
+static int check_hash_vectors(FILE *stream, const char *name, int (*hash_function)(const void *, size_t, const void *, size_t, void *, size_t), size_t out_sz, const hash_vector_t *vectors, size_t num_vectors) {
+  uint8_t key[128/8];
+  uint8_t message[64];
+  uint8_t hash_output[64/8];
+  uint64_t expected;
+  size_t i;
+  size_t j;
+  int rc;
 
-HX4_TEST_COOKIE_APPLIED_IMPL(hx4_djbx33a_32_ref, 32)
-HX4_TEST_COOKIE_APPLIED_IMPL(hx4_djbx33a_32_copt, 32)
-HX4_TEST_COOKIE_APPLIED_IMPL(hx4_x4djbx33a_128_ref, 128)
-HX4_TEST_COOKIE_APPLIED_IMPL(hx4_x4djbx33a_128_copt, 128)
-#if HX4_HAS_MMX
-HX4_TEST_COOKIE_APPLIED_IMPL(hx4_x4djbx33a_128_mmx, 128)
-#endif
-#if HX4_HAS_SSE2
-HX4_TEST_COOKIE_APPLIED_IMPL(hx4_x4djbx33a_128_sse2, 128)
-#endif
-#if HX4_HAS_SSSE3
-HX4_TEST_COOKIE_APPLIED_IMPL(hx4_x4djbx33a_128_ssse3, 128)
-#endif
+  for(i=0; i<sizeof(key); i++) {
+    key[i] = (uint8_t)i;
+  }
+  for(i=0; i<sizeof(message); i++) {
+    message[i] = (uint8_t)i;
+  }
 
+  for(i=0; i<num_vectors; i++) {
+    rc = hash_function(message, vectors[i].length, key, sizeof(key), hash_output, out_sz);
+    if(rc != HX4_ERR_SUCCESS) {
+      return rc;
+    }
+    expected = vectors[i].hash;
+    for(j=0; j<out_sz; j++, expected >>= 8) {
+      if(hash_output[j] != (uint8_t)expected) {
+        fprintf(stream, "\t%s output doesn't match test vector for length %d\n", name, vectors[i].length);
+        return 1;
+      }
+    }
+  }
+  return 0;
+}
 
-typedef int (*test_function_t)(FILE*, const void *, size_t, const void *, size_t);
-typedef struct {
-  test_function_t function;
-  const char *name;
-} test_t;
+static int test_hx4_siphash_vectors_correctness(FILE *stream, const void *in, size_t in_sz, const void *cookie, size_t cookie_sz) {
+  //from the SipHash paper
+  static const hash_vector_t siphash24_vectors[] = {
+    { 15, 0xa129ca6149be45e5ULL },
+  };
+  static const hash_vector_t siphash13_vectors[] = {
+    {  0, 0xabac0158050fc4dcULL },
+    {  1, 0xc9f49bf37d57ca93ULL },
+    {  3, 0x8bf80ab8e7ddf7fbULL },
+    {  4, 0xcf75576088d38328ULL },
+    {  7, 0xd3927d989bb11140ULL },
+    {  8, 0x369095118d299a8eULL },
+    {  9, 0x25a48eb36c063de4ULL },
+    { 15, 0xd320d86d2a519956ULL },
+    { 16, 0xcc4fdd1a7d908b66ULL },
+    { 31, 0x2370dd1f8c21d1bcULL },
+    { 63, 0x9d199062b7bbb3a8ULL },
+  };
+  static const hash_vector_t halfsiphash13_vectors[] = {
+    {  0, 0x5814c896UL },
+    {  1, 0xe7e864caUL },
+    {  3, 0x01539939UL },
+    {  4, 0x7e059ea6UL },
+    {  7, 0x9d38d9d6UL },
+    {  8, 0x577999b1UL },
+    {  9, 0xc839caedUL },
+    { 15, 0xd0257b04UL },
+    { 16, 0x8b31d501UL },
+    { 31, 0x08d8791aUL },
+    { 63, 0x87178304UL },
+  };
+  int rc = 0;
 
-#define TEST_ITEM(function_name) { function_name , #function_name } ,
+  (void)in;
+  (void)in_sz;
+  (void)cookie;
+  (void)cookie_sz;
 
-static void init_random_buffer(unsigned char *buffer, size_t buffer_size) {
-  unsigned char * p = buffer;
-  unsigned char * const buffer_end = buffer+buffer_size;
-  srand(42);
+  rc += check_hash_vectors(stream, "siphash24 ref", hx4_siphash24_64_ref, 64/8, siphash24_vectors, sizeof(siphash24_vectors)/sizeof(hash_vector_t));
+  rc += check_hash_vectors(stream, "siphash24 copt", hx4_siphash24_64_copt, 64/8, siphash24_vectors, sizeof(siphash24_vectors)/sizeof(hash_vector_t));
+  rc += check_hash_vectors(stream, "siphash13 ref", hx4_siphash13_64_ref, 64/8, siphash13_vectors, sizeof(siphash13_vectors)/sizeof(hash_vector_t));
+  rc += check_hash_vectors(stream, "siphash13 copt", hx4_siphash13_64_copt, 64/8, siphash13_vectors, sizeof(siphash13_vectors)/sizeof(hash_vector_t));
+  rc += check_hash_vectors(stream, "halfsiphash13 ref", hx4_halfsiphash13_32_ref, 32/8, halfsiphash13_vectors, sizeof(halfsiphash13_vectors)/sizeof(hash_vector_t));
+  rc += check_hash_vectors(stream, "halfsiphash13 copt", hx4_halfsiphash13_32_copt, 32/8, halfsiphash13_vectors, sizeof(halfsiphash13_vectors)/sizeof(hash_vector_t));
+
+  return rc;
+}
+
+/* checks every lane of an x4 sip hash against the scalar hash of the words dealt to that lane */
+static int check_x4_lanes(FILE *stream, const char *name, hash_function_t x4_function, hash_function_t lane_function, size_t word_size, const void *in, const void *cookie, size_t cookie_sz) {
+  uint8_t x4_output[256/8];
+  uint8_t lane_output[64/8];
+  uint8_t lane_input[128];
+  size_t lane_sz;
+  size_t in_sz;
   size_t i;
+  size_t j;
+  int lane;
+  int rc;
 
-  for(i=0;p<buffer_end;p++,i++) {
-    //*p = rand();
-    *p = (unsigned char)(i & 0x00ff);
+  for(in_sz = 0; in_sz < 4*sizeof(lane_input); in_sz++) {
+    rc = x4_function(in, in_sz, cookie, cookie_sz, x4_output, 4*word_size);
+    if(rc != HX4_ERR_SUCCESS) {
+      return rc;
+    }
+    for(lane=0; lane<4; lane++) {
+      lane_sz = 0;
+      for(i=lane*word_size; i<in_sz; i+=4*word_size) {
+        for(j=0; j<word_size && i+j<in_sz; j++) {
+          lane_input[lane_sz++] = ((const uint8_t*)in)[i+j];
+        }
+      }
+      rc = lane_function(lane_input, lane_sz, cookie, cookie_sz, lane_output, word_size);
+      if(rc != HX4_ERR_SUCCESS) {
+        return rc;
+      }
+      if(memcmp(lane_output, x4_output + lane*word_size, word_size) != 0) {
+        fprintf(stream, "\t%s lane %d doesn't match the scalar hash at size %d\n", name, lane, (int)in_sz);
+        return 1;
+      }
+    }
+  }
+  return 0;
+}
+
+static int compare_functions(FILE *stream, const char *name, hash_function_t ref_function, hash_function_t function, size_t out_sz, const void *in, const void *cookie, size_t cookie_sz) {
+  uint8_t hash_output_ref[512/8];
+  uint8_t hash_output[512/8];
+  size_t in_sz;
+  int i;
+  int rc;
+
+  for(i=0; i<32; i++) {
+    for(in_sz = 0; in_sz < 300; in_sz++) {
+      rc = ref_function((const uint8_t*)in+i, in_sz, cookie, cookie_sz, hash_output_ref, out_sz);
+      if(rc != HX4_ERR_SUCCESS) {
+        return rc;
+      }
+      rc = function((const uint8_t*)in+i, in_sz, cookie, cookie_sz, hash_output, out_sz);
+      if(rc != HX4_ERR_SUCCESS) {
+        return rc;
+      }
+      if(memcmp(hash_output_ref, hash_output, out_sz) != 0) {
+        fprintf(stream, "\t%s output doesn't match ref output at offset %d, size %d\n", name, i, (int)in_sz);
+        return 1;
+      }
+    }
+  }
+  return 0;
+}
+
+static int test_hx4_siphash_all_correctness(FILE *stream, const void *in, size_t in_sz, const void *cookie, size_t cookie_sz) {
+  int rc = 0;
+
+  if(in_sz < 1024) {
+    fprintf(stream, "\tinput buffer too small\n");
+    return 1;
+  }
+
+  rc += compare_functions(stream, "siphash24 copt", hx4_siphash24_64_ref, hx4_siphash24_64_copt, 64/8, in, cookie, cookie_sz);
+  rc += compare_functions(stream, "siphash13 copt", hx4_siphash13_64_ref, hx4_siphash13_64_copt, 64/8, in, cookie, cookie_sz);
+  rc += compare_functions(stream, "halfsiphash13 copt", hx4_halfsiphash13_32_ref, hx4_halfsiphash13_32_copt, 32/8, in, cookie, cookie_sz);
+#if HX4_HAS_SSE2
+  rc += compare_functions(stream, "x4siphash13 sse2", hx4_x4siphash13_256_ref, hx4_x4siphash13_256_sse2, 256/8, in, cookie, cookie_sz);
+  rc += compare_functions(stream, "x4halfsiphash13 sse2", hx4_x4halfsiphash13_128_ref, hx4_x4halfsiphash13_128_sse2, 128/8, in, cookie, cookie_sz);
+#endif
+  rc += check_x4_lanes(stream, "x4siphash13 ref", hx4_x4siphash13_256_ref, hx4_siphash13_64_ref, 64/8, in, cookie, cookie_sz);
+  rc += check_x4_lanes(stream, "x4halfsiphash13 ref", hx4_x4halfsiphash13_128_ref, hx4_halfsiphash13_32_ref, 32/8, in, cookie, cookie_sz);
+
+  return rc;
+}
+
+static int test_hx4_crc32c_correctness(FILE *stream, const void *in, size_t in_sz, const void *cookie, size_t cookie_sz) {
+  const hash_function_item_t crc32c_functions[] = {
+    HASH_FUNCTION_ITEM(hx4_crc32c_32_ref, 32)
+#if HX4_HAS_SSE42
+    HASH_FUNCTION_ITEM(hx4_crc32c_32_sse42, 32)
+#endif
+#if HX4_HAS_SSE42 && HX4_HAS_PCLMUL
+    HASH_FUNCTION_ITEM(hx4_crc32c_32_pclmul, 32)
+#endif
+  };
+  const uint8_t zero_cookie[128/8] = { 0 };
+  uint8_t lane_cookie[128/8];
+  uint8_t hash_output_ref[128/8];
+  uint8_t hash_output[128/8];
+  uint8_t lane_input[2048];
+  uint32_t crc;
+  size_t lane_sz;
+  size_t sz;
+  size_t f;
+  size_t i;
+  int lane;
+  int rc = 0;
+
+  if(in_sz < 8*1024 + 32) {
+    fprintf(stream, "\tinput buffer too small\n");
+    return 1;
+  }
+
+  //the check value of the CRC catalogue
+  for(f=0; f<sizeof(crc32c_functions)/sizeof(crc32c_functions[0]); f++) {
+    rc = crc32c_functions[f].function("123456789", 9, zero_cookie, sizeof(zero_cookie), hash_output, 32/8);
+    if(rc != HX4_ERR_SUCCESS) {
+      return rc;
+    }
+    crc = (uint32_t)hash_output[0] | ((uint32_t)hash_output[1] << 8) | ((uint32_t)hash_output[2] << 16) | ((uint32_t)hash_output[3] << 24);
+    if(crc != 0xe3069283UL) {
+      fprintf(stream, "\t%s doesn't match the CRC-32C check value: %08x\n", crc32c_functions[f].name, (unsigned int)crc);
+      return 1;
+    }
+  }
+
+#if HX4_HAS_SSE42
+  rc += compare_functions(stream, "crc32c sse42", hx4_crc32c_32_ref, hx4_crc32c_32_sse42, 32/8, in, cookie, cookie_sz);
+  rc += compare_functions(stream, "x4crc32c sse42", hx4_x4crc32c_128_ref, hx4_x4crc32c_128_sse42, 128/8, in, cookie, cookie_sz);
+#endif
+#if HX4_HAS_SSE42 && HX4_HAS_PCLMUL
+  //sizes around the three blocks of 128 and 1024 bytes the pclmul variant combines
+  for(sz=0; sz<=8*1024; sz += 1 + sz/64) {
+    for(i=0; i<3; i++) {
+      hx4_crc32c_32_ref((const uint8_t*)in + i, sz, cookie, cookie_sz, hash_output_ref, 32/8);
+      hx4_crc32c_32_pclmul((const uint8_t*)in + i, sz, cookie, cookie_sz, hash_output, 32/8);
+      if(memcmp(hash_output_ref, hash_output, 32/8) != 0) {
+        fprintf(stream, "\tcrc32c pclmul output doesn't match ref output at offset %d, size %d\n", (int)i, (int)sz);
+        return 1;
+      }
+    }
+  }
+#endif
+  if(rc != 0) {
+    return rc;
+  }
+
+  //every lane is the CRC-32C of its words, with its own word of the cookie
+  for(sz=0; sz<4*sizeof(lane_input); sz += 1 + sz/32) {
+    rc = hx4_x4crc32c_128_ref(in, sz, cookie, cookie_sz, hash_output_ref, 128/8);
+    if(rc != HX4_ERR_SUCCESS) {
+      return rc;
+    }
+    for(lane=0; lane<4; lane++) {
+      lane_sz = 0;
+      for(i=0; i<sz; i++) {
+        if(((i >> 3) & 0x03) == (size_t)lane) {
+          lane_input[lane_sz++] = ((const uint8_t*)in)[i];
+        }
+      }
+      for(i=0; i<sizeof(lane_cookie); i++) {
+        lane_cookie[i] = ((const uint8_t*)cookie)[(4*lane + i) % 16];
+      }
+      hx4_crc32c_32_ref(lane_input, lane_sz, lane_cookie, sizeof(lane_cookie), hash_output, 32/8);
+      if(memcmp(hash_output_ref + 4*lane, hash_output, 32/8) != 0) {
+        fprintf(stream, "\tx4crc32c ref lane %d doesn't match crc32c at size %d\n", lane, (int)sz);
+        return 1;
+      }
+    }
+  }
+
+  return 0;
+}
+
+static int test_hx4_x4aes_correctness(FILE *stream, const void *in, size_t in_sz, const void *cookie, size_t cookie_sz) {
+  const uint8_t zeros[2*64] = { 0 };
+  uint8_t hash_outputs[sizeof(zeros) + 1][128/8];
+#if HX4_HAS_AESNI
+  uint8_t hash_output_ref[128/8];
+  uint8_t hash_output[128/8];
+  size_t offset;
+#endif
+  size_t sz;
+  size_t i;
+  int rc = 0;
+
+  if(in_sz < 8*1024 + 32) {
+    fprintf(stream, "\tinput buffer too small\n");
+    return 1;
+  }
+
+  //the last chunk is padded with zeros, the length must still make a difference
+  for(sz=0; sz<=sizeof(zeros); sz++) {
+    rc = hx4_x4aes_128_ref(zeros, sz, cookie, cookie_sz, hash_outputs[sz], 128/8);
+    if(rc != HX4_ERR_SUCCESS) {
+      return rc;
+    }
+    for(i=0; i<sz; i++) {
+      if(memcmp(hash_outputs[i], hash_outputs[sz], 128/8) == 0) {
+        fprintf(stream, "\tx4aes ref gives the same output for %d and %d zero bytes\n", (int)i, (int)sz);
+        return 1;
+      }
+    }
+  }
+
+#if HX4_HAS_AESNI
+  rc += compare_functions(stream, "x4aes aesni", hx4_x4aes_128_ref, hx4_x4aes_128_aesni, 128/8, in, cookie, cookie_sz);
+  if(rc != 0) {
+    return rc;
+  }
+
+  //longer inputs, over many chunks and with every tail length
+  for(sz=0; sz<=8*1024; sz += 1 + sz/64) {
+    for(offset=0; offset<3; offset++) {
+      hx4_x4aes_128_ref((const uint8_t*)in + offset, sz, cookie, cookie_sz, hash_output_ref, 128/8);
+      hx4_x4aes_128_aesni((const uint8_t*)in + offset, sz, cookie, cookie_sz, hash_output, 128/8);
+      if(memcmp(hash_output_ref, hash_output, 128/8) != 0) {
+        fprintf(stream, "\tx4aes aesni output doesn't match ref output at offset %d, size %d\n", (int)offset, (int)sz);
+        return 1;
+      }
+    }
+  }
+#endif
+
+  return rc;
+}
+
+typedef struct {
+  const char *key;
+  const char *message;
+  const char *hash;
+} polyval_vector_t;
+
+static void hex_to_bytes(const char *hex, uint8_t *out, size_t *out_sz) {
+  unsigned int b;
+  size_t i;
+
+  for(i=0; hex[2*i] != '\0'; i++) {
+    sscanf(hex + 2*i, "%2x", &b);
+    out[i] = (uint8_t)b;
+  }
+  *out_sz = i;
+}
+
+static int test_hx4_polyval_correctness(FILE *stream, const void *in, size_t in_sz, const void *cookie, size_t cookie_sz) {
+  //POLYVAL values of the AES-GCM-SIV examples in RFC 8452 appendix C.1 (no additional data),
+  //and the POLYVAL example of appendix A with the length block appended
+  const polyval_vector_t vectors[] = {
+    { "d9b360279694941ac5dbc6987ada7377", "", "00000000000000000000000000000000" },
+    { "d9b360279694941ac5dbc6987ada7377", "0100000000000000", "eb93b7740962c5e49d2a90a7dc5cec74" },
+    { "d9b360279694941ac5dbc6987ada7377", "010000000000000000000000", "48eb6c6c5a2dbe4a1dde508fee06361b" },
+    { "25629347589242761d31f826ba4b757b", "4f4f95668c83dfb6401762bb2d01a262d1a24ddd2721d006bbe45f20d3c9f362", "17f22264d936e82bc4fd735d7b9417fe" },
+  };
+  const hash_function_item_t polyval_functions[] = {
+    HASH_FUNCTION_ITEM(hx4_polyval_128_ref, 128)
+#if HX4_HAS_PCLMUL
+    HASH_FUNCTION_ITEM(hx4_polyval_128_pclmul, 128)
+#endif
+  };
+  uint8_t key[128/8];
+  uint8_t message[64];
+  uint8_t expected[128/8];
+  uint8_t hash_output[128/8];
+#if HX4_HAS_PCLMUL
+  uint8_t hash_output_ref[128/8];
+  size_t offset;
+  size_t sz;
+#endif
+  size_t key_sz;
+  size_t message_sz;
+  size_t expected_sz;
+  size_t f;
+  size_t i;
+  int rc = 0;
+
+  if(in_sz < 8*1024 + 32) {
+    fprintf(stream, "\tinput buffer too small\n");
+    return 1;
+  }
+
+  for(f=0; f<sizeof(polyval_functions)/sizeof(polyval_functions[0]); f++) {
+    for(i=0; i<sizeof(vectors)/sizeof(vectors[0]); i++) {
+      hex_to_bytes(vectors[i].key, key, &key_sz);
+      hex_to_bytes(vectors[i].message, message, &message_sz);
+      hex_to_bytes(vectors[i].hash, expected, &expected_sz);
+      rc = polyval_functions[f].function(message, message_sz, key, key_sz, hash_output, sizeof(hash_output));
+      if(rc != HX4_ERR_SUCCESS) {
+        return rc;
+      }
+      if(memcmp(hash_output, expected, sizeof(expected)) != 0) {
+        fprintf(stream, "\t%s output doesn't match test vector %d\n", polyval_functions[f].name, (int)i);
+        return 1;
+      }
+    }
+  }
+
+#if HX4_HAS_PCLMUL
+  rc += compare_functions(stream, "polyval pclmul", hx4_polyval_128_ref, hx4_polyval_128_pclmul, 128/8, in, cookie, cookie_sz);
+  if(rc != 0) {
+    return rc;
+  }
+
+  //longer inputs, over the 8 block aggregation and every tail length
+  for(sz=0; sz<=8*1024; sz += 1 + sz/64) {
+    for(offset=0; offset<3; offset++) {
+      hx4_polyval_128_ref((const uint8_t*)in + offset, sz, cookie, cookie_sz, hash_output_ref, 128/8);
+      hx4_polyval_128_pclmul((const uint8_t*)in + offset, sz, cookie, cookie_sz, hash_output, 128/8);
+      if(memcmp(hash_output_ref, hash_output, 128/8) != 0) {
+        fprintf(stream, "\tpolyval pclmul output doesn't match ref output at offset %d, size %d\n", (int)offset, (int)sz);
+        return 1;
+      }
+    }
+  }
+#endif
+
+  return rc;
+}
+
+static int test_hx4_x4mulfold_correctness(FILE *stream, const void *in, size_t in_sz, const void *cookie, size_t cookie_sz) {
+  const hash_function_item_t mulfold_functions[] = {
+    HASH_FUNCTION_ITEM(hx4_x4mulfold_128_copt, 128)
+#if HX4_HAS_SSE2
+    HASH_FUNCTION_ITEM(hx4_x4mulfold_128_sse2, 128)
+#endif
+#if HX4_HAS_AVX2
+    HASH_FUNCTION_ITEM(hx4_x4mulfold_128_avx2, 128)
+#endif
+  };
+  const uint8_t zeros[2*16] = { 0 };
+  uint8_t hash_outputs[sizeof(zeros) + 1][128/8];
+  uint8_t flipped[67];
+  uint8_t hash_output_ref[128/8];
+  uint8_t hash_output[128/8];
+  size_t offset;
+  size_t sz;
+  size_t f;
+  size_t i;
+  int rc = 0;
+
+  if(in_sz < 8*1024 + 32) {
+    fprintf(stream, "\tinput buffer too small\n");
+    return 1;
+  }
+
+  //the last word is padded with zeros, the length must still make a difference
+  for(sz=0; sz<=sizeof(zeros); sz++) {
+    rc = hx4_x4mulfold_128_ref(zeros, sz, cookie, cookie_sz, hash_outputs[sz], 128/8);
+    if(rc != HX4_ERR_SUCCESS) {
+      return rc;
+    }
+    for(i=0; i<sz; i++) {
+      if(memcmp(hash_outputs[i], hash_outputs[sz], 128/8) == 0) {
+        fprintf(stream, "\tx4mulfold ref gives the same output for %d and %d zero bytes\n", (int)i, (int)sz);
+        return 1;
+      }
+    }
+  }
+
+  //words 2, 3, 6 and 7 go to lanes 2 and 3, the first 8 output bytes must still see them
+  memcpy(flipped, in, sizeof(flipped));
+  hx4_x4mulfold_128_ref(flipped, sizeof(flipped), cookie, cookie_sz, hash_output_ref, 128/8);
+  for(i=8; i<sizeof(flipped); i++) {
+    if((i / 4) % 4 < 2) {
+      continue;
+    }
+    flipped[i] ^= 0x01;
+    hx4_x4mulfold_128_ref(flipped, sizeof(flipped), cookie, cookie_sz, hash_output, 128/8);
+    flipped[i] ^= 0x01;
+    if(memcmp(hash_output_ref, hash_output, 8) == 0) {
+      fprintf(stream, "\tx4mulfold ref output bytes 0-7 don't change with input byte %d\n", (int)i);
+      return 1;
+    }
+  }
+
+  for(f=0; f<sizeof(mulfold_functions)/sizeof(mulfold_functions[0]); f++) {
+    rc += compare_functions(stream, mulfold_functions[f].name, hx4_x4mulfold_128_ref, mulfold_functions[f].function, 128/8, in, cookie, cookie_sz);
+    if(rc != 0) {
+      return rc;
+    }
+
+    //longer inputs, every tail length after the blocks of the main loops
+    for(sz=0; sz<=8*1024; sz += 1 + sz/64) {
+      for(offset=0; offset<3; offset++) {
+        hx4_x4mulfold_128_ref((const uint8_t*)in + offset, sz, cookie, cookie_sz, hash_output_ref, 128/8);
+        mulfold_functions[f].function((const uint8_t*)in + offset, sz, cookie, cookie_sz, hash_output, 128/8);
+        if(memcmp(hash_output_ref, hash_output, 128/8) != 0) {
+          fprintf(stream, "\t%s output doesn't match ref output at offset %d, size %d\n", mulfold_functions[f].name, (int)offset, (int)sz);
+          return 1;
+        }
+      }
+    }
+  }
+
+  return rc;
+}
+
+static int test_hx4_dispatch_correctness(FILE *stream, const void *in, size_t in_sz, const void *cookie, size_t cookie_sz) {
+  const size_t sizes[] = { 0, 1, 15, 16, 17, 63, 64, 65, 255, 256, 257, 4095, 4096, 4097, 70001 };
+  hx4_dispatch_table table;
+  hx4_dispatch_table ref_table;
+  hx4_dispatch_table loaded;
+  uint8_t hash_output_ref[256/8];
+  uint8_t hash_output[256/8];
+  void *memory;
+  FILE *f;
+  size_t i;
+  int algorithm;
+  int rc;
+
+  if(in_sz < 70001) {
+    fprintf(stream, "\tinput buffer too small\n");
+    return 1;
+  }
+
+  memory = malloc(HX4_DISPATCH_CALIBRATE_MEMORY_SIZE);
+  if(memory == NULL) {
+    return 1;
+  }
+  rc = hx4_dispatch_calibrate(&table, memory, HX4_DISPATCH_CALIBRATE_MEMORY_SIZE - 1);
+  if(rc != HX4_ERR_BUFFER_TOO_SMALL) {
+    fprintf(stream, "\tcalibration accepted a small scratch buffer\n");
+    free(memory);
+    return 1;
+  }
+  rc = hx4_dispatch_calibrate(&table, memory, HX4_DISPATCH_CALIBRATE_MEMORY_SIZE);
+  free(memory);
+  if(rc != HX4_ERR_SUCCESS) {
+    return rc;
+  }
+
+  //the selected kernels against ref
+  memcpy(&ref_table, &table, sizeof(table));
+  memset(ref_table.kernel, 0, sizeof(ref_table.kernel));
+  for(algorithm=0; algorithm<HX4_ALG_COUNT; algorithm++) {
+    for(i=0; i<sizeof(sizes)/sizeof(sizes[0]); i++) {
+      memset(hash_output_ref, 0, sizeof(hash_output_ref));
+      memset(hash_output, 0, sizeof(hash_output));
+      rc = hx4_dispatch_hash(&ref_table, algorithm, (const uint8_t*)in + 1, sizes[i], cookie, cookie_sz, hash_output_ref, sizeof(hash_output_ref));
+      if(rc != HX4_ERR_SUCCESS) {
+        return rc;
+      }
+      rc = hx4_dispatch_hash(&table, algorithm, (const uint8_t*)in + 1, sizes[i], cookie, cookie_sz, hash_output, sizeof(hash_output));
+      if(rc != HX4_ERR_SUCCESS) {
+        return rc;
+      }
+      if(memcmp(hash_output_ref, hash_output, sizeof(hash_output)) != 0) {
+        fprintf(stream, "\t%s kernel %s doesn't match ref at size %d\n", hx4_dispatch_algorithm_name(algorithm),
+          hx4_dispatch_kernel_name(algorithm, table.kernel[algorithm][hx4_dispatch_size_class(sizes[i])]), (int)sizes[i]);
+        return 1;
+      }
+    }
+  }
+  if(hx4_dispatch_hash(&table, HX4_ALG_COUNT, in, 16, cookie, cookie_sz, hash_output, sizeof(hash_output)) != HX4_ERR_PARAM_INVALID) {
+    fprintf(stream, "\tinvalid algorithm accepted\n");
+    return 1;
+  }
+
+  //the profile round trip
+  remove(HX4_DISPATCH_TEST_PROFILE);
+  if(hx4_dispatch_load(&loaded, HX4_DISPATCH_TEST_PROFILE) != HX4_ERR_NOT_FOUND) {
+    fprintf(stream, "\tloading a missing profile doesn't fail\n");
+    return 1;
+  }
+  rc = hx4_dispatch_save(&table, HX4_DISPATCH_TEST_PROFILE);
+  if(rc != HX4_ERR_SUCCESS) {
+    return rc;
+  }
+  memset(&loaded, 0xff, sizeof(loaded));
+  rc = hx4_dispatch_load(&loaded, HX4_DISPATCH_TEST_PROFILE);
+  if(rc != HX4_ERR_SUCCESS || memcmp(&loaded, &table, sizeof(table)) != 0) {
+    fprintf(stream, "\tloaded profile doesn't match the saved one\n");
+    remove(HX4_DISPATCH_TEST_PROFILE);
+    return 1;
+  }
+
+  //a profile of another cpu
+  strcpy(table.cpu, "another cpu");
+  hx4_dispatch_save(&table, HX4_DISPATCH_TEST_PROFILE);
+  if(hx4_dispatch_load(&loaded, HX4_DISPATCH_TEST_PROFILE) != HX4_ERR_NOT_FOUND) {
+    fprintf(stream, "\tprofile of another cpu accepted\n");
+    remove(HX4_DISPATCH_TEST_PROFILE);
+    return 1;
+  }
+
+  //a kernel that is not in this build
+  f = fopen(HX4_DISPATCH_TEST_PROFILE, "w");
+  if(f == NULL) {
+    return 1;
+  }
+  fprintf(f, "hx4dispatch 1\ncpu %s\n", loaded.cpu);
+  for(algorithm=0; algorithm<HX4_ALG_COUNT; algorithm++) {
+    fprintf(f, "%s ref ref ref ref %s\n", hx4_dispatch_algorithm_name(algorithm), algorithm == 0 ? "neon" : "ref");
+  }
+  fclose(f);
+  rc = hx4_dispatch_load(&loaded, HX4_DISPATCH_TEST_PROFILE);
+  remove(HX4_DISPATCH_TEST_PROFILE);
+  if(rc != HX4_ERR_NOT_FOUND) {
+    fprintf(stream, "\tprofile with an unknown kernel accepted\n");
+    return 1;
+  }
+
+  return 0;
+}
+
+#if HX4_STATS
+HX_THREAD_FUNCTION(stats_thread) {
+  uint8_t *in = (uint8_t*)arg;
+  uint8_t cookie[16];
+  uint8_t out[4];
+  int i;
+  memset(cookie, 0, sizeof(cookie));
+  for(i=0; i<100; i++) {
+    hx4_halfsiphash13_32_copt(in, 8, cookie, sizeof(cookie), out, sizeof(out));
+  }
+  HX_THREAD_RETURN;
+}
+#endif
+
+static int test_hx4_stats_correctness(FILE *stream, const void *in, size_t in_sz, const void *cookie, size_t cookie_sz) {
+  static hx4_stats stats;
+  uint8_t out[16];
+  int rc;
+#if HX4_STATS
+  const hx4_stats_counters *c;
+  hx4_iovec iov[2];
+  uint8_t dst[100];
+  uint8_t thread_in[8];
+  hx_thread thread;
+  int i;
+#endif
+
+  (void)in_sz;
+
+  if(hx4_stats_size_bucket(0) != 0 || hx4_stats_size_bucket(1) != 1 || hx4_stats_size_bucket(5) != 3 ||
+     hx4_stats_size_bucket(1024) != 11 || hx4_stats_size_bucket((uint64_t)1 << 40) != HX4_STATS_HISTOGRAM_SIZE-1) {
+    fprintf(stream, "\thx4_stats_size_bucket is wrong\n");
+    return 1;
+  }
+  if(hx4_stats_kernel_name(HX4_STATS_hx4_crc32c_32_ref) == NULL ||
+     strcmp(hx4_stats_kernel_name(HX4_STATS_hx4_crc32c_32_ref), "hx4_crc32c_32_ref") != 0 ||
+     hx4_stats_kernel_name(-1) != NULL || hx4_stats_kernel_name(HX4_STATS_KERNEL_COUNT) != NULL) {
+    fprintf(stream, "\thx4_stats_kernel_name is wrong\n");
+    return 1;
+  }
+
+#if HX4_STATS
+  hx4_stats_reset();
+
+  // one shot, failed, _v and _cstr calls count for the kernel
+  hx4_x4djbx33a_128_ref(in, 0, cookie, cookie_sz, out, sizeof(out));
+  hx4_x4djbx33a_128_ref(in, 5, cookie, cookie_sz, out, sizeof(out));
+  hx4_x4djbx33a_128_ref(in, 1000, cookie, cookie_sz, out, sizeof(out));
+  hx4_x4djbx33a_128_ref(in, 1000, cookie, cookie_sz, NULL, sizeof(out));
+  iov[0].iov_base = in;
+  iov[0].iov_len = 3;
+  iov[1].iov_base = (const uint8_t*)in + 10;
+  iov[1].iov_len = 4;
+  hx4_x4djbx33a_128_ref_v(iov, 2, cookie, cookie_sz, out, sizeof(out));
+  hx4_x4djbx33a_128_ref_cstr("hello", NULL, cookie, cookie_sz, out, sizeof(out));
+
+  // every HX4_STATS_SAMPLE_INTERVAL-th call is timed, the first one too
+  for(i=0; i<2*HX4_STATS_SAMPLE_INTERVAL; i++) {
+    hx4_siphash13_64_copt(in, 16, cookie, cookie_sz, out, 8);
+  }
+
+#if HX4_HAS_SSE2
+  // a short _copy goes to the one shot function and counts once
+  hx4_x4djbx33a_128_sse2_copy(dst, in, sizeof(dst), cookie, cookie_sz, out, sizeof(out));
+#else
+  (void)dst;
+#endif
+
+  memset(thread_in, 0, sizeof(thread_in));
+  hx_thread_start(&thread, stats_thread, thread_in);
+  hx_thread_join(thread);
+
+  rc = hx4_stats_snapshot(&stats);
+  if(rc != HX4_ERR_SUCCESS) {
+    fprintf(stream, "\thx4_stats_snapshot failed with %d\n", rc);
+    return 1;
+  }
+
+  c = &stats.kernel[HX4_STATS_hx4_x4djbx33a_128_ref];
+  if(c->calls != 5 || c->bytes != 0+5+1000+7+5 ||
+     c->size_histogram[0] != 1 || c->size_histogram[3] != 3 || c->size_histogram[10] != 1) {
+    fprintf(stream, "\thx4_x4djbx33a_128_ref: %d calls and %d bytes counted, expected 5 calls and 1017 bytes\n", (int)c->calls, (int)c->bytes);
+    return 1;
+  }
+
+  c = &stats.kernel[HX4_STATS_hx4_siphash13_64_copt];
+  if(c->calls != 2*HX4_STATS_SAMPLE_INTERVAL || c->size_histogram[5] != c->calls) {
+    fprintf(stream, "\thx4_siphash13_64_copt: %d calls counted, expected %d\n", (int)c->calls, 2*HX4_STATS_SAMPLE_INTERVAL);
+    return 1;
+  }
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+  if(c->latency_samples != 2 || c->latency_cycles == 0 || c->latency_max_cycles == 0 || c->latency_max_cycles > c->latency_cycles) {
+    fprintf(stream, "\thx4_siphash13_64_copt: %d latency samples, expected 2\n", (int)c->latency_samples);
+    return 1;
+  }
+#endif
+
+#if HX4_HAS_SSE2
+  if(stats.kernel[HX4_STATS_hx4_x4djbx33a_128_sse2].calls != 1) {
+    fprintf(stream, "\thx4_x4djbx33a_128_sse2_copy: %d calls counted, expected 1\n", (int)stats.kernel[HX4_STATS_hx4_x4djbx33a_128_sse2].calls);
+    return 1;
+  }
+#endif
+
+  if(stats.kernel[HX4_STATS_hx4_halfsiphash13_32_copt].calls != 100 || stats.threads < 2) {
+    fprintf(stream, "\tthe counters of the second thread are missing\n");
+    return 1;
+  }
+
+  for(i=0; i<HX4_STATS_KERNEL_COUNT; i++) {
+    if(stats.kernel[i].calls > 0) {
+      fprintf(stream, "\t%-32s %6d calls %8d bytes\n", hx4_stats_kernel_name(i), (int)stats.kernel[i].calls, (int)stats.kernel[i].bytes);
+    }
+  }
+#else
+  rc = hx4_stats_snapshot(&stats);
+  if(rc != HX4_ERR_NOT_FOUND || stats.kernel[0].calls != 0) {
+    fprintf(stream, "\thx4_stats_snapshot without HX4_STATS returned %d\n", rc);
+    return 1;
+  }
+  (void)out;
+  (void)cookie;
+#endif
+
+  return 0;
+}
+
+static int test_hx4_kdjbx33a_all_correctness(FILE *stream, const void *in, size_t in_sz, const void *cookie, size_t cookie_sz) {
+  int rc = 0;
+
+  if(in_sz < 1024) {
+    fprintf(stream, "\tinput buffer too small\n");
+    return 1;
+  }
+
+  rc += compare_functions(stream, "kdjbx33a copt", hx4_kdjbx33a_32_ref, hx4_kdjbx33a_32_copt, 32/8, in, cookie, cookie_sz);
+  rc += compare_functions(stream, "x4kdjbx33a copt", hx4_x4kdjbx33a_128_ref, hx4_x4kdjbx33a_128_copt, 128/8, in, cookie, cookie_sz);
+#if HX4_HAS_SSE2
+  rc += compare_functions(stream, "x4kdjbx33a sse2", hx4_x4kdjbx33a_128_ref, hx4_x4kdjbx33a_128_sse2, 128/8, in, cookie, cookie_sz);
+#endif
+#if HX4_HAS_SSSE3
+  rc += compare_functions(stream, "x4kdjbx33a ssse3", hx4_x4kdjbx33a_128_ref, hx4_x4kdjbx33a_128_ssse3, 128/8, in, cookie, cookie_sz);
+#endif
+
+  return rc;
+}
+
+typedef void (*fixed_hash_function_t)(const void *, const void *, void *);
+typedef struct {
+  fixed_hash_function_t function;
+  hash_function_t generic_function;
+  size_t len;
+  size_t output_size;
+  const char *name;
+} fixed_hash_function_item_t;
+
+#define FIXED_HASH_FUNCTION_ITEM(algorithm, len, output_bits) { algorithm##_len##len , algorithm##_ref , len , (output_bits)/8 , #algorithm "_len" #len } ,
+
+static int test_hx4_fixed_correctness(FILE *stream, const void *in, size_t in_sz, const void *cookie, size_t cookie_sz) {
+  const fixed_hash_function_item_t items[] = {
+    FIXED_HASH_FUNCTION_ITEM(hx4_djbx33a_32, 4, 32)
+    FIXED_HASH_FUNCTION_ITEM(hx4_djbx33a_32, 8, 32)
+    FIXED_HASH_FUNCTION_ITEM(hx4_djbx33a_32, 12, 32)
+    FIXED_HASH_FUNCTION_ITEM(hx4_djbx33a_32, 16, 32)
+    FIXED_HASH_FUNCTION_ITEM(hx4_x4djbx33a_128, 4, 128)
+    FIXED_HASH_FUNCTION_ITEM(hx4_x4djbx33a_128, 8, 128)
+    FIXED_HASH_FUNCTION_ITEM(hx4_x4djbx33a_128, 12, 128)
+    FIXED_HASH_FUNCTION_ITEM(hx4_x4djbx33a_128, 16, 128)
+    FIXED_HASH_FUNCTION_ITEM(hx4_siphash24_64, 4, 64)
+    FIXED_HASH_FUNCTION_ITEM(hx4_siphash24_64, 8, 64)
+    FIXED_HASH_FUNCTION_ITEM(hx4_siphash24_64, 12, 64)
+    FIXED_HASH_FUNCTION_ITEM(hx4_siphash24_64, 16, 64)
+    FIXED_HASH_FUNCTION_ITEM(hx4_siphash13_64, 4, 64)
+    FIXED_HASH_FUNCTION_ITEM(hx4_siphash13_64, 8, 64)
+    FIXED_HASH_FUNCTION_ITEM(hx4_siphash13_64, 12, 64)
+    FIXED_HASH_FUNCTION_ITEM(hx4_siphash13_64, 16, 64)
+  };
+  uint8_t hash_output_ref[128/8];
+  uint8_t hash_output_fixed[128/8];
+  size_t i;
+  int offset;
+  int rc;
+
+  if(in_sz < 1024) {
+    fprintf(stream, "\tinput buffer too small\n");
+    return 1;
+  }
+
+  for(i=0; i<sizeof(items)/sizeof(items[0]); i++) {
+    for(offset=0; offset<64; offset++) {
+      rc = items[i].generic_function((const uint8_t*)in+offset, items[i].len, cookie, cookie_sz, hash_output_ref, items[i].output_size);
+      if(rc != HX4_ERR_SUCCESS) {
+        return rc;
+      }
+      items[i].function((const uint8_t*)in+offset, cookie, hash_output_fixed);
+      if(memcmp(hash_output_ref, hash_output_fixed, items[i].output_size) != 0) {
+        fprintf(stream, "\t%s output doesn't match ref output at offset %d\n", items[i].name, offset);
+        return 1;
+      }
+    }
+  }
+  return 0;
+}
+
+/* times a loop over many short keys, once through the generic function and once through the inline fixed length function */
+#define HX4_FIXED_PERF_IMPL(algorithm, len, output_bits, generic_function) \
+static void print_##algorithm##_len##len##_performance(FILE *stream, const uint8_t *keys, size_t num_keys, size_t repeats, const void *cookie, size_t cookie_sz) { \
+  uint8_t hash_output[(output_bits)/8]; \
+  volatile uint8_t sink = 0; \
+  hx_time start; \
+  hx_time stop; \
+  float generic_ns; \
+  float fixed_ns; \
+  size_t i; \
+  size_t r; \
+  start = hx_gettime(); \
+  for(r=0; r<repeats; r++) { \
+    for(i=0; i<num_keys; i++) { \
+      generic_function(keys + i*(len), (len), cookie, cookie_sz, hash_output, sizeof(hash_output)); \
+      sink ^= hash_output[0]; \
+    } \
+  } \
+  stop = hx_gettime(); \
+  generic_ns = hx_timedelta_s(&start, &stop) * 1000000000.0f / (float)(num_keys*repeats); \
+  start = hx_gettime(); \
+  for(r=0; r<repeats; r++) { \
+    for(i=0; i<num_keys; i++) { \
+      algorithm##_len##len(keys + i*(len), cookie, hash_output); \
+      sink ^= hash_output[0]; \
+    } \
+  } \
+  stop = hx_gettime(); \
+  fixed_ns = hx_timedelta_s(&start, &stop) * 1000000000.0f / (float)(num_keys*repeats); \
+  fprintf(stream, "\t%-28s %6.2f ns per key | %-28s %6.2f ns per key\n", #generic_function, (double)generic_ns, #algorithm "_len" #len, (double)fixed_ns); \
+}
+
+HX4_FIXED_PERF_IMPL(hx4_djbx33a_32, 4, 32, hx4_djbx33a_32_copt)
+HX4_FIXED_PERF_IMPL(hx4_djbx33a_32, 8, 32, hx4_djbx33a_32_copt)
+HX4_FIXED_PERF_IMPL(hx4_djbx33a_32, 16, 32, hx4_djbx33a_32_copt)
+#if HX4_HAS_SSE2
+HX4_FIXED_PERF_IMPL(hx4_x4djbx33a_128, 4, 128, hx4_x4djbx33a_128_sse2)
+HX4_FIXED_PERF_IMPL(hx4_x4djbx33a_128, 8, 128, hx4_x4djbx33a_128_sse2)
+HX4_FIXED_PERF_IMPL(hx4_x4djbx33a_128, 16, 128, hx4_x4djbx33a_128_sse2)
+#else
+HX4_FIXED_PERF_IMPL(hx4_x4djbx33a_128, 4, 128, hx4_x4djbx33a_128_copt)
+HX4_FIXED_PERF_IMPL(hx4_x4djbx33a_128, 8, 128, hx4_x4djbx33a_128_copt)
+HX4_FIXED_PERF_IMPL(hx4_x4djbx33a_128, 16, 128, hx4_x4djbx33a_128_copt)
+#endif
+HX4_FIXED_PERF_IMPL(hx4_siphash24_64, 8, 64, hx4_siphash24_64_copt)
+HX4_FIXED_PERF_IMPL(hx4_siphash24_64, 16, 64, hx4_siphash24_64_copt)
+HX4_FIXED_PERF_IMPL(hx4_siphash13_64, 8, 64, hx4_siphash13_64_copt)
+HX4_FIXED_PERF_IMPL(hx4_siphash13_64, 16, 64, hx4_siphash13_64_copt)
+
+static int test_hx4_fixed_performance(FILE *stream, const void *in, size_t in_sz, const void *cookie, size_t cookie_sz) {
+  const size_t num_keys = 4096;
+  const size_t repeats = 2000;
+
+  if(in_sz < num_keys*16) {
+    fprintf(stream, "\tinput buffer too small\n");
+    return 1;
+  }
+
+  print_hx4_djbx33a_32_len4_performance(stream, in, num_keys, repeats, cookie, cookie_sz);
+  print_hx4_djbx33a_32_len8_performance(stream, in, num_keys, repeats, cookie, cookie_sz);
+  print_hx4_djbx33a_32_len16_performance(stream, in, num_keys, repeats, cookie, cookie_sz);
+  print_hx4_x4djbx33a_128_len4_performance(stream, in, num_keys, repeats, cookie, cookie_sz);
+  print_hx4_x4djbx33a_128_len8_performance(stream, in, num_keys, repeats, cookie, cookie_sz);
+  print_hx4_x4djbx33a_128_len16_performance(stream, in, num_keys, repeats, cookie, cookie_sz);
+  print_hx4_siphash24_64_len8_performance(stream, in, num_keys, repeats, cookie, cookie_sz);
+  print_hx4_siphash24_64_len16_performance(stream, in, num_keys, repeats, cookie, cookie_sz);
+  print_hx4_siphash13_64_len8_performance(stream, in, num_keys, repeats, cookie, cookie_sz);
+  print_hx4_siphash13_64_len16_performance(stream, in, num_keys, repeats, cookie, cookie_sz);
+  return 0;
+}
+
+static int test_hx4_bulk_correctness(FILE *stream, const void *in, size_t in_sz, const void *cookie, size_t cookie_sz) {
+  const size_t max_keys = 67;
+  uint64_t *keys;
+  uint64_t *out_ref;
+  uint64_t *out_bulk;
+  size_t n;
+  size_t offset;
+  int rc = 0;
+
+  if(in_sz < 1024) {
+    fprintf(stream, "\tinput buffer too small\n");
+    return 1;
+  }
+
+  //room for max_keys 128-bit keys behind every tested offset
+  keys = malloc((2*max_keys + 4) * sizeof(uint64_t));
+  out_ref = malloc((max_keys + 4) * sizeof(uint64_t));
+  out_bulk = malloc((max_keys + 4) * sizeof(uint64_t));
+  if(!keys || !out_ref || !out_bulk) {
+    fprintf(stream, "\tout of memory\n");
+    free(keys); free(out_ref); free(out_bulk);
+    return 1;
+  }
+  memcpy(keys, in, (2*max_keys + 4) * sizeof(uint64_t));
+
+#define HX4_CHECK_BULK(ref_function, function, key_type, out_type, out_size) \
+  rc = ref_function((const key_type*)keys + offset, n, cookie, cookie_sz, (out_type*)out_ref); \
+  rc += function((const key_type*)keys + offset, n, cookie, cookie_sz, (out_type*)out_bulk); \
+  if(rc != HX4_ERR_SUCCESS || memcmp(out_ref, out_bulk, n*(out_size)) != 0) { \
+    fprintf(stream, "\t" #function " output doesn't match ref output for %d keys at offset %d\n", (int)n, (int)offset); \
+    rc = 1; \
+    goto out; \
+  }
+
+  for(offset=0; offset<4; offset++) {
+    for(n=0; n<=max_keys; n++) {
+      HX4_CHECK_BULK(hx4_hash_u32_array_ref, hx4_hash_u32_array, uint32_t, uint32_t, 4)
+      HX4_CHECK_BULK(hx4_hash_u64_array_ref, hx4_hash_u64_array, uint64_t, uint64_t, 8)
+      HX4_CHECK_BULK(hx4_hash_u128_array_ref, hx4_hash_u128_array, uint64_t, uint64_t, 8)
+#if HX4_HAS_SSE2
+      HX4_CHECK_BULK(hx4_hash_u32_array_ref, hx4_hash_u32_array_sse2, uint32_t, uint32_t, 4)
+      HX4_CHECK_BULK(hx4_hash_u64_array_ref, hx4_hash_u64_array_sse2, uint64_t, uint64_t, 8)
+      HX4_CHECK_BULK(hx4_hash_u128_array_ref, hx4_hash_u128_array_sse2, uint64_t, uint64_t, 8)
+#endif
+#if HX4_HAS_AVX2
+      HX4_CHECK_BULK(hx4_hash_u32_array_ref, hx4_hash_u32_array_avx2, uint32_t, uint32_t, 4)
+      HX4_CHECK_BULK(hx4_hash_u64_array_ref, hx4_hash_u64_array_avx2, uint64_t, uint64_t, 8)
+      HX4_CHECK_BULK(hx4_hash_u128_array_ref, hx4_hash_u128_array_avx2, uint64_t, uint64_t, 8)
+#endif
+    }
+  }
+#undef HX4_CHECK_BULK
+
+  //n*key_size would wrap around to a short array
+#define HX4_CHECK_BULK_OVERFLOW(function, key_type, out_type, key_size) \
+  if(function((const key_type*)keys, SIZE_MAX/(key_size) + 1, cookie, cookie_sz, (out_type*)out_bulk) != HX4_ERR_PARAM_INVALID) { \
+    fprintf(stream, "\t" #function " accepts a number of keys whose size overflows\n"); \
+    rc = 1; \
+    goto out; \
+  }
+
+  HX4_CHECK_BULK_OVERFLOW(hx4_hash_u32_array_ref, uint32_t, uint32_t, 4)
+  HX4_CHECK_BULK_OVERFLOW(hx4_hash_u64_array_ref, uint64_t, uint64_t, 8)
+  HX4_CHECK_BULK_OVERFLOW(hx4_hash_u128_array_ref, uint64_t, uint64_t, 16)
+#if HX4_HAS_SSE2
+  HX4_CHECK_BULK_OVERFLOW(hx4_hash_u32_array_sse2, uint32_t, uint32_t, 4)
+  HX4_CHECK_BULK_OVERFLOW(hx4_hash_u64_array_sse2, uint64_t, uint64_t, 8)
+  HX4_CHECK_BULK_OVERFLOW(hx4_hash_u128_array_sse2, uint64_t, uint64_t, 16)
+#endif
+#if HX4_HAS_AVX2
+  HX4_CHECK_BULK_OVERFLOW(hx4_hash_u32_array_avx2, uint32_t, uint32_t, 4)
+  HX4_CHECK_BULK_OVERFLOW(hx4_hash_u64_array_avx2, uint64_t, uint64_t, 8)
+  HX4_CHECK_BULK_OVERFLOW(hx4_hash_u128_array_avx2, uint64_t, uint64_t, 16)
+#endif
+#undef HX4_CHECK_BULK_OVERFLOW
+
+out:
+  free(keys);
+  free(out_ref);
+  free(out_bulk);
+  return rc;
+}
+
+/* the per element call loops the bulk functions are measured against */
+static int hash_u32_array_per_element(const uint32_t *keys, size_t n, const void *cookie, size_t cookie_sz, uint32_t *out) {
+  size_t i;
+  for(i=0; i<n; i++) {
+    hx4_halfsiphash13_32_copt(&keys[i], 4, cookie, cookie_sz, &out[i], 4);
+  }
+  return 0;
+}
+
+static int hash_u64_array_per_element(const uint64_t *keys, size_t n, const void *cookie, size_t cookie_sz, uint64_t *out) {
+  size_t i;
+  for(i=0; i<n; i++) {
+    hx4_siphash13_64_copt(&keys[i], 8, cookie, cookie_sz, &out[i], 8);
+  }
+  return 0;
+}
+
+static int hash_u64_array_per_element_fixed(const uint64_t *keys, size_t n, const void *cookie, size_t cookie_sz, uint64_t *out) {
+  size_t i;
+  (void)cookie_sz;
+  for(i=0; i<n; i++) {
+    hx4_siphash13_64_len8(&keys[i], cookie, &out[i]);
+  }
+  return 0;
+}
+
+static int hash_u128_array_per_element(const void *keys, size_t n, const void *cookie, size_t cookie_sz, uint64_t *out) {
+  size_t i;
+  for(i=0; i<n; i++) {
+    hx4_siphash13_64_copt((const uint8_t*)keys + 16*i, 16, cookie, cookie_sz, &out[i], 8);
+  }
+  return 0;
+}
+
+static int hash_u128_array_per_element_fixed(const void *keys, size_t n, const void *cookie, size_t cookie_sz, uint64_t *out) {
+  size_t i;
+  (void)cookie_sz;
+  for(i=0; i<n; i++) {
+    hx4_siphash13_64_len16((const uint8_t*)keys + 16*i, cookie, &out[i]);
+  }
+  return 0;
+}
+
+/* hashes the whole column again and again for about a second and prints the keys per second */
+#define HX4_BULK_PERF_IMPL(function, key_type, out_type) \
+static void print_##function##_performance(FILE *stream, const key_type *keys, size_t n, const void *cookie, size_t cookie_sz, out_type *out) { \
+  hx_time start; \
+  hx_time stop; \
+  float timedelta = 0; \
+  uint64_t repeat_count = 0; \
+  start = hx_gettime(); \
+  while (timedelta < 1.0) { \
+    function(keys, n, cookie, cookie_sz, out); \
+    repeat_count++; \
+    stop = hx_gettime(); \
+    timedelta = hx_timedelta_s(&start, &stop); \
+  } \
+  fprintf(stream, "\t%-36s %8.2f Mkeys/s\n", #function, (double)n * (double)repeat_count / (double)timedelta / 1000000.0); \
+}
+
+HX4_BULK_PERF_IMPL(hash_u32_array_per_element, uint32_t, uint32_t)
+HX4_BULK_PERF_IMPL(hx4_hash_u32_array_ref, uint32_t, uint32_t)
+#if HX4_HAS_SSE2
+HX4_BULK_PERF_IMPL(hx4_hash_u32_array_sse2, uint32_t, uint32_t)
+#endif
+#if HX4_HAS_AVX2
+HX4_BULK_PERF_IMPL(hx4_hash_u32_array_avx2, uint32_t, uint32_t)
+#endif
+HX4_BULK_PERF_IMPL(hash_u64_array_per_element, uint64_t, uint64_t)
+HX4_BULK_PERF_IMPL(hash_u64_array_per_element_fixed, uint64_t, uint64_t)
+HX4_BULK_PERF_IMPL(hx4_hash_u64_array_ref, uint64_t, uint64_t)
+#if HX4_HAS_SSE2
+HX4_BULK_PERF_IMPL(hx4_hash_u64_array_sse2, uint64_t, uint64_t)
+#endif
+#if HX4_HAS_AVX2
+HX4_BULK_PERF_IMPL(hx4_hash_u64_array_avx2, uint64_t, uint64_t)
+#endif
+HX4_BULK_PERF_IMPL(hash_u128_array_per_element, void, uint64_t)
+HX4_BULK_PERF_IMPL(hash_u128_array_per_element_fixed, void, uint64_t)
+HX4_BULK_PERF_IMPL(hx4_hash_u128_array_ref, void, uint64_t)
+#if HX4_HAS_SSE2
+HX4_BULK_PERF_IMPL(hx4_hash_u128_array_sse2, void, uint64_t)
+#endif
+#if HX4_HAS_AVX2
+HX4_BULK_PERF_IMPL(hx4_hash_u128_array_avx2, void, uint64_t)
+#endif
+
+static int test_hx4_bulk_performance(FILE *stream, const void *in, size_t in_sz, const void *cookie, size_t cookie_sz) {
+  size_t num_keys = 4*1024*1024;
+  uint64_t *out;
+
+  //the 128-bit column is the largest one
+  if(in_sz < 16*num_keys) {
+    num_keys = in_sz / 16;
+  }
+  out = malloc(num_keys * sizeof(uint64_t));
+  if(!out) {
+    fprintf(stream, "\tout of memory\n");
+    return 1;
+  }
+
+  fprintf(stream, "\t%d keys per column\n", (int)num_keys);
+  print_hash_u32_array_per_element_performance(stream, in, num_keys, cookie, cookie_sz, (uint32_t*)out);
+  print_hx4_hash_u32_array_ref_performance(stream, in, num_keys, cookie, cookie_sz, (uint32_t*)out);
+#if HX4_HAS_SSE2
+  print_hx4_hash_u32_array_sse2_performance(stream, in, num_keys, cookie, cookie_sz, (uint32_t*)out);
+#endif
+#if HX4_HAS_AVX2
+  print_hx4_hash_u32_array_avx2_performance(stream, in, num_keys, cookie, cookie_sz, (uint32_t*)out);
+#endif
+  print_hash_u64_array_per_element_performance(stream, in, num_keys, cookie, cookie_sz, out);
+  print_hash_u64_array_per_element_fixed_performance(stream, in, num_keys, cookie, cookie_sz, out);
+  print_hx4_hash_u64_array_ref_performance(stream, in, num_keys, cookie, cookie_sz, out);
+#if HX4_HAS_SSE2
+  print_hx4_hash_u64_array_sse2_performance(stream, in, num_keys, cookie, cookie_sz, out);
+#endif
+#if HX4_HAS_AVX2
+  print_hx4_hash_u64_array_avx2_performance(stream, in, num_keys, cookie, cookie_sz, out);
+#endif
+  print_hash_u128_array_per_element_performance(stream, in, num_keys, cookie, cookie_sz, out);
+  print_hash_u128_array_per_element_fixed_performance(stream, in, num_keys, cookie, cookie_sz, out);
+  print_hx4_hash_u128_array_ref_performance(stream, in, num_keys, cookie, cookie_sz, out);
+#if HX4_HAS_SSE2
+  print_hx4_hash_u128_array_sse2_performance(stream, in, num_keys, cookie, cookie_sz, out);
+#endif
+#if HX4_HAS_AVX2
+  print_hx4_hash_u128_array_avx2_performance(stream, in, num_keys, cookie, cookie_sz, out);
+#endif
+
+  free(out);
+  return 0;
+}
+
+#define HX4_TEST_COOKIE_APPLIED_IMPL(hash_function, output_bits) \
+static int test_##hash_function##_cookie_applied(FILE *stream, const void *in, size_t in_sz, const void *cookie, size_t cookie_sz) { \
+  uint8_t out_i_cookie[(output_bits)/8]; \
+  uint8_t out_z_cookie[(output_bits)/8]; \
+  uint8_t out_1_cookie[(output_bits)/8]; \
+  uint8_t zero_cookie[128/8]; \
+  uint8_t ones_cookie[128/8]; \
+  int rc; \
+  if(in_sz < 1024) { \
+    fprintf(stream, "\tinput buffer too small\n"); \
+    return 1; \
+  } \
+  in_sz = 1024; \
+  memset(zero_cookie, 0, sizeof(zero_cookie)); \
+  memset(ones_cookie, 1, sizeof(ones_cookie)); \
+  memset(out_i_cookie, 0, sizeof(out_i_cookie)); \
+  memset(out_z_cookie, 0, sizeof(out_z_cookie)); \
+  rc = hash_function(in, in_sz, cookie, cookie_sz, out_i_cookie, sizeof(out_i_cookie)); \
+  if(rc != HX4_ERR_SUCCESS) { \
+    return rc; \
+  } \
+  rc = hash_function(in, in_sz, zero_cookie, sizeof(zero_cookie), out_z_cookie, sizeof(out_z_cookie)); \
+  if(rc != HX4_ERR_SUCCESS) { \
+    return rc; \
+  } \
+  rc = hash_function(in, in_sz, ones_cookie, sizeof(ones_cookie), out_1_cookie, sizeof(out_1_cookie)); \
+  if(rc != HX4_ERR_SUCCESS) { \
+    return rc; \
+  } \
+  if(memcmp(out_i_cookie, out_z_cookie, sizeof(out_i_cookie)) == 0) { \
+    fprintf(stream, "\tcookie not applied\n"); \
+    return 2; \
+  } \
+  if(memcmp(out_i_cookie, out_1_cookie, sizeof(out_i_cookie)) == 0) { \
+    fprintf(stream, "\tcookie not applied\n"); \
+    return 3; \
+  } \
+  return 0; \
+}
+
+
+HX4_TEST_COOKIE_APPLIED_IMPL(hx4_djbx33a_32_ref, 32)
+HX4_TEST_COOKIE_APPLIED_IMPL(hx4_djbx33a_32_copt, 32)
+HX4_TEST_COOKIE_APPLIED_IMPL(hx4_x4djbx33a_128_ref, 128)
+HX4_TEST_COOKIE_APPLIED_IMPL(hx4_x4djbx33a_128_copt, 128)
+#if HX4_HAS_MMX
+HX4_TEST_COOKIE_APPLIED_IMPL(hx4_x4djbx33a_128_mmx, 128)
+#endif
+#if HX4_HAS_SSE2
+HX4_TEST_COOKIE_APPLIED_IMPL(hx4_x4djbx33a_128_sse2, 128)
+HX4_TEST_COOKIE_APPLIED_IMPL(hx4_x4djbx33a_128_sse2rle, 128)
+#endif
+#if HX4_HAS_SSSE3
+HX4_TEST_COOKIE_APPLIED_IMPL(hx4_x4djbx33a_128_ssse3, 128)
+#endif
+HX4_TEST_COOKIE_APPLIED_IMPL(hx4_kdjbx33a_32_ref, 32)
+HX4_TEST_COOKIE_APPLIED_IMPL(hx4_kdjbx33a_32_copt, 32)
+HX4_TEST_COOKIE_APPLIED_IMPL(hx4_x4kdjbx33a_128_ref, 128)
+HX4_TEST_COOKIE_APPLIED_IMPL(hx4_x4kdjbx33a_128_copt, 128)
+#if HX4_HAS_SSE2
+HX4_TEST_COOKIE_APPLIED_IMPL(hx4_x4kdjbx33a_128_sse2, 128)
+#endif
+#if HX4_HAS_SSSE3
+HX4_TEST_COOKIE_APPLIED_IMPL(hx4_x4kdjbx33a_128_ssse3, 128)
+#endif
+HX4_TEST_COOKIE_APPLIED_IMPL(hx4_siphash13_64_ref, 64)
+HX4_TEST_COOKIE_APPLIED_IMPL(hx4_siphash13_64_copt, 64)
+HX4_TEST_COOKIE_APPLIED_IMPL(hx4_x4siphash13_256_ref, 256)
+#if HX4_HAS_SSE2
+HX4_TEST_COOKIE_APPLIED_IMPL(hx4_x4siphash13_256_sse2, 256)
+#endif
+HX4_TEST_COOKIE_APPLIED_IMPL(hx4_halfsiphash13_32_ref, 32)
+HX4_TEST_COOKIE_APPLIED_IMPL(hx4_halfsiphash13_32_copt, 32)
+HX4_TEST_COOKIE_APPLIED_IMPL(hx4_x4halfsiphash13_128_ref, 128)
+#if HX4_HAS_SSE2
+HX4_TEST_COOKIE_APPLIED_IMPL(hx4_x4halfsiphash13_128_sse2, 128)
+#endif
+HX4_TEST_COOKIE_APPLIED_IMPL(hx4_crc32c_32_ref, 32)
+HX4_TEST_COOKIE_APPLIED_IMPL(hx4_x4crc32c_128_ref, 128)
+#if HX4_HAS_SSE42
+HX4_TEST_COOKIE_APPLIED_IMPL(hx4_crc32c_32_sse42, 32)
+HX4_TEST_COOKIE_APPLIED_IMPL(hx4_x4crc32c_128_sse42, 128)
+#endif
+#if HX4_HAS_SSE42 && HX4_HAS_PCLMUL
+HX4_TEST_COOKIE_APPLIED_IMPL(hx4_crc32c_32_pclmul, 32)
+#endif
+HX4_TEST_COOKIE_APPLIED_IMPL(hx4_x4aes_128_ref, 128)
+#if HX4_HAS_AESNI
+HX4_TEST_COOKIE_APPLIED_IMPL(hx4_x4aes_128_aesni, 128)
+#endif
+HX4_TEST_COOKIE_APPLIED_IMPL(hx4_polyval_128_ref, 128)
+#if HX4_HAS_PCLMUL
+HX4_TEST_COOKIE_APPLIED_IMPL(hx4_polyval_128_pclmul, 128)
+#endif
+HX4_TEST_COOKIE_APPLIED_IMPL(hx4_x4mulfold_128_ref, 128)
+HX4_TEST_COOKIE_APPLIED_IMPL(hx4_x4mulfold_128_copt, 128)
+#if HX4_HAS_SSE2
+HX4_TEST_COOKIE_APPLIED_IMPL(hx4_x4mulfold_128_sse2, 128)
+#endif
+#if HX4_HAS_AVX2
+HX4_TEST_COOKIE_APPLIED_IMPL(hx4_x4mulfold_128_avx2, 128)
+#endif
+
+
+/* a chained hash table like it is found in many C programs, used to show hash flooding */
+typedef struct {
+  const uint8_t *key;
+  size_t key_sz;
+  uint32_t hash;
+  size_t next;
+} chained_entry_t;
+
+#define CHAINED_END ((size_t)-1)
+
+static uint32_t fold_hash_output(const uint8_t *hash_output, size_t hash_output_sz) {
+  uint32_t folded = 0;
+  uint32_t word;
+  size_t i;
+  for(i=0; i+4<=hash_output_sz; i+=4) {
+    memcpy(&word, hash_output+i, sizeof(word));
+    folded ^= word;
+  }
+  return folded;
+}
+
+/* fills a table with the keys, then looks up every key and returns the time per lookup in ns */
+static float measure_chained_lookup_ns(hash_function_t hash_function, size_t hash_output_sz, const uint8_t *keys, size_t key_sz, size_t num_keys, const void *cookie, size_t cookie_sz, size_t *longest_chain) {
+  const size_t num_buckets = num_keys;
+  uint8_t hash_output[512/8];
+  chained_entry_t *entries;
+  size_t *heads;
+  size_t bucket;
+  size_t chain;
+  size_t found = 0;
+  size_t i;
+  size_t e;
+  uint32_t hash;
+  hx_time start;
+  hx_time stop;
+  float timedelta = 0;
+  size_t repeat_count = 0;
+
+  entries = malloc(num_keys * sizeof(chained_entry_t));
+  heads = malloc(num_buckets * sizeof(size_t));
+  if(!entries || !heads) {
+    free(entries);
+    free(heads);
+    return -1;
+  }
+  for(i=0; i<num_buckets; i++) {
+    heads[i] = CHAINED_END;
+  }
+
+  for(i=0; i<num_keys; i++) {
+    hash_function(keys + i*key_sz, key_sz, cookie, cookie_sz, hash_output, hash_output_sz);
+    hash = fold_hash_output(hash_output, hash_output_sz);
+    bucket = hash % num_buckets;
+    entries[i].key = keys + i*key_sz;
+    entries[i].key_sz = key_sz;
+    entries[i].hash = hash;
+    entries[i].next = heads[bucket];
+    heads[bucket] = i;
+  }
+
+  *longest_chain = 0;
+  for(i=0; i<num_buckets; i++) {
+    for(chain=0, e=heads[i]; e != CHAINED_END; e=entries[e].next) {
+      chain++;
+    }
+    *longest_chain = chain > *longest_chain ? chain : *longest_chain;
+  }
+
+  //one pass over the keys is below the resolution of the clock, repeat it for a second
+  start = hx_gettime();
+  while(timedelta < 1.0) {
+    for(i=0; i<num_keys; i++) {
+      hash_function(keys + i*key_sz, key_sz, cookie, cookie_sz, hash_output, hash_output_sz);
+      hash = fold_hash_output(hash_output, hash_output_sz);
+      for(e=heads[hash % num_buckets]; e != CHAINED_END; e=entries[e].next) {
+        if(entries[e].hash == hash && entries[e].key_sz == key_sz && memcmp(entries[e].key, keys + i*key_sz, key_sz) == 0) {
+          found++;
+          break;
+        }
+      }
+    }
+    repeat_count++;
+    stop = hx_gettime();
+    timedelta = hx_timedelta_s(&start, &stop);
+  }
+
+  free(entries);
+  free(heads);
+  if(found != num_keys * repeat_count) {
+    return -1;
+  }
+  return (float)(timedelta * 1000000000.0 / ((double)num_keys * (double)repeat_count));
+}
+
+/*
+ * Crafts keys that all collide for x4djbx33a independent of the cookie:
+ * every lane sees two bytes (a, b) per 8 byte block and (a+1, b-33) gives
+ * the same lane state. With 4 lanes that's 16 variants per block.
+ */
+static void init_x4djbx33a_collisions(uint8_t *keys, size_t num_blocks) {
+  const uint8_t base_block[8] = { 'h', 'a', 's', 'h', 'x', '4', 'k', 'y' };
+  const size_t key_sz = 8*num_blocks;
+  size_t num_keys = (size_t)1 << (4*num_blocks);
+  size_t i;
+  size_t block;
+  int lane;
+  int variant;
+  uint8_t *key;
+
+  for(i=0; i<num_keys; i++) {
+    key = keys + i*key_sz;
+    for(block=0; block<num_blocks; block++) {
+      memcpy(key + 8*block, base_block, sizeof(base_block));
+      variant = (int)((i >> (4*block)) & 0x0f);
+      for(lane=0; lane<4; lane++) {
+        if(variant & (1 << lane)) {
+          key[8*block + lane] += 1;
+          key[8*block + lane + 4] -= 33;
+        }
+      }
+    }
+  }
+}
+
+static int test_hx4_x4kdjbx33a_128_flooding_performance(FILE *stream, const void *in, size_t in_sz, const void *cookie, size_t cookie_sz) {
+  const size_t num_blocks = 3;
+  const size_t key_sz = 8*num_blocks;
+  const size_t num_keys = (size_t)1 << (4*num_blocks);
+  const hash_function_item_t items[] = {
+    HASH_FUNCTION_ITEM(hx4_x4djbx33a_128_copt, 128)
+    HASH_FUNCTION_ITEM(hx4_x4kdjbx33a_128_copt, 128)
+#if HX4_HAS_SSE2
+    HASH_FUNCTION_ITEM(hx4_x4djbx33a_128_sse2, 128)
+    HASH_FUNCTION_ITEM(hx4_x4kdjbx33a_128_sse2, 128)
+#endif
+  };
+  uint8_t *keys;
+  size_t longest_chain;
+  size_t i;
+  float ns;
+  int rc = 0;
+
+  (void)in;
+  (void)in_sz;
+
+  keys = malloc(num_keys * key_sz);
+  if(!keys) {
+    fprintf(stream, "\tout of memory\n");
+    return 1;
+  }
+  init_x4djbx33a_collisions(keys, num_blocks);
+
+  fprintf(stream, "\tchained table with %d crafted %d byte keys:\n", (int)num_keys, (int)key_sz);
+  for(i=0; i<sizeof(items)/sizeof(items[0]); i++) {
+    ns = measure_chained_lookup_ns(items[i].function, items[i].output_size, keys, key_sz, num_keys, cookie, cookie_sz, &longest_chain);
+    if(ns < 0) {
+      fprintf(stream, "\t%s: lookup failed\n", items[i].name);
+      rc = 1;
+      continue;
+    }
+    fprintf(stream, "\t%-32s %10.1f ns per lookup, longest chain %d\n", items[i].name, (double)ns, (int)longest_chain);
+  }
+
+  free(keys);
+  return rc;
+}
+
+/* checks that every row landed exactly once, in the partition of its hash and in row order */
+static int check_partitions(FILE *stream, const char *name, const uint64_t *keys, size_t n, const void *cookie, size_t cookie_sz, int bits, const hx4_tuple *out, const size_t *partition_offsets) {
+  uint64_t hash;
+  size_t p;
+  size_t i;
+  uint64_t row;
+
+  if(partition_offsets[0] != 0 || partition_offsets[(size_t)1 << bits] != n) {
+    fprintf(stream, "\t%s with %d bits: partition offsets don't cover the input\n", name, bits);
+    return 1;
+  }
+  for(p=0; p<((size_t)1 << bits); p++) {
+    for(i=partition_offsets[p]; i<partition_offsets[p+1]; i++) {
+      row = out[i].payload;
+      if(row >= n || keys[row] != out[i].key) {
+        fprintf(stream, "\t%s with %d bits: tuple %d doesn't match its row\n", name, bits, (int)i);
+        return 1;
+      }
+      if(i > partition_offsets[p] && out[i-1].payload >= row) {
+        fprintf(stream, "\t%s with %d bits: partition %d is not in row order\n", name, bits, (int)p);
+        return 1;
+      }
+      hx4_hash_u64_array_ref(&keys[row], 1, cookie, cookie_sz, &hash);
+      if((bits == 0 ? 0 : (size_t)(hash >> (64 - bits))) != p) {
+        fprintf(stream, "\t%s with %d bits: tuple %d is in the wrong partition\n", name, bits, (int)i);
+        return 1;
+      }
+    }
+  }
+  //row order within the partitions and the matching count make every row appear once
+  return 0;
+}
+
+static int test_hx4_partition_correctness(FILE *stream, const void *in, size_t in_sz, const void *cookie, size_t cookie_sz) {
+  const size_t n = 10007;
+  const size_t num_chunks = 3;
+  const int bits_list[] = { 0, 1, 4, 10 };
+  const size_t shifts[] = { 8, 16, 48 };
+  uint64_t *keys;
+  uint64_t *payloads;
+  uint16_t *pids;
+  hx4_tuple *out;
+  size_t *histograms;
+  size_t offsets[(1 << 10) + 1];
+  void *swwc;
+  size_t swwc_sz = HX4_PARTITION_SWWC_SIZE(10);
+  size_t chunk;
+  size_t first;
+  hx4_tuple *shifted;
+  size_t c;
+  size_t b;
+  size_t s;
+  size_t i;
+  int bits;
+  int rc = 0;
+
+  (void)in;
+  (void)in_sz;
+
+  keys = malloc(n * sizeof(uint64_t));
+  payloads = malloc(n * sizeof(uint64_t));
+  pids = malloc(n * sizeof(uint16_t));
+  //spare tuples, so out can be shifted against the cache lines
+  out = malloc((n + 4) * sizeof(hx4_tuple));
+  histograms = malloc((num_chunks << 10) * sizeof(size_t));
+  swwc = malloc(swwc_sz);
+  if(!keys || !payloads || !pids || !out || !histograms || !swwc) {
+    fprintf(stream, "\tout of memory\n");
+    rc = 1;
+    goto out;
+  }
+  //the input buffer repeats every 256 bytes, the keys have to be distinct
+  for(i=0; i<n; i++) {
+    keys[i] = (uint64_t)i * 0x9e3779b97f4a7c15ULL;
+    payloads[i] = i;
+  }
+
+  for(b=0; b<sizeof(bits_list)/sizeof(bits_list[0]); b++) {
+    bits = bits_list[b];
+
+    memset(out, 0, n * sizeof(hx4_tuple));
+    memset(swwc, 0xee, swwc_sz);
+    rc = hx4_partition_u64(keys, payloads, n, cookie, cookie_sz, bits, pids, swwc, swwc_sz, out, offsets);
+    if(rc != HX4_ERR_SUCCESS) {
+      goto out;
+    }
+    rc = check_partitions(stream, "hx4_partition_u64", keys, n, cookie, cookie_sz, bits, out, offsets);
+    if(rc != 0) {
+      goto out;
+    }
+
+    //the same rows split into chunks like the threads of a parallel run would,
+    //written to an output at every position relative to the cache lines
+    for(s=0; s<sizeof(shifts)/sizeof(shifts[0]); s++) {
+      shifted = (hx4_tuple*)((uint8_t*)out + shifts[s]);
+      chunk = n / num_chunks;
+      for(c=0; c<num_chunks; c++) {
+        first = c*chunk;
+        rc = hx4_partition_histogram(keys + first, c == num_chunks-1 ? n - first : chunk, cookie, cookie_sz, bits, pids + first, histograms + (c << bits));
+        if(rc != HX4_ERR_SUCCESS) {
+          goto out;
+        }
+      }
+      rc = hx4_partition_prefix_sum(histograms, num_chunks, bits, offsets);
+      if(rc != HX4_ERR_SUCCESS) {
+        goto out;
+      }
+      for(c=0; c<num_chunks; c++) {
+        first = c*chunk;
+        //stale buffer contents must never reach the output
+        memset(swwc, 0xee, swwc_sz);
+        rc = hx4_partition_scatter(keys + first, payloads + first, pids + first, c == num_chunks-1 ? n - first : chunk, bits, histograms + (c << bits), swwc, swwc_sz, shifted);
+        if(rc != HX4_ERR_SUCCESS) {
+          goto out;
+        }
+      }
+      rc = check_partitions(stream, "chunked hx4_partition_scatter", keys, n, cookie, cookie_sz, bits, shifted, offsets);
+      if(rc != 0) {
+        goto out;
+      }
+    }
+  }
+
+out:
+  free(keys);
+  free(payloads);
+  free(pids);
+  free(out);
+  free(histograms);
+  free(swwc);
+  return rc;
+}
+
+#define HX4_PARTITION_TEST_THREADS 4
+
+typedef struct {
+  const uint64_t *keys;
+  const uint64_t *payloads;
+  uint16_t *pids;
+  size_t n;
+  const void *cookie;
+  size_t cookie_sz;
+  int bits;
+  size_t *histogram;
+  void *swwc;
+  size_t swwc_sz;
+  hx4_tuple *out;
+  int rc;
+} partition_thread_t;
+
+HX_THREAD_FUNCTION(partition_histogram_thread) {
+  partition_thread_t *t = arg;
+  t->rc = hx4_partition_histogram(t->keys, t->n, t->cookie, t->cookie_sz, t->bits, t->pids, t->histogram);
+  HX_THREAD_RETURN;
+}
+
+HX_THREAD_FUNCTION(partition_scatter_thread) {
+  partition_thread_t *t = arg;
+  t->rc = hx4_partition_scatter(t->keys, t->payloads, t->pids, t->n, t->bits, t->histogram, t->swwc, t->swwc_sz, t->out);
+  HX_THREAD_RETURN;
+}
+
+/* the three pass way: hash the column, histogram the hashes, scatter with plain stores */
+static int partition_three_pass(const uint64_t *keys, const uint64_t *payloads, size_t n, const void *cookie, size_t cookie_sz, int bits, uint64_t *hashes, size_t *cursors, hx4_tuple *out) {
+  size_t sum = 0;
+  size_t count;
+  size_t p;
+  size_t i;
+  int rc;
+
+  rc = hx4_hash_u64_array(keys, n, cookie, cookie_sz, hashes);
+  if(rc != HX4_ERR_SUCCESS) {
+    return rc;
+  }
+  memset(cursors, 0, sizeof(size_t) << bits);
+  for(i=0; i<n; i++) {
+    cursors[hashes[i] >> (64 - bits)]++;
+  }
+  for(p=0; p<((size_t)1 << bits); p++) {
+    count = cursors[p];
+    cursors[p] = sum;
+    sum += count;
+  }
+  for(i=0; i<n; i++) {
+    p = (size_t)(hashes[i] >> (64 - bits));
+    out[cursors[p]].key = keys[i];
+    out[cursors[p]].payload = payloads[i];
+    cursors[p]++;
+  }
+  return HX4_ERR_SUCCESS;
+}
+
+static int test_hx4_partition_performance(FILE *stream, const void *in, size_t in_sz, const void *cookie, size_t cookie_sz) {
+  const size_t num_threads = HX4_PARTITION_TEST_THREADS;
+  size_t n = 8*1024*1024;
+  const size_t swwc_sz = HX4_PARTITION_SWWC_SIZE(14);
+  partition_thread_t threads[HX4_PARTITION_TEST_THREADS];
+  hx_thread handles[HX4_PARTITION_TEST_THREADS];
+  uint64_t *keys;
+  uint64_t *hashes;
+  uint16_t *pids;
+  hx4_tuple *out;
+  size_t *histograms;
+  uint8_t *swwc;
+  size_t chunk;
+  size_t t;
+  hx_time start;
+  hx_time stop;
+  float three_pass_s;
+  float fused_s;
+  float threaded_s;
+  int bits;
+  int rc = 0;
+
+  (void)in;
+  (void)in_sz;
+
+  keys = malloc(n * sizeof(uint64_t));
+  hashes = malloc(n * sizeof(uint64_t));
+  pids = malloc(n * sizeof(uint16_t));
+  out = malloc(n * sizeof(hx4_tuple));
+  histograms = malloc((num_threads << 14) * sizeof(size_t));
+  swwc = malloc(num_threads * swwc_sz);
+  if(!keys || !hashes || !pids || !out || !histograms || !swwc) {
+    fprintf(stream, "\tout of memory\n");
+    rc = 1;
+    goto out;
+  }
+  for(t=0; t<n; t++) {
+    keys[t] = (uint64_t)t * 0x9e3779b97f4a7c15ULL;
+  }
+  //touch the scratch and output once, so no run pays for the page faults
+  memset(hashes, 0, n * sizeof(uint64_t));
+  memset(pids, 0, n * sizeof(uint16_t));
+  memset(out, 0, n * sizeof(hx4_tuple));
+
+  //the key column doubles as the payload column
+  fprintf(stream, "\t%d tuples, %d threads, Mtuples/s\n", (int)n, (int)num_threads);
+  fprintf(stream, "\t%10s %12s %12s %12s\n", "partitions", "three pass", "fused", "fused mt");
+  for(bits=4; bits<=14; bits+=2) {
+    start = hx_gettime();
+    rc += partition_three_pass(keys, keys, n, cookie, cookie_sz, bits, hashes, histograms, out);
+    stop = hx_gettime();
+    three_pass_s = hx_timedelta_s(&start, &stop);
+
+    start = hx_gettime();
+    rc += hx4_partition_u64(keys, keys, n, cookie, cookie_sz, bits, pids, swwc, swwc_sz, out, histograms);
+    stop = hx_gettime();
+    fused_s = hx_timedelta_s(&start, &stop);
+
+    chunk = n / num_threads;
+    for(t=0; t<num_threads; t++) {
+      threads[t].keys = keys + t*chunk;
+      threads[t].payloads = keys + t*chunk;
+      threads[t].pids = pids + t*chunk;
+      threads[t].n = t == num_threads-1 ? n - t*chunk : chunk;
+      threads[t].cookie = cookie;
+      threads[t].cookie_sz = cookie_sz;
+      threads[t].bits = bits;
+      threads[t].histogram = histograms + (t << bits);
+      threads[t].swwc = swwc + t*swwc_sz;
+      threads[t].swwc_sz = swwc_sz;
+      threads[t].out = out;
+    }
+    start = hx_gettime();
+    for(t=0; t<num_threads; t++) {
+      hx_thread_start(&handles[t], partition_histogram_thread, &threads[t]);
+    }
+    for(t=0; t<num_threads; t++) {
+      hx_thread_join(handles[t]);
+      rc += threads[t].rc;
+    }
+    rc += hx4_partition_prefix_sum(histograms, num_threads, bits, NULL);
+    for(t=0; t<num_threads; t++) {
+      hx_thread_start(&handles[t], partition_scatter_thread, &threads[t]);
+    }
+    for(t=0; t<num_threads; t++) {
+      hx_thread_join(handles[t]);
+      rc += threads[t].rc;
+    }
+    stop = hx_gettime();
+    threaded_s = hx_timedelta_s(&start, &stop);
+
+    fprintf(stream, "\t%10d %12.2f %12.2f %12.2f\n", 1 << bits,
+      (double)n / three_pass_s / 1000000.0,
+      (double)n / fused_s / 1000000.0,
+      (double)n / threaded_s / 1000000.0);
+  }
+
+out:
+  free(keys);
+  free(hashes);
+  free(pids);
+  free(out);
+  free(histograms);
+  free(swwc);
+  return rc;
+}
+
+/* n keys of 8 to 40 bytes each, all different, in one buffer */
+static uint8_t *init_varlen_keys(size_t n, const void **keys, size_t *key_sizes) {
+  uint8_t *buffer;
+  uint8_t *p;
+  uint64_t word;
+  size_t i;
+  size_t j;
+
+  buffer = malloc(n * 48);
+  if(!buffer) {
+    return NULL;
+  }
+  p = buffer;
+  for(i=0; i<n; i++) {
+    //the index makes the first 8 bytes unique, the rest is filler
+    key_sizes[i] = 8 + (i * 7) % 33;
+    word = (uint64_t)i * 0x9e3779b97f4a7c15ULL;
+    for(j=0; j<key_sizes[i]; j++) {
+      p[j] = j < 8 ? (uint8_t)(i >> (8*j)) : (uint8_t)(word >> (8*(j%8)));
+    }
+    keys[i] = p;
+    p += 48;
+  }
+  return buffer;
+}
+
+static int test_hx4_bloom_correctness(FILE *stream, const void *in, size_t in_sz, const void *cookie, size_t cookie_sz) {
+  const size_t n = 20000;
+  const size_t num_blocks = n * 10 / 512;
+  const void **keys;
+  size_t *key_sizes;
+  uint8_t *key_buffer = NULL;
+  uint8_t *results;
+  void *memory;
+  hx4_bloom bloom;
+  size_t positives = 0;
+  size_t i;
+  int rc = 0;
+
+  (void)in;
+  (void)in_sz;
+
+  //twice as many keys, the second half is never inserted
+  keys = malloc(2*n * sizeof(void*));
+  key_sizes = malloc(2*n * sizeof(size_t));
+  results = malloc(2*n);
+  memory = malloc(HX4_BLOOM_MEMORY_SIZE(num_blocks));
+  if(keys && key_sizes) {
+    key_buffer = init_varlen_keys(2*n, keys, key_sizes);
+  }
+  if(!keys || !key_sizes || !key_buffer || !results || !memory) {
+    fprintf(stream, "\tout of memory\n");
+    rc = 1;
+    goto out;
+  }
+
+  rc = hx4_bloom_init(&bloom, memory, HX4_BLOOM_MEMORY_SIZE(num_blocks), cookie, cookie_sz);
+  if(rc != HX4_ERR_SUCCESS) {
+    goto out;
+  }
+  if(bloom.num_blocks != num_blocks) {
+    fprintf(stream, "\tfilter has %d blocks instead of %d\n", (int)bloom.num_blocks, (int)num_blocks);
+    rc = 1;
+    goto out;
+  }
+
+  //half of the set one by one, the other half as a batch
+  for(i=0; i<n/2; i++) {
+    rc = hx4_bloom_insert(&bloom, keys[i], key_sizes[i]);
+    if(rc != HX4_ERR_SUCCESS) {
+      goto out;
+    }
+  }
+  rc = hx4_bloom_insert_batch(&bloom, keys + n/2, key_sizes + n/2, n - n/2);
+  if(rc != HX4_ERR_SUCCESS) {
+    goto out;
+  }
+
+  rc = hx4_bloom_query_batch(&bloom, keys, key_sizes, 2*n, results);
+  if(rc != HX4_ERR_SUCCESS) {
+    goto out;
+  }
+  for(i=0; i<2*n; i++) {
+    if(hx4_bloom_query(&bloom, keys[i], key_sizes[i]) != results[i]) {
+      fprintf(stream, "\thx4_bloom_query and hx4_bloom_query_batch disagree on key %d\n", (int)i);
+      rc = 1;
+      goto out;
+    }
+    if(i < n && results[i] != 1) {
+      fprintf(stream, "\tinserted key %d not found\n", (int)i);
+      rc = 1;
+      goto out;
+    }
+    if(i >= n) {
+      positives += results[i];
+    }
+  }
+
+  //about 1% at 10 bits per key, 3% leaves room for the blocking
+  fprintf(stream, "\tfalse positive rate at 10 bits per key: %.2f%%\n", 100.0 * (double)positives / (double)n);
+  if(positives * 100 > n * 3) {
+    fprintf(stream, "\tfalse positive rate too high\n");
+    rc = 1;
+  }
+
+out:
+  free(keys);
+  free(key_sizes);
+  free(key_buffer);
+  free(results);
+  free(memory);
+  return rc;
+}
+
+#define HX4_NAIVE_BLOOM_K 7
+
+/* the textbook filter: one flat bit array and a rehash of the key for every probe */
+static void naive_bloom_hash(const void *key, size_t key_sz, const uint8_t (*cookies)[128/8], size_t num_bits, size_t *bit_indices) {
+  uint32_t hash;
+  int j;
+  for(j=0; j<HX4_NAIVE_BLOOM_K; j++) {
+    hx4_kdjbx33a_32_copt(key, key_sz, cookies[j], 128/8, &hash, sizeof(hash));
+    bit_indices[j] = (size_t)(((uint64_t)hash * (uint64_t)num_bits) >> 32);
+  }
+}
+
+static int naive_bloom_query(const uint8_t *bits, size_t num_bits, const void *key, size_t key_sz, const uint8_t (*cookies)[128/8]) {
+  size_t bit_indices[HX4_NAIVE_BLOOM_K];
+  int j;
+  naive_bloom_hash(key, key_sz, cookies, num_bits, bit_indices);
+  for(j=0; j<HX4_NAIVE_BLOOM_K; j++) {
+    if(!(bits[bit_indices[j] / 8] & (1 << (bit_indices[j] % 8)))) {
+      return 0;
+    }
+  }
+  return 1;
+}
+
+static int test_hx4_bloom_performance(FILE *stream, const void *in, size_t in_sz, const void *cookie, size_t cookie_sz) {
+  const size_t n = 4*1024*1024;
+  const size_t num_blocks = n * 10 / 512;
+  const size_t num_bits = num_blocks * 512;
+  uint8_t cookies[HX4_NAIVE_BLOOM_K][128/8];
+  size_t bit_indices[HX4_NAIVE_BLOOM_K];
+  uint64_t *key_words;
+  const void **keys;
+  size_t *key_sizes;
+  uint8_t *results;
+  uint8_t *naive_bits;
+  void *memory;
+  hx4_bloom bloom;
+  volatile size_t sink = 0;
+  hx_time start;
+  hx_time stop;
+  size_t i;
+  int j;
+  int rc = 0;
+
+  (void)in;
+  (void)in_sz;
+
+  //8 byte keys, the odd ones are inserted, every query hits a random block
+  key_words = malloc(n * sizeof(uint64_t));
+  keys = malloc(n * sizeof(void*));
+  key_sizes = malloc(n * sizeof(size_t));
+  results = malloc(n);
+  naive_bits = calloc(num_bits / 8, 1);
+  memory = malloc(HX4_BLOOM_MEMORY_SIZE(num_blocks));
+  if(!key_words || !keys || !key_sizes || !results || !naive_bits || !memory) {
+    fprintf(stream, "\tout of memory\n");
+    rc = 1;
+    goto out;
+  }
+  for(i=0; i<n; i++) {
+    key_words[i] = (uint64_t)i * 0x9e3779b97f4a7c15ULL;
+    keys[i] = &key_words[i];
+    key_sizes[i] = sizeof(uint64_t);
+  }
+  for(j=0; j<HX4_NAIVE_BLOOM_K; j++) {
+    memcpy(cookies[j], cookie, sizeof(cookies[j]));
+    cookies[j][0] ^= (uint8_t)(j + 1);
+  }
+
+  rc = hx4_bloom_init(&bloom, memory, HX4_BLOOM_MEMORY_SIZE(num_blocks), cookie, cookie_sz);
+  if(rc != HX4_ERR_SUCCESS) {
+    goto out;
+  }
+  for(i=1; i<n; i+=2) {
+    hx4_bloom_insert(&bloom, keys[i], key_sizes[i]);
+    naive_bloom_hash(keys[i], key_sizes[i], (const uint8_t (*)[128/8])cookies, num_bits, bit_indices);
+    for(j=0; j<HX4_NAIVE_BLOOM_K; j++) {
+      naive_bits[bit_indices[j] / 8] |= (uint8_t)(1 << (bit_indices[j] % 8));
+    }
+  }
+
+  fprintf(stream, "\t%d queries of 8 byte keys against a %d KiB filter\n", (int)n, (int)(num_bits / 8 / 1024));
+
+  start = hx_gettime();
+  for(i=0; i<n; i++) {
+    sink += naive_bloom_query(naive_bits, num_bits, keys[i], key_sizes[i], (const uint8_t (*)[128/8])cookies);
+  }
+  stop = hx_gettime();
+  fprintf(stream, "\t%-36s %8.2f Mqueries/s\n", "rehash per probe (k=7)", (double)n / (double)hx_timedelta_s(&start, &stop) / 1000000.0);
+
+  start = hx_gettime();
+  for(i=0; i<n; i++) {
+    sink += hx4_bloom_query(&bloom, keys[i], key_sizes[i]);
+  }
+  stop = hx_gettime();
+  fprintf(stream, "\t%-36s %8.2f Mqueries/s\n", "hx4_bloom_query", (double)n / (double)hx_timedelta_s(&start, &stop) / 1000000.0);
+
+  start = hx_gettime();
+  rc = hx4_bloom_query_batch(&bloom, keys, key_sizes, n, results);
+  stop = hx_gettime();
+  fprintf(stream, "\t%-36s %8.2f Mqueries/s\n", "hx4_bloom_query_batch", (double)n / (double)hx_timedelta_s(&start, &stop) / 1000000.0);
+
+out:
+  free(key_words);
+  free(keys);
+  free(key_sizes);
+  free(results);
+  free(naive_bits);
+  free(memory);
+  return rc;
+}
+
+static int test_hx4_hll_correctness(FILE *stream, const void *in, size_t in_sz, const void *cookie, size_t cookie_sz) {
+  const int precision = 12;
+  const size_t cardinalities[] = { 0, 10, 100, 1000, 10000, 100000, 1000000 };
+  const size_t max_n = 1000000;
+  uint8_t *memory[3];
+  uint64_t *keys;
+  hx4_hll hll[3];
+  double estimate[3];
+  double error;
+  size_t n;
+  size_t c;
+  size_t i;
+  int j;
+  int rc = 0;
+
+  (void)in;
+  (void)in_sz;
+
+  keys = malloc(max_n * sizeof(uint64_t));
+  for(j=0; j<3; j++) {
+    memory[j] = malloc(HX4_HLL_MEMORY_SIZE(HX4_HLL_MAX_PRECISION));
+  }
+  if(!keys || !memory[0] || !memory[1] || !memory[2]) {
+    fprintf(stream, "\tout of memory\n");
+    rc = 1;
+    goto out;
+  }
+  for(i=0; i<max_n; i++) {
+    keys[i] = (uint64_t)i * 0x9e3779b97f4a7c15ULL;
+  }
+
+  for(c=0; c<sizeof(cardinalities)/sizeof(cardinalities[0]); c++) {
+    n = cardinalities[c];
+    for(j=0; j<3; j++) {
+      rc = hx4_hll_init(&hll[j], precision, memory[j], HX4_HLL_MEMORY_SIZE(precision), cookie, cookie_sz);
+      if(rc != HX4_ERR_SUCCESS) {
+        goto out;
+      }
+    }
+
+    //0: all keys as a u64 batch, twice, 1: one by one as 8 byte keys,
+    //2: the first half as a u64 batch, merged with 1
+    rc += hx4_hll_add_u64_batch(&hll[0], keys, n);
+    rc += hx4_hll_add_u64_batch(&hll[0], keys, n);
+    for(i=0; i<n; i++) {
+      rc += hx4_hll_add(&hll[1], &keys[i], sizeof(uint64_t));
+    }
+    rc += hx4_hll_add_u64_batch(&hll[2], keys, n/2);
+    rc += hx4_hll_merge(&hll[2], &hll[1]);
+    for(j=0; j<3; j++) {
+      rc += hx4_hll_estimate(&hll[j], &estimate[j]);
+    }
+    if(rc != HX4_ERR_SUCCESS) {
+      goto out;
+    }
+
+    if(estimate[0] != estimate[1] || estimate[0] != estimate[2]) {
+      fprintf(stream, "\t%d keys: batch %.1f, single %.1f and merged %.1f estimates differ\n", (int)n, estimate[0], estimate[1], estimate[2]);
+      rc = 1;
+      goto out;
+    }
+    //the standard error is 1.04/sqrt(2^precision) = 1.6%, allow five of them
+    error = n == 0 ? estimate[0] : (estimate[0] - (double)n) / (double)n;
+    fprintf(stream, "\t%8d keys: estimate %10.1f, error %+.2f%% (%s)\n", (int)n, estimate[0], 100.0 * error, hll[0].dense ? "dense" : "sparse");
+    if(error > 0.08 || error < -0.08) {
+      fprintf(stream, "\testimate too far off\n");
+      rc = 1;
+      goto out;
+    }
+    //the sparse list counts over 2^25 registers, a few hundred keys hardly collide
+    if(!hll[0].dense && (estimate[0] - (double)n > 0.5 || estimate[0] - (double)n < -0.5)) {
+      fprintf(stream, "\tsparse estimate not exact\n");
+      rc = 1;
+      goto out;
+    }
+  }
+
+  //entries folded down from the sparse list must end up in the same registers
+  //as keys added to a dense sketch: 0 gets the big set, then the small one
+  //key by key, 1 merges a sparse sketch of the small set into the big one,
+  //2 starts sparse with the small set and merges the big one in. At the
+  //highest precision 1 in 2^(25-18) entries has no one bit below the dense index.
+  n = 20000;
+  for(j=0; j<3; j++) {
+    rc = hx4_hll_init(&hll[j], HX4_HLL_MAX_PRECISION, memory[j], HX4_HLL_MEMORY_SIZE(HX4_HLL_MAX_PRECISION), cookie, cookie_sz);
+    if(rc != HX4_ERR_SUCCESS) {
+      goto out;
+    }
+  }
+  rc += hx4_hll_add_u64_batch(&hll[0], keys + n, max_n - n);
+  for(i=0; i<n; i++) {
+    rc += hx4_hll_add(&hll[0], &keys[i], sizeof(uint64_t));
+  }
+  rc += hx4_hll_add_u64_batch(&hll[1], keys + n, max_n - n);
+  rc += hx4_hll_add_u64_batch(&hll[2], keys, n);
+  rc += hx4_hll_merge(&hll[1], &hll[2]);
+  rc += hx4_hll_merge(&hll[2], &hll[0]);
+  if(rc != HX4_ERR_SUCCESS) {
+    goto out;
+  }
+  if(!hll[0].dense || !hll[1].dense || !hll[2].dense) {
+    fprintf(stream, "\tsketches of %d keys not dense\n", (int)max_n);
+    rc = 1;
+    goto out;
+  }
+  if(memcmp(hll[0].registers, hll[1].registers, (size_t)1 << HX4_HLL_MAX_PRECISION) != 0
+    || memcmp(hll[0].registers, hll[2].registers, (size_t)1 << HX4_HLL_MAX_PRECISION) != 0) {
+    fprintf(stream, "\tfolded sparse entries differ from dense registers\n");
+    rc = 1;
+    goto out;
+  }
+
+out:
+  free(keys);
+  for(j=0; j<3; j++) {
+    free(memory[j]);
+  }
+  return rc;
+}
+
+static int test_hx4_cms_correctness(FILE *stream, const void *in, size_t in_sz, const void *cookie, size_t cookie_sz) {
+  const size_t width = 4096;
+  const int depth = 4;
+  const size_t num_keys = 20000;
+  uint32_t *memory[2];
+  uint64_t *keys;
+  uint32_t *counts;
+  uint64_t stream_length = 0;
+  uint64_t overestimate = 0;
+  hx4_cms cms[2];
+  uint32_t count;
+  uint32_t true_count;
+  size_t i;
+  uint32_t r;
+  int rc = 0;
+
+  (void)in;
+  (void)in_sz;
+
+  keys = malloc(num_keys * sizeof(uint64_t));
+  counts = malloc(num_keys * sizeof(uint32_t));
+  memory[0] = malloc(HX4_CMS_MEMORY_SIZE(width, depth));
+  memory[1] = malloc(HX4_CMS_MEMORY_SIZE(width, depth));
+  if(!keys || !counts || !memory[0] || !memory[1]) {
+    fprintf(stream, "\tout of memory\n");
+    rc = 1;
+    goto out;
+  }
+  for(i=0; i<num_keys; i++) {
+    keys[i] = (uint64_t)i * 0x9e3779b97f4a7c15ULL;
+  }
+  rc += hx4_cms_init(&cms[0], width, depth, memory[0], HX4_CMS_MEMORY_SIZE(width, depth), cookie, cookie_sz);
+  rc += hx4_cms_init(&cms[1], width, depth, memory[1], HX4_CMS_MEMORY_SIZE(width, depth), cookie, cookie_sz);
+  if(rc != HX4_ERR_SUCCESS) {
+    goto out;
+  }
+
+  //every key once into 0 through the batch, every 100th key another 99 times
+  //into 1 one by one, then 1 is merged into 0
+  rc += hx4_cms_add_u64_batch(&cms[0], keys, num_keys);
+  for(i=0; i<num_keys; i+=100) {
+    for(r=0; r<99; r++) {
+      rc += hx4_cms_add(&cms[1], &keys[i], sizeof(uint64_t), 1);
+    }
+  }
+  rc += hx4_cms_merge(&cms[0], &cms[1]);
+  rc += hx4_cms_query_u64_batch(&cms[0], keys, num_keys, counts);
+  if(rc != HX4_ERR_SUCCESS) {
+    goto out;
+  }
+
+  for(i=0; i<num_keys; i++) {
+    true_count = i % 100 == 0 ? 100 : 1;
+    stream_length += true_count;
+  }
+  for(i=0; i<num_keys; i++) {
+    true_count = i % 100 == 0 ? 100 : 1;
+    rc = hx4_cms_query(&cms[0], &keys[i], sizeof(uint64_t), &count);
+    if(rc != HX4_ERR_SUCCESS) {
+      goto out;
+    }
+    if(count != counts[i]) {
+      fprintf(stream, "\thx4_cms_query and hx4_cms_query_u64_batch disagree on key %d\n", (int)i);
+      rc = 1;
+      goto out;
+    }
+    if(count < true_count) {
+      fprintf(stream, "\tkey %d underestimated: %d < %d\n", (int)i, (int)count, (int)true_count);
+      rc = 1;
+      goto out;
+    }
+    overestimate += count - true_count;
+  }
+
+  //the expected overestimate of one row is N/width, the minimum of the rows is below that
+  fprintf(stream, "\tmean overestimate %.3f, N/width %.3f\n", (double)overestimate / (double)num_keys, (double)stream_length / (double)width);
+  if((double)overestimate / (double)num_keys > (double)stream_length / (double)width) {
+    fprintf(stream, "\toverestimate too large\n");
+    rc = 1;
+  }
+
+out:
+  free(keys);
+  free(counts);
+  free(memory[0]);
+  free(memory[1]);
+  return rc;
+}
+
+typedef int (*minhash_function_t)(const hx4_minhash*, const void*, size_t, uint32_t*);
+typedef struct {
+  minhash_function_t function;
+  const char *name;
+} minhash_function_item_t;
+#define MINHASH_FUNCTION_ITEM(function_name) { function_name , #function_name } ,
+
+static const minhash_function_item_t minhash_functions[] = {
+  MINHASH_FUNCTION_ITEM(hx4_minhash_signature_ref)
+#if HX4_HAS_SSE2
+  MINHASH_FUNCTION_ITEM(hx4_minhash_signature_sse2)
+#endif
+#if HX4_HAS_SSE41
+  MINHASH_FUNCTION_ITEM(hx4_minhash_signature_sse41)
+#endif
+#if HX4_HAS_AVX2
+  MINHASH_FUNCTION_ITEM(hx4_minhash_signature_avx2)
+#endif
+  MINHASH_FUNCTION_ITEM(hx4_minhash_signature)
+};
+
+static void init_minhash_doc(uint8_t *doc, size_t doc_sz, uint64_t seed) {
+  size_t i;
+  for(i=0; i<doc_sz; i++) {
+    seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+    doc[i] = (uint8_t)(seed >> 56);
+  }
+}
+
+static int compare_u64(const void *a, const void *b) {
+  uint64_t ua = *(const uint64_t*)a;
+  uint64_t ub = *(const uint64_t*)b;
+  return ua < ub ? -1 : (ua > ub ? 1 : 0);
+}
+
+//the sorted distinct shingles of doc, returns their number
+static size_t minhash_shingle_set(const uint8_t *doc, size_t doc_sz, size_t shingle_sz, uint64_t *set) {
+  size_t n = doc_sz >= shingle_sz ? doc_sz - shingle_sz + 1 : 1;
+  size_t distinct = 0;
+  size_t i;
+  size_t j;
+
+  for(i=0; i<n; i++) {
+    set[i] = 0;
+    for(j=0; j<shingle_sz && i+j < doc_sz; j++) {
+      set[i] |= (uint64_t)doc[i+j] << (8*j);
+    }
+  }
+  qsort(set, n, sizeof(uint64_t), compare_u64);
+  for(i=0; i<n; i++) {
+    if(i == 0 || set[i] != set[distinct-1]) {
+      set[distinct++] = set[i];
+    }
+  }
+  return distinct;
+}
+
+static int test_hx4_minhash_correctness(FILE *stream, const void *in, size_t in_sz, const void *cookie, size_t cookie_sz) {
+  static const size_t doc_sizes[] = { 0, 1, 2, 7, 8, 9, 255, 256, 257, 300, 4096 };
+  static const size_t hash_counts[] = { 16, 64, 256 };
+  const size_t num_functions = sizeof(minhash_functions)/sizeof(minhash_functions[0]);
+  const size_t doc_sz = 4096;
+  const size_t shingle_sz = 5;
+  const size_t num_hashes = 256;
+  uint8_t *doc[2];
+  uint64_t *set[2];
+  uint32_t expected[HX4_MINHASH_MAX_HASHES];
+  uint32_t signature[2][HX4_MINHASH_MAX_HASHES];
+  hx4_minhash minhash;
+  size_t distinct[2];
+  size_t intersection = 0;
+  double jaccard;
+  double similarity;
+  size_t s, d, h, f, i, j;
+  int rc = 0;
+
+  (void)in;
+  (void)in_sz;
+
+  doc[0] = malloc(doc_sz);
+  doc[1] = malloc(doc_sz);
+  set[0] = malloc(doc_sz * sizeof(uint64_t));
+  set[1] = malloc(doc_sz * sizeof(uint64_t));
+  if(!doc[0] || !doc[1] || !set[0] || !set[1]) {
+    fprintf(stream, "\tout of memory\n");
+    rc = 1;
+    goto out;
+  }
+  init_minhash_doc(doc[0], doc_sz, 1);
+
+  //every variant against the reference, across block boundaries and shorter than a shingle
+  for(s=1; s<=HX4_MINHASH_MAX_SHINGLE_SIZE; s++) {
+    for(h=0; h<sizeof(hash_counts)/sizeof(hash_counts[0]); h++) {
+      rc = hx4_minhash_init(&minhash, s, hash_counts[h], cookie, cookie_sz);
+      if(rc != HX4_ERR_SUCCESS) {
+        goto out;
+      }
+      for(d=0; d<sizeof(doc_sizes)/sizeof(doc_sizes[0]); d++) {
+        rc = hx4_minhash_signature_ref(&minhash, doc[0], doc_sizes[d], expected);
+        if(rc != HX4_ERR_SUCCESS) {
+          goto out;
+        }
+        for(f=0; f<num_functions; f++) {
+          memset(signature[0], 0xee, sizeof(signature[0]));
+          rc = minhash_functions[f].function(&minhash, doc[0], doc_sizes[d], signature[0]);
+          if(rc != HX4_ERR_SUCCESS) {
+            goto out;
+          }
+          if(memcmp(signature[0], expected, hash_counts[h] * sizeof(uint32_t)) != 0) {
+            fprintf(stream, "\t%s differs from reference, shingle %d, hashes %d, doc %d\n",
+                minhash_functions[f].name, (int)s, (int)hash_counts[h], (int)doc_sizes[d]);
+            rc = 1;
+            goto out;
+          }
+        }
+      }
+    }
+  }
+
+  //a near duplicate with every 64th byte changed, the estimate against the exact Jaccard index
+  memcpy(doc[1], doc[0], doc_sz);
+  for(i=0; i<doc_sz; i+=64) {
+    doc[1][i] ^= 0x5a;
+  }
+  distinct[0] = minhash_shingle_set(doc[0], doc_sz, shingle_sz, set[0]);
+  distinct[1] = minhash_shingle_set(doc[1], doc_sz, shingle_sz, set[1]);
+  for(i=0, j=0; i<distinct[0] && j<distinct[1]; ) {
+    if(set[0][i] == set[1][j]) {
+      intersection++;
+      i++;
+      j++;
+    } else if(set[0][i] < set[1][j]) {
+      i++;
+    } else {
+      j++;
+    }
+  }
+  jaccard = (double)intersection / (double)(distinct[0] + distinct[1] - intersection);
+
+  rc += hx4_minhash_init(&minhash, shingle_sz, num_hashes, cookie, cookie_sz);
+  rc += hx4_minhash_signature(&minhash, doc[0], doc_sz, signature[0]);
+  rc += hx4_minhash_signature(&minhash, doc[1], doc_sz, signature[1]);
+  rc += hx4_minhash_similarity(signature[0], signature[1], num_hashes, &similarity);
+  if(rc != HX4_ERR_SUCCESS) {
+    goto out;
+  }
+  //the standard error with 256 hashes is below 0.032
+  fprintf(stream, "\tjaccard %.3f, minhash estimate %.3f\n", jaccard, similarity);
+  if(similarity < jaccard - 0.12 || similarity > jaccard + 0.12) {
+    fprintf(stream, "\testimate too far off\n");
+    rc = 1;
+    goto out;
+  }
+
+  //two unrelated documents
+  init_minhash_doc(doc[1], doc_sz, 2);
+  rc += hx4_minhash_signature(&minhash, doc[1], doc_sz, signature[1]);
+  rc += hx4_minhash_similarity(signature[0], signature[1], num_hashes, &similarity);
+  if(rc != HX4_ERR_SUCCESS) {
+    goto out;
+  }
+  fprintf(stream, "\tunrelated documents, minhash estimate %.3f\n", similarity);
+  if(similarity > 0.05) {
+    fprintf(stream, "\testimate too high\n");
+    rc = 1;
+  }
+
+out:
+  free(doc[0]);
+  free(doc[1]);
+  free(set[0]);
+  free(set[1]);
+  return rc;
+}
+
+static int test_hx4_phf_correctness(FILE *stream, const void *in, size_t in_sz, const void *cookie, size_t cookie_sz) {
+  static const size_t set_sizes[] = { 0, 1, 2, 3, 17, 1000, 50000 };
+  const size_t max_n = 50000;
+  const void **keys;
+  size_t *key_sizes;
+  uint8_t *key_buffer = NULL;
+  uint32_t *displacements;
+  uint32_t *slots;
+  uint32_t *key_offsets;
+  uint8_t *seen;
+  char *key_data;
+  void *memory;
+  uint8_t phf_cookie[128/8];
+  hx4_phf phf;
+  size_t s, n, i;
+  int attempt;
+  int rc = 0;
+
+  (void)in;
+  (void)in_sz;
+  (void)cookie_sz;
+
+  //twice as many keys, the second half is never in the set
+  keys = malloc(2*max_n * sizeof(void*));
+  key_sizes = malloc(2*max_n * sizeof(size_t));
+  displacements = malloc(HX4_PHF_NUM_BUCKETS(max_n) * sizeof(uint32_t));
+  slots = malloc(max_n * sizeof(uint32_t));
+  key_offsets = malloc((max_n + 1) * sizeof(uint32_t));
+  seen = malloc(max_n);
+  key_data = malloc(max_n * 48);
+  memory = malloc(HX4_PHF_BUILD_MEMORY_SIZE(max_n));
+  if(keys && key_sizes) {
+    key_buffer = init_varlen_keys(2*max_n, keys, key_sizes);
+  }
+  if(!keys || !key_sizes || !key_buffer || !displacements || !slots || !key_offsets || !seen || !key_data || !memory) {
+    fprintf(stream, "\tout of memory\n");
+    rc = 1;
+    goto out;
+  }
+
+  for(s=0; s<sizeof(set_sizes)/sizeof(set_sizes[0]); s++) {
+    n = set_sizes[s];
+    memcpy(phf_cookie, cookie, sizeof(phf_cookie));
+    rc = HX4_ERR_SEARCH_FAILED;
+    for(attempt=0; attempt<16 && rc == HX4_ERR_SEARCH_FAILED; attempt++) {
+      phf_cookie[0] = (uint8_t)attempt;
+      rc = hx4_phf_build(keys, key_sizes, n, phf_cookie, sizeof(phf_cookie), displacements, slots, memory, HX4_PHF_BUILD_MEMORY_SIZE(n));
+    }
+    if(rc != HX4_ERR_SUCCESS) {
+      fprintf(stream, "\tno table for %d keys: %d\n", (int)n, rc);
+      goto out;
+    }
+
+    //the slots are a permutation, lay the keys out in slot order
+    memset(seen, 0, n);
+    for(i=0; i<n; i++) {
+      if(slots[i] >= n || seen[slots[i]]) {
+        fprintf(stream, "\t%d keys: slot %d of key %d is out of range or taken twice\n", (int)n, (int)slots[i], (int)i);
+        rc = 1;
+        goto out;
+      }
+      seen[slots[i]] = 1;
+    }
+    key_offsets[0] = 0;
+    for(i=0; i<n; i++) {
+      key_offsets[slots[i] + 1] = (uint32_t)key_sizes[i];
+    }
+    for(i=1; i<=n; i++) {
+      key_offsets[i] += key_offsets[i-1];
+    }
+    for(i=0; i<n; i++) {
+      memcpy(key_data + key_offsets[slots[i]], keys[i], key_sizes[i]);
+    }
+    memcpy(phf.cookie, phf_cookie, sizeof(phf.cookie));
+    phf.num_keys = (uint32_t)n;
+    phf.num_buckets = (uint32_t)HX4_PHF_NUM_BUCKETS(n);
+    phf.displacements = displacements;
+    phf.key_offsets = key_offsets;
+    phf.key_data = key_data;
+
+    for(i=0; i<n; i++) {
+      rc = hx4_phf_lookup(&phf, keys[i], key_sizes[i]);
+      if(rc != (int)slots[i]) {
+        fprintf(stream, "\t%d keys: key %d found in %d instead of %d\n", (int)n, (int)i, rc, (int)slots[i]);
+        rc = 1;
+        goto out;
+      }
+      //a prefix of a key hashes differently or fails the compare
+      rc = hx4_phf_lookup(&phf, keys[i], key_sizes[i] - 1);
+      if(rc != HX4_ERR_NOT_FOUND) {
+        fprintf(stream, "\t%d keys: prefix of key %d found in %d\n", (int)n, (int)i, rc);
+        rc = 1;
+        goto out;
+      }
+    }
+    for(i=max_n; i<2*max_n; i++) {
+      rc = hx4_phf_lookup(&phf, keys[i], key_sizes[i]);
+      if(rc != HX4_ERR_NOT_FOUND) {
+        fprintf(stream, "\t%d keys: key %d is not in the set but found in %d\n", (int)n, (int)i, rc);
+        rc = 1;
+        goto out;
+      }
+    }
+    rc = 0;
+  }
+
+  //a duplicate key fails for every cookie
+  keys[1] = keys[0];
+  key_sizes[1] = key_sizes[0];
+  rc = hx4_phf_build(keys, key_sizes, 2, cookie, cookie_sz, displacements, slots, memory, HX4_PHF_BUILD_MEMORY_SIZE(2));
+  if(rc != HX4_ERR_PARAM_INVALID) {
+    fprintf(stream, "\tduplicate keys not detected: %d\n", rc);
+    rc = 1;
+    goto out;
+  }
+  rc = 0;
+
+out:
+  free(keys);
+  free(key_sizes);
+  free(key_buffer);
+  free(displacements);
+  free(slots);
+  free(key_offsets);
+  free(seen);
+  free(key_data);
+  free(memory);
+  return rc;
+}
+
+#define HX4_INTERN_TEST_READERS 3
+
+typedef struct {
+  const hx4_intern *intern;
+  const void **keys;
+  size_t *key_sizes;
+  size_t n;
+  volatile int *writer_done;
+  size_t passes;
+  int rc;
+} intern_reader_t;
+
+/* finds all keys while the writer interns them, then once more after it is done and all have to be there */
+HX_THREAD_FUNCTION(intern_reader_thread) {
+  intern_reader_t *t = arg;
+  uint32_t handle;
+  int done;
+  size_t i;
+  int rc;
+
+  do {
+    done = *t->writer_done;
+    for(i=0; i<t->n; i++) {
+      rc = hx4_intern_find(t->intern, t->keys[i], t->key_sizes[i], &handle);
+      if(rc == HX4_ERR_NOT_FOUND && !done) {
+        continue;
+      }
+      if(rc != HX4_ERR_SUCCESS || hx4_intern_len(t->intern, handle) != t->key_sizes[i] || memcmp(hx4_intern_data(t->intern, handle), t->keys[i], t->key_sizes[i]) != 0) {
+        t->rc = 1;
+        HX_THREAD_RETURN;
+      }
+    }
+    t->passes++;
+  } while(!done);
+  HX_THREAD_RETURN;
+}
+
+static int test_hx4_intern_correctness(FILE *stream, const void *in, size_t in_sz, const void *cookie, size_t cookie_sz) {
+  const size_t n = 20000;
+  const size_t num_slots = 32768;
+  const size_t arena_sz = n * HX4_INTERN_ENTRY_SIZE(40);
+  const void **keys;
+  size_t *key_sizes;
+  uint8_t *key_buffer = NULL;
+  uint32_t *handles;
+  uint32_t *batch_handles;
+  uint8_t *seen;
+  void *memory;
+  uint8_t small_memory[HX4_INTERN_MEMORY_SIZE(8, 16)];
+  hx4_intern intern;
+  const void *repeated_keys[64];
+  size_t repeated_sizes[64];
+  intern_reader_t readers[HX4_INTERN_TEST_READERS];
+  hx_thread threads[HX4_INTERN_TEST_READERS];
+  volatile int writer_done = 0;
+  uint8_t hash[64/8];
+  uint32_t handle;
+  size_t i;
+  int rc = 0;
+
+  (void)in;
+  (void)in_sz;
+
+  //twice as many keys, the second half is never interned
+  keys = malloc(2*n * sizeof(void*));
+  key_sizes = malloc(2*n * sizeof(size_t));
+  handles = malloc(2*n * sizeof(uint32_t));
+  batch_handles = malloc(2*n * sizeof(uint32_t));
+  seen = calloc(arena_sz / 8 + 1, 1);
+  memory = malloc(HX4_INTERN_MEMORY_SIZE(num_slots, arena_sz));
+  if(keys && key_sizes) {
+    key_buffer = init_varlen_keys(2*n, keys, key_sizes);
+  }
+  if(!keys || !key_sizes || !key_buffer || !handles || !batch_handles || !seen || !memory) {
+    fprintf(stream, "\tout of memory\n");
+    rc = 1;
+    goto out;
+  }
+
+  rc = hx4_intern_init(&intern, memory, HX4_INTERN_MEMORY_SIZE(num_slots, arena_sz), num_slots, cookie, cookie_sz);
+  if(rc != HX4_ERR_SUCCESS) {
+    goto out;
+  }
+
+  //half of the set one by one while the readers look for all of it, then all of it as a batch
+  for(i=0; i<HX4_INTERN_TEST_READERS; i++) {
+    readers[i].intern = &intern;
+    readers[i].keys = keys;
+    readers[i].key_sizes = key_sizes;
+    readers[i].n = n/2;
+    readers[i].writer_done = &writer_done;
+    readers[i].passes = 0;
+    readers[i].rc = 0;
+    hx_thread_start(&threads[i], intern_reader_thread, &readers[i]);
+  }
+  for(i=0; i<n/2 && rc == 0; i++) {
+    rc = hx4_intern_add(&intern, keys[i], key_sizes[i], &handles[i]);
+  }
+  writer_done = 1;
+  for(i=0; i<HX4_INTERN_TEST_READERS; i++) {
+    hx_thread_join(threads[i]);
+    if(readers[i].rc != 0) {
+      fprintf(stream, "\treader %d found a wrong string\n", (int)i);
+      rc = 1;
+    }
+  }
+  if(rc != 0) {
+    goto out;
+  }
+  for(i=1; i<HX4_INTERN_TEST_READERS; i++) {
+    readers[0].passes += readers[i].passes;
+  }
+  fprintf(stream, "\t%d readers, %d passes while interning\n", HX4_INTERN_TEST_READERS, (int)readers[0].passes);
+
+  //8 new strings repeating within one batch get one handle each
+  for(i=0; i<64; i++) {
+    repeated_keys[i] = keys[n/2 + i % 8];
+    repeated_sizes[i] = key_sizes[n/2 + i % 8];
+  }
+  rc = hx4_intern_add_batch(&intern, repeated_keys, repeated_sizes, 64, batch_handles);
+  if(rc != HX4_ERR_SUCCESS) {
+    goto out;
+  }
+  if(intern.count != n/2 + 8 || batch_handles[0] != batch_handles[8] || batch_handles[7] != batch_handles[63]) {
+    fprintf(stream, "\trepeated strings in a batch got different handles\n");
+    rc = 1;
+    goto out;
+  }
+
+  rc = hx4_intern_add_batch(&intern, keys, key_sizes, n, batch_handles);
+  if(rc != HX4_ERR_SUCCESS) {
+    goto out;
+  }
+  if(intern.count != n) {
+    fprintf(stream, "\t%d strings interned instead of %d\n", (int)intern.count, (int)n);
+    rc = 1;
+    goto out;
+  }
+
+  rc = hx4_intern_find_batch(&intern, keys, key_sizes, 2*n, handles);
+  if(rc != HX4_ERR_SUCCESS) {
+    goto out;
+  }
+  for(i=0; i<2*n; i++) {
+    rc = hx4_intern_find(&intern, keys[i], key_sizes[i], &handle);
+    if(i >= n) {
+      if(rc != HX4_ERR_NOT_FOUND || handles[i] != 0) {
+        fprintf(stream, "\tkey %d found but never interned\n", (int)i);
+        rc = 1;
+        goto out;
+      }
+      continue;
+    }
+    if(rc != HX4_ERR_SUCCESS || handle != handles[i] || handle != batch_handles[i]) {
+      fprintf(stream, "\tkey %d has different handles\n", (int)i);
+      rc = 1;
+      goto out;
+    }
+    if(handle == 0 || handle > arena_sz / 8 || seen[handle]) {
+      fprintf(stream, "\tkey %d has a bad or duplicate handle %u\n", (int)i, (unsigned)handle);
+      rc = 1;
+      goto out;
+    }
+    seen[handle] = 1;
+    hx4_siphash13_64_ref(keys[i], key_sizes[i], cookie, cookie_sz, hash, sizeof(hash));
+    if(hx4_intern_len(&intern, handle) != key_sizes[i] || memcmp(hx4_intern_data(&intern, handle), keys[i], key_sizes[i]) != 0
+       || hx4_intern_data(&intern, handle)[key_sizes[i]] != 0
+       || hx4_intern_hash(&intern, handle) != ((uint32_t)hash[0] | ((uint32_t)hash[1] << 8) | ((uint32_t)hash[2] << 16) | ((uint32_t)hash[3] << 24))) {
+      fprintf(stream, "\tkey %d: string or hash of the handle wrong\n", (int)i);
+      rc = 1;
+      goto out;
+    }
+  }
+  rc = 0;
+
+  //the empty string, a full arena and a full table
+  if(hx4_intern_add(&intern, "", 0, &handle) != HX4_ERR_SUCCESS || hx4_intern_len(&intern, handle) != 0
+     || hx4_intern_add(&intern, "", 0, &batch_handles[0]) != HX4_ERR_SUCCESS || batch_handles[0] != handle
+     || hx4_intern_add(&intern, NULL, 0, &handle) != HX4_ERR_PARAM_INVALID) {
+    fprintf(stream, "\tempty string not interned\n");
+    rc = 1;
+    goto out;
+  }
+  rc = hx4_intern_init(&intern, small_memory, sizeof(small_memory), 8, cookie, cookie_sz);
+  if(rc != HX4_ERR_SUCCESS) {
+    goto out;
+  }
+  if(hx4_intern_add(&intern, keys[0], 7, &handle) != HX4_ERR_SUCCESS || hx4_intern_add(&intern, keys[1], 7, &handle) != HX4_ERR_BUFFER_TOO_SMALL) {
+    fprintf(stream, "\tfull arena not detected\n");
+    rc = 1;
+    goto out;
+  }
+  rc = hx4_intern_init(&intern, memory, HX4_INTERN_MEMORY_SIZE(8, arena_sz), 8, cookie, cookie_sz);
+  if(rc != HX4_ERR_SUCCESS) {
+    goto out;
+  }
+  for(i=0; i<HX4_INTERN_MAX_STRINGS(8) && rc == HX4_ERR_SUCCESS; i++) {
+    rc = hx4_intern_add(&intern, keys[i], key_sizes[i], &handle);
+  }
+  if(rc != HX4_ERR_SUCCESS || hx4_intern_add(&intern, keys[i], key_sizes[i], &handle) != HX4_ERR_BUFFER_TOO_SMALL
+     || hx4_intern_find(&intern, keys[0], key_sizes[0], &handle) != HX4_ERR_SUCCESS) {
+    fprintf(stream, "\tfull table not detected\n");
+    rc = 1;
+    goto out;
+  }
+  rc = 0;
+  if(hx4_intern_init(&intern, memory, HX4_INTERN_MEMORY_SIZE(num_slots, arena_sz), 6, cookie, cookie_sz) != HX4_ERR_PARAM_INVALID
+     || hx4_intern_init(&intern, memory, HX4_INTERN_MEMORY_SIZE(num_slots, arena_sz), num_slots, cookie, 8) != HX4_ERR_COOKIE_TOO_SMALL
+     || hx4_intern_init(&intern, memory, num_slots * 8 - 1, num_slots, cookie, cookie_sz) != HX4_ERR_BUFFER_TOO_SMALL) {
+    fprintf(stream, "\thx4_intern_init accepts bad parameters\n");
+    rc = 1;
+  }
+
+out:
+  free(keys);
+  free(key_sizes);
+  free(key_buffer);
+  free(handles);
+  free(batch_handles);
+  free(seen);
+  free(memory);
+  return rc;
+}
+
+/* steps through the job with the byte and time limits, moving it by 8 bytes between the steps */
+static int run_job(hx4_job *job, int algorithm, const void *in, size_t in_sz, const void *cookie, size_t cookie_sz, size_t max_bytes, uint32_t max_us, uint8_t *out, size_t *steps) {
+  //two places that differ by 8 modulo 16
+  const size_t place_b = (sizeof(hx4_job)/16 + 1) * 16 + 8;
+  uint64_t moved[2 * (sizeof(hx4_job)/16 + 2) * 2];
+  hx4_job *current = job;
+  int rc;
+
+  *steps = 0;
+  rc = hx4_job_init(current, algorithm, in, in_sz, cookie, cookie_sz);
+  while(rc == HX4_ERR_SUCCESS || rc == HX4_JOB_PENDING) {
+    rc = hx4_job_step(current, max_bytes, max_us);
+    (*steps)++;
+    if(rc != HX4_JOB_PENDING) {
+      break;
+    }
+    if(hx4_job_final(current, out, 256/8) != HX4_ERR_PARAM_INVALID) {
+      return 1;
+    }
+    memcpy((uint8_t*)moved + place_b * (*steps % 2), current, sizeof(hx4_job));
+    current = (hx4_job*)((uint8_t*)moved + place_b * (*steps % 2));
+  }
+  if(rc != HX4_ERR_SUCCESS) {
+    return rc;
+  }
+  return hx4_job_final(current, out, 256/8);
+}
+
+static int test_hx4_job_correctness(FILE *stream, const void *in, size_t in_sz, const void *cookie, size_t cookie_sz) {
+  static const size_t sizes[] = { 0, 1, 15, 16, 17, 1000, HX4_JOB_CHUNK_SIZE, HX4_JOB_CHUNK_SIZE + 1, 100003 };
+  static const size_t byte_limits[] = { 1, 7, 4096 + 3, 0 };
+  hx4_dispatch_table ref_table;
+  uint8_t hash_output[256/8];
+  uint8_t hash_output_ref[256/8];
+  hx4_job job;
+  size_t steps;
+  size_t i;
+  size_t j;
+  int algorithm;
+  int rc;
+
+  if(in_sz < 100003 + 1) {
+    fprintf(stream, "\ttest input too small\n");
+    return 1;
+  }
+  hx4_dispatch_init(&ref_table);
+  memset(ref_table.kernel, 0, sizeof(ref_table.kernel));
+
+  for(algorithm=HX4_ALG_DJBX33A_32; algorithm<=HX4_ALG_X4HALFSIPHASH13_128; algorithm++) {
+    for(i=0; i<sizeof(sizes)/sizeof(sizes[0]); i++) {
+      memset(hash_output_ref, 0, sizeof(hash_output_ref));
+      rc = hx4_dispatch_hash(&ref_table, algorithm, (const uint8_t*)in + 1, sizes[i], cookie, cookie_sz, hash_output_ref, sizeof(hash_output_ref));
+      if(rc != HX4_ERR_SUCCESS) {
+        return rc;
+      }
+      //byte limits, then a time limit of 1us, which hashes one chunk per step
+      for(j=0; j<=sizeof(byte_limits)/sizeof(byte_limits[0]); j++) {
+        if(j < sizeof(byte_limits)/sizeof(byte_limits[0]) && byte_limits[j] == 1 && sizes[i] > 1000) {
+          continue;
+        }
+        memset(hash_output, 0, sizeof(hash_output));
+        rc = run_job(&job, algorithm, (const uint8_t*)in + 1, sizes[i], cookie, cookie_sz,
+          j < sizeof(byte_limits)/sizeof(byte_limits[0]) ? byte_limits[j] : 0,
+          j < sizeof(byte_limits)/sizeof(byte_limits[0]) ? 0 : 1,
+          hash_output, &steps);
+        if(rc != HX4_ERR_SUCCESS || memcmp(hash_output, hash_output_ref, sizeof(hash_output)) != 0) {
+          fprintf(stream, "\t%s job over %d bytes in %d steps doesn't match the one shot hash (%d)\n",
+            hx4_dispatch_algorithm_name(algorithm), (int)sizes[i], (int)steps, rc);
+          return 1;
+        }
+      }
+    }
+  }
+
+  if(hx4_job_init(&job, HX4_ALG_CRC32C_32, in, 16, cookie, cookie_sz) != HX4_ERR_PARAM_INVALID
+     || hx4_job_init(&job, HX4_ALG_SIPHASH13_64, in, 16, cookie, 8) != HX4_ERR_COOKIE_TOO_SMALL
+     || hx4_job_init(&job, HX4_ALG_SIPHASH13_64, in, 16, cookie, cookie_sz) != HX4_ERR_SUCCESS
+     || hx4_job_step(&job, 0, 0) != HX4_ERR_SUCCESS
+     || hx4_job_final(&job, hash_output, 7) != HX4_ERR_BUFFER_TOO_SMALL) {
+    fprintf(stream, "\thx4_job accepts bad parameters\n");
+    return 1;
+  }
+  return 0;
+}
+
+#define HX4_JOB_TEST_MAX_MESSAGES (1024*1024)
+
+static int compare_double(const void *a, const void *b) {
+  const double x = *(const double*)a;
+  const double y = *(const double*)b;
+  return x < y ? -1 : x > y ? 1 : 0;
+}
+
+/*
+ * A single threaded event loop: a 64 byte message arrives every 20us and is
+ * hashed in the next iteration, which also runs one step of the job over
+ * the blob. Without limits the step hashes all of it like the one shot
+ * function. Writes the latencies of the messages from arrival to their
+ * hash, returns how many there were.
+ */
+static size_t job_event_loop(const void *blob, size_t blob_sz, const void *cookie, size_t cookie_sz, size_t max_bytes, uint32_t max_us, double *latencies, double *blob_s) {
+  const double interval_us = 20.0;
+  uint8_t hash_output[128/8];
+  uint64_t message[8];
+  double next_arrival_us = 0.0;
+  double now_us;
+  size_t num_messages = 0;
+  int blob_done = 0;
+  hx4_job job;
+  hx_time start;
+  hx_time now;
+
+  memset(message, 0, sizeof(message));
+  hx4_job_init(&job, HX4_ALG_X4DJBX33A_128, blob, blob_sz, cookie, cookie_sz);
+  start = hx_gettime();
+  do {
+    now = hx_gettime();
+    now_us = hx_timedelta_us(&start, &now);
+    while(next_arrival_us <= now_us && num_messages < HX4_JOB_TEST_MAX_MESSAGES) {
+      message[0] = num_messages;
+      hx4_siphash13_64_copt(message, sizeof(message), cookie, cookie_sz, hash_output, sizeof(hash_output));
+      now = hx_gettime();
+      latencies[num_messages++] = hx_timedelta_us(&start, &now) - next_arrival_us;
+      next_arrival_us += interval_us;
+    }
+    if(blob_done) {
+      break;
+    }
+    blob_done = hx4_job_step(&job, max_bytes, max_us) == HX4_ERR_SUCCESS;
+    if(blob_done) {
+      now = hx_gettime();
+      *blob_s = hx_timedelta_us(&start, &now) / 1000000.0;
+    }
+  } while(1);
+
+  return num_messages;
+}
+
+static int test_hx4_job_latency_performance(FILE *stream, const void *in, size_t in_sz, const void *cookie, size_t cookie_sz) {
+  static const struct {
+    const char *name;
+    size_t max_bytes;
+    uint32_t max_us;
+  } modes[] = {
+    { "one step", 0, 0 },
+    { "1 MiB steps", 1024*1024, 0 },
+    { "64 KiB steps", 64*1024, 0 },
+    { "1000us steps", 0, 1000 },
+    { "100us steps", 0, 100 },
+  };
+  double *latencies;
+  double blob_s = 0;
+  size_t num_messages;
+  size_t i;
+
+  latencies = malloc(HX4_JOB_TEST_MAX_MESSAGES * sizeof(double));
+  if(!latencies) {
+    fprintf(stream, "\tout of memory\n");
+    return 1;
+  }
+
+  fprintf(stream, "\tx4djbx33a_128 over %d MiB, a 64 byte message every 20us, message latency in us\n", (int)(in_sz / 1024 / 1024));
+  fprintf(stream, "\t%-20s %10s %10s %10s %10s %10s\n", "", "MiB/s", "p50", "p99", "p99.9", "max");
+  for(i=0; i<sizeof(modes)/sizeof(modes[0]); i++) {
+    num_messages = job_event_loop(in, in_sz, cookie, cookie_sz, modes[i].max_bytes, modes[i].max_us, latencies, &blob_s);
+    qsort(latencies, num_messages, sizeof(double), compare_double);
+    fprintf(stream, "\t%-20s %10.0f %10.1f %10.1f %10.1f %10.1f\n", modes[i].name,
+      (double)in_sz / 1024.0 / 1024.0 / blob_s,
+      latencies[num_messages / 2],
+      latencies[num_messages * 99 / 100],
+      latencies[num_messages * 999 / 1000],
+      latencies[num_messages - 1]);
+  }
+
+  free(latencies);
+  return 0;
+}
+
+typedef int (*hash_function_v_t)(const hx4_iovec *, size_t, const void *, size_t, void *, size_t);
+typedef struct {
+  hash_function_t function;
+  hash_function_v_t function_v;
+  const char *name;
+  size_t output_size;
+} hash_function_v_item_t;
+
+#define HASH_FUNCTION_V_ITEM(function_name, output_bits) { function_name , function_name##_v , #function_name "_v" , (output_bits)/8 } ,
+
+static const hash_function_v_item_t hash_functions_v[] = {
+  HASH_FUNCTION_V_ITEM(hx4_djbx33a_32_ref, 32)
+  HASH_FUNCTION_V_ITEM(hx4_djbx33a_32_copt, 32)
+  HASH_FUNCTION_V_ITEM(hx4_x4djbx33a_128_ref, 128)
+  HASH_FUNCTION_V_ITEM(hx4_x4djbx33a_128_copt, 128)
+#if HX4_HAS_MMX
+  HASH_FUNCTION_V_ITEM(hx4_x4djbx33a_128_mmx, 128)
+#endif
+#if HX4_HAS_SSE2
+  HASH_FUNCTION_V_ITEM(hx4_x4djbx33a_128_sse2, 128)
+  HASH_FUNCTION_V_ITEM(hx4_x4djbx33a_128_sse2rle, 128)
+#endif
+#if HX4_HAS_SSSE3
+  HASH_FUNCTION_V_ITEM(hx4_x4djbx33a_128_ssse3, 128)
+#endif
+  HASH_FUNCTION_V_ITEM(hx4_kdjbx33a_32_ref, 32)
+  HASH_FUNCTION_V_ITEM(hx4_kdjbx33a_32_copt, 32)
+  HASH_FUNCTION_V_ITEM(hx4_x4kdjbx33a_128_ref, 128)
+  HASH_FUNCTION_V_ITEM(hx4_x4kdjbx33a_128_copt, 128)
+#if HX4_HAS_SSE2
+  HASH_FUNCTION_V_ITEM(hx4_x4kdjbx33a_128_sse2, 128)
+#endif
+#if HX4_HAS_SSSE3
+  HASH_FUNCTION_V_ITEM(hx4_x4kdjbx33a_128_ssse3, 128)
+#endif
+  HASH_FUNCTION_V_ITEM(hx4_siphash24_64_ref, 64)
+  HASH_FUNCTION_V_ITEM(hx4_siphash24_64_copt, 64)
+  HASH_FUNCTION_V_ITEM(hx4_siphash13_64_ref, 64)
+  HASH_FUNCTION_V_ITEM(hx4_siphash13_64_copt, 64)
+  HASH_FUNCTION_V_ITEM(hx4_x4siphash13_256_ref, 256)
+#if HX4_HAS_SSE2
+  HASH_FUNCTION_V_ITEM(hx4_x4siphash13_256_sse2, 256)
+#endif
+  HASH_FUNCTION_V_ITEM(hx4_halfsiphash13_32_ref, 32)
+  HASH_FUNCTION_V_ITEM(hx4_halfsiphash13_32_copt, 32)
+  HASH_FUNCTION_V_ITEM(hx4_x4halfsiphash13_128_ref, 128)
+#if HX4_HAS_SSE2
+  HASH_FUNCTION_V_ITEM(hx4_x4halfsiphash13_128_sse2, 128)
+#endif
+};
+
+#define HX4_V_TEST_MAX_FRAGMENTS 24
+
+static int test_hx4_v_correctness(FILE *stream, const void *in, size_t in_sz, const void *cookie, size_t cookie_sz) {
+  const size_t num_functions = sizeof(hash_functions_v)/sizeof(hash_functions_v[0]);
+  hx4_iovec iov[HX4_V_TEST_MAX_FRAGMENTS];
+  uint8_t concatenation[HX4_V_TEST_MAX_FRAGMENTS*64];
+  uint8_t hash_output_ref[512/8];
+  uint8_t hash_output[512/8];
+  uint64_t x = 0x0123456789abcdefULL;
+  size_t concatenation_sz;
+  size_t iov_cnt;
+  size_t offset;
+  size_t f;
+  size_t i;
+  int round;
+  int rc;
+
+  if(in_sz < 8192) {
+    fprintf(stream, "\tinput buffer too small\n");
+    return 1;
+  }
+
+  for(round=0; round<2000; round++) {
+    //a random chain of fragments from random places of the input, the
+    //lengths are mostly short so that words and blocks cross the boundaries
+    x = x * 6364136223846793005ULL + 1442695040888963407ULL;
+    iov_cnt = (size_t)(x >> 33) % (HX4_V_TEST_MAX_FRAGMENTS+1);
+    concatenation_sz = 0;
+    for(i=0; i<iov_cnt; i++) {
+      x = x * 6364136223846793005ULL + 1442695040888963407ULL;
+      offset = (size_t)(x >> 20) % 4096;
+      switch((x >> 40) % 4) {
+      case 0: iov[i].iov_len = (size_t)(x >> 48) % 2; break;
+      case 1: iov[i].iov_len = (size_t)(x >> 48) % 17; break;
+      default: iov[i].iov_len = (size_t)(x >> 48) % 65; break;
+      }
+      iov[i].iov_base = iov[i].iov_len ? (const uint8_t*)in + offset : NULL;
+      memcpy(concatenation + concatenation_sz, iov[i].iov_base ? iov[i].iov_base : in, iov[i].iov_len);
+      concatenation_sz += iov[i].iov_len;
+    }
+
+    for(f=0; f<num_functions; f++) {
+      rc = hash_functions_v[f].function(concatenation, concatenation_sz, cookie, cookie_sz, hash_output_ref, hash_functions_v[f].output_size);
+      if(rc != HX4_ERR_SUCCESS) {
+        return rc;
+      }
+      rc = hash_functions_v[f].function_v(iov, iov_cnt, cookie, cookie_sz, hash_output, hash_functions_v[f].output_size);
+      if(rc != HX4_ERR_SUCCESS) {
+        fprintf(stream, "\t%s failed: %d\n", hash_functions_v[f].name, rc);
+        return 1;
+      }
+      if(memcmp(hash_output_ref, hash_output, hash_functions_v[f].output_size) != 0) {
+        fprintf(stream, "\t%s output doesn't match the hash of the concatenation in round %d (%d fragments, %d bytes)\n",
+          hash_functions_v[f].name, round, (int)iov_cnt, (int)concatenation_sz);
+        return 1;
+      }
+    }
+  }
+
+  //one big fragment goes through the SIMD main loop
+  iov[0].iov_base = (const uint8_t*)in + 3;
+  iov[0].iov_len = 4000;
+  for(f=0; f<num_functions; f++) {
+    hash_functions_v[f].function(iov[0].iov_base, iov[0].iov_len, cookie, cookie_sz, hash_output_ref, hash_functions_v[f].output_size);
+    hash_functions_v[f].function_v(iov, 1, cookie, cookie_sz, hash_output, hash_functions_v[f].output_size);
+    if(memcmp(hash_output_ref, hash_output, hash_functions_v[f].output_size) != 0) {
+      fprintf(stream, "\t%s output doesn't match for a single fragment\n", hash_functions_v[f].name);
+      return 1;
+    }
+  }
+
+  rc = hx4_x4djbx33a_128_copt_v(NULL, 1, cookie, cookie_sz, hash_output, sizeof(hash_output));
+  if(rc != HX4_ERR_PARAM_INVALID) {
+    fprintf(stream, "\tNULL iov not rejected\n");
+    return 1;
+  }
+  iov[0].iov_base = NULL;
+  iov[0].iov_len = 1;
+  rc = hx4_x4djbx33a_128_copt_v(iov, 1, cookie, cookie_sz, hash_output, sizeof(hash_output));
+  if(rc != HX4_ERR_PARAM_INVALID) {
+    fprintf(stream, "\tNULL fragment not rejected\n");
+    return 1;
+  }
+
+  return 0;
+}
+
+typedef int (*hash_function_copy_t)(void *, const void *, size_t, const void *, size_t, void *, size_t);
+typedef struct {
+  hash_function_t function;
+  hash_function_copy_t function_copy;
+  const char *name;
+  size_t output_size;
+} hash_function_copy_item_t;
+
+#define HASH_FUNCTION_COPY_ITEM(function_name, output_bits) { function_name , function_name##_copy , #function_name "_copy" , (output_bits)/8 } ,
+
+static const hash_function_copy_item_t hash_functions_copy[] = {
+#if HX4_HAS_SSE2
+  HASH_FUNCTION_COPY_ITEM(hx4_x4djbx33a_128_sse2, 128)
+#endif
+#if HX4_HAS_SSSE3
+  HASH_FUNCTION_COPY_ITEM(hx4_x4djbx33a_128_ssse3, 128)
+#endif
+#if HX4_HAS_SSE2
+  HASH_FUNCTION_COPY_ITEM(hx4_x4siphash13_256_sse2, 256)
+  HASH_FUNCTION_COPY_ITEM(hx4_x4halfsiphash13_128_sse2, 128)
+#endif
+};
+
+/* hashes with the _copy function into a guarded destination and checks hash, copy and guards */
+static int check_copy_function(FILE *stream, const hash_function_copy_item_t *item, uint8_t *dst_buffer, size_t dst_offset, const uint8_t *in, size_t in_sz, const void *cookie, size_t cookie_sz) {
+  uint8_t hash_output_ref[512/8];
+  uint8_t hash_output[512/8];
+  size_t i;
+  int rc;
+
+  memset(dst_buffer, 0xa5, dst_offset + in_sz + 64);
+  rc = item->function(in, in_sz, cookie, cookie_sz, hash_output_ref, item->output_size);
+  if(rc != HX4_ERR_SUCCESS) {
+    return rc;
+  }
+  rc = item->function_copy(dst_buffer + dst_offset, in, in_sz, cookie, cookie_sz, hash_output, item->output_size);
+  if(rc != HX4_ERR_SUCCESS) {
+    fprintf(stream, "\t%s failed: %d\n", item->name, rc);
+    return 1;
+  }
+  if(memcmp(hash_output_ref, hash_output, item->output_size) != 0) {
+    fprintf(stream, "\t%s output doesn't match the hash at dst offset %d, size %d\n", item->name, (int)dst_offset, (int)in_sz);
+    return 1;
+  }
+  if(memcmp(dst_buffer + dst_offset, in, in_sz) != 0) {
+    fprintf(stream, "\t%s copy doesn't match the input at dst offset %d, size %d\n", item->name, (int)dst_offset, (int)in_sz);
+    return 1;
+  }
+  for(i=0; i<dst_offset; i++) {
+    if(dst_buffer[i] != 0xa5) {
+      fprintf(stream, "\t%s wrote before dst\n", item->name);
+      return 1;
+    }
+  }
+  for(i=0; i<64; i++) {
+    if(dst_buffer[dst_offset + in_sz + i] != 0xa5) {
+      fprintf(stream, "\t%s wrote after dst\n", item->name);
+      return 1;
+    }
+  }
+  return 0;
+}
+
+static int test_hx4_copy_correctness(FILE *stream, const void *in, size_t in_sz, const void *cookie, size_t cookie_sz) {
+  const size_t num_functions = sizeof(hash_functions_copy)/sizeof(hash_functions_copy[0]);
+  const size_t large_sz = HX4_COPY_STREAM_MIN_SIZE + 1000;
+  uint8_t *dst_buffer = NULL;
+  uint8_t hash_output[512/8];
+  size_t dst_offset;
+  size_t sz;
+  size_t f;
+  int i;
+  int rc = 0;
+
+  if(in_sz < large_sz + 64) {
+    fprintf(stream, "\tinput buffer too small\n");
+    return 1;
+  }
+
+  dst_buffer = malloc(large_sz + 128);
+  if(!dst_buffer) {
+    fprintf(stream, "\tout of memory\n");
+    return 1;
+  }
+
+  for(f=0; f<num_functions; f++) {
+    //every relative alignment of in and dst, short copies take the memcpy path
+    for(i=0; i<16; i++) {
+      for(dst_offset=0; dst_offset<16; dst_offset++) {
+        for(sz=0; sz<1500; sz += 1 + sz/16) {
+          rc = check_copy_function(stream, &hash_functions_copy[f], dst_buffer, dst_offset, (const uint8_t*)in + i, sz, cookie, cookie_sz);
+          if(rc != 0) {
+            goto out;
+          }
+        }
+      }
+    }
+
+    //large enough for the non-temporal stores, aligned and unaligned dst
+    for(dst_offset=0; dst_offset<2; dst_offset++) {
+      rc = check_copy_function(stream, &hash_functions_copy[f], dst_buffer, 16*dst_offset + dst_offset, (const uint8_t*)in + 5, large_sz, cookie, cookie_sz);
+      if(rc != 0) {
+        goto out;
+      }
+    }
+
+    //dst overlapping the input is rejected
+    rc = hash_functions_copy[f].function_copy((uint8_t*)in + 8, in, 64, cookie, cookie_sz, hash_output, hash_functions_copy[f].output_size);
+    if(rc != HX4_ERR_OVERLAP) {
+      fprintf(stream, "\t%s doesn't reject an overlapping dst\n", hash_functions_copy[f].name);
+      rc = 1;
+      goto out;
+    }
+    rc = 0;
+  }
+
+out:
+  free(dst_buffer);
+  return rc;
+}
+
+static int test_hx4_sketch_performance(FILE *stream, const void *in, size_t in_sz, const void *cookie, size_t cookie_sz) {
+  const size_t n = 8*1024*1024;
+  const int precision = 14;
+  const size_t width = 1 << 20;
+  const int depth = 4;
+  uint64_t *keys;
+  uint8_t *hll_memory[2];
+  uint32_t *cms_memory;
+  hx4_hll hll[2];
+  hx4_cms cms;
+  hx_time start;
+  hx_time stop;
+  double estimate;
+  size_t i;
+  int rc = 0;
+
+  (void)in;
+  (void)in_sz;
+
+  keys = malloc(n * sizeof(uint64_t));
+  hll_memory[0] = malloc(HX4_HLL_MEMORY_SIZE(precision));
+  hll_memory[1] = malloc(HX4_HLL_MEMORY_SIZE(precision));
+  cms_memory = malloc(HX4_CMS_MEMORY_SIZE(width, depth));
+  if(!keys || !hll_memory[0] || !hll_memory[1] || !cms_memory) {
+    fprintf(stream, "\tout of memory\n");
+    rc = 1;
+    goto out;
+  }
+  for(i=0; i<n; i++) {
+    keys[i] = (uint64_t)i * 0x9e3779b97f4a7c15ULL;
+  }
+
+  fprintf(stream, "\t%d u64 keys, hll precision %d, cms %dx%d\n", (int)n, precision, (int)width, depth);
+
+  rc += hx4_hll_init(&hll[0], precision, hll_memory[0], HX4_HLL_MEMORY_SIZE(precision), cookie, cookie_sz);
+  start = hx_gettime();
+  for(i=0; i<n; i++) {
+    rc += hx4_hll_add(&hll[0], &keys[i], sizeof(uint64_t));
+  }
+  stop = hx_gettime();
+  fprintf(stream, "\t%-28s %8.2f Mkeys/s\n", "hx4_hll_add", (double)n / (double)hx_timedelta_s(&start, &stop) / 1000000.0);
+
+  rc += hx4_hll_init(&hll[1], precision, hll_memory[1], HX4_HLL_MEMORY_SIZE(precision), cookie, cookie_sz);
+  start = hx_gettime();
+  rc += hx4_hll_add_u64_batch(&hll[1], keys, n);
+  stop = hx_gettime();
+  fprintf(stream, "\t%-28s %8.2f Mkeys/s\n", "hx4_hll_add_u64_batch", (double)n / (double)hx_timedelta_s(&start, &stop) / 1000000.0);
+
+  start = hx_gettime();
+  for(i=0; i<1000; i++) {
+    rc += hx4_hll_merge(&hll[0], &hll[1]);
+  }
+  rc += hx4_hll_estimate(&hll[0], &estimate);
+  stop = hx_gettime();
+  fprintf(stream, "\t%-28s %8.2f us per merge of %d registers, estimate %.0f\n", "hx4_hll_merge", (double)hx_timedelta_s(&start, &stop) * 1000.0, 1 << precision, estimate);
+
+  rc += hx4_cms_init(&cms, width, depth, cms_memory, HX4_CMS_MEMORY_SIZE(width, depth), cookie, cookie_sz);
+  start = hx_gettime();
+  for(i=0; i<n; i++) {
+    rc += hx4_cms_add(&cms, &keys[i], sizeof(uint64_t), 1);
+  }
+  stop = hx_gettime();
+  fprintf(stream, "\t%-28s %8.2f Mkeys/s\n", "hx4_cms_add", (double)n / (double)hx_timedelta_s(&start, &stop) / 1000000.0);
+
+  start = hx_gettime();
+  rc += hx4_cms_add_u64_batch(&cms, keys, n);
+  stop = hx_gettime();
+  fprintf(stream, "\t%-28s %8.2f Mkeys/s\n", "hx4_cms_add_u64_batch", (double)n / (double)hx_timedelta_s(&start, &stop) / 1000000.0);
+
+out:
+  free(keys);
+  free(hll_memory[0]);
+  free(hll_memory[1]);
+  free(cms_memory);
+  return rc;
+}
+
+//the baseline: every permutation is an independently keyed hash over all shingles
+static int minhash_signature_independent(const hx4_minhash *minhash, const uint8_t *doc, size_t doc_sz, uint64_t *shingles, uint64_t *hashes, uint32_t *signature) {
+  const size_t n = doc_sz - minhash->shingle_sz + 1;
+  uint8_t cookie[128/8];
+  size_t i;
+  size_t j;
+  int rc = 0;
+
+  for(i=0; i<n; i++) {
+    shingles[i] = 0;
+    for(j=0; j<minhash->shingle_sz; j++) {
+      shingles[i] |= (uint64_t)doc[i+j] << (8*j);
+    }
+  }
+  memcpy(cookie, minhash->cookie, sizeof(cookie));
+  for(j=0; j<minhash->num_hashes; j++) {
+    cookie[0] = (uint8_t)j;
+    rc += hx4_hash_u64_array(shingles, n, cookie, sizeof(cookie), hashes);
+    signature[j] = 0xffffffff;
+    for(i=0; i<n; i++) {
+      if((uint32_t)hashes[i] < signature[j]) {
+        signature[j] = (uint32_t)hashes[i];
+      }
+    }
+  }
+  return rc;
+}
+
+static int test_hx4_minhash_performance(FILE *stream, const void *in, size_t in_sz, const void *cookie, size_t cookie_sz) {
+  const size_t num_functions = sizeof(minhash_functions)/sizeof(minhash_functions[0]);
+  const size_t doc_sz = 4096;
+  const size_t num_docs = 1024;
+  const size_t num_baseline_docs = 64;
+  const size_t shingle_sz = 5;
+  const size_t num_hashes = 128;
+  uint8_t *docs;
+  uint64_t *shingles;
+  uint64_t *hashes;
+  uint32_t signature[HX4_MINHASH_MAX_HASHES];
+  hx4_minhash minhash;
+  hx_time start;
+  hx_time stop;
+  size_t d, f;
+  int rc = 0;
+
+  (void)in;
+  (void)in_sz;
+
+  docs = malloc(num_docs * doc_sz);
+  shingles = malloc(doc_sz * sizeof(uint64_t));
+  hashes = malloc(doc_sz * sizeof(uint64_t));
+  if(!docs || !shingles || !hashes) {
+    fprintf(stream, "\tout of memory\n");
+    rc = 1;
+    goto out;
+  }
+  init_minhash_doc(docs, num_docs * doc_sz, 3);
+  rc = hx4_minhash_init(&minhash, shingle_sz, num_hashes, cookie, cookie_sz);
+  if(rc != HX4_ERR_SUCCESS) {
+    goto out;
+  }
+
+  fprintf(stream, "\t%d byte documents, %d byte shingles, %d hashes\n", (int)doc_sz, (int)shingle_sz, (int)num_hashes);
+
+  start = hx_gettime();
+  for(d=0; d<num_baseline_docs; d++) {
+    rc += minhash_signature_independent(&minhash, docs + d*doc_sz, doc_sz, shingles, hashes, signature);
+  }
+  stop = hx_gettime();
+  fprintf(stream, "\t%-32s %10.0f docs/s\n", "independent hash per permutation", (double)num_baseline_docs / (double)hx_timedelta_s(&start, &stop));
+
+  for(f=0; f<num_functions; f++) {
+    start = hx_gettime();
+    for(d=0; d<num_docs; d++) {
+      rc += minhash_functions[f].function(&minhash, docs + d*doc_sz, doc_sz, signature);
+    }
+    stop = hx_gettime();
+    fprintf(stream, "\t%-32s %10.0f docs/s\n", minhash_functions[f].name, (double)num_docs / (double)hx_timedelta_s(&start, &stop));
+  }
+
+out:
+  free(docs);
+  free(shingles);
+  free(hashes);
+  return rc;
+}
+
+typedef int (*hash_function_cstr_t)(const char *, size_t *, const void *, size_t, void *, size_t);
+typedef struct {
+  hash_function_t function;
+  hash_function_cstr_t function_cstr;
+  const char *name;
+  size_t output_size;
+} hash_function_cstr_item_t;
+
+#define HASH_FUNCTION_CSTR_ITEM(function_name, output_bits) { function_name , function_name##_cstr , #function_name "_cstr" , (output_bits)/8 } ,
+
+static const hash_function_cstr_item_t hash_functions_cstr[] = {
+  HASH_FUNCTION_CSTR_ITEM(hx4_djbx33a_32_ref, 32)
+  HASH_FUNCTION_CSTR_ITEM(hx4_djbx33a_32_copt, 32)
+  HASH_FUNCTION_CSTR_ITEM(hx4_x4djbx33a_128_ref, 128)
+  HASH_FUNCTION_CSTR_ITEM(hx4_x4djbx33a_128_copt, 128)
+#if HX4_HAS_MMX
+  HASH_FUNCTION_CSTR_ITEM(hx4_x4djbx33a_128_mmx, 128)
+#endif
+#if HX4_HAS_SSE2
+  HASH_FUNCTION_CSTR_ITEM(hx4_x4djbx33a_128_sse2, 128)
+  HASH_FUNCTION_CSTR_ITEM(hx4_x4djbx33a_128_sse2rle, 128)
+#endif
+#if HX4_HAS_SSSE3
+  HASH_FUNCTION_CSTR_ITEM(hx4_x4djbx33a_128_ssse3, 128)
+#endif
+  HASH_FUNCTION_CSTR_ITEM(hx4_kdjbx33a_32_ref, 32)
+  HASH_FUNCTION_CSTR_ITEM(hx4_kdjbx33a_32_copt, 32)
+  HASH_FUNCTION_CSTR_ITEM(hx4_x4kdjbx33a_128_ref, 128)
+  HASH_FUNCTION_CSTR_ITEM(hx4_x4kdjbx33a_128_copt, 128)
+#if HX4_HAS_SSE2
+  HASH_FUNCTION_CSTR_ITEM(hx4_x4kdjbx33a_128_sse2, 128)
+#endif
+#if HX4_HAS_SSSE3
+  HASH_FUNCTION_CSTR_ITEM(hx4_x4kdjbx33a_128_ssse3, 128)
+#endif
+  HASH_FUNCTION_CSTR_ITEM(hx4_siphash24_64_ref, 64)
+  HASH_FUNCTION_CSTR_ITEM(hx4_siphash24_64_copt, 64)
+  HASH_FUNCTION_CSTR_ITEM(hx4_siphash13_64_ref, 64)
+  HASH_FUNCTION_CSTR_ITEM(hx4_siphash13_64_copt, 64)
+  HASH_FUNCTION_CSTR_ITEM(hx4_x4siphash13_256_ref, 256)
+#if HX4_HAS_SSE2
+  HASH_FUNCTION_CSTR_ITEM(hx4_x4siphash13_256_sse2, 256)
+#endif
+  HASH_FUNCTION_CSTR_ITEM(hx4_halfsiphash13_32_ref, 32)
+  HASH_FUNCTION_CSTR_ITEM(hx4_halfsiphash13_32_copt, 32)
+  HASH_FUNCTION_CSTR_ITEM(hx4_x4halfsiphash13_128_ref, 128)
+#if HX4_HAS_SSE2
+  HASH_FUNCTION_CSTR_ITEM(hx4_x4halfsiphash13_128_sse2, 128)
+#endif
+};
+
+#define HX4_CSTR_TEST_PAGES 16
+
+/* HX4_CSTR_TEST_PAGES readable pages followed by one that faults on access,
+ * strings that end on the last readable byte catch reads past their page */
+static uint8_t *guarded_pages_alloc(size_t *page_sz) {
+#ifdef __GNUC__
+  uint8_t *pages;
+
+  *page_sz = (size_t)sysconf(_SC_PAGESIZE);
+  pages = mmap(NULL, (HX4_CSTR_TEST_PAGES+1) * *page_sz, PROT_READ|PROT_WRITE, MAP_PRIVATE|MAP_ANONYMOUS, -1, 0);
+  if(pages == MAP_FAILED) {
+    return NULL;
+  }
+  if(mprotect(pages + HX4_CSTR_TEST_PAGES * *page_sz, *page_sz, PROT_NONE) != 0) {
+    munmap(pages, (HX4_CSTR_TEST_PAGES+1) * *page_sz);
+    return NULL;
+  }
+  return pages;
+#elif _MSC_VER
+  SYSTEM_INFO info;
+  DWORD old_protect;
+  uint8_t *pages;
+
+  GetSystemInfo(&info);
+  *page_sz = info.dwPageSize;
+  pages = VirtualAlloc(NULL, (HX4_CSTR_TEST_PAGES+1) * *page_sz, MEM_COMMIT|MEM_RESERVE, PAGE_READWRITE);
+  if(!pages) {
+    return NULL;
+  }
+  if(!VirtualProtect(pages + HX4_CSTR_TEST_PAGES * *page_sz, *page_sz, PAGE_NOACCESS, &old_protect)) {
+    VirtualFree(pages, 0, MEM_RELEASE);
+    return NULL;
+  }
+  return pages;
+#endif
+}
+
+static void guarded_pages_free(uint8_t *pages, size_t page_sz) {
+  if(!pages) {
+    return;
+  }
+#ifdef __GNUC__
+  munmap(pages, (HX4_CSTR_TEST_PAGES+1) * page_sz);
+#elif _MSC_VER
+  (void)page_sz;
+  VirtualFree(pages, 0, MEM_RELEASE);
+#endif
+}
+
+/* hashes str with the _cstr function and checks hash and length against the function on (str, len) */
+static int check_cstr_function(FILE *stream, const hash_function_cstr_item_t *item, const char *str, size_t len, const void *cookie, size_t cookie_sz) {
+  uint8_t hash_output_ref[512/8];
+  uint8_t hash_output[512/8];
+  size_t str_len = (size_t)-1;
+  int rc;
+
+  rc = item->function(str, len, cookie, cookie_sz, hash_output_ref, item->output_size);
+  if(rc != HX4_ERR_SUCCESS) {
+    return rc;
+  }
+  rc = item->function_cstr(str, &str_len, cookie, cookie_sz, hash_output, item->output_size);
+  if(rc != HX4_ERR_SUCCESS) {
+    fprintf(stream, "\t%s failed: %d\n", item->name, rc);
+    return 1;
+  }
+  if(str_len != len) {
+    fprintf(stream, "\t%s returned length %d instead of %d\n", item->name, (int)str_len, (int)len);
+    return 1;
+  }
+  if(memcmp(hash_output_ref, hash_output, item->output_size) != 0) {
+    fprintf(stream, "\t%s output doesn't match the hash of the string at offset %d, length %d\n",
+      item->name, (int)((size_t)str % 16), (int)len);
+    return 1;
+  }
+  return 0;
+}
+
+static int test_hx4_cstr_correctness(FILE *stream, const void *in, size_t in_sz, const void *cookie, size_t cookie_sz) {
+  const size_t num_functions = sizeof(hash_functions_cstr)/sizeof(hash_functions_cstr[0]);
+  uint8_t hash_output[512/8];
+  uint8_t *pages = NULL;
+  size_t page_sz = 0;
+  size_t mapped_sz;
+  size_t len;
+  size_t f;
+  size_t i;
+  char *str;
+  int rc = 0;
+
+  pages = guarded_pages_alloc(&page_sz);
+  if(!pages) {
+    fprintf(stream, "\tout of memory\n");
+    return 1;
+  }
+  mapped_sz = HX4_CSTR_TEST_PAGES * page_sz;
+  if(in_sz < mapped_sz) {
+    fprintf(stream, "\tinput buffer too small\n");
+    rc = 1;
+    goto out;
+  }
+
+  //the input without its zero bytes
+  for(i=0; i<mapped_sz; i++) {
+    pages[i] = ((const uint8_t*)in)[i] ? ((const uint8_t*)in)[i] : 'x';
+  }
+
+  for(f=0; f<num_functions; f++) {
+    //strings that end on the last byte before the guard page, every
+    //alignment of the terminator and lengths across the chunk size
+    for(len=0; len<2100; len += 1 + len/64) {
+      str = (char*)pages + mapped_sz - 1 - len;
+      str[len] = '\0';
+      rc = check_cstr_function(stream, &hash_functions_cstr[f], str, len, cookie, cookie_sz);
+      str[len] = 'x';
+      if(rc != 0) {
+        goto out;
+      }
+    }
+
+    //every alignment of the start and the terminator inside a page
+    for(i=0; i<16; i++) {
+      for(len=0; len<300; len++) {
+        str = (char*)pages + 64 + i;
+        str[len] = '\0';
+        rc = check_cstr_function(stream, &hash_functions_cstr[f], str, len, cookie, cookie_sz);
+        str[len] = 'x';
+        if(rc != 0) {
+          goto out;
+        }
+      }
+    }
+
+    //a string over all readable pages
+    len = mapped_sz - 1 - 5;
+    str = (char*)pages + 5;
+    str[len] = '\0';
+    rc = check_cstr_function(stream, &hash_functions_cstr[f], str, len, cookie, cookie_sz);
+    str[len] = 'x';
+    if(rc != 0) {
+      goto out;
+    }
+  }
+
+  str = (char*)pages + mapped_sz - 4;
+  str[3] = '\0';
+  if(hx4_x4djbx33a_128_copt_cstr(str, NULL, cookie, cookie_sz, hash_output, sizeof(hash_output)) != HX4_ERR_SUCCESS) {
+    fprintf(stream, "\tNULL str_len not accepted\n");
+    rc = 1;
+    goto out;
+  }
+  if(hx4_x4djbx33a_128_copt_cstr(NULL, NULL, cookie, cookie_sz, hash_output, sizeof(hash_output)) != HX4_ERR_PARAM_INVALID) {
+    fprintf(stream, "\tNULL str not rejected\n");
+    rc = 1;
+    goto out;
+  }
+
+out:
+  guarded_pages_free(pages, page_sz);
+  return rc;
+}
+
+typedef struct {
+  hash_function_t function;
+  hash_function_t function_ci;
+  const char *name;
+  size_t output_size;
+} hash_function_ci_item_t;
+
+#define HASH_FUNCTION_CI_ITEM(function_name, output_bits) { function_name , function_name##_ci , #function_name "_ci" , (output_bits)/8 } ,
+
+static const hash_function_ci_item_t hash_functions_ci[] = {
+  HASH_FUNCTION_CI_ITEM(hx4_djbx33a_32_ref, 32)
+  HASH_FUNCTION_CI_ITEM(hx4_djbx33a_32_copt, 32)
+  HASH_FUNCTION_CI_ITEM(hx4_x4djbx33a_128_ref, 128)
+  HASH_FUNCTION_CI_ITEM(hx4_x4djbx33a_128_copt, 128)
+#if HX4_HAS_SSE2
+  HASH_FUNCTION_CI_ITEM(hx4_x4djbx33a_128_sse2, 128)
+#endif
+#if HX4_HAS_SSSE3
+  HASH_FUNCTION_CI_ITEM(hx4_x4djbx33a_128_ssse3, 128)
+#endif
+  HASH_FUNCTION_CI_ITEM(hx4_siphash24_64_ref, 64)
+  HASH_FUNCTION_CI_ITEM(hx4_siphash24_64_copt, 64)
+  HASH_FUNCTION_CI_ITEM(hx4_siphash13_64_ref, 64)
+  HASH_FUNCTION_CI_ITEM(hx4_siphash13_64_copt, 64)
+};
+
+/* ASCII only, the C library tolower depends on the locale */
+static void ascii_lowercase(uint8_t *dst, const uint8_t *src, size_t sz) {
+  size_t i;
+  for(i=0; i<sz; i++) {
+    dst[i] = (src[i] >= 'A' && src[i] <= 'Z') ? (uint8_t)(src[i] + ('a' - 'A')) : src[i];
+  }
+}
+
+static int test_hx4_ci_correctness(FILE *stream, const void *in, size_t in_sz, const void *cookie, size_t cookie_sz) {
+  const size_t num_functions = sizeof(hash_functions_ci)/sizeof(hash_functions_ci[0]);
+  const size_t max_sz = 4096;
+  const char * const spellings[] = { "content-type", "Content-Type", "CONTENT-TYPE", "cOnTeNt-TyPe" };
+  uint8_t *mixed = NULL;
+  uint8_t *lowered = NULL;
+  uint8_t hash_output_ref[512/8];
+  uint8_t hash_output[512/8];
+  uint64_t x = 0x0123456789abcdefULL;
+  size_t offset;
+  size_t sz;
+  size_t f;
+  size_t i;
+  int rc = 0;
+
+  (void)in;
+  (void)in_sz;
+
+  mixed = malloc(max_sz + 16);
+  lowered = malloc(max_sz);
+  if(!mixed || !lowered) {
+    fprintf(stream, "\tout of memory\n");
+    rc = 1;
+    goto out;
+  }
+
+  //every byte value, with many letters and the bytes right next to A-Z and a-z
+  for(i=0; i<max_sz + 16; i++) {
+    x = x * 6364136223846793005ULL + 1442695040888963407ULL;
+    switch((x >> 60) % 4) {
+    case 0: mixed[i] = (uint8_t)('@' + (x >> 32) % 28); break;
+    case 1: mixed[i] = (uint8_t)('`' + (x >> 32) % 28); break;
+    default: mixed[i] = (uint8_t)(x >> 32); break;
+    }
+  }
+
+  for(f=0; f<num_functions; f++) {
+    for(offset=0; offset<16; offset++) {
+      for(sz=0; sz<=max_sz; sz += 1 + sz/8) {
+        ascii_lowercase(lowered, mixed + offset, sz);
+        rc = hash_functions_ci[f].function(lowered, sz, cookie, cookie_sz, hash_output_ref, hash_functions_ci[f].output_size);
+        if(rc != HX4_ERR_SUCCESS) {
+          goto out;
+        }
+        rc = hash_functions_ci[f].function_ci(mixed + offset, sz, cookie, cookie_sz, hash_output, hash_functions_ci[f].output_size);
+        if(rc != HX4_ERR_SUCCESS) {
+          fprintf(stream, "\t%s failed: %d\n", hash_functions_ci[f].name, rc);
+          goto out;
+        }
+        if(memcmp(hash_output_ref, hash_output, hash_functions_ci[f].output_size) != 0) {
+          fprintf(stream, "\t%s output doesn't match the hash of the lowercased input at offset %d, size %d\n",
+            hash_functions_ci[f].name, (int)offset, (int)sz);
+          rc = 1;
+          goto out;
+        }
+      }
+    }
+
+    for(i=0; i<sizeof(spellings)/sizeof(spellings[0]); i++) {
+      hash_functions_ci[f].function(spellings[0], strlen(spellings[0]), cookie, cookie_sz, hash_output_ref, hash_functions_ci[f].output_size);
+      hash_functions_ci[f].function_ci(spellings[i], strlen(spellings[i]), cookie, cookie_sz, hash_output, hash_functions_ci[f].output_size);
+      if(memcmp(hash_output_ref, hash_output, hash_functions_ci[f].output_size) != 0) {
+        fprintf(stream, "\t%s output doesn't match for \"%s\"\n", hash_functions_ci[f].name, spellings[i]);
+        rc = 1;
+        goto out;
+      }
+    }
+  }
+
+out:
+  free(mixed);
+  free(lowered);
+  return rc;
+}
+
+#define HX4_MTU_SIZE 1500
+
+/* hashes messages that arrive as chains of MTU sized fragments, once by
+ * copying the fragments together and hashing the copy, once with the _v function */
+static int test_hx4_v_performance(FILE *stream, const void *in, size_t in_sz, const void *cookie, size_t cookie_sz) {
+  const size_t message_sizes[] = { 1500, 9000, 64*1024, 1024*1024 };
+  const size_t num_messages = 64;
+  const size_t max_fragments = (1024*1024 + HX4_MTU_SIZE - 1) / HX4_MTU_SIZE;
+  const hash_function_v_item_t items[] = {
+    HASH_FUNCTION_V_ITEM(hx4_x4djbx33a_128_copt, 128)
+#if HX4_HAS_SSSE3
+    HASH_FUNCTION_V_ITEM(hx4_x4djbx33a_128_ssse3, 128)
+    HASH_FUNCTION_V_ITEM(hx4_x4kdjbx33a_128_ssse3, 128)
+#endif
+    HASH_FUNCTION_V_ITEM(hx4_siphash13_64_copt, 64)
+#if HX4_HAS_SSE2
+    HASH_FUNCTION_V_ITEM(hx4_x4siphash13_256_sse2, 256)
+    HASH_FUNCTION_V_ITEM(hx4_x4halfsiphash13_128_sse2, 128)
+#endif
+  };
+  hx4_iovec *iov = NULL;
+  uint8_t *coalesced = NULL;
+  volatile unsigned char hash_output[512/8];
+  volatile int result = 0;
+  hx_time start;
+  hx_time stop;
+  size_t message_sz;
+  size_t iov_cnt;
+  size_t m;
+  size_t s;
+  size_t f;
+  size_t i;
+  size_t repeat;
+  size_t repeats;
+  double copy_s;
+  double v_s;
+  uint64_t x = 0x0123456789abcdefULL;
+  int rc = 0;
+
+  //the fragments of all messages lie scattered over the input buffer
+  if(in_sz < 64*1024*1024) {
+    fprintf(stream, "\tinput buffer too small\n");
+    return 1;
+  }
+
+  iov = malloc(num_messages * max_fragments * sizeof(hx4_iovec));
+  coalesced = malloc(1024*1024);
+  if(!iov || !coalesced) {
+    fprintf(stream, "\tout of memory\n");
+    rc = 1;
+    goto out;
+  }
+
+  fprintf(stream, "\t| %-32s | %8s | %10s | %10s |\n", "MiB/s", "message", "copy+hash", "_v");
+  for(s=0; s<sizeof(message_sizes)/sizeof(message_sizes[0]); s++) {
+    message_sz = message_sizes[s];
+    iov_cnt = (message_sz + HX4_MTU_SIZE - 1) / HX4_MTU_SIZE;
+    for(i=0; i<num_messages*iov_cnt; i++) {
+      x = x * 6364136223846793005ULL + 1442695040888963407ULL;
+      iov[i].iov_base = (const uint8_t*)in + (size_t)(x >> 24) % (in_sz - HX4_MTU_SIZE);
+      iov[i].iov_len = (i % iov_cnt == iov_cnt-1) ? message_sz - (iov_cnt-1)*HX4_MTU_SIZE : HX4_MTU_SIZE;
+    }
+    repeats = 1 + (64*1024*1024) / (num_messages*message_sz);
+
+    for(f=0; f<sizeof(items)/sizeof(items[0]); f++) {
+      start = hx_gettime();
+      for(repeat=0; repeat<repeats; repeat++) {
+        for(m=0; m<num_messages; m++) {
+          size_t coalesced_sz = 0;
+          for(i=0; i<iov_cnt; i++) {
+            memcpy(coalesced + coalesced_sz, iov[m*iov_cnt+i].iov_base, iov[m*iov_cnt+i].iov_len);
+            coalesced_sz += iov[m*iov_cnt+i].iov_len;
+          }
+          result += items[f].function(coalesced, coalesced_sz, cookie, cookie_sz, (void*)hash_output, items[f].output_size);
+        }
+      }
+      stop = hx_gettime();
+      copy_s = hx_timedelta_s(&start, &stop);
+
+      start = hx_gettime();
+      for(repeat=0; repeat<repeats; repeat++) {
+        for(m=0; m<num_messages; m++) {
+          result += items[f].function_v(iov + m*iov_cnt, iov_cnt, cookie, cookie_sz, (void*)hash_output, items[f].output_size);
+        }
+      }
+      stop = hx_gettime();
+      v_s = hx_timedelta_s(&start, &stop);
+
+      fprintf(stream, "\t| %-32s | %8d | %10.0f | %10.0f |\n", items[f].name, (int)message_sz,
+        (double)(repeats*num_messages*message_sz) / (1024.0*1024.0) / copy_s,
+        (double)(repeats*num_messages*message_sz) / (1024.0*1024.0) / v_s);
+    }
+  }
+
+  if(result != 0) {
+    fprintf(stream, "\thash functions failed\n");
+    rc = 1;
+  }
+
+out:
+  free(iov);
+  free(coalesced);
+  return rc;
+}
+
+/* copy-and-hash against memcpy followed by the hash function, from 64 bytes to 64 MiB */
+static int test_hx4_copy_performance(FILE *stream, const void *in, size_t in_sz, const void *cookie, size_t cookie_sz) {
+  const size_t num_functions = sizeof(hash_functions_copy)/sizeof(hash_functions_copy[0]);
+  const size_t max_sz = 64*1024*1024;
+  uint8_t *dst = NULL;
+  volatile unsigned char hash_output[512/8];
+  volatile int result = 0;
+  hx_time start;
+  hx_time stop;
+  double separate_s;
+  double fused_s;
+  size_t repeats;
+  size_t repeat;
+  size_t sz;
+  size_t f;
+  int rc = 0;
+
+  if(in_sz < max_sz) {
+    fprintf(stream, "\tinput buffer too small\n");
+    return 1;
+  }
+
+  dst = malloc(max_sz);
+  if(!dst) {
+    fprintf(stream, "\tout of memory\n");
+    return 1;
+  }
+  memset(dst, 0, max_sz);
+
+  fprintf(stream, "\t| %-36s | %9s | %12s | %10s |\n", "MiB/s", "size", "memcpy+hash", "_copy");
+  for(f=0; f<num_functions; f++) {
+    for(sz=64; sz<=max_sz; sz*=4) {
+      repeats = 1 + (256*1024*1024) / sz;
+
+      start = hx_gettime();
+      for(repeat=0; repeat<repeats; repeat++) {
+        memcpy(dst, in, sz);
+        result += hash_functions_copy[f].function(dst, sz, cookie, cookie_sz, (void*)hash_output, hash_functions_copy[f].output_size);
+      }
+      stop = hx_gettime();
+      separate_s = hx_timedelta_s(&start, &stop);
+
+      start = hx_gettime();
+      for(repeat=0; repeat<repeats; repeat++) {
+        result += hash_functions_copy[f].function_copy(dst, in, sz, cookie, cookie_sz, (void*)hash_output, hash_functions_copy[f].output_size);
+      }
+      stop = hx_gettime();
+      fused_s = hx_timedelta_s(&start, &stop);
+
+      fprintf(stream, "\t| %-36s | %9d | %12.0f | %10.0f |\n", hash_functions_copy[f].name, (int)sz,
+        (double)sz * (double)repeats / (1024.0*1024.0) / separate_s,
+        (double)sz * (double)repeats / (1024.0*1024.0) / fused_s);
+    }
+  }
+
+  if(result != 0) {
+    fprintf(stream, "\thash functions failed\n");
+    rc = 1;
+  }
+
+  free(dst);
+  return rc;
+}
+
+/* NUL terminated keys hashed after a strlen against the _cstr functions */
+static int test_hx4_cstr_performance(FILE *stream, const void *in, size_t in_sz, const void *cookie, size_t cookie_sz) {
+  const size_t key_sizes[] = { 8, 16, 32, 64, 256, 4096 };
+  const size_t keys_sz = 1024*1024;
+  const hash_function_cstr_item_t items[] = {
+    HASH_FUNCTION_CSTR_ITEM(hx4_x4djbx33a_128_copt, 128)
+#if HX4_HAS_SSE2
+    HASH_FUNCTION_CSTR_ITEM(hx4_x4djbx33a_128_sse2, 128)
+#endif
+#if HX4_HAS_SSSE3
+    HASH_FUNCTION_CSTR_ITEM(hx4_x4djbx33a_128_ssse3, 128)
+    HASH_FUNCTION_CSTR_ITEM(hx4_x4kdjbx33a_128_ssse3, 128)
+#endif
+    HASH_FUNCTION_CSTR_ITEM(hx4_siphash13_64_copt, 64)
+#if HX4_HAS_SSE2
+    HASH_FUNCTION_CSTR_ITEM(hx4_x4halfsiphash13_128_sse2, 128)
+#endif
+  };
+  char *keys = NULL;
+  const char *p;
+  volatile unsigned char hash_output[512/8];
+  volatile int result = 0;
+  hx_time start;
+  hx_time stop;
+  double strlen_s;
+  double cstr_s;
+  size_t key_sz;
+  size_t num_keys;
+  size_t len;
+  size_t repeats;
+  size_t repeat;
+  size_t k;
+  size_t s;
+  size_t f;
+  size_t i;
+  int rc = 0;
+
+  if(in_sz < keys_sz) {
+    fprintf(stream, "\tinput buffer too small\n");
+    return 1;
+  }
+
+  keys = malloc(keys_sz);
+  if(!keys) {
+    fprintf(stream, "\tout of memory\n");
+    return 1;
+  }
+
+  fprintf(stream, "\t| %-38s | %5s | %11s | %10s |\n", "MiB/s", "key", "strlen+hash", "_cstr");
+  for(s=0; s<sizeof(key_sizes)/sizeof(key_sizes[0]); s++) {
+    //the keys back to back, every one at another alignment
+    key_sz = key_sizes[s];
+    num_keys = keys_sz / (key_sz+1);
+    for(i=0; i<num_keys*(key_sz+1); i++) {
+      keys[i] = i % (key_sz+1) == key_sz ? '\0' : (((const char*)in)[i] ? ((const char*)in)[i] : 'x');
+    }
+    repeats = 1 + (64*1024*1024) / (num_keys*key_sz);
+
+    for(f=0; f<sizeof(items)/sizeof(items[0]); f++) {
+      start = hx_gettime();
+      for(repeat=0; repeat<repeats; repeat++) {
+        p = keys;
+        for(k=0; k<num_keys; k++) {
+          len = strlen(p);
+          result += items[f].function(p, len, cookie, cookie_sz, (void*)hash_output, items[f].output_size);
+          p += len + 1;
+        }
+      }
+      stop = hx_gettime();
+      strlen_s = hx_timedelta_s(&start, &stop);
+
+      start = hx_gettime();
+      for(repeat=0; repeat<repeats; repeat++) {
+        p = keys;
+        for(k=0; k<num_keys; k++) {
+          result += items[f].function_cstr(p, &len, cookie, cookie_sz, (void*)hash_output, items[f].output_size);
+          p += len + 1;
+        }
+      }
+      stop = hx_gettime();
+      cstr_s = hx_timedelta_s(&start, &stop);
+
+      fprintf(stream, "\t| %-38s | %5d | %11.0f | %10.0f |\n", items[f].name, (int)key_sz,
+        (double)(repeats*num_keys*key_sz) / (1024.0*1024.0) / strlen_s,
+        (double)(repeats*num_keys*key_sz) / (1024.0*1024.0) / cstr_s);
+    }
+  }
+
+  if(result != 0) {
+    fprintf(stream, "\thash functions failed\n");
+    rc = 1;
+  }
+
+  free(keys);
+  return rc;
+}
+
+/* keys in mixed case, lowercased into a buffer and hashed against the _ci functions */
+static int test_hx4_ci_performance(FILE *stream, const void *in, size_t in_sz, const void *cookie, size_t cookie_sz) {
+  const size_t key_sizes[] = { 16, 64, 256, 4096 };
+  const size_t keys_sz = 1024*1024;
+  const hash_function_ci_item_t items[] = {
+    HASH_FUNCTION_CI_ITEM(hx4_x4djbx33a_128_copt, 128)
+#if HX4_HAS_SSE2
+    HASH_FUNCTION_CI_ITEM(hx4_x4djbx33a_128_sse2, 128)
+#endif
+#if HX4_HAS_SSSE3
+    HASH_FUNCTION_CI_ITEM(hx4_x4djbx33a_128_ssse3, 128)
+#endif
+    HASH_FUNCTION_CI_ITEM(hx4_siphash24_64_copt, 64)
+    HASH_FUNCTION_CI_ITEM(hx4_siphash13_64_copt, 64)
+  };
+  uint8_t *keys = NULL;
+  uint8_t *lowered = NULL;
+  volatile unsigned char hash_output[512/8];
+  volatile int result = 0;
+  hx_time start;
+  hx_time stop;
+  double lowercase_s;
+  double ci_s;
+  size_t key_sz;
+  size_t num_keys;
+  size_t repeats;
+  size_t repeat;
+  size_t k;
+  size_t s;
+  size_t f;
+  size_t i;
+  int rc = 0;
+
+  (void)in;
+  (void)in_sz;
+
+  keys = malloc(keys_sz);
+  lowered = malloc(4096);
+  if(!keys || !lowered) {
+    fprintf(stream, "\tout of memory\n");
+    rc = 1;
+    goto out;
+  }
+  //header and host name like keys, letters in both cases, digits and dashes
+  for(i=0; i<keys_sz; i++) {
+    keys[i] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-."[(i * 2654435761u >> 7) % 64];
+  }
+
+  fprintf(stream, "\t| %-32s | %5s | %14s | %10s |\n", "MiB/s", "key", "lowercase+hash", "_ci");
+  for(s=0; s<sizeof(key_sizes)/sizeof(key_sizes[0]); s++) {
+    key_sz = key_sizes[s];
+    num_keys = keys_sz / key_sz;
+    repeats = 1 + (64*1024*1024) / (num_keys*key_sz);
+
+    for(f=0; f<sizeof(items)/sizeof(items[0]); f++) {
+      start = hx_gettime();
+      for(repeat=0; repeat<repeats; repeat++) {
+        for(k=0; k<num_keys; k++) {
+          ascii_lowercase(lowered, keys + k*key_sz, key_sz);
+          result += items[f].function(lowered, key_sz, cookie, cookie_sz, (void*)hash_output, items[f].output_size);
+        }
+      }
+      stop = hx_gettime();
+      lowercase_s = hx_timedelta_s(&start, &stop);
+
+      start = hx_gettime();
+      for(repeat=0; repeat<repeats; repeat++) {
+        for(k=0; k<num_keys; k++) {
+          result += items[f].function_ci(keys + k*key_sz, key_sz, cookie, cookie_sz, (void*)hash_output, items[f].output_size);
+        }
+      }
+      stop = hx_gettime();
+      ci_s = hx_timedelta_s(&start, &stop);
+
+      fprintf(stream, "\t| %-32s | %5d | %14.0f | %10.0f |\n", items[f].name, (int)key_sz,
+        (double)(repeats*num_keys*key_sz) / (1024.0*1024.0) / lowercase_s,
+        (double)(repeats*num_keys*key_sz) / (1024.0*1024.0) / ci_s);
+    }
+  }
+
+  if(result != 0) {
+    fprintf(stream, "\thash functions failed\n");
+    rc = 1;
+  }
+
+out:
+  free(keys);
+  free(lowered);
+  return rc;
+}
+
+typedef int (*test_function_t)(FILE*, const void *, size_t, const void *, size_t);
+typedef struct {
+  test_function_t function;
+  const char *name;
+} test_t;
+
+#define TEST_ITEM(function_name) { function_name , #function_name } ,
+
+static void init_random_buffer(unsigned char *buffer, size_t buffer_size) {
+  unsigned char * p = buffer;
+  unsigned char * const buffer_end = buffer+buffer_size;
+  srand(42);
+  size_t i;
+
+  for(i=0;p<buffer_end;p++,i++) {
+    //*p = rand();
+    *p = (unsigned char)(i & 0x00ff);
   }
 }
 
@@ -365,6 +4687,34 @@ int main(int argc, char **argv) {
   test_t tests[] = {
     TEST_ITEM(test_hx4_x4djbx33a_128_all_correctness)
     TEST_ITEM(test_hx4_djbx33a_32_all_correctness)
+#if HX4_HAS_SSE2
+    TEST_ITEM(test_hx4_x4djbx33a_128_sse2rle_runs_correctness)
+#endif
+    TEST_ITEM(test_hx4_kdjbx33a_all_correctness)
+    TEST_ITEM(test_hx4_siphash_vectors_correctness)
+    TEST_ITEM(test_hx4_siphash_all_correctness)
+    TEST_ITEM(test_hx4_crc32c_correctness)
+    TEST_ITEM(test_hx4_x4aes_correctness)
+    TEST_ITEM(test_hx4_polyval_correctness)
+    TEST_ITEM(test_hx4_x4mulfold_correctness)
+    TEST_ITEM(test_hx4_dispatch_correctness)
+    TEST_ITEM(test_hx4_cpp_correctness)
+    TEST_ITEM(test_hx4_stats_correctness)
+    TEST_ITEM(test_hx4_fixed_correctness)
+    TEST_ITEM(test_hx4_bulk_correctness)
+    TEST_ITEM(test_hx4_partition_correctness)
+    TEST_ITEM(test_hx4_bloom_correctness)
+    TEST_ITEM(test_hx4_hll_correctness)
+    TEST_ITEM(test_hx4_cms_correctness)
+    TEST_ITEM(test_hx4_minhash_correctness)
+    TEST_ITEM(test_hx4_phf_correctness)
+    TEST_ITEM(test_hx4_intern_correctness)
+    TEST_ITEM(test_hx4_job_correctness)
+    TEST_ITEM(test_hx4_job_cpp_correctness)
+    TEST_ITEM(test_hx4_v_correctness)
+    TEST_ITEM(test_hx4_copy_correctness)
+    TEST_ITEM(test_hx4_cstr_correctness)
+    TEST_ITEM(test_hx4_ci_correctness)
    
     TEST_ITEM(test_hx4_djbx33a_32_ref_cookie_applied)
     TEST_ITEM(test_hx4_djbx33a_32_copt_cookie_applied)
@@ -375,10 +4725,58 @@ int main(int argc, char **argv) {
 #endif
 #if HX4_HAS_SSE2
     TEST_ITEM(test_hx4_x4djbx33a_128_sse2_cookie_applied)
+    TEST_ITEM(test_hx4_x4djbx33a_128_sse2rle_cookie_applied)
 #endif
 #if HX4_HAS_SSSE3
     TEST_ITEM(test_hx4_x4djbx33a_128_ssse3_cookie_applied)
 #endif
+    TEST_ITEM(test_hx4_kdjbx33a_32_ref_cookie_applied)
+    TEST_ITEM(test_hx4_kdjbx33a_32_copt_cookie_applied)
+    TEST_ITEM(test_hx4_x4kdjbx33a_128_ref_cookie_applied)
+    TEST_ITEM(test_hx4_x4kdjbx33a_128_copt_cookie_applied)
+#if HX4_HAS_SSE2
+    TEST_ITEM(test_hx4_x4kdjbx33a_128_sse2_cookie_applied)
+#endif
+#if HX4_HAS_SSSE3
+    TEST_ITEM(test_hx4_x4kdjbx33a_128_ssse3_cookie_applied)
+#endif
+    TEST_ITEM(test_hx4_siphash13_64_ref_cookie_applied)
+    TEST_ITEM(test_hx4_siphash13_64_copt_cookie_applied)
+    TEST_ITEM(test_hx4_x4siphash13_256_ref_cookie_applied)
+#if HX4_HAS_SSE2
+    TEST_ITEM(test_hx4_x4siphash13_256_sse2_cookie_applied)
+#endif
+    TEST_ITEM(test_hx4_halfsiphash13_32_ref_cookie_applied)
+    TEST_ITEM(test_hx4_halfsiphash13_32_copt_cookie_applied)
+    TEST_ITEM(test_hx4_x4halfsiphash13_128_ref_cookie_applied)
+#if HX4_HAS_SSE2
+    TEST_ITEM(test_hx4_x4halfsiphash13_128_sse2_cookie_applied)
+#endif
+    TEST_ITEM(test_hx4_crc32c_32_ref_cookie_applied)
+    TEST_ITEM(test_hx4_x4crc32c_128_ref_cookie_applied)
+#if HX4_HAS_SSE42
+    TEST_ITEM(test_hx4_crc32c_32_sse42_cookie_applied)
+    TEST_ITEM(test_hx4_x4crc32c_128_sse42_cookie_applied)
+#endif
+#if HX4_HAS_SSE42 && HX4_HAS_PCLMUL
+    TEST_ITEM(test_hx4_crc32c_32_pclmul_cookie_applied)
+#endif
+    TEST_ITEM(test_hx4_x4aes_128_ref_cookie_applied)
+#if HX4_HAS_AESNI
+    TEST_ITEM(test_hx4_x4aes_128_aesni_cookie_applied)
+#endif
+    TEST_ITEM(test_hx4_polyval_128_ref_cookie_applied)
+#if HX4_HAS_PCLMUL
+    TEST_ITEM(test_hx4_polyval_128_pclmul_cookie_applied)
+#endif
+    TEST_ITEM(test_hx4_x4mulfold_128_ref_cookie_applied)
+    TEST_ITEM(test_hx4_x4mulfold_128_copt_cookie_applied)
+#if HX4_HAS_SSE2
+    TEST_ITEM(test_hx4_x4mulfold_128_sse2_cookie_applied)
+#endif
+#if HX4_HAS_AVX2
+    TEST_ITEM(test_hx4_x4mulfold_128_avx2_cookie_applied)
+#endif
  
     TEST_ITEM(test_hx4_djbx33a_32_ref_performance)
     TEST_ITEM(test_hx4_djbx33a_32_copt_performance)
@@ -389,11 +4787,56 @@ int main(int argc, char **argv) {
 #endif
 #if HX4_HAS_SSE2
     TEST_ITEM(test_hx4_x4djbx33a_128_sse2_performance)
+    TEST_ITEM(test_hx4_x4djbx33a_128_sse2rle_performance)
+    TEST_ITEM(test_hx4_x4djbx33a_128_sse2rle_runs_performance)
 #endif
 #if HX4_HAS_SSSE3
     TEST_ITEM(test_hx4_x4djbx33a_128_ssse3_performance)
 #endif
+#if HX4_HAS_SSE2
+    TEST_ITEM(test_hx4_x4kdjbx33a_128_sse2_performance)
+#endif
+#if HX4_HAS_SSSE3
+    TEST_ITEM(test_hx4_x4kdjbx33a_128_ssse3_performance)
+#endif
+    TEST_ITEM(test_hx4_x4kdjbx33a_128_flooding_performance)
     TEST_ITEM(test_hx4_siphash24_64_ref_performance)
+    TEST_ITEM(test_hx4_siphash_short_input_performance)
+#if HX4_HAS_SSE42
+    TEST_ITEM(test_hx4_crc32c_32_sse42_performance)
+    TEST_ITEM(test_hx4_x4crc32c_128_sse42_performance)
+#endif
+#if HX4_HAS_SSE42 && HX4_HAS_PCLMUL
+    TEST_ITEM(test_hx4_crc32c_32_pclmul_performance)
+#endif
+    TEST_ITEM(test_hx4_crc32c_short_input_performance)
+#if HX4_HAS_AESNI
+    TEST_ITEM(test_hx4_x4aes_128_aesni_performance)
+#endif
+    TEST_ITEM(test_hx4_x4aes_short_input_performance)
+    TEST_ITEM(test_hx4_polyval_performance)
+#if HX4_HAS_SSE2
+    TEST_ITEM(test_hx4_x4mulfold_128_sse2_performance)
+#endif
+#if HX4_HAS_AVX2
+    TEST_ITEM(test_hx4_x4mulfold_128_avx2_performance)
+#endif
+    TEST_ITEM(test_hx4_x4mulfold_short_input_performance)
+    TEST_ITEM(test_hx4_inline_short_key_performance)
+    TEST_ITEM(test_hx4_dispatch_calibrate_performance)
+    TEST_ITEM(test_hx4_cpp_hasher_performance)
+    TEST_ITEM(test_hx4_fixed_performance)
+    TEST_ITEM(test_hx4_bulk_performance)
+    TEST_ITEM(test_hx4_partition_performance)
+    TEST_ITEM(test_hx4_bloom_performance)
+    TEST_ITEM(test_hx4_cpp_intern_performance)
+    TEST_ITEM(test_hx4_job_latency_performance)
+    TEST_ITEM(test_hx4_sketch_performance)
+    TEST_ITEM(test_hx4_minhash_performance)
+    TEST_ITEM(test_hx4_v_performance)
+    TEST_ITEM(test_hx4_copy_performance)
+    TEST_ITEM(test_hx4_cstr_performance)
+    TEST_ITEM(test_hx4_ci_performance)
   };
 
   for(i=0; i<sizeof(tests)/sizeof(test_t); i++) {
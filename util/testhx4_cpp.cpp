@@ -0,0 +1,387 @@
+/* 
+ * Copyright 2015 Kai Dietrich <mail@cleeus.de>
+ *
+ * This file is part of hashx4.
+ *
+ * Hashx4 is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Hashx4 is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with hashx4.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/*
+ * Tests of the C++17 interface in hashx4.hpp and benchmarks against the
+ * standard containers, called from testhx4.c.
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "hashx4.hpp"
+#include "hashx4_intern.h"
+
+using namespace hx4::literals;
+
+static_assert(hx4::djbx33a_32("") == 5381, "djbx33a_32 of the empty string");
+static_assert(hx4::djbx33a_32("a") == 5381*33 + 'a', "djbx33a_32 of one byte");
+static_assert("GET"_djbx33a == hx4::djbx33a_32("GET"), "_djbx33a literal");
+static_assert(hx4::x4djbx33a_128("")[0] == 0x05 && hx4::x4djbx33a_128("")[1] == 0x15, "x4djbx33a_128 of the empty string");
+static_assert(hx4::x4djbx33a_128("abcd")[4] == (uint8_t)(5381*33 + 'b'), "x4djbx33a_128 lanes");
+
+static int http_method(std::string_view method) {
+  switch(hx4::djbx33a_32(method)) {
+    case "GET"_djbx33a:    return method == "GET" ? 1 : 0;
+    case "POST"_djbx33a:   return method == "POST" ? 2 : 0;
+    case "DELETE"_djbx33a: return method == "DELETE" ? 3 : 0;
+    default:               return 0;
+  }
+}
+
+/* hash<Algo> and hasher<Algo> against the ref kernel of the algorithm at input sizes from 0 to 300 bytes */
+template<class Algo>
+static int check_algo(FILE *stream, const char *name, hx4::kernel_t ref_kernel, const uint8_t *in, const hx4::cookie &c) {
+  hx4::digest<Algo::output_size> ref;
+  size_t sz;
+  const hx4::hasher<Algo> h(c);
+
+  for(sz=0; sz<=300; sz++) {
+    ref_kernel(in, sz, c.bytes, sizeof(c.bytes), ref.data(), ref.size());
+    if(hx4::hash<Algo>(in, sz, c) != ref) {
+      fprintf(stream, "\thx4::hash<%s> (%s) doesn't match the ref kernel at %d bytes\n", name, Algo::kernel_name, (int)sz);
+      return 1;
+    }
+    if(h(std::string_view((const char*)in, sz)) != hx4::fold(ref)) {
+      fprintf(stream, "\thx4::hasher<%s> doesn't match the ref kernel at %d bytes\n", name, (int)sz);
+      return 1;
+    }
+  }
+  if(h(std::string_view()) != h(std::string_view("", 0))) {
+    fprintf(stream, "\thx4::hasher<%s> of an empty string_view without data\n", name);
+    return 1;
+  }
+  // keys that differ only in the last bytes, which x4 functions put into the last lanes
+  if(h("ab") == h("abc") || h("abc") == h("abcd") || h("abcd") == h("abXY") || h("abcdefgh") == h("abcdefgi")) {
+    fprintf(stream, "\thx4::hasher<%s> ignores the last lanes\n", name);
+    return 1;
+  }
+  fprintf(stream, "\thx4::algo::%-20s %s\n", name, Algo::kernel_name);
+  return 0;
+}
+
+#define HX4_CHECK_ALGO(algo_name) \
+  if(check_algo<hx4::algo::algo_name>(stream, #algo_name, hx4_##algo_name##_ref, p, c) != 0) { \
+    return 1; \
+  }
+
+extern "C" int test_hx4_cpp_correctness(FILE *stream, const void *in, size_t in_sz, const void *cookie, size_t cookie_sz) {
+  const uint8_t *p = (const uint8_t*)in;
+  hx4::cookie c;
+  uint8_t ref[16] = { 0 };
+  uint32_t ref_word;
+  size_t sz;
+  size_t i;
+
+  (void)cookie_sz;
+  memcpy(c.bytes, cookie, sizeof(c.bytes));
+
+  // the constexpr functions at runtime against the C functions
+  for(sz=0; sz<=300; sz++) {
+    const std::string_view s((const char*)p, sz);
+    hx4_djbx33a_32_ref(p, sz, c.bytes, sizeof(c.bytes), ref, 4);
+    ref_word = (uint32_t)ref[0] | ((uint32_t)ref[1] << 8) | ((uint32_t)ref[2] << 16) | ((uint32_t)ref[3] << 24);
+    if(hx4::djbx33a_32(s, c) != ref_word) {
+      fprintf(stream, "\thx4::djbx33a_32 doesn't match hx4_djbx33a_32_ref at %d bytes\n", (int)sz);
+      return 1;
+    }
+    hx4_x4djbx33a_128_ref(p, sz, c.bytes, sizeof(c.bytes), ref, 16);
+    if(memcmp(hx4::x4djbx33a_128(s, c).data(), ref, 16) != 0) {
+      fprintf(stream, "\thx4::x4djbx33a_128 doesn't match hx4_x4djbx33a_128_ref at %d bytes\n", (int)sz);
+      return 1;
+    }
+  }
+
+  // the inline C functions keep their parameter checks next to hashx4.hpp
+  if(hx4_x4djbx33a_128_copt(p, 5, c.bytes, sizeof(c.bytes), ref, 2) != HX4_ERR_BUFFER_TOO_SMALL
+    || hx4_x4djbx33a_128_copt(p, 5, c.bytes, 8, ref, sizeof(ref)) != HX4_ERR_COOKIE_TOO_SMALL) {
+    fprintf(stream, "\tinline hx4_x4djbx33a_128_copt doesn't check its parameters\n");
+    return 1;
+  }
+
+  if(http_method("GET") != 1 || http_method("POST") != 2 || http_method("DELETE") != 3 || http_method("PUT") != 0) {
+    fprintf(stream, "\tswitch on string with _djbx33a failed\n");
+    return 1;
+  }
+
+  HX4_CHECK_ALGO(djbx33a_32)
+  HX4_CHECK_ALGO(x4djbx33a_128)
+  HX4_CHECK_ALGO(kdjbx33a_32)
+  HX4_CHECK_ALGO(x4kdjbx33a_128)
+  HX4_CHECK_ALGO(siphash24_64)
+  HX4_CHECK_ALGO(siphash13_64)
+  HX4_CHECK_ALGO(x4siphash13_256)
+  HX4_CHECK_ALGO(halfsiphash13_32)
+  HX4_CHECK_ALGO(x4halfsiphash13_128)
+  HX4_CHECK_ALGO(crc32c_32)
+  HX4_CHECK_ALGO(x4crc32c_128)
+  HX4_CHECK_ALGO(x4aes_128)
+  HX4_CHECK_ALGO(polyval_128)
+  HX4_CHECK_ALGO(x4mulfold_128)
+
+  // the hasher in a container, with std::string keys and string_view lookups
+  {
+    std::unordered_map<std::string, size_t, hx4::hasher<hx4::algo::x4djbx33a_128> > map(16, hx4::hasher<hx4::algo::x4djbx33a_128>(c));
+    for(i=0; i<1000 && i+32<=in_sz; i++) {
+      map[std::string((const char*)p + i, 1 + i % 32)] = i;
+    }
+    for(i=0; i<1000 && i+32<=in_sz; i++) {
+      const std::string_view key((const char*)p + i, 1 + i % 32);
+      if(map.find(std::string(key)) == map.end() || map.count(std::string(key)) != 1 || map.hash_function()(key) != hx4::hasher<hx4::algo::x4djbx33a_128>(c)(key)) {
+        fprintf(stream, "\tstd::unordered_map with hx4::hasher lost key %d\n", (int)i);
+        return 1;
+      }
+    }
+  }
+
+  return 0;
+}
+
+#undef HX4_CHECK_ALGO
+
+/* looks up all keys in a std::unordered_set with the hash functor Hash again and again for half a second */
+template<class Hash>
+static void print_lookup_performance(FILE *stream, const char *name, const std::vector<std::string> &keys, const Hash &h) {
+  std::unordered_set<std::string, Hash> set(keys.size(), h);
+  size_t found = 0;
+  uint64_t repeat_count = 0;
+  double timedelta = 0;
+  std::chrono::steady_clock::time_point start;
+  std::chrono::steady_clock::time_point stop;
+
+  set.insert(keys.begin(), keys.end());
+
+  start = std::chrono::steady_clock::now();
+  while(timedelta < 0.5) {
+    for(const std::string &key : keys) {
+      found += set.count(key);
+    }
+    repeat_count++;
+    stop = std::chrono::steady_clock::now();
+    timedelta = std::chrono::duration<double>(stop - start).count();
+  }
+  fprintf(stream, "\t%-40s %8.2f Mlookups/s %s\n", name, (double)keys.size() * (double)repeat_count / timedelta / 1000000.0, found == keys.size() * repeat_count ? "" : "(keys missing)");
+}
+
+/* std::unordered_set<std::string> lookups of 100000 keys of 8 to 39 bytes with std::hash and with several hx4::hasher */
+extern "C" int test_hx4_cpp_hasher_performance(FILE *stream, const void *in, size_t in_sz, const void *cookie, size_t cookie_sz) {
+  const uint8_t *p = (const uint8_t*)in;
+  std::vector<std::string> keys;
+  hx4::cookie c;
+  size_t i;
+
+  (void)cookie_sz;
+  memcpy(c.bytes, cookie, sizeof(c.bytes));
+
+  // a unique number in front of input bytes, the test input repeats after 256 bytes
+  for(i=0; i<100000 && i+40<=in_sz; i++) {
+    keys.push_back((std::to_string(i) + std::string((const char*)p + i, 32)).substr(0, 8 + (i * 7) % 32));
+  }
+
+  print_lookup_performance(stream, "std::hash<std::string>", keys, std::hash<std::string>());
+  print_lookup_performance(stream, "hx4::hasher<hx4::algo::djbx33a_32>", keys, hx4::hasher<hx4::algo::djbx33a_32>(c));
+  print_lookup_performance(stream, "hx4::hasher<hx4::algo::x4djbx33a_128>", keys, hx4::hasher<hx4::algo::x4djbx33a_128>(c));
+  print_lookup_performance(stream, "hx4::hasher<hx4::algo::siphash13_64>", keys, hx4::hasher<hx4::algo::siphash13_64>(c));
+  print_lookup_performance(stream, "hx4::hasher<hx4::algo::crc32c_32>", keys, hx4::hasher<hx4::algo::crc32c_32>(c));
+  print_lookup_performance(stream, "hx4::hasher<hx4::algo::x4mulfold_128>", keys, hx4::hasher<hx4::algo::x4mulfold_128>(c));
+  return 0;
+}
+
+/* counts the bytes a container and its strings hold */
+static size_t counted_bytes = 0;
+
+template<class T>
+struct counting_allocator {
+  typedef T value_type;
+  counting_allocator() = default;
+  template<class U> counting_allocator(const counting_allocator<U> &) {}
+  T *allocate(size_t n) { counted_bytes += n * sizeof(T); return std::allocator<T>().allocate(n); }
+  void deallocate(T *p, size_t n) { counted_bytes -= n * sizeof(T); std::allocator<T>().deallocate(p, n); }
+  template<class U> bool operator==(const counting_allocator<U> &) const { return true; }
+  template<class U> bool operator!=(const counting_allocator<U> &) const { return false; }
+};
+
+typedef std::basic_string<char, std::char_traits<char>, counting_allocator<char> > counted_string;
+
+struct counted_string_hash {
+  size_t operator()(const counted_string &s) const { return std::hash<std::string_view>()(std::string_view(s.data(), s.size())); }
+};
+
+struct handle_hash {
+  const hx4_intern *intern;
+  size_t operator()(uint32_t handle) const { return hx4_intern_hash(intern, handle); }
+};
+
+/* calls f(token, token_len) for every identifier in text */
+template<class F>
+static void parse_identifiers(const std::string &text, F f) {
+  const char *p = text.data();
+  const char *end = p + text.size();
+  const char *start;
+
+  while(p < end) {
+    if(*p == '_' || (*p >= 'a' && *p <= 'z') || (*p >= 'A' && *p <= 'Z')) {
+      start = p;
+      while(p < end && (*p == '_' || (*p >= 'a' && *p <= 'z') || (*p >= 'A' && *p <= 'Z') || (*p >= '0' && *p <= '9'))) {
+        p++;
+      }
+      f(start, (size_t)(p - start));
+    } else {
+      p++;
+    }
+  }
+}
+
+/*
+ * Tokenizes a C like source text of 2M identifiers from a vocabulary of
+ * 100000 and interns every identifier into a std::unordered_set<std::string>
+ * and into hx4_intern, one by one and in batches. Then looks every token up
+ * again, in a std::unordered_map keyed by the string and in one keyed by the
+ * handle with the cached hash, both without the parsing.
+ */
+extern "C" int test_hx4_cpp_intern_performance(FILE *stream, const void *in, size_t in_sz, const void *cookie, size_t cookie_sz) {
+  static const char * const parts[] = { "node", "parse", "get", "set", "buffer", "size", "count", "index", "next", "value", "token", "state" };
+  static const char * const separators[] = { " = ", "(", ", ", ");\n", " + ", "->", ".", " == " };
+  const size_t vocabulary_size = 100000;
+  const size_t num_tokens = 2000000;
+  std::vector<std::string> vocabulary;
+  std::vector<const void*> batch_strs;
+  std::vector<size_t> batch_lens;
+  std::vector<uint32_t> batch_handles;
+  std::vector<uint32_t> handles;
+  std::vector<uint8_t> memory;
+  std::string text;
+  hx4_intern intern;
+  size_t num_slots = 4;
+  uint64_t rng = 1;
+  size_t found = 0;
+  size_t i;
+  size_t base_bytes;
+  size_t set_bytes;
+  size_t set_count;
+  double set_s;
+  double intern_s;
+  double batch_s;
+  double string_lookup_s;
+  double handle_lookup_s;
+  std::chrono::steady_clock::time_point start;
+  int rc = 0;
+
+  (void)in;
+  (void)in_sz;
+
+  for(i=0; i<vocabulary_size; i++) {
+    vocabulary.push_back(std::string(parts[i % 12]) + "_" + parts[(i / 12) % 12] + "_" + std::to_string(i));
+  }
+  // a skewed token stream, half of the tokens come from the first 1% of the vocabulary
+  for(i=0; i<num_tokens; i++) {
+    rng = rng * 6364136223846793005ULL + 1442695040888963407ULL;
+    text += vocabulary[(rng >> 33) % ((rng >> 63) ? vocabulary_size : vocabulary_size / 100)];
+    text += separators[(rng >> 20) & 7];
+  }
+  while(HX4_INTERN_MAX_STRINGS(num_slots) < vocabulary_size) {
+    num_slots *= 2;
+  }
+  memory.resize(HX4_INTERN_MEMORY_SIZE(num_slots, vocabulary_size * HX4_INTERN_ENTRY_SIZE(32)));
+
+  {
+    std::unordered_set<counted_string, counted_string_hash, std::equal_to<counted_string>, counting_allocator<counted_string> > set;
+    base_bytes = counted_bytes;
+    start = std::chrono::steady_clock::now();
+    parse_identifiers(text, [&](const char *token, size_t len) {
+      set.insert(counted_string(token, len));
+    });
+    set_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    set_bytes = counted_bytes - base_bytes;
+    set_count = set.size();
+  }
+
+  rc += hx4_intern_init(&intern, memory.data(), memory.size(), num_slots, cookie, cookie_sz);
+  start = std::chrono::steady_clock::now();
+  parse_identifiers(text, [&](const char *token, size_t len) {
+    uint32_t handle;
+    rc += hx4_intern_add(&intern, token, len, &handle);
+    handles.push_back(handle);
+  });
+  intern_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  rc += hx4_intern_init(&intern, memory.data(), memory.size(), num_slots, cookie, cookie_sz);
+  batch_handles.resize(handles.size());
+  start = std::chrono::steady_clock::now();
+  i = 0;
+  parse_identifiers(text, [&](const char *token, size_t len) {
+    batch_strs.push_back(token);
+    batch_lens.push_back(len);
+    if(batch_strs.size() == 256) {
+      rc += hx4_intern_add_batch(&intern, batch_strs.data(), batch_lens.data(), batch_strs.size(), batch_handles.data() + i);
+      i += batch_strs.size();
+      batch_strs.clear();
+      batch_lens.clear();
+    }
+  });
+  rc += hx4_intern_add_batch(&intern, batch_strs.data(), batch_lens.data(), batch_strs.size(), batch_handles.data() + i);
+  batch_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  if(rc != 0 || batch_handles != handles || intern.count != set_count) {
+    fprintf(stream, "\thx4_intern_add and hx4_intern_add_batch disagree\n");
+    return 1;
+  }
+
+  // a symbol table keyed by the string against one keyed by the handle
+  {
+    std::unordered_map<std::string, size_t> by_string;
+    std::vector<std::string_view> tokens;
+    std::unordered_map<uint32_t, size_t, handle_hash> by_handle(16, handle_hash{&intern});
+    parse_identifiers(text, [&](const char *token, size_t len) {
+      tokens.push_back(std::string_view(token, len));
+    });
+    for(uint32_t handle : handles) {
+      by_string.emplace(std::string(hx4_intern_data(&intern, handle), hx4_intern_len(&intern, handle)), handle);
+      by_handle.emplace(handle, handle);
+    }
+    start = std::chrono::steady_clock::now();
+    for(std::string_view token : tokens) {
+      found += by_string.count(std::string(token));
+    }
+    string_lookup_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    start = std::chrono::steady_clock::now();
+    for(uint32_t handle : handles) {
+      found += by_handle.count(handle);
+    }
+    handle_lookup_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  }
+  if(rc != 0 || found != 2 * handles.size()) {
+    fprintf(stream, "\tsymbol table lookups failed\n");
+    return 1;
+  }
+
+  fprintf(stream, "\t%d identifiers, %d distinct, %.1f MiB of text\n", (int)handles.size(), (int)set_count, (double)text.size() / 1024.0 / 1024.0);
+  fprintf(stream, "\t%-48s %8.2f Mtokens/s %8.2f MiB\n", "parse and std::unordered_set<std::string>::insert", (double)handles.size() / set_s / 1000000.0, (double)set_bytes / 1024.0 / 1024.0);
+  fprintf(stream, "\t%-48s %8.2f Mtokens/s %8.2f MiB\n", "parse and hx4_intern_add", (double)handles.size() / intern_s / 1000000.0, (double)(num_slots * 8 + intern.arena_used) / 1024.0 / 1024.0);
+  fprintf(stream, "\t%-48s %8.2f Mtokens/s\n", "parse and hx4_intern_add_batch", (double)handles.size() / batch_s / 1000000.0);
+  fprintf(stream, "\t%-48s %8.2f Mlookups/s\n", "std::unordered_map<std::string> lookups", (double)handles.size() / string_lookup_s / 1000000.0);
+  fprintf(stream, "\t%-48s %8.2f Mlookups/s\n", "std::unordered_map<handle> with hx4_intern_hash", (double)handles.size() / handle_lookup_s / 1000000.0);
+  return 0;
+}
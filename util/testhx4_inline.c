@@ -0,0 +1,54 @@
+/* 
+ * Copyright 2015 Kai Dietrich <mail@cleeus.de>
+ *
+ * This file is part of hashx4.
+ *
+ * Hashx4 is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Hashx4 is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with hashx4.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/*
+ * Short key loops over the header-only build of hashx4.
+ *
+ * This file includes hashx4_inline.h and no other hashx4 header, so the
+ * kernels below get inlined into the loops with the key length known at
+ * compile time. testhx4.c runs the same loops against the library and
+ * compares both the checksums and the throughput.
+ */
+
+#include "hashx4_inline.h"
+
+#define HX4_INLINE_KEYS_IMPL(function_name, output_bits, key_sz) \
+uint64_t hx4_inline_keys_##function_name##_##key_sz(const uint8_t *keys, size_t num_keys, const void *cookie, size_t cookie_sz) { \
+  uint8_t out[(output_bits)/8]; \
+  uint64_t word; \
+  uint64_t checksum = 0; \
+  size_t i; \
+  for(i=0; i<num_keys; i++) { \
+    function_name(keys + i*(key_sz), (key_sz), cookie, cookie_sz, out, sizeof(out)); \
+    word = 0; \
+    memcpy(&word, out, sizeof(out) < sizeof(word) ? sizeof(out) : sizeof(word)); \
+    checksum ^= word + i; \
+  } \
+  return checksum; \
+}
+
+HX4_INLINE_KEYS_IMPL(hx4_x4djbx33a_128_copt, 128, 8)
+HX4_INLINE_KEYS_IMPL(hx4_x4djbx33a_128_copt, 128, 16)
+HX4_INLINE_KEYS_IMPL(hx4_siphash13_64_copt, 64, 8)
+HX4_INLINE_KEYS_IMPL(hx4_siphash13_64_copt, 64, 16)
+HX4_INLINE_KEYS_IMPL(hx4_x4mulfold_128_copt, 128, 8)
+HX4_INLINE_KEYS_IMPL(hx4_x4mulfold_128_copt, 128, 16)
+
+#undef HX4_INLINE_KEYS_IMPL
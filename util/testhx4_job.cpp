@@ -0,0 +1,154 @@
+/* 
+ * Copyright 2015 Kai Dietrich <mail@cleeus.de>
+ *
+ * This file is part of hashx4.
+ *
+ * Hashx4 is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Hashx4 is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with hashx4.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+
+/*
+ * Tests of hx4::job and, when built as C++20, of the hx4::hash_sliced
+ * coroutine, called from testhx4.c.
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <string_view>
+
+// hashx4.h comes first here, so hx4::hash calls the library kernels, while
+// testhx4_cpp.cpp compiles them inline into the same binary
+#include "hashx4_stats.h"
+#include "hashx4.hpp"
+
+/* steps through the job in slices of max_bytes and compares with hx4::hash */
+template<class Algo>
+static int check_job(FILE *stream, const char *name, const uint8_t *in, std::size_t in_sz, const hx4::cookie &c, std::size_t max_bytes) {
+  hx4::job<Algo> j(in, in_sz, c);
+  std::size_t steps = 1;
+
+  while(j.step(max_bytes)) {
+    if(j.bytes_hashed() != steps * max_bytes) {
+      fprintf(stream, "\thx4::job<%s> hashed %d bytes in %d steps of %d\n", name, (int)j.bytes_hashed(), (int)steps, (int)max_bytes);
+      return 1;
+    }
+    steps++;
+  }
+  if(!j.done() || j.result() != hx4::hash<Algo>(in, in_sz, c) || j.result() != j.result()) {
+    fprintf(stream, "\thx4::job<%s> over %d bytes doesn't match hx4::hash\n", name, (int)in_sz);
+    return 1;
+  }
+
+#if HX4_HAS_COROUTINES
+  auto task = hx4::hash_sliced<Algo>(in, in_sz, c, max_bytes, std::chrono::microseconds(0));
+  std::size_t resumes = 1;
+  while(!task.resume()) {
+    resumes++;
+  }
+  if(resumes != steps || task.result() != hx4::hash<Algo>(in, in_sz, c)) {
+    fprintf(stream, "\thx4::hash_sliced<%s> over %d bytes doesn't match hx4::hash\n", name, (int)in_sz);
+    return 1;
+  }
+#endif
+  return 0;
+}
+
+/* an empty std::string_view has a NULL data(), the job hashes it like hx4::hash */
+template<class Algo>
+static int check_job_empty(FILE *stream, const char *name, const hx4::cookie &c) {
+  const std::string_view empty;
+  hx4::job<Algo> j(empty, c);
+
+  if(j.step(4096) || !j.done() || j.result() != hx4::hash<Algo>(empty, c)) {
+    fprintf(stream, "\thx4::job<%s> of an empty string_view doesn't match hx4::hash\n", name);
+    return 1;
+  }
+#if HX4_HAS_COROUTINES
+  auto task = hx4::hash_sliced<Algo>(empty.data(), empty.size(), c, 4096, std::chrono::microseconds(0));
+  if(!task.resume() || task.result() != hx4::hash<Algo>(empty, c)) {
+    fprintf(stream, "\thx4::hash_sliced<%s> of an empty string_view doesn't match hx4::hash\n", name);
+    return 1;
+  }
+#endif
+  return 0;
+}
+
+#define HX4_CHECK_JOB(algo_name) \
+  if(check_job<hx4::algo::algo_name>(stream, #algo_name, p, sz, c, max_bytes) != 0) { \
+    return 1; \
+  }
+
+#define HX4_CHECK_JOB_EMPTY(algo_name) \
+  if(check_job_empty<hx4::algo::algo_name>(stream, #algo_name, c) != 0) { \
+    return 1; \
+  }
+
+extern "C" int test_hx4_job_cpp_correctness(FILE *stream, const void *in, size_t in_sz, const void *cookie, size_t cookie_sz) {
+  static const std::size_t sizes[] = { 0, 1, 100, 65537 };
+  static const std::size_t byte_limits[] = { 1, 13, 4096 };
+  const uint8_t *p = (const uint8_t*)in;
+  hx4::cookie c;
+
+  (void)in_sz;
+  (void)cookie_sz;
+  memcpy(c.bytes, cookie, sizeof(c.bytes));
+
+  for(std::size_t sz : sizes) {
+    for(std::size_t max_bytes : byte_limits) {
+      if(max_bytes == 1 && sz > 100) {
+        continue;
+      }
+      HX4_CHECK_JOB(djbx33a_32)
+      HX4_CHECK_JOB(x4djbx33a_128)
+      HX4_CHECK_JOB(kdjbx33a_32)
+      HX4_CHECK_JOB(x4kdjbx33a_128)
+      HX4_CHECK_JOB(siphash24_64)
+      HX4_CHECK_JOB(siphash13_64)
+      HX4_CHECK_JOB(x4siphash13_256)
+      HX4_CHECK_JOB(halfsiphash13_32)
+      HX4_CHECK_JOB(x4halfsiphash13_128)
+    }
+  }
+
+  HX4_CHECK_JOB_EMPTY(djbx33a_32)
+  HX4_CHECK_JOB_EMPTY(x4djbx33a_128)
+  HX4_CHECK_JOB_EMPTY(kdjbx33a_32)
+  HX4_CHECK_JOB_EMPTY(x4kdjbx33a_128)
+  HX4_CHECK_JOB_EMPTY(siphash24_64)
+  HX4_CHECK_JOB_EMPTY(siphash13_64)
+  HX4_CHECK_JOB_EMPTY(x4siphash13_256)
+  HX4_CHECK_JOB_EMPTY(halfsiphash13_32)
+  HX4_CHECK_JOB_EMPTY(x4halfsiphash13_128)
+
+  // a NULL input with a size is an error, not a job that is done at once
+  try {
+    hx4::job<hx4::algo::siphash13_64> j(nullptr, 5, c);
+    fprintf(stream, "\thx4::job of a NULL input with 5 bytes didn't throw\n");
+    return 1;
+  } catch(const std::invalid_argument &) {
+  }
+
+#if HX4_HAS_COROUTINES
+  fprintf(stream, "\thx4::job and hx4::hash_sliced\n");
+#else
+  fprintf(stream, "\thx4::job, no C++20 coroutines in this build\n");
+#endif
+  return 0;
+}
+
+#undef HX4_CHECK_JOB_EMPTY
+#undef HX4_CHECK_JOB